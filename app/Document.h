@@ -1,8 +1,10 @@
 #import <Types.h>
 
 #include <optional>
+#include <vector>
 
 #include "document.hpp"
+#include "progressive_document.hpp"
 
 NS_ASSUME_NONNULL_BEGIN
 
@@ -10,10 +12,25 @@ NS_ASSUME_NONNULL_BEGIN
 
 @property(strong, nonatomic, nullable) NSData *initialData;
 
+// Receives the lines of an opened document handed over after its first ones
+@property(copy, nonatomic, nullable) void (^loadingHandler)
+    (std::vector<marlin::control::source_update> updates);
+
 - (std::optional<marlin::control::source_update>)initialize;
 
 - (marlin::control::document &)content;
 
+- (BOOL)isLoading;
+
+- (void)pollLoading;
+
+// Must be called before saving or running the document
+- (void)finishLoading;
+
+// Set once the blocks after those handed over could not be read, the document
+// must then not be saved over the file it was opened from
+- (nullable NSError *)loadingError;
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -4,6 +4,7 @@
 
 @interface Document () {
   std::optional<marlin::control::document> _content;
+  std::optional<marlin::control::progressive_document> _loading;
 }
 
 @end
@@ -11,20 +12,64 @@
 @implementation Document
 
 - (std::optional<marlin::control::source_update>)initialize {
-  if (auto result{self.initialData == nil
-                      ? marlin::control::document::make_document()
-                      : marlin::control::document::make_document(self.initialData.dataView)}) {
+  if (self.initialData == nil) {
+    if (auto result{marlin::control::document::make_document()}) {
+      auto [doc, source]{*std::move(result)};
+      _content = std::move(doc);
+      return source;
+    }
+  } else if (auto result{marlin::control::progressive_document::open(self.initialData.dataView)}) {
     auto [doc, source]{*std::move(result)};
     self.initialData = nil;
-    _content = std::move(doc);
+    _loading = std::move(doc);
     return source;
-  } else {
-    return std::nullopt;
   }
+  return std::nullopt;
 }
 
 - (marlin::control::document &)content {
-  return *_content;
+  return _loading.has_value() ? _loading->content() : *_content;
+}
+
+- (BOOL)isLoading {
+  return _loading.has_value() && !_loading->is_complete();
+}
+
+- (void)pollLoading {
+  if (self.isLoading) {
+    [self handOverLoadedUpdates:_loading->poll()];
+    if (auto error = self.loadingError) {
+#ifdef IOS
+      [self handleError:error userInteractionPermitted:YES];
+#else
+      [self presentError:error];
+#endif
+    }
+  }
+}
+
+- (void)finishLoading {
+  if (self.isLoading) {
+    [self handOverLoadedUpdates:_loading->finish()];
+  }
+}
+
+- (NSError *)loadingError {
+  if (!_loading.has_value() || !_loading->has_failed()) {
+    return nil;
+  }
+  return [NSError errorWithDomain:NSCocoaErrorDomain
+                             code:NSFileReadCorruptFileError
+                         userInfo:@{
+                           NSLocalizedDescriptionKey :
+                               @"The end of the document could not be read, it cannot be saved."
+                         }];
+}
+
+- (void)handOverLoadedUpdates:(std::vector<marlin::control::source_update>)updates {
+  if (!updates.empty() && self.loadingHandler != nil) {
+    self.loadingHandler(std::move(updates));
+  }
 }
 
 @end
@@ -8,6 +8,9 @@ NS_ASSUME_NONNULL_BEGIN
 
 - (void)setExecutable:(NSString *)executable;
 
+// Receives the stack traces sampled by a profiled run once it stops
+@property(copy, nonatomic, nullable) void (^profileHandler)(NSArray<NSString *> *samples);
+
 @end
 
 NS_ASSUME_NONNULL_END
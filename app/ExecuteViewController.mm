@@ -93,6 +93,11 @@ VIEWDIDAPPEAR_END
         NSLog(@"Name: %@", payload[@"name"]);
         NSLog(@"Message: %@", payload[@"message"]);
         NSLog(@"Stacktrace: %@", payload[@"stacktrace"]);
+      } else if ([type isEqualToString:@"profile"]) {
+        NSArray* samples = payload[@"samples"];
+        if (self.profileHandler != nil && [samples isKindOfClass:[NSArray class]]) {
+          self.profileHandler(samples);
+        }
       }
     }
   }
@@ -2,6 +2,10 @@
 
 #import "SourceView.h"
 
+#include <vector>
+
+#include "profile.hpp"
+
 NS_ASSUME_NONNULL_BEGIN
 
 @interface LineNumberView : RulerView
@@ -20,6 +24,11 @@ NS_ASSUME_NONNULL_BEGIN
 
 - (void)clearErrors;
 
+// Shades each line by the samples taken right on it
+- (void)showProfile:(const std::vector<marlin::exec::profile::line_counts>&)lines;
+
+- (void)clearProfile;
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -1,5 +1,7 @@
 #import "LineNumberView.h"
 
+#include <algorithm>
+
 #import "DrawHelper.h"
 #import "Theme.h"
 
@@ -13,6 +15,8 @@
 
 @implementation LineNumberView {
   NSMutableDictionary* _errors;
+  // Share of the samples of the busiest line taken on each line
+  NSMutableDictionary<NSNumber*, NSNumber*>* _profile;
   CGFloat _inset;
 }
 
@@ -26,6 +30,7 @@
     self.ruleThickness = 45;
     self.clientView = view;
     _errors = [NSMutableDictionary new];
+    _profile = [NSMutableDictionary new];
     _inset = 5;
   }
   return self;
@@ -57,6 +62,28 @@
   [self setNeedsDisplayInRect:self.bounds];
 }
 
+- (void)showProfile:(const std::vector<marlin::exec::profile::line_counts>&)lines {
+  [_profile removeAllObjects];
+  size_t busiest = 0;
+  for (const auto& line : lines) {
+    busiest = std::max(busiest, line.samples.exclusive);
+  }
+  if (busiest > 0) {
+    for (const auto& line : lines) {
+      if (line.samples.exclusive > 0) {
+        [_profile setObject:@(static_cast<double>(line.samples.exclusive) / busiest)
+                     forKey:@(line.line)];
+      }
+    }
+  }
+  [self setNeedsDisplayInRect:self.bounds];
+}
+
+- (void)clearProfile {
+  [_profile removeAllObjects];
+  [self setNeedsDisplayInRect:self.bounds];
+}
+
 #ifdef IOS
 - (void)drawRect:(CGRect)rect {
   [super drawRect:rect];
@@ -78,6 +105,7 @@
   auto y = [sourceView lineTopOfNumber:startLine] + offset.y;
   if (startLine > 0) {
     for (auto line = startLine; line <= endLine; ++line) {
+      [self drawProfileOfLine:line atRect:CGRectMake(0, y, self.ruleThickness, height)];
       auto errorRect = CGRectMake(_inset, y + _inset, errorSize, errorSize);
       [self drawErrorIndicatorOfLine:line atRect:errorRect];
 
@@ -91,6 +119,12 @@
   }
 }
 
+- (void)drawProfileOfLine:(NSUInteger)number atRect:(CGRect)rect {
+  if (NSNumber* share = [_profile objectForKey:[NSNumber numberWithInteger:number]]) {
+    drawRectangle(rect, [Color.orangeColor colorWithAlphaComponent:0.6 * share.doubleValue]);
+  }
+}
+
 - (void)drawErrorIndicatorOfLine:(NSUInteger)number atRect:(CGRect)rect {
   if ([_errors objectForKey:[NSNumber numberWithInteger:number]]) {
     drawOval(rect, Color.redColor);
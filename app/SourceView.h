@@ -67,6 +67,8 @@ NS_ASSUME_NONNULL_BEGIN
 
 - (void)initializeWithDisplay:(marlin::format::display)display;
 
+- (void)performLoadingUpdates:(std::vector<marlin::control::source_update>)updates;
+
 - (marlin::source_loc)sourceLocationOfPoint:(CGPoint)point;
 
 - (CGFloat)lineHeight;
@@ -11,6 +11,15 @@
 
 using optional_source_selection = std::optional<marlin::control::source_selection>;
 
+// Columns count codepoints, while strings are indexed by UTF-16 units
+static NSUInteger indexOfColumn(NSString* string, size_t column) {
+  NSUInteger index = 0;
+  for (size_t i = 1; i < column && index < string.length; ++i) {
+    index += CFStringIsSurrogateHighCharacter([string characterAtIndex:index]) ? 2 : 1;
+  }
+  return index;
+}
+
 struct DocumentGetter {
   DocumentGetter(SourceView* sourceView) : _sourceView{sourceView} {}
 
@@ -65,6 +74,17 @@ struct DocumentGetter {
 }
 
 - (void)performUpdates:(std::vector<marlin::control::source_update>)updates {
+  [self applyUpdates:std::move(updates)];
+  [self clearErrors];
+  [self.delegate sourceViewChanged:self];
+}
+
+- (void)performLoadingUpdates:(std::vector<marlin::control::source_update>)updates {
+  // The document is unchanged, only more of it is shown
+  [self applyUpdates:std::move(updates)];
+}
+
+- (void)applyUpdates:(std::vector<marlin::control::source_update>)updates {
   for (auto& update : updates) {
     // For now, we assume that there are only 3 types of updates:
     //  - Insert statements/blocks
@@ -76,7 +96,14 @@ struct DocumentGetter {
     if (update.range.begin == update.range.end) {
       [self insertLinesBeforeLine:update.range.begin.line withDisplay:std::move(update.display)];
     } else if (update.range.begin.line == update.range.end.line) {
-      [self updateExpressionInSourceRange:update.range withDisplay:std::move(update.display)];
+      if (update.deltas.empty()) {
+        [self updateExpressionInSourceRange:update.range withDisplay:std::move(update.display)];
+      } else {
+        // Only repaint the columns that changed
+        for (auto& delta : update.deltas) {
+          [self updateExpressionInSourceRange:delta.range withDisplay:std::move(delta.display)];
+        }
+      }
     } else {
       assert(update.display.source.length() == 0);
       [self removeLinesFromLine:update.range.begin.line toLine:update.range.end.line];
@@ -84,8 +111,6 @@ struct DocumentGetter {
   }
   self.frameSize = self.currentSize;
   [self setNeedsDisplayInRect:self.bounds];
-  [self clearErrors];
-  [self.delegate sourceViewChanged:self];
 }
 
 - (void)insertLinesBeforeLine:(NSUInteger)line withDisplay:(marlin::format::display)display {
@@ -93,24 +118,12 @@ struct DocumentGetter {
   if (lineIndex > _strings.count) {
     lineIndex = _strings.count;
   }
-  size_t lineBegin = 0;
-  size_t highlightIndex = 0;
-  while (lineBegin < display.source.size()) {
-    auto lineEnd = display.source.find_first_of('\n', lineBegin);
-    std::string_view str_view{&display.source[lineBegin], lineEnd - lineBegin};
-    auto str =
-        [[NSMutableAttributedString alloc] initWithString:[NSString stringWithStringView:str_view]];
-    std::vector<marlin::format::highlight_token> lineHighlights;
-    while (highlightIndex < display.highlights.size() &&
-           display.highlights[highlightIndex].offset < lineEnd) {
-      auto highlight = display.highlights[highlightIndex];
-      highlight.offset -= lineBegin;
-      lineHighlights.push_back(highlight);
-      ++highlightIndex;
-    }
-    applyTheme(currentTheme(), str, NSMakeRange(0, str.string.length), lineHighlights);
+  for (size_t i = 0; i < display.line_count(); ++i) {
+    auto str = [[NSMutableAttributedString alloc]
+        initWithString:[NSString stringWithStringView:display.line_source(i)]];
+    applyTheme(currentTheme(), str, NSMakeRange(0, str.string.length), display.line_source(i),
+               display.line_highlights(i), display.line_offset(i));
     [_strings insertObject:str atIndex:lineIndex];
-    lineBegin = lineEnd + 1;
     ++lineIndex;
   }
 }
@@ -120,11 +133,12 @@ struct DocumentGetter {
   NSAssert(sourceRange.begin.line == sourceRange.end.line, @"Only support one line expression");
   NSAssert(sourceRange.begin.line > 0 && sourceRange.begin.line <= _strings.count, @"");
   NSMutableAttributedString* str = [_strings objectAtIndex:sourceRange.begin.line - 1];
-  auto range =
-      NSMakeRange(sourceRange.begin.column - 1, sourceRange.end.column - sourceRange.begin.column);
-  [str replaceCharactersInRange:range withString:[NSString stringWithStringView:display.source]];
-  range.length = display.source.size();
-  applyTheme(currentTheme(), str, range, display.highlights);
+  auto begin = indexOfColumn(str.string, sourceRange.begin.column);
+  auto range = NSMakeRange(begin, indexOfColumn(str.string, sourceRange.end.column) - begin);
+  auto replacement = [NSString stringWithStringView:display.source];
+  [str replaceCharactersInRange:range withString:replacement];
+  range.length = replacement.length;
+  applyTheme(currentTheme(), str, range, display.source, display.highlights);
 }
 
 - (void)removeLinesFromLine:(NSUInteger)from toLine:(NSUInteger)to {
@@ -465,20 +479,25 @@ struct DocumentGetter {
   }
   if (lines == 1) {
     NSAttributedString* attrString = [_strings objectAtIndex:range.begin.line - 1];
-    return
-        [attrString.string substringWithRange:NSMakeRange(range.begin.column - 1,
-                                                          range.end.column - range.begin.column)];
+    auto begin = indexOfColumn(attrString.string, range.begin.column);
+    return [attrString.string
+        substringWithRange:NSMakeRange(begin,
+                                       indexOfColumn(attrString.string, range.end.column) - begin)];
   } else if (lines > 1) {
     auto string = [NSMutableString new];
     NSAttributedString* attrString = [_strings objectAtIndex:range.begin.line - 1];
-    [string appendString:[attrString.string substringFromIndex:range.begin.column - 1]];
+    [string appendString:[attrString.string
+                             substringFromIndex:indexOfColumn(attrString.string,
+                                                              range.begin.column)]];
     [string appendString:@"\n"];
     if (lines > 2) {
       [string appendString:@"  ...\n"];
     }
     auto endLine = range.end.column > range.begin.column ? range.end.line - 1 : range.end.line - 2;
     attrString = [_strings objectAtIndex:endLine];
-    [string appendString:[attrString.string substringFromIndex:range.begin.column - 1]];
+    [string appendString:[attrString.string
+                             substringFromIndex:indexOfColumn(attrString.string,
+                                                              range.begin.column)]];
     return string;
   } else {
     NSAssert(NO, @"");
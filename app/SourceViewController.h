@@ -12,8 +12,15 @@ NS_ASSUME_NONNULL_BEGIN
 @property(weak, nonatomic) ToolboxViewController* toolboxViewController;
 @property(weak, nonatomic) LineNumberView* lineNumberView;
 
+// Shows the rest of the document as it is opened in the background
+- (void)followLoadingDocument;
+
 - (void)execute;
 
+// Runs the document sampling its statements, then shows how many samples
+// each line took next to it
+- (void)executeProfiled;
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -5,6 +5,11 @@
 #import "Pasteboard.h"
 #import "Theme.h"
 
+// Names the script in the stack traces of its runs
+static NSString *const executableSourceURL = @"marlin.js";
+
+constexpr double profileIntervalInSeconds = 0.001;
+
 @interface SourceViewController () <SourceViewDelegate>
 
 - (Document *)document;
@@ -15,6 +20,7 @@
 
 @implementation SourceViewController {
   NSString *_executableCode;
+  bool _profiling;
 }
 
 - (void)viewDidLoad {
@@ -44,15 +50,53 @@ VIEWWILLAPPEAR_END
   NSWindowController *windowController = segue.destinationController;
   auto vc = [ExecuteViewController cast:windowController.window.contentViewController];
   vc.executable = _executableCode;
+  if (_profiling) {
+    __weak SourceViewController *weakSelf = self;
+    vc.profileHandler = ^(NSArray<NSString *> *samples) {
+      [weakSelf showProfileOfSamples:samples];
+    };
+  }
 #endif
 }
 
+- (void)followLoadingDocument {
+  if (!self.document.isLoading) {
+    return;
+  }
+  __weak SourceViewController *weakSelf = self;
+  self.document.loadingHandler = ^(std::vector<marlin::control::source_update> updates) {
+    [weakSelf.sourceView performLoadingUpdates:std::move(updates)];
+    [weakSelf.lineNumberView setNeedsDisplayInRect:weakSelf.lineNumberView.bounds];
+  };
+  [NSTimer scheduledTimerWithTimeInterval:0.05
+                                  repeats:YES
+                                    block:^(NSTimer *timer) {
+                                      auto document = weakSelf.document;
+                                      [document pollLoading];
+                                      if (!document.isLoading) {
+                                        [timer invalidate];
+                                      }
+                                    }];
+}
+
 - (void)execute {
+  [self executeWithProfileInterval:0];
+}
+
+- (void)executeProfiled {
+  [self executeWithProfileInterval:profileIntervalInSeconds];
+}
+
+- (void)executeWithProfileInterval:(double)interval {
+  [self.document finishLoading];
   [self.lineNumberView clearErrors];
+  [self.lineNumberView clearProfile];
   _executableCode = nil;
+  _profiling = interval > 0;
   try {
-    _executableCode =
-        [NSString stringWithStringView:self.document.content.generate_executable_code()];
+    auto code = [NSString
+        stringWithStringView:self.document.content.generate_executable_code(interval)];
+    _executableCode = [code stringByAppendingFormat:@"\n//# sourceURL=%@\n", executableSourceURL];
   } catch (marlin::exec::collected_generation_error &e) {
     for (auto &err : e.errors()) {
       [self.sourceView addErrorInSourceRange:err.node().source_code_range];
@@ -67,6 +111,18 @@ VIEWWILLAPPEAR_END
   }
 }
 
+- (void)showProfileOfSamples:(NSArray<NSString *> *)samples {
+  std::vector<std::string> stacktraces;
+  stacktraces.reserve(samples.count);
+  for (NSString *sample in samples) {
+    stacktraces.emplace_back(sample.UTF8String);
+  }
+  // Empty if the document was edited since it was generated
+  const auto profile =
+      self.document.content.profile_of(stacktraces, executableSourceURL.UTF8String);
+  [self.lineNumberView showProfile:profile.lines()];
+}
+
 - (ViewController *)destinationViewControllerOfSegue:(StoryboardSegue *)segue {
   NSAssert(NO, @"Implemented by subclass");
   return nil;
@@ -40,5 +40,8 @@ void setCurrentTheme(id<Theme> theme);
 
 CGSize characterSizeWithAttributes(NSDictionary<NSAttributedStringKey, id>* attrs);
 
+// Highlights are offset in bytes of the UTF-8 source shown in range, which
+// starts at highlightsOffset of the display
 void applyTheme(id<Theme> theme, NSMutableAttributedString* attributedString, NSRange range,
-                const std::vector<marlin::format::highlight_token>& highlights);
+                std::string_view source, marlin::format::highlight_span highlights,
+                size_t highlightsOffset = 0);
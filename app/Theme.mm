@@ -1,5 +1,7 @@
 #import "Theme.h"
 
+#include "utf8.hpp"
+
 @implementation DefaultTheme
 
 - (instancetype)init {
@@ -44,10 +46,18 @@ CGSize characterSizeWithAttributes(NSDictionary<NSAttributedStringKey, id>* attr
 }
 
 void applyTheme(id<Theme> theme, NSMutableAttributedString* attributedString, NSRange range,
-                const std::vector<marlin::format::highlight_token>& highlights) {
+                std::string_view source, marlin::format::highlight_span highlights,
+                size_t highlightsOffset) {
   [attributedString setAttributes:theme.allAttrs range:range];
+  // Highlights come in order, so the source before each is only counted once
+  size_t byteOffset = 0;
+  auto location = range.location;
   for (const auto& highlight : highlights) {
-    auto highlight_range = NSMakeRange(range.location + highlight.offset, highlight.length);
+    const auto offset = highlight.offset - highlightsOffset;
+    location += marlin::format::utf16_length(source.substr(byteOffset, offset - byteOffset));
+    const auto length = marlin::format::utf16_length(source.substr(offset, highlight.length));
+    byteOffset = offset;
+    auto highlight_range = NSMakeRange(location, length);
     switch (highlight.type) {
       case marlin::format::highlight_token_type::keyword:
         [attributedString setAttributes:theme.keywordAttrs range:highlight_range];
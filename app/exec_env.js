@@ -43,8 +43,14 @@ function assertColor(value) {
   }
 }
 
+// Functions checking their arguments have an Unchecked twin, which the
+// generated code calls with arguments proven of the types checked
+
 async function sleep(time) {
-  time = asNumber(time);
+  return sleepUnchecked(asNumber(time));
+}
+
+async function sleepUnchecked(time) {
   return new Promise(accept => {
     setTimeout(accept, time * 1000);
   });
@@ -81,24 +87,34 @@ function print(obj) {
 
 const ArrayUtils = {
   length(list) {
-    assertArray(list);
+    return this.lengthUnchecked(assertArray(list));
+  },
+
+  lengthUnchecked(list) {
     return list.length;
   },
 
   append(list, element) {
-    assertArray(list);
+    this.appendUnchecked(assertArray(list), element);
+  },
+
+  appendUnchecked(list, element) {
     list.push(element);
   },
 
   insert(list, index, element) {
-    assertArray(list);
-    index = asNumber(index);
+    this.insertUnchecked(assertArray(list), asNumber(index), element);
+  },
+
+  insertUnchecked(list, index, element) {
     list.splice(index, 0, element);
   },
 
   remove(list, index) {
-    assertArray(list);
-    index = asNumber(index);
+    this.removeUnchecked(assertArray(list), asNumber(index));
+  },
+
+  removeUnchecked(list, index) {
     list.splice(index, 1);
   }
 };
@@ -107,91 +123,145 @@ const MathUtils = {
   RAD_PER_DEG: Math.PI / 180,
 
   random(min, max) {
-    min = asNumber(min);
-    max = asNumber(max);
+    return this.randomUnchecked(asNumber(min), asNumber(max));
+  },
+
+  randomUnchecked(min, max) {
     return min + Math.random() * (max - min);
   },
 
   abs(value) {
-    value = asNumber(value);
+    return this.absUnchecked(asNumber(value));
+  },
+
+  absUnchecked(value) {
     return Math.abs(value);
   },
 
   sqrt(value) {
-    value = asNumber(value);
+    return this.sqrtUnchecked(asNumber(value));
+  },
+
+  sqrtUnchecked(value) {
     return Math.sqrt(value);
   },
 
   sin(degree) {
-    degree = asNumber(degree);
+    return this.sinUnchecked(asNumber(degree));
+  },
+
+  sinUnchecked(degree) {
     return Math.sin(degree * this.RAD_PER_DEG);
   },
 
   cos(degree) {
-    degree = asNumber(degree);
+    return this.cosUnchecked(asNumber(degree));
+  },
+
+  cosUnchecked(degree) {
     return Math.cos(degree * this.RAD_PER_DEG);
   },
 
   tan(degree) {
-    degree = asNumber(degree);
+    return this.tanUnchecked(asNumber(degree));
+  },
+
+  tanUnchecked(degree) {
     return Math.tan(degree * this.RAD_PER_DEG);
   },
 
   asin(value) {
-    value = asNumber(value);
+    return this.asinUnchecked(asNumber(value));
+  },
+
+  asinUnchecked(value) {
     return Math.asin(value) / this.RAD_PER_DEG;
   },
 
   acos(value) {
-    value = asNumber(value);
+    return this.acosUnchecked(asNumber(value));
+  },
+
+  acosUnchecked(value) {
     return Math.acos(value) / this.RAD_PER_DEG;
   },
 
   atan(value) {
-    value = asNumber(value);
+    return this.atanUnchecked(asNumber(value));
+  },
+
+  atanUnchecked(value) {
     return Math.atan(value) / this.RAD_PER_DEG;
   },
 
   ln(value) {
-    value = asNumber(value);
+    return this.lnUnchecked(asNumber(value));
+  },
+
+  lnUnchecked(value) {
     return Math.log(value);
   },
 
   log(value) {
-    value = asNumber(value);
+    return this.logUnchecked(asNumber(value));
+  },
+
+  logUnchecked(value) {
     return Math.log10(value);
   },
 
   round(value) {
-    value = asNumber(value);
+    return this.roundUnchecked(asNumber(value));
+  },
+
+  roundUnchecked(value) {
     return Math.round(value);
   },
 
   floor(value) {
-    value = asNumber(value);
+    return this.floorUnchecked(asNumber(value));
+  },
+
+  floorUnchecked(value) {
     return Math.floor(value);
   },
 
   ceil(value) {
-    value = asNumber(value);
+    return this.ceilUnchecked(asNumber(value));
+  },
+
+  ceilUnchecked(value) {
     return Math.ceil(value);
   }
 };
 
 const ColorUtils = {
   rgb(red, green, blue) {
-    red = restrict(asNumber(red), 0, 255);
-    green = restrict(asNumber(green), 0, 255);
-    blue = restrict(asNumber(blue), 0, 255);
+    return this.rgbUnchecked(asNumber(red), asNumber(green), asNumber(blue));
+  },
+
+  rgbUnchecked(red, green, blue) {
+    red = restrict(red, 0, 255);
+    green = restrict(green, 0, 255);
+    blue = restrict(blue, 0, 255);
 
     return new Color("rgb(" + red + "," + green + "," + blue + ")");
   },
 
   rgba(red, green, blue, alpha) {
-    red = restrict(asNumber(red), 0, 255);
-    green = restrict(asNumber(green), 0, 255);
-    blue = restrict(asNumber(blue), 0, 255);
-    alpha = restrict(asNumber(alpha), 0, 1);
+    return this.rgbaUnchecked(
+      asNumber(red),
+      asNumber(green),
+      asNumber(blue),
+      asNumber(alpha)
+    );
+  },
+
+  rgbaUnchecked(red, green, blue, alpha) {
+    red = restrict(red, 0, 255);
+    green = restrict(green, 0, 255);
+    blue = restrict(blue, 0, 255);
+    alpha = restrict(alpha, 0, 1);
 
     return new Color(
       "rgba(" + red + "," + green + "," + blue + "," + alpha + ")"
@@ -199,18 +269,35 @@ const ColorUtils = {
   },
 
   hsl(hue, saturation, lightness) {
-    hue = restrict(asNumber(hue), 0, 360);
-    saturation = restrict(asNumber(saturation), 0, 1) * 100;
-    lightness = restrict(asNumber(lightness), 0, 1) * 100;
+    return this.hslUnchecked(
+      asNumber(hue),
+      asNumber(saturation),
+      asNumber(lightness)
+    );
+  },
+
+  hslUnchecked(hue, saturation, lightness) {
+    hue = restrict(hue, 0, 360);
+    saturation = restrict(saturation, 0, 1) * 100;
+    lightness = restrict(lightness, 0, 1) * 100;
 
     return new Color("hsl(" + hue + "," + saturation + "%," + lightness + "%)");
   },
 
   hsla(hue, saturation, lightness, alpha) {
-    hue = restrict(asNumber(hue), 0, 360);
-    saturation = restrict(asNumber(saturation), 0, 1) * 100;
-    lightness = restrict(asNumber(lightness), 0, 1) * 100;
-    alpha = restrict(asNumber(alpha), 0, 1);
+    return this.hslaUnchecked(
+      asNumber(hue),
+      asNumber(saturation),
+      asNumber(lightness),
+      asNumber(alpha)
+    );
+  },
+
+  hslaUnchecked(hue, saturation, lightness, alpha) {
+    hue = restrict(hue, 0, 360);
+    saturation = restrict(saturation, 0, 1) * 100;
+    lightness = restrict(lightness, 0, 1) * 100;
+    alpha = restrict(alpha, 0, 1);
 
     return new Color(
       "hsla(" + hue + "," + saturation + "%," + lightness + "%," + alpha + ")"
@@ -250,25 +337,36 @@ const Graphics = {
   },
 
   async drawLine(startX, startY, endX, endY) {
-    startX = asNumber(startX);
-    startY = asNumber(startY);
-    endX = asNumber(endX);
-    endY = asNumber(endY);
+    await this.drawLineUnchecked(
+      asNumber(startX),
+      asNumber(startY),
+      asNumber(endX),
+      asNumber(endY)
+    );
+  },
 
+  async drawLineUnchecked(startX, startY, endX, endY) {
     const origin = this.origin();
     this.context.beginPath();
     this.context.moveTo(startX + origin.x, startY + origin.y);
     this.context.lineTo(endX + origin.x, endY + origin.y);
     this.context.stroke();
-    await sleep(0);
+    await sleepUnchecked(0);
   },
 
   async drawArc(x, y, radius, startAngle, endAngle) {
-    x = asNumber(x);
-    y = asNumber(y);
-    radius = asNumber(radius);
-    startAngle = asNumber(startAngle) - 90;
-    endAngle = asNumber(endAngle) - 90;
+    await this.drawArcUnchecked(
+      asNumber(x),
+      asNumber(y),
+      asNumber(radius),
+      asNumber(startAngle),
+      asNumber(endAngle)
+    );
+  },
+
+  async drawArcUnchecked(x, y, radius, startAngle, endAngle) {
+    startAngle -= 90;
+    endAngle -= 90;
 
     const origin = this.origin();
     this.context.beginPath();
@@ -280,29 +378,37 @@ const Graphics = {
       endAngle * MathUtils.RAD_PER_DEG
     );
     this.context.stroke();
-    await sleep(0);
+    await sleepUnchecked(0);
   },
 
   async drawRect(x, y, width, height) {
-    x = asNumber(x);
-    y = asNumber(y);
-    width = asNumber(width);
-    height = asNumber(height);
+    await this.drawRectUnchecked(
+      asNumber(x),
+      asNumber(y),
+      asNumber(width),
+      asNumber(height)
+    );
+  },
 
+  async drawRectUnchecked(x, y, width, height) {
     const origin = this.origin();
     this.context.beginPath();
     this.context.rect(x + origin.x, y + origin.y, width, height);
     this.context.stroke();
     this.context.fill();
-    await sleep(0);
+    await sleepUnchecked(0);
   },
 
   async drawEllipse(x, y, hRadius, vRadius) {
-    x = asNumber(x);
-    y = asNumber(y);
-    hRadius = asNumber(hRadius);
-    vRadius = asNumber(vRadius);
+    await this.drawEllipseUnchecked(
+      asNumber(x),
+      asNumber(y),
+      asNumber(hRadius),
+      asNumber(vRadius)
+    );
+  },
 
+  async drawEllipseUnchecked(x, y, hRadius, vRadius) {
     const origin = this.origin();
     this.context.beginPath();
     this.context.ellipse(
@@ -316,12 +422,14 @@ const Graphics = {
     );
     this.context.stroke();
     this.context.fill();
-    await sleep(0);
+    await sleepUnchecked(0);
   },
 
   clearCanvas(color) {
-    assertColor(color);
+    this.clearCanvasUnchecked(assertColor(color));
+  },
 
+  clearCanvasUnchecked(color) {
     document.body.style.backgroundColor = color.text;
     this.context.clearRect(
       0,
@@ -332,17 +440,26 @@ const Graphics = {
   },
 
   setLineWidth(width) {
-    width = asNumber(width);
+    this.setLineWidthUnchecked(asNumber(width));
+  },
+
+  setLineWidthUnchecked(width) {
     this.context.lineWidth = width;
   },
 
   setLineColor(color) {
-    assertColor(color);
+    this.setLineColorUnchecked(assertColor(color));
+  },
+
+  setLineColorUnchecked(color) {
     this.context.strokeStyle = color.text;
   },
 
   setFillColor(color) {
-    assertColor(color);
+    this.setFillColorUnchecked(assertColor(color));
+  },
+
+  setFillColorUnchecked(color) {
     this.context.fillStyle = color.text;
   }
 };
@@ -354,28 +471,41 @@ const Logo = {
   isPenDown: true,
 
   async forward(length) {
-    length = asNumber(length);
+    await this.forwardUnchecked(asNumber(length));
+  },
 
+  async forwardUnchecked(length) {
     const originalX = this.x;
     const originalY = this.y;
     this.x -= length * Math.sin(this.dir);
     this.y += length * Math.cos(this.dir);
     if (this.isPenDown) {
-      await Graphics.drawLine(originalX, originalY, this.x, this.y);
+      await Graphics.drawLineUnchecked(originalX, originalY, this.x, this.y);
     }
   },
 
   async backward(length) {
-    await this.forward(-asNumber(length));
+    await this.forwardUnchecked(-asNumber(length));
+  },
+
+  async backwardUnchecked(length) {
+    await this.forwardUnchecked(-length);
   },
 
   turnRight(degree) {
-    degree = asNumber(degree);
+    this.turnRightUnchecked(asNumber(degree));
+  },
+
+  turnRightUnchecked(degree) {
     this.dir = (this.dir + degree * MathUtils.RAD_PER_DEG) % (Math.PI * 2);
   },
 
   turnLeft(degree) {
-    this.turnRight(-asNumber(degree));
+    this.turnRightUnchecked(-asNumber(degree));
+  },
+
+  turnLeftUnchecked(degree) {
+    this.turnRightUnchecked(-degree);
   },
 
   penUp() {
@@ -388,7 +518,7 @@ const Logo = {
 
   async goHome() {
     if (this.isPenDown) {
-      await Graphics.drawLine(this.x, this.y, 0, 0);
+      await Graphics.drawLineUnchecked(this.x, this.y, 0, 0);
     }
     this.x = 0;
     this.y = 0;
@@ -396,6 +526,37 @@ const Logo = {
   }
 };
 
+// Stack traces of the statements during which the intervals pass, taken as
+// they end, or before they leave their block, and sent to the app once the
+// program stops
+const Profiler = {
+  interval: 0,
+  next: 0,
+  samples: [],
+
+  start(interval) {
+    this.interval = interval * 1000;
+    this.next = performance.now() + this.interval;
+    this.samples = [];
+  },
+
+  tick() {
+    const now = performance.now();
+    if (now >= this.next) {
+      this.samples.push(new Error().stack);
+      this.next = now + this.interval;
+    }
+  },
+
+  stop() {
+    webkit.messageHandlers.system.postMessage({
+      type: "profile",
+      samples: this.samples
+    });
+    this.samples = [];
+  }
+};
+
 window.env = {
   globals: {},
 
@@ -417,7 +578,25 @@ window.env = {
     _exec();
   },
 
+  profile(func, interval) {
+    Profiler.start(interval);
+    this.execute(async () => {
+      try {
+        await func();
+      } finally {
+        Profiler.stop();
+      }
+    });
+  },
+
+  // Passes on the result of a function returning
+  tick(result) {
+    Profiler.tick();
+    return result;
+  },
+
   sleep: sleep,
+  sleepUnchecked: sleepUnchecked,
   time: time,
   range: range,
   print: print,
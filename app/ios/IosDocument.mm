@@ -3,6 +3,13 @@
 @implementation IosDocument
 
 - (id)contentsForType:(NSString *)typeName error:(NSError **)errorPtr {
+  [self finishLoading];
+  if (auto error = self.loadingError) {
+    if (errorPtr != nil) {
+      *errorPtr = error;
+    }
+    return nil;
+  }
   return [NSData dataWithDataView:self.content.write()];
 }
 
@@ -20,6 +20,7 @@
   if (auto initialData = [self.document initialize]) {
     [self.sourceView initializeWithDisplay:std::move(initialData->display)];
     [self.lineNumberView setNeedsDisplay];
+    [self followLoadingDocument];
   }
 }
 
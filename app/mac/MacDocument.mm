@@ -26,6 +26,13 @@
 }
 
 - (NSData *)dataOfType:(NSString *)typeName error:(NSError **)outError {
+  [self finishLoading];
+  if (auto error = self.loadingError) {
+    if (outError != nil) {
+      *outError = error;
+    }
+    return nil;
+  }
   return [NSData dataWithDataView:self.content.write()];
 }
 
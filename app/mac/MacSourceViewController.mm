@@ -16,6 +16,7 @@
 
   if (auto initialData = [self.document initialize]) {
     [self.sourceView initializeWithDisplay:std::move(initialData->display)];
+    [self followLoadingDocument];
   }
 }
 
@@ -23,7 +23,7 @@
 }
 
 - (NSArray<NSToolbarItemIdentifier> *)toolbarAllowedItemIdentifiers:(NSToolbar *)toolbar {
-  return @[ @"run" ];
+  return @[ @"run", @"profile" ];
 }
 
 - (NSArray<NSToolbarItemIdentifier> *)toolbarDefaultItemIdentifiers:(NSToolbar *)toolbar {
@@ -34,9 +34,14 @@
         itemForItemIdentifier:(NSToolbarItemIdentifier)itemIdentifier
     willBeInsertedIntoToolbar:(BOOL)flag {
   auto *toolbarItem = [[NSToolbarItem alloc] initWithItemIdentifier:itemIdentifier];
-  toolbarItem.label = @"Run";
   toolbarItem.target = self;
-  toolbarItem.action = @selector(run:);
+  if ([itemIdentifier isEqualToString:@"profile"]) {
+    toolbarItem.label = @"Profile";
+    toolbarItem.action = @selector(profile:);
+  } else {
+    toolbarItem.label = @"Run";
+    toolbarItem.action = @selector(run:);
+  }
   return toolbarItem;
 }
 
@@ -49,6 +54,15 @@
   }
 }
 
+- (void)profile:(NSToolbarItem *)sender {
+  if (auto splitViewController = [NSSplitViewController cast:self.contentViewController]) {
+    if (auto *vc =
+            [SourceViewController cast:splitViewController.splitViewItems[1].viewController]) {
+      [vc executeProfiled];
+    }
+  }
+}
+
 @end
 
 @implementation ExecuteWindowController
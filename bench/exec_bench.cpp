@@ -0,0 +1,143 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "ast.hpp"
+#include "interpreter.hpp"
+#include "program_builders.hpp"
+#include "vm.hpp"
+
+// Runs small compute-heavy programs through the tree interpreter and the
+// bytecode VM, checking both print the same output
+
+namespace {
+
+using namespace marlin;
+using namespace marlin::ast;
+using namespace marlin::program_builders;
+
+node range(std::string count) {
+  return call(system_function::range1, number(std::move(count)));
+}
+
+struct workload : stored_program {
+  const char* name;
+
+  workload(const char* _name, std::vector<node> blocks)
+      : stored_program{std::move(blocks)}, name{_name} {}
+};
+
+std::deque<workload> make_workloads() {
+  std::deque<workload> result;
+
+  result.emplace_back(
+      "range_sum",
+      nodes(make<on_start>(nodes(
+          assign("sum", number("0")),
+          make<for_statement>(
+              var("i"), range("1000000"),
+              nodes(assign("sum", binary(id("sum"), binary_op::add,
+                                         binary(id("i"), binary_op::multiply,
+                                                number("0.5")))))),
+          print(id("sum"))))));
+
+  result.emplace_back(
+      "logo_spiral",
+      nodes(make<on_start>(nodes(make<for_statement>(
+          var("i"), range("100000"),
+          nodes(call(system_procedure::logo_forward,
+                     binary(id("i"), binary_op::divide, number("100"))),
+                call(system_procedure::logo_turn_right, number("89"))))))));
+
+  auto fib_left{
+      call("fib", binary(id("n"), binary_op::subtract, number("1")))};
+  auto fib_right{
+      call("fib", binary(id("n"), binary_op::subtract, number("2")))};
+  result.emplace_back(
+      "fib",
+      nodes(make<on_start>(nodes(print(call("fib", number("25"))))),
+            make<function>(
+                make<function_signature>("fib", nodes(make<parameter>("n"))),
+                nodes(make<if_statement>(
+                          binary(id("n"), binary_op::less, number("2")),
+                          nodes(make<return_result_statement>(id("n")))),
+                      make<return_result_statement>(
+                          binary(std::move(fib_left), binary_op::add,
+                                 std::move(fib_right)))))));
+
+  result.emplace_back(
+      "array_fill",
+      nodes(make<on_start>(nodes(
+          assign("a", make<new_array>(std::vector<node>{})),
+          make<for_statement>(
+              var("i"), range("100000"),
+              nodes(make<modify_array>(array_modification::append, id("a"),
+                                       nodes(id("i"))))),
+          make<for_statement>(
+              var("i"), range("100000"),
+              nodes(make<assignment>(
+                  make<subscript_set>(id("a"), id("i")),
+                  binary(make<subscript_get>(id("a"), id("i")),
+                         binary_op::multiply, number("2"))))),
+          print(call(system_function::list_length, id("a")))))));
+
+  return result;
+}
+
+template <typename operation_type>
+double measure(double min_time, operation_type&& operation) {
+  using clock = std::chrono::steady_clock;
+
+  size_t runs{0};
+  const auto start{clock::now()};
+  std::chrono::duration<double> elapsed{0};
+  do {
+    operation();
+    runs++;
+    elapsed = clock::now() - start;
+  } while (elapsed.count() < min_time);
+  return elapsed.count() / runs;
+}
+
+[[nodiscard]] std::string output_of(const exec::run_result& result) {
+  if (result.error) {
+    std::fprintf(stderr, "%s: %s\n", result.error->name().c_str(),
+                 result.error->what());
+    std::abort();
+  }
+  std::string output;
+  for (const auto& printed : result.printed) {
+    output += printed.message + '\n';
+  }
+  return output + std::to_string(result.commands.size());
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  const double min_time{argc > 1 ? std::strtod(argv[1], nullptr) : 0.5};
+
+  std::printf("%-12s %14s %14s %8s\n", "program", "interpreter ms",
+              "bytecode ms", "speedup");
+  for (auto& work : make_workloads()) {
+    const auto expected{output_of(exec::interpreter{{}}.run(work.get()))};
+    const auto module{exec::bytecode::compile(work.get())};
+    if (output_of(exec::vm{{}}.run(module)) != expected) {
+      std::fprintf(stderr, "%s: different output\n", work.name);
+      return 1;
+    }
+
+    const auto interpreted{measure(min_time, [&]() {
+      const auto result{exec::interpreter{{}}.run(work.get())};
+    })};
+    const auto compiled{measure(min_time, [&]() {
+      const auto result{exec::vm{{}}.run(module)};
+    })};
+    std::printf("%-12s %14.2f %14.2f %7.1fx\n", work.name, interpreted * 1e3,
+                compiled * 1e3, interpreted / compiled);
+  }
+  return 0;
+}
@@ -0,0 +1,294 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <regex>
+#include <string>
+#include <vector>
+
+#include "document.hpp"
+#include "formatter.hpp"
+#include "generator.hpp"
+#include "program_generator.hpp"
+#include "stacktrace.hpp"
+#include "store.hpp"
+#include "text_model.hpp"
+#include "user_function.hpp"
+
+// Counts every allocation made through the global operators, so that each
+// measurement can report allocations per run next to its throughput
+
+namespace {
+
+std::atomic<size_t> allocation_count{0};
+
+}  // namespace
+
+void* operator new(size_t size) {
+  allocation_count.fetch_add(1, std::memory_order_relaxed);
+  if (auto* p{std::malloc(size == 0 ? 1 : size)}) {
+    return p;
+  }
+  throw std::bad_alloc{};
+}
+
+void* operator new[](size_t size) { return operator new(size); }
+
+void operator delete(void* p) noexcept { std::free(p); }
+
+void operator delete[](void* p) noexcept { std::free(p); }
+
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+
+void operator delete[](void* p, size_t) noexcept { std::free(p); }
+
+namespace {
+
+using namespace marlin;
+
+struct options {
+  std::vector<size_t> sizes{1000, 10000, 100000, 1000000};
+  bench::program_shape shape;
+  size_t stack_depth{5000};
+  double min_time{0.5};
+};
+
+struct measurement {
+  double seconds;
+  size_t allocations;
+};
+
+// Runs the operation until min_time has passed, at least once
+template <typename operation_type>
+measurement measure(double min_time, operation_type&& operation) {
+  using clock = std::chrono::steady_clock;
+
+  size_t runs{0};
+  const auto allocations{allocation_count.load()};
+  const auto start{clock::now()};
+  std::chrono::duration<double> elapsed{0};
+  do {
+    operation();
+    runs++;
+    elapsed = clock::now() - start;
+  } while (elapsed.count() < min_time);
+  return {elapsed.count() / runs,
+          (allocation_count.load() - allocations) / runs};
+}
+
+void report(const char* name, size_t nodes, size_t bytes,
+            measurement result) {
+  std::printf("%-12s %10zu %12zu %10.2f %14.0f %12zu\n", name, nodes, bytes,
+              bytes / result.seconds / 1e6, nodes / result.seconds,
+              result.allocations);
+}
+
+[[nodiscard]] std::vector<size_t> parse_sizes(const char* arg) {
+  std::vector<size_t> sizes;
+  const char* p{arg};
+  while (*p != '\0') {
+    char* end;
+    const auto size{std::strtoull(p, &end, 10)};
+    if (end == p) {
+      break;
+    }
+    sizes.push_back(size);
+    p = *end == ',' ? end + 1 : end;
+  }
+  return sizes;
+}
+
+[[nodiscard]] bool parse(int argc, char* argv[], options& result) {
+  for (int i{1}; i < argc; i++) {
+    const std::string arg{argv[i]};
+    if (arg == "--help" || i + 1 == argc) {
+      return false;
+    }
+    const char* value{argv[++i]};
+    if (arg == "--sizes") {
+      result.sizes = parse_sizes(value);
+    } else if (arg == "--functions") {
+      result.shape.function_count = std::strtoull(value, nullptr, 10);
+    } else if (arg == "--depth") {
+      result.shape.depth = std::strtoull(value, nullptr, 10);
+    } else if (arg == "--width") {
+      result.shape.width = std::strtoull(value, nullptr, 10);
+    } else if (arg == "--vocabulary") {
+      result.shape.vocabulary = std::strtoull(value, nullptr, 10);
+    } else if (arg == "--seed") {
+      result.shape.seed = std::strtoull(value, nullptr, 10);
+    } else if (arg == "--stack-depth") {
+      result.stack_depth = std::strtoull(value, nullptr, 10);
+    } else if (arg == "--min-time") {
+      result.min_time = std::strtod(value, nullptr);
+    } else {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Stack trace of a recursion going through a few places of the script, as
+// JavaScriptCore writes them
+[[nodiscard]] std::string recursion_trace(const std::string& script,
+                                          size_t depth) {
+  constexpr size_t places{16};
+  const auto lines{
+      static_cast<size_t>(std::count(script.begin(), script.end(), '\n'))};
+  std::string trace;
+  for (size_t i{0}; i < depth; i++) {
+    const auto line{1 + (i % places) * 7919 % lines};
+    trace += "f@marlin:" + std::to_string(line) + ":5\n";
+  }
+  return trace;
+}
+
+// The regular expression stack traces were parsed with before, for
+// comparison
+[[nodiscard]] size_t count_frames_with_regex(std::string_view stacktrace) {
+  size_t count{0};
+  std::regex regex{"^.*?@(.*):([0-9]*):([0-9]*)$"};
+  const char* prev{stacktrace.data()};
+  const char* end{stacktrace.data() + stacktrace.size()};
+  for (const char* it{prev}; it <= end; it++) {
+    if (it == end || *it == '\n') {
+      std::cmatch match;
+      if (std::regex_match(prev, it, match, regex) &&
+          std::string_view{match[1].first, static_cast<size_t>(
+                                               match[1].length())} ==
+              "marlin") {
+        count++;
+      }
+      prev = it + 1;
+    }
+  }
+  return count;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  options opts;
+  if (!parse(argc, argv, opts)) {
+    std::fprintf(stderr,
+                 "usage: %s [--sizes 1000,10000,...] [--functions n] "
+                 "[--depth n] [--width n] [--vocabulary n] [--seed n] "
+                 "[--stack-depth n] [--min-time seconds]\n",
+                 argv[0]);
+    return 1;
+  }
+
+  std::printf("%-12s %10s %12s %10s %14s %12s\n", "operation", "nodes",
+              "bytes", "MB/s", "nodes/s", "allocs/op");
+
+  bench::program_generator generator{opts.shape};
+  for (const auto size : opts.sizes) {
+    const auto generated{generator.generate(size)};
+    const auto nodes{generated.node_count};
+    const auto data{store::write({generated.program.get()})};
+    const auto bytes{data.size()};
+
+    report("write", nodes, bytes, measure(opts.min_time, [&]() {
+             const auto result{store::write({generated.program.get()})};
+             if (result.size() != bytes) {
+               std::abort();
+             }
+           }));
+
+    report("read_nodes", nodes, bytes, measure(opts.min_time, [&]() {
+             control::temporary_user_function_table_holder table;
+             const auto result{store::read_nodes(
+                 data, table, store::type_expectation::program)};
+           }));
+
+    report("read", nodes, bytes, measure(opts.min_time, [&]() {
+             control::temporary_user_function_table_holder table;
+             const auto result{
+                 store::read(data, table, store::type_expectation::program)};
+           }));
+
+    // Emit path alone, bytes are those of the rendered text
+    const auto formatted_size{
+        format::const_formatter{}.format(generated.program).source.size()};
+    report("format", nodes, formatted_size, measure(opts.min_time, [&]() {
+             const auto result{
+                 format::const_formatter{}.format(generated.program)};
+             if (result.source.size() != formatted_size) {
+               std::abort();
+             }
+           }));
+
+    report("document", nodes, bytes, measure(opts.min_time, [&]() {
+             if (!control::document::make_document(data)) {
+               std::abort();
+             }
+           }));
+
+    // Rendered text, loaded into a text model and read back line by line
+    control::temporary_user_function_table_holder table;
+    auto read{store::read(data, table, store::type_expectation::program)};
+    const auto& display{read.display};
+    report("text_model", nodes, display.source.size(),
+           measure(opts.min_time, [&]() {
+             format::text_model model{display.source};
+             size_t size{0};
+             for (size_t line{1}; line <= model.line_count(); line++) {
+               size += model.line(line).size() + 1;
+             }
+             if (size != model.size() + 1) {
+               std::abort();
+             }
+           }));
+
+    // JavaScript of the program, through a jsast tree and written directly,
+    // bytes are those of the script
+    auto& program{*read.nodes[0]};
+    const auto script_size{exec::generator{}.generate(program).size()};
+    for (const auto mode :
+         {exec::generator::output::tree, exec::generator::output::stream}) {
+      report(mode == exec::generator::output::tree ? "js_tree" : "js_stream",
+             nodes, script_size, measure(opts.min_time, [&]() {
+               const auto script{exec::generator{mode}.generate(program)};
+               if (script.size() != script_size) {
+                 std::abort();
+               }
+             }));
+    }
+
+    // Frames of a deep recursion, parsed alone then located through the
+    // source map, without and with a cache; nodes are frames here
+    exec::source_map map;
+    const auto trace{recursion_trace(
+        exec::generator{}.generate(program, map), opts.stack_depth)};
+    const auto depth{opts.stack_depth};
+    report("stack_regex", depth, trace.size(), measure(opts.min_time, [&]() {
+             if (count_frames_with_regex(trace) != depth) {
+               std::abort();
+             }
+           }));
+    report("stack_parse", depth, trace.size(), measure(opts.min_time, [&]() {
+             if (exec::parse_stacktrace(trace, "marlin").size() != depth) {
+               std::abort();
+             }
+           }));
+    report("stack_locate", depth, trace.size(),
+           measure(opts.min_time, [&]() {
+             if (exec::parse_stacktrace(trace, "marlin", map, program)
+                     .size() != depth) {
+               std::abort();
+             }
+           }));
+    report("stack_cached", depth, trace.size(),
+           measure(opts.min_time, [&]() {
+             exec::frame_cache cache;
+             if (exec::parse_stacktrace(trace, "marlin", map, program, &cache)
+                     .size() != depth) {
+               std::abort();
+             }
+           }));
+  }
+  return 0;
+}
@@ -0,0 +1,202 @@
+#include "program_generator.hpp"
+
+#include <iterator>
+#include <utility>
+
+namespace marlin::bench {
+
+program_generator::program_generator(program_shape shape)
+    : _shape{shape}, _state{shape.seed} {
+  if (_shape.vocabulary == 0) {
+    _shape.vocabulary = 1;
+  }
+  if (_shape.width == 0) {
+    _shape.width = 1;
+  }
+}
+
+generated_program program_generator::generate(size_t node_count) {
+  _state = _shape.seed;
+  _node_count = 0;
+
+  _variables.clear();
+  for (size_t i{0}; i < _shape.vocabulary; i++) {
+    _variables.emplace_back("var" + std::to_string(i));
+  }
+  _functions.clear();
+  _function_params.clear();
+  for (size_t i{0}; i < _shape.function_count; i++) {
+    _functions.emplace_back("func" + std::to_string(i));
+    _function_params.emplace_back(pick(4));
+  }
+
+  // The last block is on start
+  const auto block_count{_shape.function_count + 1};
+  std::vector<std::vector<ast::node>> statements(block_count);
+  for (size_t i{0}; _node_count < node_count; i = (i + 1) % block_count) {
+    const bool in_function{i < _shape.function_count};
+    statements[i].emplace_back(
+        make_statement(_shape.depth, in_function, false));
+  }
+
+  std::vector<ast::node> blocks;
+  for (size_t i{0}; i < _shape.function_count; i++) {
+    std::vector<ast::node> params;
+    for (size_t j{0}; j < _function_params[i]; j++) {
+      params.emplace_back(make<ast::parameter>("param" + std::to_string(j)));
+    }
+    blocks.emplace_back(make<ast::function>(
+        make<ast::function_signature>(_functions[i], std::move(params)),
+        std::move(statements[i])));
+  }
+  blocks.emplace_back(make<ast::on_start>(std::move(statements.back())));
+
+  auto program{make<ast::program>(std::move(blocks))};
+  return {std::move(program), _node_count};
+}
+
+// splitmix64, so that programs do not depend on the standard library
+uint64_t program_generator::next() {
+  uint64_t z{_state += 0x9e3779b97f4a7c15};
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+  return z ^ (z >> 31);
+}
+
+size_t program_generator::pick(size_t count) {
+  return static_cast<size_t>(next() % count);
+}
+
+template <typename node_type, typename... arg_types>
+ast::node program_generator::make(arg_types&&... args) {
+  _node_count++;
+  return ast::make<node_type>(std::forward<arg_types>(args)...);
+}
+
+const std::string& program_generator::variable() {
+  return _variables[pick(_variables.size())];
+}
+
+ast::node program_generator::make_statement(size_t depth, bool in_function,
+                                            bool in_loop) {
+  const auto kind{pick(depth > 0 ? 10 : 5)};
+  switch (kind) {
+    case 0:
+    case 1: {
+      // Arguments are built first, as their order of evaluation is unspecified
+      auto variable_node{make<ast::variable_name>(variable())};
+      return make<ast::assignment>(std::move(variable_node),
+                                   make_expression(_shape.width));
+    }
+    case 2: {
+      std::vector<ast::node> args;
+      args.emplace_back(make_expression(_shape.width));
+      return make<ast::system_procedure_call>(ast::system_procedure::print,
+                                              std::move(args));
+    }
+    case 3:
+      if (!_functions.empty()) {
+        return make<ast::eval_statement>(make_call());
+      }
+      return make<ast::use_global>(make<ast::variable_name>(variable()));
+    case 4:
+      if (in_function) {
+        return make<ast::return_result_statement>(
+            make_expression(_shape.width));
+      }
+      if (in_loop) {
+        return make<ast::break_statement>();
+      }
+      return make<ast::use_global>(make<ast::variable_name>(variable()));
+    case 5:
+    case 6: {
+      auto condition{make_expression(_shape.width)};
+      return make<ast::if_statement>(
+          std::move(condition),
+          make_statements(depth - 1, in_function, in_loop));
+    }
+    case 7: {
+      auto condition{make_expression(_shape.width)};
+      auto consequence{make_statements(depth - 1, in_function, in_loop)};
+      return make<ast::if_else_statement>(
+          std::move(condition), std::move(consequence),
+          make_statements(depth - 1, in_function, in_loop));
+    }
+    case 8: {
+      auto condition{make_expression(_shape.width)};
+      return make<ast::while_statement>(
+          std::move(condition), make_statements(depth - 1, in_function, true));
+    }
+    default: {
+      auto variable_node{make<ast::variable_name>(variable())};
+      std::vector<ast::node> elements;
+      for (size_t i{0}; i < _shape.width; i++) {
+        elements.emplace_back(make_leaf());
+      }
+      auto list{make<ast::new_array>(std::move(elements))};
+      return make<ast::for_statement>(std::move(variable_node),
+                                      std::move(list),
+                                      make_statements(depth - 1, in_function,
+                                                      true));
+    }
+  }
+}
+
+std::vector<ast::node> program_generator::make_statements(size_t depth,
+                                                          bool in_function,
+                                                          bool in_loop) {
+  std::vector<ast::node> result;
+  const auto count{1 + pick(3)};
+  for (size_t i{0}; i < count; i++) {
+    result.emplace_back(make_statement(depth, in_function, in_loop));
+  }
+  return result;
+}
+
+ast::node program_generator::make_expression(size_t width) {
+  if (width <= 1) {
+    return make_leaf();
+  }
+
+  static constexpr ast::binary_op ops[]{
+      ast::binary_op::add,  ast::binary_op::subtract, ast::binary_op::multiply,
+      ast::binary_op::divide, ast::binary_op::less,   ast::binary_op::equal,
+      ast::binary_op::logical_and};
+  const auto left_width{1 + pick(width - 1)};
+  auto left{make_expression(left_width)};
+  const auto op{ops[pick(std::size(ops))]};
+  return make<ast::binary_expression>(std::move(left), op,
+                                      make_expression(width - left_width));
+}
+
+ast::node program_generator::make_leaf() {
+  switch (pick(8)) {
+    case 0:
+    case 1:
+    case 2:
+      return make<ast::identifier>(variable());
+    case 3:
+    case 4:
+      return make<ast::number_literal>(std::to_string(pick(1000)));
+    case 5:
+      return make<ast::string_literal>("text" + std::to_string(pick(16)));
+    case 6:
+      return make<ast::bool_literal>(pick(2) == 0);
+    default:
+      if (!_functions.empty()) {
+        return make_call();
+      }
+      return make<ast::identifier>(variable());
+  }
+}
+
+ast::node program_generator::make_call() {
+  const auto index{pick(_functions.size())};
+  std::vector<ast::node> args;
+  for (size_t i{0}; i < _function_params[index]; i++) {
+    args.emplace_back(make_leaf());
+  }
+  return make<ast::user_function_call>(_functions[index], std::move(args));
+}
+
+}  // namespace marlin::bench
@@ -0,0 +1,65 @@
+#ifndef marlin_bench_program_generator_hpp
+#define marlin_bench_program_generator_hpp
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "ast.hpp"
+
+namespace marlin::bench {
+
+struct program_shape {
+  size_t function_count{16};
+  // Levels of nested control flow inside a statement
+  size_t depth{3};
+  // Leaves of each generated expression
+  size_t width{4};
+  // Distinct variable names in use
+  size_t vocabulary{64};
+  uint64_t seed{1};
+};
+
+struct generated_program {
+  ast::node program;
+  size_t node_count;
+};
+
+// Builds the same program for the same shape and size on every platform,
+// adding statements to the blocks in turn until node_count is reached
+struct program_generator {
+  explicit program_generator(program_shape shape);
+
+  [[nodiscard]] generated_program generate(size_t node_count);
+
+ private:
+  program_shape _shape;
+  uint64_t _state;
+  size_t _node_count{0};
+
+  std::vector<std::string> _variables;
+  std::vector<std::string> _functions;
+  std::vector<size_t> _function_params;
+
+  [[nodiscard]] uint64_t next();
+  [[nodiscard]] size_t pick(size_t count);
+
+  template <typename node_type, typename... arg_types>
+  [[nodiscard]] ast::node make(arg_types&&... args);
+
+  [[nodiscard]] const std::string& variable();
+
+  // Breaks only appear in loops, results are only returned in functions
+  [[nodiscard]] ast::node make_statement(size_t depth, bool in_function,
+                                         bool in_loop);
+  [[nodiscard]] std::vector<ast::node> make_statements(size_t depth,
+                                                      bool in_function,
+                                                      bool in_loop);
+  [[nodiscard]] ast::node make_expression(size_t width);
+  [[nodiscard]] ast::node make_leaf();
+  [[nodiscard]] ast::node make_call();
+};
+
+}  // namespace marlin::bench
+
+#endif  // marlin_bench_program_generator_hpp
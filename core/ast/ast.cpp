@@ -42,10 +42,14 @@ bool user_function_call::assign_definition(const function_definition* func) {
         if (placeholder.name != _func->parameters[i]) {
           changed = true;
           placeholder.name = _func->parameters[i];
+          placeholder.touch();
         }
       }
     }
 
+    if (changed) {
+      touch();
+    }
     return changed;
   }
 }
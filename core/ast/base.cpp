@@ -1,7 +1,22 @@
 #include "base.hpp"
 
+#include <atomic>
+
 namespace marlin::ast {
 
+uint64_t base::next_revision() noexcept {
+  // Documents are read on several threads at once
+  static std::atomic<uint64_t> _next{1};
+  return _next.fetch_add(1, std::memory_order_relaxed);
+}
+
+void base::touch() noexcept {
+  const auto revision{next_revision()};
+  for (auto* curr{this}; curr != nullptr; curr = curr->_parent) {
+    curr->_revision = revision;
+  }
+}
+
 base &base::locate(source_loc loc) {
   for (auto &child : children()) {
     if (child->contains(loc)) {
@@ -20,22 +35,4 @@ const base &base::locate(source_loc loc) const {
   return *this;
 }
 
-base &base::locate_js(source_loc loc) {
-  for (auto &child : children()) {
-    if (child->_js_range.contains(loc)) {
-      return child->locate_js(loc);
-    }
-  }
-  return *this;
-}
-
-const base &base::locate_js(source_loc loc) const {
-  for (const auto &child : children()) {
-    if (child->_js_range.contains(loc)) {
-      return child->locate_js(loc);
-    }
-  }
-  return *this;
-}
-
 }  // namespace marlin::ast
@@ -1,6 +1,7 @@
 #ifndef marlin_ast_base_impl
 #define marlin_ast_base_impl
 
+#include <cstdint>
 #include <optional>
 #include <tuple>
 #include <type_traits>
@@ -13,15 +14,9 @@
 
 namespace marlin {
 
-namespace exec {
-struct generator;
-}
-
 namespace ast {
 
 struct base {
-  friend exec::generator;
-
   friend subnode::concrete_view<base>;
   friend subnode::vector_view<base>;
 
@@ -78,8 +73,13 @@ struct base {
   [[nodiscard]] base &locate(source_loc loc);
   [[nodiscard]] const base &locate(source_loc loc) const;
 
-  [[nodiscard]] base &locate_js(source_loc loc);
-  [[nodiscard]] const base &locate_js(source_loc loc) const;
+  // Stamp unique among all nodes, renewed whenever the node or any of its
+  // descendants is modified
+  [[nodiscard]] uint64_t revision() const noexcept { return _revision; }
+
+  // Must be called after modifying the fields of a node, subnode changes are
+  // recorded automatically
+  void touch() noexcept;
 
   [[nodiscard]] bool has_parent() const noexcept { return _parent != nullptr; }
   [[nodiscard]] base &parent() { return *_parent; }
@@ -99,6 +99,7 @@ struct base {
       replacement->_parent = this;
       auto result{std::exchange(_children[i], std::move(replacement))};
       result->_parent = nullptr;
+      touch();
       return result;
     } else {
       /* should not occur */
@@ -118,12 +119,15 @@ struct base {
   std::vector<node> _children;
   base *_parent{nullptr};
 
-  source_range _js_range;
+  uint64_t _revision;
 
-  explicit base(size_t tid, size_t subnode_count) : _typeid{tid} {
+  explicit base(size_t tid, size_t subnode_count)
+      : _typeid{tid}, _revision{next_revision()} {
     _children.reserve(subnode_count);
   }
 
+  [[nodiscard]] static uint64_t next_revision() noexcept;
+
   void apply_update_subnode_refs() {
     apply<void>([](auto &n) { n.update_subnode_refs(); });
   }
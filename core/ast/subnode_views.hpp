@@ -21,6 +21,7 @@ struct concrete_view {
     auto& ref{_data()[_con->index]};
     ref = std::move(other);
     ref->_parent = _base;
+    _base->touch();
   }
 
   decltype(auto) operator*() const { return *(_data()[_con->index]); }
@@ -35,6 +36,7 @@ struct concrete_view {
     auto item{std::exchange(ref, std::move(other))};
     item->_parent = nullptr;
     ref->_parent = _base;
+    _base->touch();
     return item;
   }
 
@@ -107,6 +109,7 @@ struct vector_view {
     (*this)[pos]->_parent = _base;
     _vec->size++;
     _base->apply_update_subnode_refs();
+    _base->touch();
     return (*this)[pos];
   }
 
@@ -122,6 +125,7 @@ struct vector_view {
     _data().erase(it);
     _vec->size--;
     _base->apply_update_subnode_refs();
+    _base->touch();
     return item;
   }
 
@@ -130,6 +134,7 @@ struct vector_view {
     auto item{std::exchange(ref, std::move(other))};
     item->_parent = nullptr;
     ref->_parent = _base;
+    _base->touch();
     return item;
   }
 
@@ -138,6 +143,7 @@ struct vector_view {
       _data().erase(begin(), end());
       _vec->size = 0;
       _base->apply_update_subnode_refs();
+      _base->touch();
     }
   }
 
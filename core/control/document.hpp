@@ -5,6 +5,7 @@
 #include <string>
 #include <string_view>
 #include <utility>
+#include <vector>
 
 // Testing
 #include <iostream>
@@ -12,7 +13,9 @@
 #include "base.hpp"
 #include "formatter.hpp"
 #include "generator.hpp"
+#include "profile.hpp"
 #include "source_update.hpp"
+#include "stacktrace.hpp"
 #include "store.hpp"
 #include "toolbox.hpp"
 #include "user_function.hpp"
@@ -30,6 +33,7 @@ struct document final : store::user_function_table_interface {
   template <pasteboard_t node_type, typename>
   friend struct expr_inserter;
   friend struct source_selection;
+  friend struct progressive_document;
 
   static store::data_view default_data() {
     static const store::data_vector _data{[]() {
@@ -55,6 +59,21 @@ struct document final : store::user_function_table_interface {
     }
   }
 
+  static std::optional<std::pair<document, source_update>>
+  make_document_from_file(const std::string& path) {
+    try {
+      temporary_user_function_table_holder table;
+      auto result{
+          store::read_file(path, table, store::type_expectation::program)};
+      assert(result.nodes.size() == 1);
+      return std::make_pair(
+          document{std::move(result.nodes[0]), std::move(table).get()},
+          source_update{{{1, 1}, {1, 1}}, std::move(result.display)});
+    } catch (const store::read_error&) {
+      return std::nullopt;
+    }
+  }
+
   explicit document(ast::node program, user_function_table table) noexcept
       : _program(std::move(program)), _functions{std::move(table)} {}
 
@@ -65,15 +84,49 @@ struct document final : store::user_function_table_interface {
     return _program->locate(loc);
   }
 
-  [[nodiscard]] std::string generate_executable_code() {
-    exec::generator gen;
-    return gen.generate(*_program);
+  // Profiled code samples the running statement about every
+  // profile_interval seconds
+  [[nodiscard]] std::string generate_executable_code(
+      double profile_interval = 0) {
+    exec::generator gen{_scripts, _calls};
+    gen.set_profile_interval(profile_interval);
+    _frames.clear();
+    return gen.generate(*_program, _js_map);
+  }
+
+  // Nodes of the frames of an error thrown by the code last generated, run
+  // from source_url
+  [[nodiscard]] std::vector<ast::base*> locate_stacktrace(
+      std::string_view stacktrace, std::string_view source_url) {
+    return exec::parse_stacktrace(stacktrace, source_url, _js_map, *_program,
+                                  &_frames);
+  }
+
+  // Samples of a profiled run of the code last generated, run from
+  // source_url
+  [[nodiscard]] exec::profile profile_of(
+      const std::vector<std::string>& samples, std::string_view source_url) {
+    exec::profile result;
+    for (const auto& sample : samples) {
+      result.add_sample(sample, source_url, _js_map, &_frames);
+    }
+    return result;
+  }
+
+  // Nodes of the code last generated, until the document is edited
+  [[nodiscard]] const exec::source_map& executable_source_map() const {
+    return _js_map;
   }
 
   auto& functions() { return _functions.map(); }
 
   store::data_vector write() const { return store::write({_program.get()}); }
 
+  // Passes the source to the sink as it is formatted, for large documents
+  void write_source(format::sink& output) const {
+    format::const_formatter{}.format_to(output, *_program);
+  }
+
   void register_toolbox(std::weak_ptr<toolbox> model) {
     _functions.set_toolbox(std::move(model));
   }
@@ -81,22 +134,36 @@ struct document final : store::user_function_table_interface {
  private:
   ast::node _program;
   user_function_table _functions;
+  format::fragment_cache _fragments;
+  exec::js_cache _scripts;
+  exec::call_graph _calls;
+  exec::source_map _js_map;
+  exec::frame_cache _frames;
 
-  std::vector<ast::base*> _side_effects;
+  // Nodes to refresh, with their display before the change
+  std::vector<std::pair<ast::base*, format::display>> _side_effects;
 
   // Convenient functions to modify _program
   // Implemented for use of friend structs
 
-  void start_recording_side_effects() { _side_effects.clear(); }
+  // The nodes of the code last generated may be freed from now on
+  void start_recording_side_effects() {
+    _side_effects.clear();
+    _js_map.clear();
+    _frames.clear();
+  }
   void gather_side_effects(std::vector<source_update>& updates) {
-    for (auto node : _side_effects) {
-      updates.emplace_back(refresh_node_display(*node));
+    for (auto& [node, previous] : _side_effects) {
+      updates.emplace_back(refresh_node_display(*node, previous));
     }
     _side_effects.clear();
+    if (_fragments.needs_retain()) {
+      _fragments.retain(*_program);
+    }
   }
 
   source_update refresh_node_display(ast::base& node) {
-    format::in_place_formatter formatter;
+    format::in_place_formatter formatter{_fragments};
     auto original{node.source_code_range};
     auto display{formatter.format(node, node)};
     source_update result{original, std::move(display)};
@@ -111,6 +178,17 @@ struct document final : store::user_function_table_interface {
     return result;
   }
 
+  // Also computes the deltas of the update from the display of the node
+  // before it was modified, for nodes on a single line
+  source_update refresh_node_display(ast::base& node,
+                                     const format::display& previous) {
+    auto result{refresh_node_display(node)};
+    if (result.range.begin.line == result.range.end.line) {
+      result.compute_deltas(previous);
+    }
+    return result;
+  }
+
   ast::node replace_expression(ast::base& existing, ast::node replacement) {
     assert(existing.has_parent());
 
@@ -330,8 +408,7 @@ struct document final : store::user_function_table_interface {
     }
   }
 
-  [[nodiscard]] const bool has_function(
-      const std::string& name) const override {
+  [[nodiscard]] bool has_function(const std::string& name) const override {
     return _functions.has_function(name);
   }
 
@@ -353,7 +430,7 @@ struct document final : store::user_function_table_interface {
     assign_user_call_definition(name, &definition);
   }
 
-  void remove_function(const std::string& name) {
+  void remove_function(const std::string& name) override {
     _functions.remove_function(name);
     assign_user_call_definition(name, nullptr);
   }
@@ -382,8 +459,11 @@ struct document final : store::user_function_table_interface {
     if (node.is<ast::user_function_call>()) {
       auto& call{node.as<ast::user_function_call>()};
       if (call.name == name) {
+        auto previous{needs_update
+                          ? format::const_formatter{}.format(call, call)
+                          : format::display{}};
         if (call.assign_definition(definition) && needs_update) {
-          _side_effects.emplace_back(&call);
+          _side_effects.emplace_back(&call, std::move(previous));
           needs_update = false;
         }
       }
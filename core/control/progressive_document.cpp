@@ -0,0 +1,233 @@
+#include "progressive_document.hpp"
+
+#include <condition_variable>
+#include <mutex>
+#include <unordered_set>
+
+#include "user_function.hpp"
+
+namespace marlin::control {
+
+// State shared with the background thread
+struct progressive_document::loader {
+  store::program_reader reader;
+  std::vector<function_definition> functions;
+
+  std::mutex mutex;
+  std::condition_variable ready;
+  std::vector<batch> batches;
+  bool finished{false};
+  bool failed{false};
+  bool stopped{false};
+
+  explicit loader(store::program_reader _reader)
+      : reader{std::move(_reader)}, functions{reader.functions()} {}
+};
+
+std::optional<std::pair<progressive_document, source_update>>
+progressive_document::open(store::data_view data, size_t first_lines,
+                           size_t batch_lines) {
+  std::optional<store::program_reader> reader;
+  try {
+    reader.emplace(store::data_vector{data.begin(), data.end()});
+  } catch (const store::read_error&) {
+    // Either not a program or saved without a directory
+    auto result{document::make_document(data)};
+    if (!result.has_value()) {
+      return std::nullopt;
+    }
+    progressive_document doc{std::move(result->first)};
+    doc._complete = true;
+    return std::make_pair(std::move(doc), std::move(result->second));
+  }
+
+  temporary_user_function_table_holder table;
+  for (const auto& function : reader->functions()) {
+    table.add_function(function);
+  }
+  auto program{ast::make<ast::program>(std::vector<ast::node>{})};
+  program->source_code_range = {{1, 1}, {1, 1}};
+  progressive_document doc{
+      document{std::move(program), std::move(table).get()}};
+
+  std::vector<source_update> updates;
+  try {
+    doc.hand_over(read_batch(*reader, first_lines), updates);
+  } catch (const store::read_error&) {
+    return std::nullopt;
+  }
+  assert(updates.size() == 1);
+
+  if (reader->done()) {
+    doc._complete = true;
+  } else {
+    doc._loader = std::make_shared<loader>(*std::move(reader));
+    doc._worker = std::thread{run, doc._loader, batch_lines};
+  }
+  return std::make_pair(std::move(doc), std::move(updates[0]));
+}
+
+progressive_document::~progressive_document() noexcept {
+  if (_worker.joinable()) {
+    {
+      std::lock_guard lock{_loader->mutex};
+      _loader->stopped = true;
+    }
+    _worker.join();
+  }
+}
+
+std::vector<source_update> progressive_document::poll() {
+  if (_loader == nullptr) {
+    return {};
+  }
+
+  std::vector<batch> batches;
+  bool finished;
+  {
+    std::lock_guard lock{_loader->mutex};
+    batches = std::exchange(_loader->batches, {});
+    finished = _loader->finished;
+    _failed = _loader->failed;
+  }
+  auto updates{hand_over(std::move(batches))};
+  if (finished) {
+    _worker.join();
+    if (_failed) {
+      remove_missing_functions();
+    }
+    _loader.reset();
+    _complete = true;
+  }
+  return updates;
+}
+
+std::vector<source_update> progressive_document::finish() {
+  if (_loader != nullptr) {
+    std::unique_lock lock{_loader->mutex};
+    _loader->ready.wait(lock, [this]() { return _loader->finished; });
+  }
+  return poll();
+}
+
+progressive_document::batch progressive_document::read_batch(
+    store::program_reader& reader, size_t lines) {
+  batch result;
+  std::string source;
+  std::vector<format::highlight_token> highlights;
+  format::in_place_formatter formatter;
+  while (!reader.done() && result.lines < lines) {
+    auto block{reader.read_block()};
+    // Blocks are formatted from line 1 of the batch, then moved when handed
+    // over to the line after the end of the document
+    auto display{formatter.format(*block, result.lines + 1)};
+    result.lines = block->source_code_range.end.line;
+
+    const auto offset{source.size()};
+    source.append(display.source);
+    for (const auto& token : display.highlights) {
+      highlights.emplace_back(token.type, token.offset + offset, token.length);
+    }
+    result.blocks.emplace_back(std::move(block));
+  }
+  result.display = {std::move(source), std::move(highlights)};
+  return result;
+}
+
+void progressive_document::run(std::shared_ptr<loader> shared,
+                               size_t batch_lines) {
+  bool failed{false};
+  try {
+    while (!shared->reader.done()) {
+      {
+        std::lock_guard lock{shared->mutex};
+        if (shared->stopped) {
+          break;
+        }
+      }
+      auto next{read_batch(shared->reader, batch_lines)};
+      std::lock_guard lock{shared->mutex};
+      shared->batches.emplace_back(std::move(next));
+      shared->ready.notify_all();
+    }
+  } catch (const store::read_error&) {
+    failed = true;
+  }
+
+  std::lock_guard lock{shared->mutex};
+  shared->failed = failed;
+  shared->finished = true;
+  shared->ready.notify_all();
+}
+
+std::vector<source_update> progressive_document::hand_over(
+    std::vector<batch> batches) {
+  std::vector<source_update> updates;
+  for (auto& b : batches) {
+    hand_over(std::move(b), updates);
+  }
+  return updates;
+}
+
+void progressive_document::hand_over(batch b,
+                                     std::vector<source_update>& updates) {
+  auto& program{_document._program->as<ast::program>()};
+  // Lines of the program end with a line break, so the end of the program
+  // is the start of the line after its last block
+  const auto line{program.source_code_range.end.line};
+
+  // Calls are bound to the functions of the reader until now
+  std::vector<ast::user_function_call*> changed_calls;
+  const auto bind{[this, &changed_calls](const auto& self,
+                                         ast::base& node) -> void {
+    if (node.is<ast::user_function_call>()) {
+      auto& call{node.as<ast::user_function_call>()};
+      const auto* definition{_document.has_function(call.name)
+                                 ? &_document.get_function(call.name)
+                                 : nullptr};
+      if (call.assign_definition(definition)) {
+        changed_calls.emplace_back(&call);
+      }
+    }
+    for (auto& child : node.children()) {
+      self(self, *child);
+    }
+  }};
+
+  auto blocks{program.blocks()};
+  for (auto& block : b.blocks) {
+    if (line > 1) {
+      format::shift_lines(*block, static_cast<ptrdiff_t>(line) - 1);
+    }
+    bind(bind, *block);
+    blocks.emplace_back(std::move(block));
+  }
+  program.source_code_range.end.line += b.lines;
+
+  updates.emplace_back(source_range{{line, 1}, {line, 1}},
+                       std::move(b.display));
+  // Functions may have been changed since the data was saved
+  for (auto* call : changed_calls) {
+    updates.emplace_back(_document.refresh_node_display(*call));
+  }
+}
+
+void progressive_document::remove_missing_functions() {
+  std::unordered_set<std::string> names;
+  for (const auto& block : _document._program->children()) {
+    if (block->is<ast::function>()) {
+      const auto& signature{*block->as<ast::function>().signature()};
+      if (signature.is<ast::function_signature>()) {
+        names.emplace(signature.as<ast::function_signature>().name);
+      }
+    }
+  }
+  for (const auto& function : _loader->functions) {
+    if (names.find(function.name) == names.end() &&
+        _document.has_function(function.name)) {
+      _document.remove_function(function.name);
+    }
+  }
+}
+
+}  // namespace marlin::control
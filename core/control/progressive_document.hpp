@@ -0,0 +1,74 @@
+#ifndef marlin_control_progressive_document_hpp
+#define marlin_control_progressive_document_hpp
+
+#include <memory>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "document.hpp"
+#include "source_update.hpp"
+#include "store.hpp"
+
+namespace marlin::control {
+
+// Opens a document showing its first lines right away, while the remaining
+// blocks are decoded and formatted on a background thread. Those are handed
+// over by poll() in batches, as lines inserted at the end of the document.
+// Until then the document only holds the blocks handed over, with consistent
+// source ranges, so finish() must be called before saving or running it.
+// Data saved without a function directory is opened in one pass.
+struct progressive_document {
+  [[nodiscard]] static std::optional<
+      std::pair<progressive_document, source_update>>
+  open(store::data_view data, size_t first_lines = 200,
+       size_t batch_lines = 2000);
+
+  progressive_document(progressive_document&&) noexcept = default;
+  ~progressive_document() noexcept;
+
+  [[nodiscard]] document& content() noexcept { return _document; }
+  [[nodiscard]] const document& content() const noexcept { return _document; }
+
+  // Every block has been handed over, or reading them has failed
+  [[nodiscard]] bool is_complete() const noexcept { return _complete; }
+  // The blocks after those handed over could not be read
+  [[nodiscard]] bool has_failed() const noexcept { return _failed; }
+
+  // Hands over the blocks formatted since the last call
+  [[nodiscard]] std::vector<source_update> poll();
+  // Waits for the remaining blocks and hands them over
+  [[nodiscard]] std::vector<source_update> finish();
+
+ private:
+  struct batch {
+    std::vector<ast::node> blocks;
+    format::display display;
+    size_t lines{0};
+  };
+
+  struct loader;
+
+  document _document;
+  std::shared_ptr<loader> _loader;
+  std::thread _worker;
+  bool _complete{false};
+  bool _failed{false};
+
+  explicit progressive_document(document doc) noexcept
+      : _document{std::move(doc)} {}
+
+  [[nodiscard]] static batch read_batch(store::program_reader& reader,
+                                        size_t lines);
+  static void run(std::shared_ptr<loader> shared, size_t batch_lines);
+
+  [[nodiscard]] std::vector<source_update> hand_over(
+      std::vector<batch> batches);
+  void hand_over(batch b, std::vector<source_update>& updates);
+  void remove_missing_functions();
+};
+
+}  // namespace marlin::control
+
+#endif  // marlin_control_progressive_document_hpp
@@ -19,10 +19,7 @@ struct prototype {
       : name{std::move(_name)},
         type{_type},
         data{store::write({_node.get()})},
-        display{formatter.format(*_node)} {}
-
- private:
-  inline static format::const_formatter formatter;
+        display{format::const_formatter{}.format(*_node)} {}
 };
 
 inline prototype function_prototype() {
@@ -12,6 +12,10 @@ std::vector<source_update> source_selection::set_new_array_elements_count(
 
   auto elements{_selection->as<ast::new_array>().elements()};
   const bool need_refresh = elements.size() != count;
+  const auto previous{need_refresh
+                          ? format::const_formatter{}.format(*_selection,
+                                                             *_selection)
+                          : format::display{}};
   if (elements.size() < count) {
     for (auto i{elements.size()}; i < count; i++) {
       elements.emplace_back(ast::make<ast::expression_placeholder>(
@@ -30,7 +34,7 @@ std::vector<source_update> source_selection::set_new_array_elements_count(
 
   assert(elements.size() == count);
   if (need_refresh) {
-    result.emplace_back(_doc->refresh_node_display(*_selection));
+    result.emplace_back(_doc->refresh_node_display(*_selection, previous));
   }
 
   _doc->gather_side_effects(result);
@@ -44,7 +48,10 @@ std::vector<source_update> source_selection::set_color_literal(
   std::vector<source_update> result;
   _doc->start_recording_side_effects();
 
+  const auto previous{
+      format::const_formatter{}.format(*_selection, *_selection)};
   _selection->as<ast::new_color>().mode = literal.mode;
+  _selection->touch();
   auto args{_selection->as<ast::new_color>().arguments()};
   args.clear();
   for (size_t i{0}; i < literal.data_dimension(); i++) {
@@ -54,7 +61,7 @@ std::vector<source_update> source_selection::set_color_literal(
   }
 
   assert(args.size() == literal.data_dimension());
-  result.emplace_back(_doc->refresh_node_display(*_selection));
+  result.emplace_back(_doc->refresh_node_display(*_selection, previous));
 
   _doc->gather_side_effects(result);
   return result;
@@ -207,10 +214,16 @@ document_update source_selection::replace_function_signature(
     }
     result.selection_update = source_selection{*_doc, *node, dropping_rule};
 
+    const auto previous{
+        format::const_formatter{}.format(*_selection, *_selection)};
     format::in_place_formatter formatter;
     auto display{formatter.format(node, *_selection)};
 
-    result.source_updates.emplace_back(original_range, std::move(display));
+    auto& update{
+        result.source_updates.emplace_back(original_range, std::move(display))};
+    if (original_range.begin.line == original_range.end.line) {
+      update.compute_deltas(previous);
+    }
 
     if (_selection->is<ast::function_signature>()) {
       const auto& previous_name{_selection->as<ast::function_signature>().name};
@@ -1,20 +1,55 @@
 #ifndef marlin_control_source_update_hpp
 #define marlin_control_source_update_hpp
 
+#include <cassert>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include "formatter.hpp"
+#include "text_diff.hpp"
+#include "utf8.hpp"
 #include "utils.hpp"
 
 namespace marlin::control {
 
+// Replacement of some columns inside the range of a source_update
+struct source_delta {
+  source_range range;
+  format::display display;
+};
+
 struct source_update {
   source_range range;
   format::display display;
+  // Optional finer form of an update replacing part of a line: applied in
+  // turn, the deltas give the same text as the range and display while only
+  // replacing the columns that changed. They go from the end of the line to
+  // its start, so applying one leaves the columns of the next valid.
+  std::vector<source_delta> deltas;
 
   source_update(source_range _range, format::display _display)
       : range{_range}, display{std::move(_display)} {}
+
+  // Computes the deltas from what the range displayed before the update
+  void compute_deltas(const format::display& original) {
+    assert(range.begin.line == range.end.line);
+    assert(range.end.column - range.begin.column ==
+           format::codepoint_count(original.source));
+    deltas.clear();
+    auto edits{format::diff(original, display)};
+    const std::string_view source{original.source};
+    for (auto edit{edits.rbegin()}; edit != edits.rend(); ++edit) {
+      const auto column{
+          range.begin.column +
+          format::codepoint_count(source.substr(0, edit->offset))};
+      const auto columns{
+          format::codepoint_count(source.substr(edit->offset, edit->length))};
+      deltas.push_back({{{range.begin.line, column},
+                         {range.begin.line, column + columns}},
+                        std::move(edit->replacement)});
+    }
+  }
 };
 
 }  // namespace marlin::control
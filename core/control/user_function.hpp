@@ -24,7 +24,7 @@ struct user_function_table {
 
   [[nodiscard]] const auto& map() const { return _map; }
 
-  [[nodiscard]] const bool has_function(const std::string& name) const {
+  [[nodiscard]] bool has_function(const std::string& name) const {
     return _map.find(name) != _map.end();
   }
 
@@ -87,8 +87,7 @@ struct temporary_user_function_table_holder final
     : store::user_function_table_interface {
   [[nodiscard]] user_function_table get() && { return std::move(_functions); }
 
-  [[nodiscard]] const bool has_function(
-      const std::string& name) const override {
+  [[nodiscard]] bool has_function(const std::string& name) const override {
     return _functions.has_function(name);
   }
 
@@ -102,6 +101,10 @@ struct temporary_user_function_table_holder final
     _functions.add_function(std::move(signature));
   }
 
+  void remove_function(const std::string& name) override {
+    _functions.remove_function(name);
+  }
+
  private:
   user_function_table _functions;
 };
@@ -0,0 +1,105 @@
+#ifndef marlin_exec_bytecode_hpp
+#define marlin_exec_bytecode_hpp
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "ast.hpp"
+#include "runtime.hpp"
+
+namespace marlin::exec::bytecode {
+
+// Register-based instructions: each function has a window of registers, its
+// locals first, then the temporaries of its expressions. Operands a, b and c
+// are registers (r), constants (k), jump targets, or the raw value of an
+// enum, as noted for each opcode.
+
+#define OPCODES(X)                                                          \
+  X(load_constant)  /* r[a] = k[b] */                                       \
+  X(move)           /* r[a] = r[b] */                                       \
+  X(get_global)     /* r[a] = globals[b] */                                 \
+  X(set_global)     /* globals[a] = r[b] */                                 \
+  X(throw_reference) /* ReferenceError with the message k[a] */             \
+  X(negate)         /* r[a] = -r[b] */                                      \
+  X(logical_not)    /* r[a] = not r[b] */                                   \
+  X(add)            /* r[a] = r[b] + r[c], same for the other operators */  \
+  X(subtract)                                                               \
+  X(multiply)                                                               \
+  X(divide)                                                                 \
+  X(equal)                                                                  \
+  X(not_equal)                                                              \
+  X(less)                                                                   \
+  X(less_equal)                                                             \
+  X(greater)                                                                \
+  X(greater_equal)                                                          \
+  X(jump)           /* to a */                                              \
+  X(jump_if_false)  /* to b unless r[a] */                                  \
+  X(jump_if_true)   /* to b if r[a] */                                      \
+  X(jump_unless_less) /* to c unless r[a] < r[b], same for the others */    \
+  X(jump_unless_less_equal)                                                 \
+  X(jump_unless_greater)                                                    \
+  X(jump_unless_greater_equal)                                              \
+  X(jump_unless_equal)                                                      \
+  X(jump_unless_not_equal)                                                  \
+  X(loop)           /* to a, counting an iteration */                       \
+  X(check_array)    /* asArray(r[a]) */                                     \
+  X(get_element)    /* r[a] = r[b][r[c]] */                                 \
+  X(set_element)    /* r[a][r[b]] = r[c] */                                 \
+  X(new_array)      /* r[a] = [r[b], ..., r[b + c - 1]] */                  \
+  X(new_color)      /* r[a] = color of mode c from r[b]... */               \
+  X(call_procedure) /* procedure b with r[a]... */                          \
+  X(call_function)  /* r[a] = function c of r[b]... */                     \
+  X(modify_array)   /* modification b of the array r[a] with r[a + 1]... */ \
+  X(range_init)     /* r[a], r[a + 1], r[a + 2] = range c of r[b]... */     \
+  X(range_next)     /* r[b] = next of the range in r[a], or to c */         \
+  X(iter_begin)     /* starts iterating r[a] */                             \
+  X(iter_next)      /* r[a] = next element, or to b */                      \
+  X(iter_end)       /* stops the innermost iteration */                     \
+  X(call)           /* r[a] = call site c with r[b]... */                   \
+  X(ret)            /* returns r[a] */                                      \
+  X(ret_undefined)
+
+#define _OPCODE_ENUM_TEMPLATE(NAME) NAME,
+
+enum struct opcode : uint8_t { OPCODES(_OPCODE_ENUM_TEMPLATE) };
+
+struct instruction {
+  // Filled by the VM with the address of the code handling the opcode
+  const void* handler{nullptr};
+  opcode op;
+  uint32_t a{0};
+  uint32_t b{0};
+  uint32_t c{0};
+};
+
+struct function_code {
+  std::vector<instruction> code;
+  // Node reported in the stack of errors thrown by each instruction
+  std::vector<const ast::base*> nodes;
+  uint32_t register_count{0};
+  uint32_t parameter_count{0};
+  // Registers of the parameters and locals, the only ones read before they
+  // are written
+  uint32_t local_count{0};
+};
+
+struct call_site {
+  uint32_t function;
+  uint32_t argument_count;
+};
+
+struct module {
+  std::vector<function_code> functions;
+  std::optional<uint32_t> main_function;
+  std::vector<value> constants;
+  std::vector<call_site> call_sites;
+  size_t global_count{0};
+};
+
+// Throws collected_generation_error for the programs exec::generator refuses
+[[nodiscard]] module compile(ast::program& program);
+
+}  // namespace marlin::exec::bytecode
+
+#endif  // marlin_exec_bytecode_hpp
@@ -0,0 +1,531 @@
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <initializer_list>
+#include <string>
+#include <unordered_map>
+
+#include "bytecode.hpp"
+#include "resolver.hpp"
+
+namespace marlin::exec::bytecode {
+
+namespace {
+
+struct module_compiler {
+  const program_layout& layout;
+  module result;
+
+  explicit module_compiler(const program_layout& _layout) : layout{_layout} {
+    result.global_count = layout.globals.size();
+  }
+
+  [[nodiscard]] uint32_t constant(double number) {
+    // Keyed by bits to keep -0 apart from 0
+    uint64_t bits;
+    std::memcpy(&bits, &number, sizeof(bits));
+    return add_constant(_numbers, bits, number);
+  }
+
+  [[nodiscard]] uint32_t constant(const std::string& string) {
+    return add_constant(_strings, string, string);
+  }
+
+  [[nodiscard]] uint32_t constant(bool boolean) {
+    return add_constant(_booleans, boolean, boolean);
+  }
+
+  [[nodiscard]] uint32_t call_site(size_t function, size_t argument_count) {
+    result.call_sites.push_back({static_cast<uint32_t>(function),
+                                 static_cast<uint32_t>(argument_count)});
+    return static_cast<uint32_t>(result.call_sites.size() - 1);
+  }
+
+ private:
+  std::unordered_map<uint64_t, uint32_t> _numbers;
+  std::unordered_map<std::string, uint32_t> _strings;
+  std::unordered_map<bool, uint32_t> _booleans;
+
+  template <typename map_type, typename key_type>
+  [[nodiscard]] uint32_t add_constant(map_type& map, const key_type& key,
+                                      value constant) {
+    auto [it, inserted]{map.try_emplace(
+        key, static_cast<uint32_t>(result.constants.size()))};
+    if (inserted) {
+      result.constants.push_back(std::move(constant));
+    }
+    return it->second;
+  }
+};
+
+struct function_compiler {
+  function_compiler(module_compiler& module, const block_layout& block,
+                    function_code& function)
+      : _module{module},
+        _block{block},
+        _function{function},
+        _top{static_cast<uint32_t>(block.locals.size())} {
+    _function.parameter_count = static_cast<uint32_t>(block.parameter_count);
+    _function.register_count = _top;
+    _function.local_count = _top;
+  }
+
+  template <typename vector_type>
+  void compile_body(vector_type statements) {
+    compile_statements(statements);
+    emit(opcode::ret_undefined, *_block.block);
+  }
+
+ private:
+  struct loop_context {
+    std::vector<size_t> breaks;
+    std::vector<size_t> continues;
+  };
+
+  module_compiler& _module;
+  const block_layout& _block;
+  function_code& _function;
+
+  // Temporaries are allocated like a stack above the locals
+  uint32_t _top;
+  std::vector<loop_context> _loops;
+
+  size_t emit(opcode op, const ast::base& node, uint32_t a = 0,
+              uint32_t b = 0, uint32_t c = 0) {
+    _function.code.push_back({nullptr, op, a, b, c});
+    _function.nodes.push_back(&node);
+    return _function.code.size() - 1;
+  }
+
+  [[nodiscard]] uint32_t here() const noexcept {
+    return static_cast<uint32_t>(_function.code.size());
+  }
+
+  // Jumps keep their target in the last operand they use
+  void patch(size_t index, uint32_t target) {
+    auto& instruction{_function.code[index]};
+    switch (instruction.op) {
+      case opcode::jump:
+      case opcode::loop:
+        instruction.a = target;
+        break;
+      case opcode::jump_if_false:
+      case opcode::jump_if_true:
+      case opcode::iter_next:
+        instruction.b = target;
+        break;
+      default:
+        instruction.c = target;
+        break;
+    }
+  }
+
+  [[nodiscard]] uint32_t allocate(uint32_t count = 1) {
+    const auto first{_top};
+    _top += count;
+    _function.register_count = std::max(_function.register_count, _top);
+    return first;
+  }
+
+  [[nodiscard]] bool is_local(uint32_t reg) const noexcept {
+    return reg < _block.locals.size();
+  }
+
+  [[nodiscard]] const variable_ref* variable(const ast::base& node) const {
+    const auto it{_module.layout.variables.find(&node)};
+    return it == _module.layout.variables.end() ? nullptr : &it->second;
+  }
+
+  // Register already holding the value of a declared local, if it is one
+  [[nodiscard]] std::optional<uint32_t> local_register(
+      const ast::base& node) const {
+    const auto* ref{variable(node)};
+    if (ref != nullptr && !ref->is_global && _block.declared[ref->slot]) {
+      return ref->slot;
+    }
+    return std::nullopt;
+  }
+
+  // Statements
+
+  template <typename vector_type>
+  void compile_statements(vector_type statements) {
+    for (auto& statement : statements) {
+      const auto top{_top};
+      compile_statement(*statement);
+      _top = top;
+    }
+  }
+
+  void compile_statement(ast::base& node) {
+    if (node.is<ast::eval_statement>()) {
+      compile(*node.as<ast::eval_statement>().expression(), allocate());
+    } else if (node.is<ast::assignment>()) {
+      auto& assignment{node.as<ast::assignment>()};
+      store(*assignment.variable(),
+            [&](uint32_t reg) { compile(*assignment.value(), reg); });
+    } else if (node.is<ast::modify_array>()) {
+      auto& call{node.as<ast::modify_array>()};
+      const auto first{allocate(1 + call.arguments().size())};
+      compile(*call.array(), first);
+      compile_arguments(call.arguments(), first + 1);
+      emit(opcode::modify_array, node, first, raw_value(call.mod));
+    } else if (node.is<ast::system_procedure_call>()) {
+      auto& call{node.as<ast::system_procedure_call>()};
+      const auto first{allocate(call.arguments().size())};
+      compile_arguments(call.arguments(), first);
+      emit(opcode::call_procedure, node, first, raw_value(call.proc));
+    } else if (node.is<ast::if_statement>()) {
+      auto& statement{node.as<ast::if_statement>()};
+      const auto skip{branch_unless(*statement.condition())};
+      compile_statements(statement.statements());
+      patch(skip, here());
+    } else if (node.is<ast::if_else_statement>()) {
+      auto& statement{node.as<ast::if_else_statement>()};
+      const auto skip{branch_unless(*statement.condition())};
+      compile_statements(statement.consequence());
+      const auto end{emit(opcode::jump, node)};
+      patch(skip, here());
+      compile_statements(statement.alternate());
+      patch(end, here());
+    } else if (node.is<ast::while_statement>()) {
+      compile_while(node.as<ast::while_statement>());
+    } else if (node.is<ast::for_statement>()) {
+      compile_for(node.as<ast::for_statement>());
+    } else if (node.is<ast::break_statement>()) {
+      assert(!_loops.empty());
+      _loops.back().breaks.push_back(emit(opcode::jump, node));
+    } else if (node.is<ast::continue_statement>()) {
+      assert(!_loops.empty());
+      _loops.back().continues.push_back(emit(opcode::jump, node));
+    } else if (node.is<ast::return_statement>()) {
+      emit(opcode::ret_undefined, node);
+    } else if (node.is<ast::return_result_statement>()) {
+      auto& result{*node.as<ast::return_result_statement>().result()};
+      emit(opcode::ret, node, operand(result));
+    }
+    // use_global only matters to the resolver
+  }
+
+  // Stores into the variable the value compute puts in the register it is
+  // given, checking the array and evaluating the index of a subscript first
+  template <typename callable_type>
+  void store(ast::base& target, callable_type compute) {
+    if (target.is<ast::subscript_set>()) {
+      auto& subscript{target.as<ast::subscript_set>()};
+      const auto list{operand(*subscript.list())};
+      emit(opcode::check_array, target, list);
+      const auto index{operand(*subscript.index())};
+      const auto element{allocate()};
+      compute(element);
+      emit(opcode::set_element, target, list, index, element);
+      return;
+    }
+    const auto* ref{variable(target)};
+    assert(ref != nullptr);
+    if (ref->is_global) {
+      const auto reg{allocate()};
+      compute(reg);
+      emit(opcode::set_global, target, ref->slot, reg);
+    } else {
+      compute(ref->slot);
+    }
+  }
+
+  void compile_while(ast::while_statement& statement) {
+    const auto head{here()};
+    _loops.emplace_back();
+    const auto exit{branch_unless(*statement.condition())};
+    compile_statements(statement.statements());
+    close_loop(statement, head, {exit});
+  }
+
+  void compile_for(ast::for_statement& statement) {
+    auto& list{*statement.list()};
+    auto& variable{*statement.variable()};
+
+    // Ranges iterated right away count in registers, nothing else can see
+    // the generator
+    if (list.is<ast::system_function_call>()) {
+      auto& call{list.as<ast::system_function_call>()};
+      if (call.func == ast::system_function::range1 ||
+          call.func == ast::system_function::range2 ||
+          call.func == ast::system_function::range3) {
+        const auto state{allocate(3)};
+        const auto first{allocate(call.arguments().size())};
+        compile_arguments(call.arguments(), first);
+        _top = first;
+        emit(opcode::range_init, list, state, first, raw_value(call.func));
+
+        const auto head{here()};
+        _loops.emplace_back();
+        const auto element{element_register(variable)};
+        const auto next{emit(opcode::range_next, statement, state, element)};
+        store_element(variable, element);
+        compile_statements(statement.statements());
+        close_loop(statement, head, {next});
+        return;
+      }
+    }
+
+    emit(opcode::iter_begin, statement, operand(list));
+    const auto head{here()};
+    _loops.emplace_back();
+    const auto element{element_register(variable)};
+    const auto next{emit(opcode::iter_next, statement, element)};
+    store_element(variable, element);
+    compile_statements(statement.statements());
+    close_loop(statement, head, {next});
+    emit(opcode::iter_end, statement);
+  }
+
+  [[nodiscard]] uint32_t element_register(const ast::base& variable) {
+    if (const auto reg{local_register(variable)}) {
+      return *reg;
+    }
+    return allocate();
+  }
+
+  void store_element(ast::base& variable, uint32_t element) {
+    store(variable, [&](uint32_t reg) {
+      if (reg != element) {
+        emit(opcode::move, variable, reg, element);
+      }
+    });
+  }
+
+  // Jumps back to the head, and out of the loop from the exits and breaks
+  void close_loop(const ast::base& statement, uint32_t head,
+                  std::initializer_list<size_t> exits) {
+    const auto back{emit(opcode::loop, statement, head)};
+    auto context{std::move(_loops.back())};
+    _loops.pop_back();
+    for (const auto index : context.continues) {
+      patch(index, static_cast<uint32_t>(back));
+    }
+    for (const auto index : exits) {
+      patch(index, here());
+    }
+    for (const auto index : context.breaks) {
+      patch(index, here());
+    }
+  }
+
+  // Emits a jump taken when the condition is false, to be patched
+  size_t branch_unless(ast::base& condition) {
+    if (condition.is<ast::binary_expression>()) {
+      auto& binary{condition.as<ast::binary_expression>()};
+      std::optional<opcode> op;
+      switch (binary.op) {
+        case ast::binary_op::less:
+          op = opcode::jump_unless_less;
+          break;
+        case ast::binary_op::less_equal:
+          op = opcode::jump_unless_less_equal;
+          break;
+        case ast::binary_op::greater:
+          op = opcode::jump_unless_greater;
+          break;
+        case ast::binary_op::greater_equal:
+          op = opcode::jump_unless_greater_equal;
+          break;
+        case ast::binary_op::equal:
+          op = opcode::jump_unless_equal;
+          break;
+        case ast::binary_op::not_equal:
+          op = opcode::jump_unless_not_equal;
+          break;
+        default:
+          break;
+      }
+      if (op) {
+        const auto left{operand(*binary.left())};
+        const auto right{operand(*binary.right())};
+        return emit(*op, condition, left, right);
+      }
+    } else if (condition.is<ast::unary_expression>() &&
+               condition.as<ast::unary_expression>().op ==
+                   ast::unary_op::logical_not) {
+      const auto argument{
+          operand(*condition.as<ast::unary_expression>().argument())};
+      return emit(opcode::jump_if_true, condition, argument);
+    }
+    return emit(opcode::jump_if_false, condition, operand(condition));
+  }
+
+  // Expressions
+
+  // Register holding the value of the expression, its own register for
+  // declared locals
+  [[nodiscard]] uint32_t operand(ast::base& node) {
+    if (const auto reg{local_register(node)}) {
+      return *reg;
+    }
+    const auto reg{allocate()};
+    compile(node, reg);
+    return reg;
+  }
+
+  template <typename vector_type>
+  void compile_arguments(vector_type args, uint32_t first) {
+    for (size_t i{0}; i < args.size(); i++) {
+      const auto top{_top};
+      compile(*args[i], first + static_cast<uint32_t>(i));
+      _top = top;
+    }
+  }
+
+  void compile(ast::base& node, uint32_t dest) {
+    const auto top{_top};
+    node.apply<void>([&](auto& expression) { compile(expression, dest); });
+    _top = top;
+  }
+
+  template <typename node_type>
+  void compile(node_type&, uint32_t) {
+    // Refused by the resolver
+    assert(false);
+  }
+
+  void compile(ast::unary_expression& unary, uint32_t dest) {
+    const auto argument{operand(*unary.argument())};
+    emit(unary.op == ast::unary_op::negative ? opcode::negate
+                                             : opcode::logical_not,
+         unary, dest, argument);
+  }
+
+  void compile(ast::binary_expression& binary, uint32_t dest) {
+    if (binary.op == ast::binary_op::logical_and ||
+        binary.op == ast::binary_op::logical_or) {
+      // The result is built in place, which must not overwrite a local the
+      // right side still reads
+      if (is_local(dest)) {
+        const auto temporary{allocate()};
+        compile(binary, temporary);
+        emit(opcode::move, binary, dest, temporary);
+        return;
+      }
+      compile(*binary.left(), dest);
+      const auto skip{emit(binary.op == ast::binary_op::logical_and
+                               ? opcode::jump_if_false
+                               : opcode::jump_if_true,
+                           binary, dest)};
+      compile(*binary.right(), dest);
+      patch(skip, here());
+      return;
+    }
+
+    static constexpr auto opcode_map{make_array(
+        opcode::add /* add */, opcode::subtract /* subtract */,
+        opcode::multiply /* multiply */, opcode::divide /* divide */,
+        opcode::equal /* equal */, opcode::not_equal /* not_equal */,
+        opcode::less /* less */, opcode::less_equal /* less_equal */,
+        opcode::greater /* greater */,
+        opcode::greater_equal /* greater_equal */)};
+    const auto left{operand(*binary.left())};
+    const auto right{operand(*binary.right())};
+    emit(opcode_map[raw_value(binary.op)], binary, dest, left, right);
+  }
+
+  void compile(ast::subscript_get& subscript, uint32_t dest) {
+    const auto list{operand(*subscript.list())};
+    auto& index_node{*subscript.index()};
+    // asArray runs before the index is evaluated, which only shows when the
+    // index can throw or print
+    if (!local_register(index_node) && !index_node.is<ast::number_literal>() &&
+        !index_node.is<ast::string_literal>()) {
+      emit(opcode::check_array, subscript, list);
+    }
+    const auto index{operand(index_node)};
+    emit(opcode::get_element, subscript, dest, list, index);
+  }
+
+  void compile(ast::new_array& init, uint32_t dest) {
+    const auto count{static_cast<uint32_t>(init.elements().size())};
+    const auto first{allocate(count)};
+    compile_arguments(init.elements(), first);
+    emit(opcode::new_array, init, dest, first, count);
+  }
+
+  void compile(ast::new_color& init, uint32_t dest) {
+    const auto first{allocate(init.arguments().size())};
+    compile_arguments(init.arguments(), first);
+    emit(opcode::new_color, init, dest, first, raw_value(init.mode));
+  }
+
+  void compile(ast::system_function_call& call, uint32_t dest) {
+    const auto first{allocate(call.arguments().size())};
+    compile_arguments(call.arguments(), first);
+    emit(opcode::call_function, call, dest, first, raw_value(call.func));
+  }
+
+  void compile(ast::user_function_call& call, uint32_t dest) {
+    // Arguments go on top of the registers, where the frame of the callee
+    // starts
+    const auto count{call.arguments().size()};
+    const auto first{allocate(count)};
+    compile_arguments(call.arguments(), first);
+    const auto callee{_module.layout.callees.at(&call)};
+    emit(opcode::call, call, dest, first, _module.call_site(callee, count));
+  }
+
+  void compile_variable(ast::base& node, uint32_t dest) {
+    const auto* ref{variable(node)};
+    assert(ref != nullptr);
+    if (ref->is_global) {
+      emit(opcode::get_global, node, dest, ref->slot);
+    } else if (!_block.declared[ref->slot]) {
+      emit(opcode::throw_reference, node,
+           _module.constant("Can't find variable: " +
+                            _block.locals[ref->slot]));
+    } else if (ref->slot != dest) {
+      emit(opcode::move, node, dest, ref->slot);
+    }
+  }
+
+  void compile(ast::variable_name& variable, uint32_t dest) {
+    compile_variable(variable, dest);
+  }
+
+  void compile(ast::identifier& identifier, uint32_t dest) {
+    compile_variable(identifier, dest);
+  }
+
+  void compile(ast::number_literal& literal, uint32_t dest) {
+    emit(opcode::load_constant, literal, dest,
+         _module.constant(string_to_number(literal.value)));
+  }
+
+  void compile(ast::string_literal& literal, uint32_t dest) {
+    emit(opcode::load_constant, literal, dest, _module.constant(literal.value));
+  }
+
+  void compile(ast::bool_literal& literal, uint32_t dest) {
+    emit(opcode::load_constant, literal, dest, _module.constant(literal.value));
+  }
+};
+
+}  // namespace
+
+module compile(ast::program& program) {
+  const auto layout{resolve(program)};
+  module_compiler compiler{layout};
+
+  auto& functions{compiler.result.functions};
+  functions.resize(layout.blocks.size());
+  for (size_t i{0}; i < layout.blocks.size(); i++) {
+    const auto& block{layout.blocks[i]};
+    function_compiler function{compiler, block, functions[i]};
+    if (block.block->is<ast::on_start>()) {
+      function.compile_body(block.block->as<ast::on_start>().statements());
+    } else if (block.block->is<ast::function>()) {
+      function.compile_body(block.block->as<ast::function>().statements());
+    }
+  }
+  if (layout.main_block) {
+    compiler.result.main_function = static_cast<uint32_t>(*layout.main_block);
+  }
+  return std::move(compiler.result);
+}
+
+}  // namespace marlin::exec::bytecode
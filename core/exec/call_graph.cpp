@@ -0,0 +1,247 @@
+#include "call_graph.hpp"
+
+#include <algorithm>
+#include <utility>
+
+#include "generator.hpp"
+
+namespace marlin::exec {
+
+namespace {
+
+// Tarjan's algorithm over the affected blocks, components are visited after
+// every component they call
+template <typename successors_type, typename visitor_type>
+struct components {
+  components(const std::unordered_set<const ast::base*>& blocks,
+             successors_type successors, visitor_type visitor)
+      : _blocks{blocks},
+        _successors{std::move(successors)},
+        _visitor{std::move(visitor)} {
+    for (auto* block : _blocks) {
+      if (_indices.find(block) == _indices.end()) {
+        connect(block);
+      }
+    }
+  }
+
+ private:
+  const std::unordered_set<const ast::base*>& _blocks;
+  successors_type _successors;
+  visitor_type _visitor;
+
+  std::unordered_map<const ast::base*, size_t> _indices;
+  std::unordered_map<const ast::base*, size_t> _lowlinks;
+  std::vector<const ast::base*> _stack;
+  std::unordered_set<const ast::base*> _on_stack;
+
+  // Blocks being connected, kept on an explicit stack as call chains can be
+  // as deep as the program is long
+  struct frame {
+    const ast::base* block;
+    std::vector<const ast::base*> callees;
+    size_t next{0};
+  };
+  std::vector<frame> _frames;
+
+  void enter(const ast::base* block) {
+    const auto index{_indices.size()};
+    _indices[block] = index;
+    _lowlinks[block] = index;
+    _stack.push_back(block);
+    _on_stack.emplace(block);
+
+    auto& entered{_frames.emplace_back(frame{block, {}})};
+    _successors(block, [this, &entered](const ast::base* callee) {
+      if (_blocks.find(callee) != _blocks.end()) {
+        entered.callees.push_back(callee);
+      }
+    });
+  }
+
+  void connect(const ast::base* root) {
+    enter(root);
+    while (!_frames.empty()) {
+      auto& top{_frames.back()};
+      if (top.next < top.callees.size()) {
+        auto* block{top.block};
+        auto* callee{top.callees[top.next++]};
+        if (_indices.find(callee) == _indices.end()) {
+          enter(callee);
+        } else if (_on_stack.find(callee) != _on_stack.end()) {
+          _lowlinks[block] = std::min(_lowlinks[block], _indices[callee]);
+        }
+        continue;
+      }
+
+      auto* block{top.block};
+      _frames.pop_back();
+      if (_lowlinks[block] == _indices[block]) {
+        std::vector<const ast::base*> component;
+        const ast::base* member;
+        do {
+          member = _stack.back();
+          _stack.pop_back();
+          _on_stack.erase(member);
+          component.push_back(member);
+        } while (member != block);
+        _visitor(component);
+      }
+      if (!_frames.empty()) {
+        auto* caller{_frames.back().block};
+        _lowlinks[caller] = std::min(_lowlinks[caller], _lowlinks[block]);
+      }
+    }
+  }
+};
+
+template <typename successors_type, typename visitor_type>
+components(const std::unordered_set<const ast::base*>&, successors_type,
+           visitor_type) -> components<successors_type, visitor_type>;
+
+}  // namespace
+
+void call_graph::update(ast::program& program) {
+  std::unordered_set<const ast::base*> changed;
+  std::unordered_set<const ast::base*> present;
+  std::unordered_map<std::string, const ast::base*> functions;
+  for (auto& node : program.blocks()) {
+    auto& block{*node};
+    present.emplace(&block);
+    auto [it, inserted]{_blocks.try_emplace(&block)};
+    auto& info{it->second};
+    if (inserted || info.revision != block.revision()) {
+      // Blocks may take the address of removed ones
+      forget_callees(block, info);
+      info = block_info{};
+      info.revision = block.revision();
+      scan(block, info);
+      changed.emplace(&block);
+    }
+    if (!info.name.empty()) {
+      functions[info.name] = &block;
+    }
+  }
+
+  for (auto it{_blocks.begin()}; it != _blocks.end();) {
+    if (present.find(it->first) == present.end()) {
+      forget_callees(*it->first, it->second);
+      it = _blocks.erase(it);
+    } else {
+      it++;
+    }
+  }
+
+  // Calls to names now bound to another function, or to none
+  for (const auto& [name, block] : _functions) {
+    const auto it{functions.find(name)};
+    if (it == functions.end() || it->second != block) {
+      mark_callers(name, changed);
+    }
+  }
+  for (const auto& [name, block] : functions) {
+    if (_functions.find(name) == _functions.end()) {
+      mark_callers(name, changed);
+    }
+  }
+  _functions = std::move(functions);
+
+  if (!changed.empty()) {
+    propagate(changed);
+  }
+}
+
+void call_graph::scan(ast::base& block, block_info& info) {
+  _scans++;
+  if (block.is<ast::function>()) {
+    auto signature{block.as<ast::function>().signature()};
+    if (signature->is<ast::function_signature>()) {
+      info.name = signature->as<ast::function_signature>().name;
+    }
+  }
+  scan_node(block, info);
+  for (const auto& name : info.callees) {
+    _callers[name].emplace(&block);
+  }
+}
+
+void call_graph::scan_node(ast::base& node, block_info& info) {
+  if (node.is<ast::user_function_call>()) {
+    auto& call{node.as<ast::user_function_call>()};
+    info.calls.push_back(&call);
+    info.callees.emplace(call.name);
+  } else if (generator::is_async_call(node)) {
+    info.calls_async_system = true;
+  }
+  for (auto& child : node.children()) {
+    scan_node(*child, info);
+  }
+}
+
+void call_graph::forget_callees(const ast::base& block,
+                                const block_info& info) {
+  for (const auto& name : info.callees) {
+    if (auto it{_callers.find(name)}; it != _callers.end()) {
+      it->second.erase(&block);
+      if (it->second.empty()) {
+        _callers.erase(it);
+      }
+    }
+  }
+}
+
+void call_graph::mark_callers(
+    const std::string& name,
+    std::unordered_set<const ast::base*>& changed) const {
+  if (const auto it{_callers.find(name)}; it != _callers.end()) {
+    changed.insert(it->second.begin(), it->second.end());
+  }
+}
+
+void call_graph::propagate(
+    const std::unordered_set<const ast::base*>& changed) {
+  // Only the changed blocks and those calling them, directly or not, may
+  // change status
+  std::unordered_set<const ast::base*> affected;
+  std::vector<const ast::base*> queue{changed.begin(), changed.end()};
+  while (!queue.empty()) {
+    auto* block{queue.back()};
+    queue.pop_back();
+    if (!affected.emplace(block).second) {
+      continue;
+    }
+    const auto& info{_blocks.at(block)};
+    if (!info.name.empty() && function(info.name) == block) {
+      if (const auto it{_callers.find(info.name)}; it != _callers.end()) {
+        queue.insert(queue.end(), it->second.begin(), it->second.end());
+      }
+    }
+  }
+
+  const auto for_each_callee{[this](const ast::base* block, auto&& visit) {
+    for (const auto& name : _blocks.at(block).callees) {
+      if (auto* callee{function(name)}) {
+        visit(callee);
+      }
+    }
+  }};
+  const auto settle{[this, &for_each_callee](
+                          const std::vector<const ast::base*>& component) {
+    // Callees outside the component are settled already
+    bool async{false};
+    for (auto* block : component) {
+      async = async || _blocks.at(block).calls_async_system;
+      for_each_callee(block, [&](const ast::base* callee) {
+        async = async || (std::find(component.begin(), component.end(),
+                                    callee) == component.end() &&
+                          is_async(*callee));
+      });
+    }
+    for (auto* block : component) {
+      _blocks.at(block).async = async;
+    }
+  }};
+  components{affected, for_each_callee, settle};
+}
+
+}  // namespace marlin::exec
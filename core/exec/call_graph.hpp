@@ -0,0 +1,71 @@
+#ifndef marlin_exec_call_graph_hpp
+#define marlin_exec_call_graph_hpp
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "ast.hpp"
+
+namespace marlin::exec {
+
+// Calls between the blocks of a program, and which blocks must run async:
+// those calling async system procedures, and those calling async functions.
+// Kept from one update to the next, only blocks whose revision changed are
+// scanned again, and async status is propagated again only through the
+// strongly connected components of the blocks they may affect.
+struct call_graph {
+  void update(ast::program& program);
+
+  [[nodiscard]] bool is_async(const ast::base& block) const {
+    const auto it{_blocks.find(&block)};
+    return it != _blocks.end() && it->second.async;
+  }
+
+  // The function block of the name, nullptr if none
+  [[nodiscard]] const ast::base* function(const std::string& name) const {
+    const auto it{_functions.find(name)};
+    return it != _functions.end() ? it->second : nullptr;
+  }
+
+  // User function calls in the block, in the order they appear
+  [[nodiscard]] const std::vector<ast::user_function_call*>& calls(
+      const ast::base& block) const {
+    return _blocks.at(&block).calls;
+  }
+
+  // Blocks scanned since created
+  [[nodiscard]] size_t scans() const noexcept { return _scans; }
+
+ private:
+  struct block_info {
+    uint64_t revision{0};
+    // Name of the function, empty for other blocks
+    std::string name;
+    bool calls_async_system{false};
+    std::vector<ast::user_function_call*> calls;
+    // Names called, kept apart as the calls go with the block
+    std::unordered_set<std::string> callees;
+    bool async{false};
+  };
+
+  std::unordered_map<const ast::base*, block_info> _blocks;
+  std::unordered_map<std::string, const ast::base*> _functions;
+  std::unordered_map<std::string, std::unordered_set<const ast::base*>>
+      _callers;
+  size_t _scans{0};
+
+  void scan(ast::base& block, block_info& info);
+  void scan_node(ast::base& node, block_info& info);
+  void forget_callees(const ast::base& block, const block_info& info);
+  void mark_callers(const std::string& name,
+                    std::unordered_set<const ast::base*>& changed) const;
+
+  void propagate(const std::unordered_set<const ast::base*>& changed);
+};
+
+}  // namespace marlin::exec
+
+#endif  // marlin_exec_call_graph_hpp
@@ -0,0 +1,114 @@
+#include "constant_folder.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace marlin::exec {
+
+namespace {
+
+// Characters out of the BMP, where comparing UTF-8 bytes like the runtime
+// does differs from comparing the UTF-16 code units of JavaScript
+[[nodiscard]] bool has_astral(const value& v) {
+  if (!v.is(value::type::string)) {
+    return false;
+  }
+  const auto& string{v.string()};
+  return std::any_of(string.begin(), string.end(), [](char c) {
+    return static_cast<unsigned char>(c) >= 0xF0;
+  });
+}
+
+[[nodiscard]] bool is_comparison(ast::binary_op op) {
+  switch (op) {
+    case ast::binary_op::less:
+    case ast::binary_op::less_equal:
+    case ast::binary_op::greater:
+    case ast::binary_op::greater_equal:
+      return true;
+    default:
+      return false;
+  }
+}
+
+[[nodiscard]] std::optional<value> fold_binary(ast::binary_op op,
+                                               const value& left,
+                                               const value& right) {
+  switch (op) {
+    case ast::binary_op::logical_and:
+      return to_boolean(left) ? right : left;
+    case ast::binary_op::logical_or:
+      return to_boolean(left) ? left : right;
+    default:
+      if (is_comparison(op) && (has_astral(left) || has_astral(right))) {
+        return std::nullopt;
+      }
+      return binary(op, left, right);
+  }
+}
+
+}  // namespace
+
+void constant_folder::fold(const ast::base& block) {
+  _constants.clear();
+  static_cast<void>(visit(block));
+}
+
+const value* constant_folder::constant(const ast::base& node) const {
+  const auto it{_constants.find(&node)};
+  return it != _constants.end() ? &it->second : nullptr;
+}
+
+std::optional<bool> constant_folder::condition(const ast::base& node) const {
+  if (const auto* folded{constant(node)}) {
+    return to_boolean(*folded);
+  }
+  return std::nullopt;
+}
+
+std::string constant_folder::js_literal(const value& constant) {
+  if (constant.is(value::type::boolean)) {
+    return constant.boolean() ? "true" : "false";
+  }
+  assert(constant.is(value::type::number));
+  const auto number{constant.number()};
+  if (std::signbit(number) && !std::isnan(number)) {
+    // Negative zero prints as 0
+    return "(-" + number_to_string(-number) + ")";
+  }
+  return number_to_string(number);
+}
+
+std::optional<value> constant_folder::visit(const ast::base& node) {
+  // Constants within expressions that are not are recorded too
+  std::optional<value> result;
+  if (node.is<ast::number_literal>()) {
+    result = string_to_number(node.as<ast::number_literal>().value);
+  } else if (node.is<ast::string_literal>()) {
+    result = node.as<ast::string_literal>().value;
+  } else if (node.is<ast::bool_literal>()) {
+    result = node.as<ast::bool_literal>().value;
+  } else if (node.is<ast::unary_expression>()) {
+    const auto& expression{node.as<ast::unary_expression>()};
+    if (const auto argument{visit(*expression.argument())}) {
+      result = unary(expression.op, *argument);
+    }
+  } else if (node.is<ast::binary_expression>()) {
+    const auto& expression{node.as<ast::binary_expression>()};
+    const auto left{visit(*expression.left())};
+    const auto right{visit(*expression.right())};
+    if (left && right) {
+      result = fold_binary(expression.op, *left, *right);
+    }
+  } else {
+    for (const auto& child : node.children()) {
+      static_cast<void>(visit(*child));
+    }
+  }
+  if (result) {
+    _constants.emplace(&node, *result);
+  }
+  return result;
+}
+
+}  // namespace marlin::exec
@@ -0,0 +1,40 @@
+#ifndef marlin_exec_constant_folder_hpp
+#define marlin_exec_constant_folder_hpp
+
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+#include "ast.hpp"
+#include "runtime.hpp"
+
+namespace marlin::exec {
+
+// Values of the expressions of a block made of literals only, computed with
+// the JavaScript semantics of the runtime, so that the generator can write
+// them as literals and leave out the branches they make unreachable
+struct constant_folder {
+  // Replaces the values found for the previous block
+  void fold(const ast::base& block);
+
+  // Literals included, nullptr if the node is not a constant expression
+  [[nodiscard]] const value* constant(const ast::base& node) const;
+
+  // Whether a constant condition makes a branch run, if the node is one
+  [[nodiscard]] std::optional<bool> condition(const ast::base& node) const;
+
+  void clear() noexcept { _constants.clear(); }
+
+  // JavaScript literal of a number, boolean or string value, parenthesized
+  // when negative so that it stands as an operand
+  [[nodiscard]] static std::string js_literal(const value& constant);
+
+ private:
+  std::unordered_map<const ast::base*, value> _constants;
+
+  std::optional<value> visit(const ast::base& node);
+};
+
+}  // namespace marlin::exec
+
+#endif  // marlin_exec_constant_folder_hpp
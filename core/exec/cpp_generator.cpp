@@ -0,0 +1,509 @@
+#include "cpp_generator.hpp"
+
+#include <cassert>
+#include <cmath>
+#include <cstdio>
+#include <unordered_map>
+
+#include "resolver.hpp"
+#include "runtime.hpp"
+
+namespace marlin::exec {
+
+namespace {
+
+[[nodiscard]] std::string number_text(double number) {
+  if (std::isnan(number)) {
+    return "NAN";
+  }
+  if (std::isinf(number)) {
+    return number > 0 ? "HUGE_VAL" : "-HUGE_VAL";
+  }
+  // Hexadecimal keeps every bit of the number
+  char buffer[32];
+  std::snprintf(buffer, sizeof(buffer), "%a", number);
+  return buffer;
+}
+
+[[nodiscard]] std::string quoted(const std::string& text) {
+  std::string result{"\""};
+  for (const auto c : text) {
+    const auto byte{static_cast<unsigned char>(c)};
+    if (c == '"' || c == '\\') {
+      result += '\\';
+      result += c;
+    } else if (byte < 0x20 || byte >= 0x7F) {
+      // Octal escapes end after three digits, unlike hexadecimal ones
+      char buffer[5];
+      std::snprintf(buffer, sizeof(buffer), "\\%03o", byte);
+      result += buffer;
+    } else {
+      result += c;
+    }
+  }
+  return result + '"';
+}
+
+template <typename enum_type>
+[[nodiscard]] std::string enum_text(const char* type, enum_type value) {
+  return std::string{type} + "{" + std::to_string(raw_value(value)) + "}";
+}
+
+[[nodiscard]] std::string block_name(size_t index) {
+  return "block_" + std::to_string(index);
+}
+
+// Members of the program outside its functions
+struct program_writer {
+  const program_layout& layout;
+  std::string strings;
+
+  explicit program_writer(const program_layout& _layout) : layout{_layout} {}
+
+  [[nodiscard]] std::string string_constant(const std::string& text) {
+    auto [it, inserted]{_strings.try_emplace(text, _strings.size())};
+    const auto name{"string_" + std::to_string(it->second)};
+    if (inserted) {
+      strings += "  const value " + name + "{" + quoted(text) + "};\n";
+    }
+    return name;
+  }
+
+ private:
+  std::unordered_map<std::string, size_t> _strings;
+};
+
+struct function_writer {
+  function_writer(program_writer& program, const block_layout& block,
+                  std::string& out)
+      : _program{program}, _block{block}, _out{out} {}
+
+  template <typename vector_type>
+  void write(const std::string& name, vector_type statements) {
+    const auto parameter_count{_block.parameter_count};
+    if (parameter_count == 0) {
+      line("value " + name + "() {");
+    } else {
+      line("value " + name + "(values<" + std::to_string(parameter_count) +
+           "> arguments) {");
+    }
+    _indent++;
+    if (_block.block->is<ast::function>()) {
+      line("const call_guard guard{*this};");
+    }
+    for (size_t i{0}; i < _block.locals.size(); i++) {
+      if (i < parameter_count) {
+        line("value " + local_name(i) + "{std::move(arguments[" +
+             std::to_string(i) + "])};");
+      } else {
+        line("value " + local_name(i) + ";");
+      }
+    }
+    write_statements(statements);
+    line("return {};");
+    _indent--;
+    line("}");
+  }
+
+ private:
+  program_writer& _program;
+  const block_layout& _block;
+  std::string& _out;
+  size_t _indent{1};
+  // Names the state of nested for statements apart
+  size_t _loop_depth{0};
+
+  void line(const std::string& text) {
+    _out.append(_indent * 2, ' ');
+    _out += text;
+    _out += '\n';
+  }
+
+  [[nodiscard]] static std::string local_name(size_t slot) {
+    return "local_" + std::to_string(slot);
+  }
+
+  [[nodiscard]] const variable_ref& variable(const ast::base& node) const {
+    const auto it{_program.layout.variables.find(&node)};
+    assert(it != _program.layout.variables.end());
+    return it->second;
+  }
+
+  // Name of the variable assigned by the node
+  [[nodiscard]] std::string target(const ast::base& node) const {
+    const auto [is_global, slot]{variable(node)};
+    return is_global ? "global_" + std::to_string(slot) : local_name(slot);
+  }
+
+  // Statements
+
+  template <typename vector_type>
+  void write_statements(vector_type statements) {
+    for (auto& statement : statements) {
+      write_statement(*statement);
+    }
+  }
+
+  template <typename vector_type>
+  void write_block(vector_type statements) {
+    _indent++;
+    write_statements(statements);
+    _indent--;
+  }
+
+  void write_statement(ast::base& node) {
+    if (node.is<ast::eval_statement>()) {
+      line("static_cast<void>(" +
+           expression(*node.as<ast::eval_statement>().expression()) + ");");
+    } else if (node.is<ast::assignment>()) {
+      auto& assignment{node.as<ast::assignment>()};
+      write_store(*assignment.variable(), expression(*assignment.value()));
+    } else if (node.is<ast::modify_array>()) {
+      auto& call{node.as<ast::modify_array>()};
+      const auto count{call.arguments().size() + 1};
+      line("modify(env, " + enum_text("array_modification", call.mod) +
+           ", values<" + std::to_string(count) + ">{{" +
+           expression(*call.array()) +
+           (count > 1 ? ", " + expressions(call.arguments()) : "") + "}});");
+    } else if (node.is<ast::system_procedure_call>()) {
+      auto& call{node.as<ast::system_procedure_call>()};
+      line("env.call(" + enum_text("system_procedure", call.proc) + ", " +
+           arguments(call.arguments()) + ");");
+    } else if (node.is<ast::if_statement>()) {
+      auto& statement{node.as<ast::if_statement>()};
+      line("if (truthy(" + expression(*statement.condition()) + ")) {");
+      write_block(statement.statements());
+      line("}");
+    } else if (node.is<ast::if_else_statement>()) {
+      auto& statement{node.as<ast::if_else_statement>()};
+      line("if (truthy(" + expression(*statement.condition()) + ")) {");
+      write_block(statement.consequence());
+      line("} else {");
+      write_block(statement.alternate());
+      line("}");
+    } else if (node.is<ast::while_statement>()) {
+      auto& statement{node.as<ast::while_statement>()};
+      line("for (;; step()) {");
+      _indent++;
+      line("if (!truthy(" + expression(*statement.condition()) + ")) {");
+      line("  break;");
+      line("}");
+      write_loop_body(statement.statements());
+      _indent--;
+      line("}");
+    } else if (node.is<ast::for_statement>()) {
+      write_for(node.as<ast::for_statement>());
+    } else if (node.is<ast::break_statement>()) {
+      line("break;");
+    } else if (node.is<ast::continue_statement>()) {
+      line("continue;");
+    } else if (node.is<ast::return_statement>()) {
+      line("return {};");
+    } else if (node.is<ast::return_result_statement>()) {
+      line("return " +
+           expression(*node.as<ast::return_result_statement>().result()) +
+           ";");
+    }
+    // use_global only matters to the resolver
+  }
+
+  // Subscripts check the array and evaluate the index before the value, like
+  // in the interpreter
+  void write_store(ast::base& variable, const std::string& value) {
+    if (variable.is<ast::subscript_set>()) {
+      auto& subscript{variable.as<ast::subscript_set>()};
+      line("store_element({checked_array(" + expression(*subscript.list()) +
+           "), " + expression(*subscript.index()) + ", " + value + "});");
+    } else {
+      line(target(variable) + " = " + value + ";");
+    }
+  }
+
+  template <typename vector_type>
+  void write_loop_body(vector_type statements) {
+    _loop_depth++;
+    write_statements(statements);
+    _loop_depth--;
+  }
+
+  void write_for(ast::for_statement& statement) {
+    auto& list{*statement.list()};
+    auto& variable{*statement.variable()};
+    const auto depth{std::to_string(_loop_depth)};
+
+    // Ranges iterated right away count in locals, like in the bytecode VM
+    if (list.is<ast::system_function_call>()) {
+      auto& call{list.as<ast::system_function_call>()};
+      if (call.func == ast::system_function::range1 ||
+          call.func == ast::system_function::range2 ||
+          call.func == ast::system_function::range3) {
+        const auto range{"range_" + depth};
+        line("for (auto " + range + "{make_range(" +
+             enum_text("system_function", call.func) + ", " +
+             arguments(call.arguments()) + ")};");
+        line("     " + range + ".step >= 0 ? " + range + ".next < " + range +
+             ".end : " + range + ".next > " + range + ".end;");
+        line("     step()) {");
+        _indent++;
+        write_store(variable, range + ".next");
+        line(range + ".next += " + range + ".step;");
+        write_loop_body(statement.statements());
+        _indent--;
+        line("}");
+        return;
+      }
+    }
+
+    // Elements stored in an array go through a local of their own scope
+    const bool is_element{variable.is<ast::subscript_set>()};
+    const auto items{"items_" + depth};
+    const auto element{is_element ? "element_" + depth : target(variable)};
+    if (is_element) {
+      line("{");
+      _indent++;
+      line("value " + element + ";");
+    }
+    line("for (iteration " + items + "{" + expression(list) + "}; " + items +
+         ".next(" + element + "); step()) {");
+    _indent++;
+    if (is_element) {
+      write_store(variable, element);
+    }
+    write_loop_body(statement.statements());
+    _indent--;
+    line("}");
+    if (is_element) {
+      _indent--;
+      line("}");
+    }
+  }
+
+  // Expressions
+
+  template <typename vector_type>
+  [[nodiscard]] std::string expressions(vector_type nodes) {
+    std::string result;
+    for (auto& node : nodes) {
+      if (!result.empty()) {
+        result += ", ";
+      }
+      result += expression(*node);
+    }
+    return result;
+  }
+
+  // Pointer to the arguments of a system call
+  template <typename vector_type>
+  [[nodiscard]] std::string arguments(vector_type nodes) {
+    if (nodes.size() == 0) {
+      return "nullptr";
+    }
+    return "values<" + std::to_string(nodes.size()) + ">{{" +
+           expressions(nodes) + "}}.data()";
+  }
+
+  [[nodiscard]] std::string expression(ast::base& node) {
+    return node.apply<std::string>(
+        [&](auto& expression) { return generate(expression); });
+  }
+
+  template <typename node_type>
+  [[nodiscard]] std::string generate(node_type&) {
+    // Refused by the resolver
+    assert(false);
+    return {};
+  }
+
+  [[nodiscard]] std::string generate(ast::unary_expression& unary) {
+    return std::string{unary.op == ast::unary_op::negative ? "negate("
+                                                           : "logical_not("} +
+           expression(*unary.argument()) + ")";
+  }
+
+  [[nodiscard]] std::string generate(ast::binary_expression& binary) {
+    const auto left{expression(*binary.left())};
+    const auto right{expression(*binary.right())};
+    if (binary.op == ast::binary_op::logical_and) {
+      return "[&]() -> value { auto left{" + left +
+             "}; return truthy(left) ? " + right + " : left; }()";
+    }
+    if (binary.op == ast::binary_op::logical_or) {
+      return "[&]() -> value { auto left{" + left +
+             "}; return truthy(left) ? left : " + right + "; }()";
+    }
+
+    static constexpr auto function_map{make_array<const char*>(
+        "add" /* add */, "subtract" /* subtract */, "multiply" /* multiply */,
+        "divide" /* divide */, "equal" /* equal */, "not_equal" /* not_equal */,
+        "less" /* less */, "less_equal" /* less_equal */,
+        "greater" /* greater */, "greater_equal" /* greater_equal */)};
+    return call(function_map[raw_value(binary.op)], left, right,
+                is_pure(*binary.left()) || is_pure(*binary.right()));
+  }
+
+  [[nodiscard]] std::string generate(ast::subscript_get& subscript) {
+    auto& index{*subscript.index()};
+    // asArray runs before the index is evaluated, which only shows when the
+    // index can throw or print
+    if (is_pure(index)) {
+      return call("element", expression(*subscript.list()), expression(index),
+                  true);
+    }
+    return call("element",
+                "checked_array(" + expression(*subscript.list()) + ")",
+                expression(index), false);
+  }
+
+  [[nodiscard]] std::string generate(ast::new_array& init) {
+    return "make_list<" + std::to_string(init.elements().size()) + ">({" +
+           expressions(init.elements()) + "})";
+  }
+
+  [[nodiscard]] std::string generate(ast::new_color& init) {
+    return "env.make_color(" + enum_text("color_mode", init.mode) + ", " +
+           arguments(init.arguments()) + ")";
+  }
+
+  [[nodiscard]] std::string generate(ast::system_function_call& call) {
+    return "env.call(" + enum_text("system_function", call.func) + ", " +
+           arguments(call.arguments()) + ")";
+  }
+
+  [[nodiscard]] std::string generate(ast::user_function_call& call) {
+    const auto index{_program.layout.callees.at(&call)};
+    const auto parameter_count{_program.layout.blocks[index].parameter_count};
+    const auto count{call.arguments().size()};
+    const auto name{block_name(index)};
+    const auto args{"values<" + std::to_string(count) + ">{{" +
+                    expressions(call.arguments()) + "}}"};
+    if (parameter_count == 0) {
+      return count == 0 ? name + "()"
+                        : "(static_cast<void>(" + args + "), " + name + "())";
+    }
+    if (count == parameter_count) {
+      return name + "(" + args + ")";
+    }
+    return name + "(parameters<" + std::to_string(parameter_count) + ">(" +
+           args + "))";
+  }
+
+  // Operands which cannot have effects nor see those of other operands can
+  // be evaluated in any order
+  [[nodiscard]] bool is_pure(const ast::base& node) const {
+    if (node.is<ast::number_literal>() || node.is<ast::string_literal>() ||
+        node.is<ast::bool_literal>()) {
+      return true;
+    }
+    const auto it{_program.layout.variables.find(&node)};
+    return it != _program.layout.variables.end() && !it->second.is_global &&
+           _block.declared[it->second.slot];
+  }
+
+  [[nodiscard]] static std::string call(const char* function,
+                                        const std::string& left,
+                                        const std::string& right,
+                                        bool any_order) {
+    if (any_order) {
+      return std::string{function} + "(" + left + ", " + right + ")";
+    }
+    return std::string{"ordered<"} + function + ">({" + left + ", " + right +
+           "})";
+  }
+
+  [[nodiscard]] std::string read(const ast::base& node) {
+    const auto [is_global, slot]{variable(node)};
+    if (!is_global && !_block.declared[slot]) {
+      return "(throw_reference(" + quoted(_block.locals[slot]) +
+             "), value{})";
+    }
+    return target(node);
+  }
+
+  [[nodiscard]] std::string generate(ast::variable_name& variable) {
+    return read(variable);
+  }
+
+  [[nodiscard]] std::string generate(ast::identifier& identifier) {
+    return read(identifier);
+  }
+
+  [[nodiscard]] std::string generate(ast::number_literal& literal) {
+    return "value{" + number_text(string_to_number(literal.value)) + "}";
+  }
+
+  [[nodiscard]] std::string generate(ast::string_literal& literal) {
+    return _program.string_constant(literal.value);
+  }
+
+  [[nodiscard]] std::string generate(ast::bool_literal& literal) {
+    return literal.value ? "value{true}" : "value{false}";
+  }
+};
+
+}  // namespace
+
+std::string cpp_generator::generate(ast::program& program) {
+  const auto layout{resolve(program)};
+  program_writer writer{layout};
+
+  std::string functions;
+  for (size_t i{0}; i < layout.blocks.size(); i++) {
+    const auto& block{layout.blocks[i]};
+    function_writer function{writer, block, functions};
+    functions += '\n';
+    if (block.block->is<ast::on_start>()) {
+      function.write(block_name(i),
+                     block.block->as<ast::on_start>().statements());
+    } else if (block.block->is<ast::function>()) {
+      function.write(block_name(i),
+                     block.block->as<ast::function>().statements());
+    }
+  }
+
+  std::string globals;
+  for (size_t i{0}; i < layout.globals.size(); i++) {
+    globals += "  value global_" + std::to_string(i) + ";\n";
+  }
+
+  std::string result{
+      "// Generated from a marlin program, built against the runtime of\n"
+      "// marlin::exec\n"
+      "#include \"cpp_runtime.hpp\"\n"
+      "\n"
+      "namespace {\n"
+      "\n"
+      "using namespace marlin::exec;\n"
+      "using namespace marlin::exec::cpp;\n"
+      "using marlin::ast::array_modification;\n"
+      "using marlin::ast::color_mode;\n"
+      "using marlin::ast::system_function;\n"
+      "using marlin::ast::system_procedure;\n"
+      "\n"
+      "struct program : program_base {\n"
+      "  using program_base::program_base;\n"
+      "\n"};
+  if (layout.main_block) {
+    result += "  void main() { static_cast<void>(" +
+              block_name(*layout.main_block) + "()); }\n";
+  } else {
+    result += "  void main() {}\n";
+  }
+  if (!globals.empty()) {
+    result += "\n" + globals;
+  }
+  if (!writer.strings.empty()) {
+    result += "\n" + writer.strings;
+  }
+  result += functions;
+  result +=
+      "};\n"
+      "\n"
+      "}  // namespace\n"
+      "\n"
+      "int main(int argc, char* argv[]) {\n"
+      "  return marlin::exec::cpp::main<program>(argc, argv);\n"
+      "}\n";
+  return result;
+}
+
+}  // namespace marlin::exec
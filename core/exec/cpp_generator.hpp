@@ -0,0 +1,22 @@
+#ifndef marlin_exec_cpp_generator_hpp
+#define marlin_exec_cpp_generator_hpp
+
+#include <string>
+
+#include "ast.hpp"
+
+namespace marlin::exec {
+
+// Translates a program into a C++ source file for batch runs, to be built
+// with the include directories of core/exec and linked against its runtime
+// library. The executable prints the messages of the program and fails with
+// its error, with the same results as exec::interpreter except that errors
+// carry no stack.
+struct cpp_generator {
+  // Throws collected_generation_error like exec::generator
+  [[nodiscard]] std::string generate(ast::program& program);
+};
+
+}  // namespace marlin::exec
+
+#endif  // marlin_exec_cpp_generator_hpp
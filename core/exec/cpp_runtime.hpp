@@ -0,0 +1,212 @@
+#ifndef marlin_exec_cpp_runtime_hpp
+#define marlin_exec_cpp_runtime_hpp
+
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "runtime.hpp"
+
+namespace marlin::exec::cpp {
+
+// Support of the C++ sources exec::cpp_generator produces: operators with
+// the fast paths of the bytecode VM, limits, and the main function of the
+// executable. Operands that must be evaluated in order are passed in braced
+// lists, whose elements are evaluated from left to right, unlike function
+// arguments.
+
+template <size_t count>
+using values = std::array<value, count>;
+
+struct options {
+  exec::environment::options environment;
+  // Loop iterations before stopping with a RangeError, 0 for no limit
+  uint64_t max_steps{0};
+  size_t max_call_depth{1000};
+};
+
+// Generated programs derive from it, their functions being members
+struct program_base {
+  explicit program_base(const options& opts)
+      : env{opts.environment}, _options{opts} {}
+
+  environment env;
+
+  void step() {
+    if (_options.max_steps != 0 && ++_steps > _options.max_steps) {
+      throw runtime_error{"RangeError", "Maximum number of steps exceeded."};
+    }
+  }
+
+  // Held by user functions while they run
+  struct call_guard {
+    explicit call_guard(program_base& program) : _program{program} {
+      if (_program._depth >= _program._options.max_call_depth) {
+        throw runtime_error{"RangeError", "Maximum call stack size exceeded."};
+      }
+      _program._depth++;
+    }
+    ~call_guard() { _program._depth--; }
+
+    call_guard(const call_guard&) = delete;
+    call_guard& operator=(const call_guard&) = delete;
+
+   private:
+    program_base& _program;
+  };
+
+ private:
+  const options& _options;
+  uint64_t _steps{0};
+  size_t _depth{0};
+};
+
+[[noreturn]] inline void throw_reference(const char* name) {
+  throw runtime_error{"ReferenceError",
+                      std::string{"Can't find variable: "} + name};
+}
+
+[[nodiscard]] inline bool truthy(const value& v) noexcept {
+  return v.is(value::type::boolean) ? v.boolean() : to_boolean(v);
+}
+
+[[nodiscard]] inline value negate(const value& argument) {
+  if (argument.is(value::type::number)) {
+    return -argument.number();
+  }
+  return unary(ast::unary_op::negative, argument);
+}
+
+[[nodiscard]] inline value logical_not(const value& argument) {
+  return !truthy(argument);
+}
+
+#define _CPP_RUNTIME_OPERATOR_TEMPLATE(NAME, OPERATOR)                      \
+  [[nodiscard]] inline value NAME(const value& left, const value& right) {  \
+    if (left.is(value::type::number) && right.is(value::type::number)) {    \
+      return left.number() OPERATOR right.number();                         \
+    }                                                                       \
+    return binary(ast::binary_op::NAME, left, right);                       \
+  }
+
+_CPP_RUNTIME_OPERATOR_TEMPLATE(add, +)
+_CPP_RUNTIME_OPERATOR_TEMPLATE(subtract, -)
+_CPP_RUNTIME_OPERATOR_TEMPLATE(multiply, *)
+_CPP_RUNTIME_OPERATOR_TEMPLATE(divide, /)
+_CPP_RUNTIME_OPERATOR_TEMPLATE(less, <)
+_CPP_RUNTIME_OPERATOR_TEMPLATE(less_equal, <=)
+_CPP_RUNTIME_OPERATOR_TEMPLATE(greater, >)
+_CPP_RUNTIME_OPERATOR_TEMPLATE(greater_equal, >=)
+
+#undef _CPP_RUNTIME_OPERATOR_TEMPLATE
+
+[[nodiscard]] inline value equal(const value& left, const value& right) {
+  return strict_equal(left, right);
+}
+
+[[nodiscard]] inline value not_equal(const value& left, const value& right) {
+  return !strict_equal(left, right);
+}
+
+[[nodiscard]] inline value element(const value& list, const value& index) {
+  if (list.is(value::type::array) && index.is(value::type::number)) {
+    const auto& elements{*list.array()};
+    const auto i{index.number()};
+    if (i >= 0 && i < elements.size() && i == std::floor(i)) {
+      return elements[static_cast<size_t>(i)];
+    }
+  }
+  return get_element(list, index);
+}
+
+// Binary operations whose operands both have effects take them in order
+template <value (*operation)(const value&, const value&)>
+[[nodiscard]] value ordered(const values<2>& operands) {
+  return operation(operands[0], operands[1]);
+}
+
+// The list of a subscript, checked before its index is evaluated
+[[nodiscard]] inline value checked_array(value list) {
+  static_cast<void>(as_array(list));
+  return list;
+}
+
+inline void store_element(values<3> operands) {
+  set_element(operands[0], operands[1], std::move(operands[2]));
+}
+
+template <size_t count>
+[[nodiscard]] value make_list(values<count> elements) {
+  return std::make_shared<array>(std::make_move_iterator(elements.begin()),
+                                 std::make_move_iterator(elements.end()));
+}
+
+template <size_t count>
+void modify(environment& env, ast::array_modification mod,
+            const values<count>& operands) {
+  env.modify(mod, operands[0], operands.data() + 1);
+}
+
+// Arguments past the parameters of a function are evaluated and dropped
+template <size_t parameter_count, size_t count>
+[[nodiscard]] values<parameter_count> parameters(values<count> arguments) {
+  values<parameter_count> result;
+  for (size_t i{0}; i < parameter_count && i < count; i++) {
+    result[i] = std::move(arguments[i]);
+  }
+  return result;
+}
+
+template <typename program_type>
+[[nodiscard]] run_result run(const options& opts) {
+  program_type program{opts};
+
+  run_result result;
+  try {
+    program.main();
+  } catch (runtime_error& e) {
+    result.error = std::move(e);
+  }
+  result.elapsed = program.env.elapsed();
+  result.printed = std::move(program.env).printed();
+  result.commands = std::move(program.env).commands();
+  return result;
+}
+
+// Prints the messages of the program to stdout and its error to stderr,
+// failing with it. Accepts --seed, --start-time and --max-steps.
+template <typename program_type>
+int main(int argc, char* argv[]) {
+  options opts;
+  for (int i{1}; i + 1 < argc; i += 2) {
+    const std::string arg{argv[i]};
+    if (arg == "--seed") {
+      opts.environment.random_seed = std::strtoull(argv[i + 1], nullptr, 10);
+    } else if (arg == "--start-time") {
+      opts.environment.start_time = std::strtod(argv[i + 1], nullptr);
+    } else if (arg == "--max-steps") {
+      opts.max_steps = std::strtoull(argv[i + 1], nullptr, 10);
+    }
+  }
+
+  const auto result{run<program_type>(opts)};
+  for (const auto& printed : result.printed) {
+    std::printf("%s\n", printed.message.c_str());
+  }
+  if (result.error) {
+    std::fprintf(stderr, "%s: %s\n", result.error->name().c_str(),
+                 result.error->what());
+    return 1;
+  }
+  return 0;
+}
+
+}  // namespace marlin::exec::cpp
+
+#endif  // marlin_exec_cpp_runtime_hpp
@@ -2,6 +2,8 @@
 #define marlin_exec_errors_hpp
 
 #include <stdexcept>
+#include <string>
+#include <vector>
 
 #include "base.hpp"
 #include "utils.hpp"
@@ -45,6 +47,35 @@ struct collected_generation_error : std::exception {
   std::vector<generation_error> _errors;
 };
 
+// Error thrown by a program run natively, named like the JavaScript error
+// the same program would throw in exec_env.js
+struct runtime_error : std::exception {
+  inline runtime_error(std::string name, std::string message)
+      : _name{std::move(name)}, _message{std::move(message)} {}
+
+  [[nodiscard]] const char* what() const noexcept override {
+    return _message.data();
+  }
+
+  [[nodiscard]] inline const std::string& name() const noexcept {
+    return _name;
+  }
+
+  // Node where the error occurred, then the calls that led to it, the same
+  // nodes parse_stacktrace finds for an error of the generated code
+  [[nodiscard]] inline const std::vector<const ast::base*>& stack()
+      const noexcept {
+    return _stack;
+  }
+
+  inline void add_frame(const ast::base& node) { _stack.push_back(&node); }
+
+ private:
+  std::string _name;
+  std::string _message;
+  std::vector<const ast::base*> _stack;
+};
+
 };  // namespace marlin::exec
 
 #endif  // marlin_parse_errors_hpp
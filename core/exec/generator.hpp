@@ -3,8 +3,12 @@
 
 #include <algorithm>
 #include <array>
-#include <deque>
+#include <cstdint>
+#include <iterator>
+#include <optional>
+#include <string>
 #include <type_traits>
+#include <unordered_map>
 #include <unordered_set>
 #include <utility>
 #include <vector>
@@ -12,67 +16,166 @@
 #include <jsast/jsast.hpp>
 
 #include "ast.hpp"
+#include "call_graph.hpp"
+#include "constant_folder.hpp"
 #include "exec_errors.hpp"
+#include "js_writer.hpp"
+#include "source_map.hpp"
+#include "type_inference.hpp"
 
 namespace marlin::exec {
 
+// JavaScript of a block, with what it depended on besides the block itself
+struct js_block {
+  uint64_t revision;
+  std::string source;
+  // Line breaks in the source
+  size_t lines;
+  // Nodes written in the source, as if it started the script
+  js_mappings mappings;
+
+  bool async;
+  bool profiled;
+  bool optimized;
+  // How each call to a user function in the block was generated
+  std::vector<uint8_t> call_states;
+  // Globals declared by the blocks before, and those left for the next one
+  std::vector<std::string> globals_before;
+  std::vector<std::string> globals_after;
+};
+
+// Keeps the JavaScript of each block generated before, so that a generator
+// only rebuilds the blocks edited since, or whose async status or calls
+// changed. Entries are checked against the revision of the block, blocks
+// with generation errors are never kept.
+struct js_cache {
+  [[nodiscard]] js_block* find(const ast::base& block) {
+    if (auto it{_blocks.find(&block)};
+        it != _blocks.end() && it->second.revision == block.revision()) {
+      return &it->second;
+    }
+    return nullptr;
+  }
+
+  void store(const ast::base& block, js_block value) {
+    _blocks.insert_or_assign(&block, std::move(value));
+  }
+
+  // Drops the entries of the blocks not in the program
+  void retain(const std::unordered_set<const ast::base*>& blocks) {
+    for (auto it{_blocks.begin()}; it != _blocks.end();) {
+      it = blocks.find(it->first) == blocks.end() ? _blocks.erase(it)
+                                                  : std::next(it);
+    }
+  }
+
+  void clear() noexcept {
+    _blocks.clear();
+    _hits = 0;
+  }
+
+  [[nodiscard]] size_t size() const noexcept { return _blocks.size(); }
+  [[nodiscard]] size_t hits() const noexcept { return _hits; }
+  void record_hit() noexcept { _hits++; }
+
+ private:
+  std::unordered_map<const ast::base*, js_block> _blocks;
+  size_t _hits{0};
+};
+
 struct generator {
+  friend call_graph;
+
+  // How the JavaScript is produced: from a jsast tree, or written straight
+  // from the marlin AST without building one, to the same text
+  enum struct output { tree, stream };
+
+  explicit generator(output mode = output::stream) : _output{mode} {}
+  generator(js_cache& cache, call_graph& calls,
+            output mode = output::stream)
+      : _output{mode}, _cache{&cache}, _calls{&calls} {}
+
+  // Has the script sample the statement running about every interval
+  // seconds, for exec::profile, 0 not to. Only written by the stream output.
+  void set_profile_interval(double interval) noexcept {
+    _profile_interval = interval;
+  }
+
+  // Folds constant expressions, and leaves out the branches they make
+  // unreachable and the statements that write nothing. Calls and subscripts
+  // whose arguments are proven of the types the runtime checks go without
+  // the checks. On by default.
+  void set_optimize(bool optimize) noexcept { _optimize = optimize; }
+
   std::string generate(ast::base& c) {
+    source_map map;
+    return generate(c, map);
+  }
+
+  // Also maps the JavaScript back to the nodes of the program, until it is
+  // edited again
+  std::string generate(ast::base& c, source_map& map) {
     assert(c.is<ast::program>());
-    jsast::generator gen;
-
-    // Mark async blocks
-    _async_blocks.clear();
-    _user_functions.clear();
-    _user_function_callees.clear();
-    for (auto& block : c.children()) {
-      record_calls(*block, *block);
-
-      if (block->is<ast::function>()) {
-        auto signature{block->as<ast::function>().signature()};
-        if (signature->is<ast::function_signature>()) {
-          _user_functions[signature->as<ast::function_signature>().name] =
-              &*block;
-        }
-      }
+    assert(_profile_interval == 0 || _output == output::stream);
+    auto& program{c.as<ast::program>()};
+    auto blocks{program.blocks()};
+    js_cache uncached_blocks;
+    auto& cache{_cache != nullptr ? *_cache : uncached_blocks};
+    call_graph uncached_calls;
+    _graph = _calls != nullptr ? _calls : &uncached_calls;
+    _graph->update(program);
+
+    _errors.clear();
+    _global_identifiers.clear();
+    _mappings.clear();
+    std::string result;
+    size_t line_offset{0};
+    std::unordered_set<const ast::base*> present;
+    for (size_t i{0}; i < blocks.size(); i++) {
+      auto& block{*blocks[i]};
+      present.emplace(&block);
+      auto* entry{cache.find(block)};
+      const auto& block_source{
+          generate_block(block, entry, cache, line_offset)};
+      result += block_source;
+      result += '\n';
+      line_offset += entry != nullptr ? entry->lines + 1
+                                      : count_lines(block_source) + 1;
     }
-    {
-      std::deque<ast::base*> queue;
-      std::copy(_async_blocks.begin(), _async_blocks.end(),
-                std::back_inserter(queue));
-      while (!queue.empty()) {
-        auto block{queue.front()};
-        queue.pop_front();
-
-        if (block->is<ast::function>()) {
-          auto signature{block->as<ast::function>().signature()};
-          if (signature->is<ast::function_signature>()) {
-            auto it{_user_function_callees.find(
-                signature->as<ast::function_signature>().name)};
-            if (it != _user_function_callees.end()) {
-              for (auto block : it->second) {
-                if (_async_blocks.find(block) == _async_blocks.end()) {
-                  _async_blocks.emplace(block);
-                  queue.emplace_back(block);
-                }
-              }
-            }
-          }
-        }
+    if (_output == output::tree) {
+      jsast::generator gen;
+      gen.write(jsast::ast::expression_statement{jsast::ast::call_expression{
+          env_name("execute"), {jsast::ast::identifier{main_name}}}});
+      result += std::move(gen).str();
+    } else {
+      js_writer writer;
+      if (_profile_interval > 0) {
+        write_env_name(writer, "profile");
+        writer.write("(");
+        writer.write(main_name);
+        writer.write(", ");
+        writer.write(std::to_string(_profile_interval));
+        writer.write(");");
+      } else {
+        write_env_name(writer, "execute");
+        writer.write("(");
+        writer.write(main_name);
+        writer.write(");");
       }
+      result += std::move(writer).str();
     }
+    result += '\n';
+    cache.retain(present);
+    map = source_map{std::move(_mappings)};
 
-    _errors.clear();
-    gen.write(get_node(c));
-
-    _async_blocks.clear();
-    _user_functions.clear();
-    _user_function_callees.clear();
+    _graph = nullptr;
+    _global_identifiers.clear();
+    _mappings.clear();
 
     if (_errors.size()) {
       throw collected_generation_error{std::exchange(_errors, {})};
     } else {
-      return std::move(gen).str();
+      return result;
     }
   }
 
@@ -96,126 +199,315 @@ struct generator {
         jsast::ast::member_identifier{std::move(name)}};
   }
 
-  using callee_maker = jsast::ast::node (*)();
-  using callee_entry = std::pair<callee_maker, bool>;
-  static constexpr auto array_modification_callee_map{make_array<callee_entry>(
-      std::pair{[]() { return system_callee("ArrayUtils", "append"); },
-                false} /* append */,
-      std::pair{[]() { return system_callee("ArrayUtils", "insert"); },
-                false} /* insert */,
-      std::pair{[]() { return system_callee("ArrayUtils", "remove"); },
-                false} /* remove */)};
-  static constexpr auto system_procedure_callee_map{make_array<callee_entry>(
-      std::pair{[]() { return env_name("sleep"); }, true} /* sleep */,
-      std::pair{[]() { return env_name("print"); }, false} /* print */,
-      std::pair{[]() { return system_callee("Graphics", "drawLine"); },
-                true} /* draw_line */,
-      std::pair{[]() { return system_callee("Graphics", "drawArc"); },
-                true} /* draw_arc */,
-      std::pair{[]() { return system_callee("Graphics", "drawRect"); },
-                true} /* draw_rect */,
-      std::pair{[]() { return system_callee("Graphics", "drawEllipse"); },
-                true} /* draw_ellipse */,
-      std::pair{[]() { return system_callee("Graphics", "clearCanvas"); },
-                false} /* clear_canvas */,
-      std::pair{[]() { return system_callee("Graphics", "setLineWidth"); },
-                false} /* set_line_width */,
-      std::pair{[]() { return system_callee("Graphics", "setLineColor"); },
-                false} /* set_line_color */,
-      std::pair{[]() { return system_callee("Graphics", "setFillColor"); },
-                false} /* set_fill_color */,
-      std::pair{[]() { return system_callee("Logo", "forward"); },
-                true} /* logo_forward */,
-      std::pair{[]() { return system_callee("Logo", "backward"); },
-                true} /* logo_backward */,
-      std::pair{[]() { return system_callee("Logo", "turnLeft"); },
-                false} /* logo_turn_left */,
-      std::pair{[]() { return system_callee("Logo", "turnRight"); },
-                false} /* logo_turn_right */,
-      std::pair{[]() { return system_callee("Logo", "penUp"); },
-                false} /* logo_pen_up */,
-      std::pair{[]() { return system_callee("Logo", "penDown"); },
-                false} /* logo_pen_down */,
-      std::pair{[]() { return system_callee("Logo", "goHome"); },
-                true} /* logo_go_home */)};
-  static constexpr auto system_function_callee_map{make_array<callee_entry>(
-      std::pair{[]() { return env_name("range"); }, false} /* range1 */,
-      std::pair{[]() { return env_name("range"); }, false} /* range2 */,
-      std::pair{[]() { return env_name("range"); }, false} /* range3 */,
-      std::pair{[]() { return system_callee("MathUtils", "random"); },
-                false} /* random */,
-      std::pair{[]() { return system_callee("ArrayUtils", "length"); },
-                false} /* list_length */,
-      std::pair{[]() { return env_name("time"); }, false} /* time */,
-      std::pair{[]() { return system_callee("MathUtils", "abs"); },
-                false} /* abs */,
-      std::pair{[]() { return system_callee("MathUtils", "sqrt"); },
-                false} /* sqrt */,
-      std::pair{[]() { return system_callee("MathUtils", "sin"); },
-                false} /* sin */,
-      std::pair{[]() { return system_callee("MathUtils", "cos"); },
-                false} /* cos */,
-      std::pair{[]() { return system_callee("MathUtils", "tan"); },
-                false} /* tan */,
-      std::pair{[]() { return system_callee("MathUtils", "asin"); },
-                false} /* asin */,
-      std::pair{[]() { return system_callee("MathUtils", "acos"); },
-                false} /* acos */,
-      std::pair{[]() { return system_callee("MathUtils", "atan"); },
-                false} /* atan */,
-      std::pair{[]() { return system_callee("MathUtils", "ln"); },
-                false} /* ln */,
-      std::pair{[]() { return system_callee("MathUtils", "log"); },
-                false} /* log */,
-      std::pair{[]() { return system_callee("MathUtils", "round"); },
-                false} /* round */,
-      std::pair{[]() { return system_callee("MathUtils", "floor"); },
-                false} /* floor */,
-      std::pair{[]() { return system_callee("MathUtils", "ceil"); },
-                false} /* ceil */)};
-
-  std::unordered_set<ast::base*> _async_blocks;
-  std::unordered_map<std::string_view, ast::base*> _user_functions;
-  std::unordered_map<std::string_view, std::unordered_set<ast::base*>>
-      _user_function_callees;
+  // Procedure or function of window.env, or of one of its modules. Those
+  // checking their arguments have a twin that does not, named with
+  // "Unchecked" appended, and the types they check: 'n' for a number, 'a'
+  // for an array, 'c' for a color and '-' for none.
+  struct callee {
+    const char* module;
+    const char* name;
+    bool async;
+    const char* checks;
+  };
+
+  static constexpr const char* unchecked_suffix{"Unchecked"};
+
+  static jsast::ast::node callee_node(const callee& entry, bool unchecked) {
+    std::string name{entry.name};
+    if (unchecked) {
+      name += unchecked_suffix;
+    }
+    return entry.module != nullptr
+               ? system_callee(entry.module, std::move(name))
+               : env_name(std::move(name));
+  }
+
+  static constexpr auto array_modification_callee_map{make_array<callee>(
+      callee{"ArrayUtils", "append", false, "a-"} /* append */,
+      callee{"ArrayUtils", "insert", false, "an-"} /* insert */,
+      callee{"ArrayUtils", "remove", false, "an"} /* remove */)};
+  static constexpr auto system_procedure_callee_map{make_array<callee>(
+      callee{nullptr, "sleep", true, "n"} /* sleep */,
+      callee{nullptr, "print", false, nullptr} /* print */,
+      callee{"Graphics", "drawLine", true, "nnnn"} /* draw_line */,
+      callee{"Graphics", "drawArc", true, "nnnnn"} /* draw_arc */,
+      callee{"Graphics", "drawRect", true, "nnnn"} /* draw_rect */,
+      callee{"Graphics", "drawEllipse", true, "nnnn"} /* draw_ellipse */,
+      callee{"Graphics", "clearCanvas", false, "c"} /* clear_canvas */,
+      callee{"Graphics", "setLineWidth", false, "n"} /* set_line_width */,
+      callee{"Graphics", "setLineColor", false, "c"} /* set_line_color */,
+      callee{"Graphics", "setFillColor", false, "c"} /* set_fill_color */,
+      callee{"Logo", "forward", true, "n"} /* logo_forward */,
+      callee{"Logo", "backward", true, "n"} /* logo_backward */,
+      callee{"Logo", "turnLeft", false, "n"} /* logo_turn_left */,
+      callee{"Logo", "turnRight", false, "n"} /* logo_turn_right */,
+      callee{"Logo", "penUp", false, nullptr} /* logo_pen_up */,
+      callee{"Logo", "penDown", false, nullptr} /* logo_pen_down */,
+      callee{"Logo", "goHome", true, nullptr} /* logo_go_home */)};
+  static constexpr auto system_function_callee_map{make_array<callee>(
+      callee{nullptr, "range", false, nullptr} /* range1 */,
+      callee{nullptr, "range", false, nullptr} /* range2 */,
+      callee{nullptr, "range", false, nullptr} /* range3 */,
+      callee{"MathUtils", "random", false, "nn"} /* random */,
+      callee{"ArrayUtils", "length", false, "a"} /* list_length */,
+      callee{nullptr, "time", false, nullptr} /* time */,
+      callee{"MathUtils", "abs", false, "n"} /* abs */,
+      callee{"MathUtils", "sqrt", false, "n"} /* sqrt */,
+      callee{"MathUtils", "sin", false, "n"} /* sin */,
+      callee{"MathUtils", "cos", false, "n"} /* cos */,
+      callee{"MathUtils", "tan", false, "n"} /* tan */,
+      callee{"MathUtils", "asin", false, "n"} /* asin */,
+      callee{"MathUtils", "acos", false, "n"} /* acos */,
+      callee{"MathUtils", "atan", false, "n"} /* atan */,
+      callee{"MathUtils", "ln", false, "n"} /* ln */,
+      callee{"MathUtils", "log", false, "n"} /* log */,
+      callee{"MathUtils", "round", false, "n"} /* round */,
+      callee{"MathUtils", "floor", false, "n"} /* floor */,
+      callee{"MathUtils", "ceil", false, "n"} /* ceil */)};
+  static constexpr auto new_color_callee_map{make_array<callee>(
+      callee{"ColorUtils", "rgb", false, "nnn"} /* rgb */,
+      callee{"ColorUtils", "rgba", false, "nnnn"} /* rgba */,
+      callee{"ColorUtils", "hsl", false, "nnn"} /* hsl */,
+      callee{"ColorUtils", "hsla", false, "nnnn"} /* hsla */)};
 
   std::unordered_set<std::string_view> _global_identifiers;
   std::vector<generation_error> _errors;
 
-  void record_calls(ast::base& node, ast::base& block) {
-    node.apply<void>([this, &block](auto& n) { record_if_is_call(n, block); });
-    for (auto& child : node.children()) {
-      record_calls(*child, block);
+  output _output;
+  double _profile_interval{0};
+  bool _optimize{true};
+  constant_folder _folder;
+  type_inference _types;
+  js_cache* _cache{nullptr};
+  call_graph* _calls{nullptr};
+  // Graph of the generation under way, _calls or one of its own
+  call_graph* _graph{nullptr};
+  std::string _block_source;
+  // Mappings of the block being written, and of the script so far
+  js_mappings _block_mappings;
+  js_mappings _mappings;
+
+  [[nodiscard]] static size_t count_lines(const std::string& source) {
+    return static_cast<size_t>(
+        std::count(source.begin(), source.end(), '\n'));
+  }
+
+  [[nodiscard]] std::vector<std::string> sorted_globals() const {
+    std::vector<std::string> globals{_global_identifiers.begin(),
+                                     _global_identifiers.end()};
+    std::sort(globals.begin(), globals.end());
+    return globals;
+  }
+
+  // How a call is generated: an error, a plain call or an awaited one
+  [[nodiscard]] uint8_t call_state(ast::user_function_call& call) {
+    if (call.func() == nullptr ||
+        call.arguments().size() != call.func()->parameters.size()) {
+      return 0;
+    }
+    const auto* callee{_graph->function(call.name)};
+    if (callee == nullptr) {
+      return 0;
+    }
+    return _graph->is_async(*callee) ? 2 : 1;
+  }
+
+  [[nodiscard]] std::vector<uint8_t> call_states(
+      const std::vector<ast::user_function_call*>& calls) {
+    std::vector<uint8_t> states;
+    states.reserve(calls.size());
+    for (auto* call : calls) {
+      states.push_back(call_state(*call));
     }
+    return states;
   }
 
-  template <typename node_type>
-  void record_if_is_call(node_type&, ast::base&) {}
+  // Source of the block, from the cache when nothing it depends on changed.
+  // Entry is updated to the one used, if kept.
+  const std::string& generate_block(ast::base& block, js_block*& entry,
+                                    js_cache& cache, size_t line_offset) {
+    // Functions see the globals declared before them since the last
+    // on_start, an on_start starts afresh
+    auto globals_before{block.is<ast::on_start>()
+                            ? std::vector<std::string>{}
+                            : sorted_globals()};
+    const auto async{_graph->is_async(block)};
+    const auto& calls{_graph->calls(block)};
+    const auto profiled{_profile_interval > 0};
+    if (entry != nullptr && entry->async == async &&
+        entry->profiled == profiled && entry->optimized == _optimize &&
+        entry->globals_before == globals_before &&
+        entry->call_states == call_states(calls)) {
+      cache.record_hit();
+      _mappings.append(entry->mappings, line_offset);
+      _global_identifiers.clear();
+      for (const auto& name : entry->globals_after) {
+        _global_identifiers.emplace(name);
+      }
+      return entry->source;
+    }
 
-  void record_if_is_call(ast::modify_array& call, ast::base& block) {
-    auto [node_maker,
-          async]{array_modification_callee_map[raw_value(call.mod)]};
-    if (async) {
-      _async_blocks.emplace(&block);
+    const auto error_count{_errors.size()};
+    if (_optimize) {
+      _folder.fold(block);
+      _types.infer(block, globals_before, _folder);
+    } else {
+      _folder.clear();
+      _types.clear();
+    }
+    if (_output == output::tree) {
+      jsast::generator gen;
+      gen.write(get_node(block));
+      _block_source = std::move(gen).str();
+      _block_mappings = js_mappings::of_ranges(std::move(_ranges));
+      _ranges.clear();
+    } else {
+      _writer = js_writer{};
+      _block_mappings.clear();
+      write_node(block);
+      _block_source = std::move(_writer).str();
+    }
+    _mappings.append(_block_mappings, line_offset);
+    if (_cache == nullptr || _errors.size() != error_count) {
+      entry = nullptr;
+      return _block_source;
     }
+    cache.store(block, {block.revision(), _block_source,
+                        count_lines(_block_source),
+                        std::move(_block_mappings), async, profiled,
+                        _optimize,
+                        call_states(calls), std::move(globals_before),
+                        sorted_globals()});
+    entry = cache.find(block);
+    return entry->source;
   }
-  void record_if_is_call(ast::system_procedure_call& call, ast::base& block) {
-    auto [node_maker, async]{system_procedure_callee_map[raw_value(call.proc)]};
-    if (async) {
-      _async_blocks.emplace(&block);
+
+  // Whether the node calls an async system procedure or function
+  static bool is_async_call(const ast::base& node) {
+    if (node.is<ast::modify_array>()) {
+      const auto mod{node.as<ast::modify_array>().mod};
+      return array_modification_callee_map[raw_value(mod)].async;
+    } else if (node.is<ast::system_procedure_call>()) {
+      const auto proc{node.as<ast::system_procedure_call>().proc};
+      return system_procedure_callee_map[raw_value(proc)].async;
+    } else if (node.is<ast::system_function_call>()) {
+      const auto func{node.as<ast::system_function_call>().func};
+      return system_function_callee_map[raw_value(func)].async;
+    } else {
+      return false;
     }
   }
-  void record_if_is_call(ast::system_function_call& call, ast::base& block) {
-    auto [node_maker, async]{system_function_callee_map[raw_value(call.func)]};
-    if (async) {
-      _async_blocks.emplace(&block);
+
+  // Value to write instead of the expression, if it is constant
+  [[nodiscard]] const value* folded(const ast::base& node) const {
+    return node.is<ast::unary_expression>() ||
+                   node.is<ast::binary_expression>()
+               ? _folder.constant(node)
+               : nullptr;
+  }
+
+  // Empty types are those of code never reached, they prove nothing
+  [[nodiscard]] static bool is_proven_within(const js_type& type,
+                                             const js_type& kind) {
+    return type.kinds != 0 && type.is_within(kind);
+  }
+
+  [[nodiscard]] bool is_array(const ast::base& node) const {
+    return is_proven_within(_types.type(node), js_type::array);
+  }
+
+  // Whether the arguments are proven of the types the callee checks, the
+  // first one apart if given
+  template <typename vector_type>
+  [[nodiscard]] bool is_unchecked(
+      const callee& entry, vector_type arguments,
+      const ast::base* first_argument = nullptr) const {
+    if (entry.checks == nullptr) {
+      return false;
+    }
+    const std::string_view checks{entry.checks};
+    size_t index{0};
+    const auto is_proven{[this, &checks, &index](const ast::base& argument) {
+      if (index >= checks.size()) {
+        return false;
+      }
+      const auto type{_types.type(argument)};
+      switch (checks[index++]) {
+        case 'n':
+          return is_proven_within(type, js_type::number);
+        case 'a':
+          return is_proven_within(type, js_type::array);
+        case 'c':
+          return is_proven_within(type, js_type::color);
+        default:
+          return true;
+      }
+    }};
+    if (first_argument != nullptr && !is_proven(*first_argument)) {
+      return false;
     }
+    for (auto& argument : arguments) {
+      if (!is_proven(*argument)) {
+        return false;
+      }
+    }
+    return index == checks.size();
   }
-  void record_if_is_call(ast::user_function_call& call, ast::base& block) {
-    _user_function_callees[call.name].emplace(&block);
+
+  // Statements checked, but that write nothing once optimized
+  [[nodiscard]] bool is_left_out(const ast::base& statement) const {
+    if (!_optimize) {
+      return false;
+    } else if (statement.is<ast::use_global>()) {
+      return true;
+    } else if (statement.is<ast::if_statement>()) {
+      return _folder.condition(
+                 *statement.as<ast::if_statement>().condition()) == false &&
+             !declares_local(statement);
+    } else if (statement.is<ast::while_statement>()) {
+      return _folder.condition(
+                 *statement.as<ast::while_statement>().condition()) == false &&
+             !declares_local(statement);
+    } else {
+      return false;
+    }
+  }
+
+  // Branch an if else statement is reduced to, kept whole when the other
+  // branch declares a local that JavaScript hoists out of it
+  [[nodiscard]] std::optional<bool> taken_branch(
+      const ast::if_else_statement& statement) const {
+    const auto taken{_folder.condition(*statement.condition())};
+    if (!taken) {
+      return std::nullopt;
+    }
+    for (const auto& left_out :
+         *taken ? statement.alternate() : statement.consequence()) {
+      if (declares_local(*left_out)) {
+        return std::nullopt;
+      }
+    }
+    return taken;
   }
 
-  bool is_local_identifier(ast::base& node) {
+  [[nodiscard]] bool declares_local(const ast::base& node) const {
+    if (node.is<ast::assignment>() &&
+        is_local_identifier(*node.as<ast::assignment>().variable())) {
+      return true;
+    } else if (node.is<ast::for_statement>() &&
+               is_local_identifier(
+                   *node.as<ast::for_statement>().variable())) {
+      return true;
+    }
+    for (const auto& child : node.children()) {
+      if (declares_local(*child)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  [[nodiscard]] bool is_local_identifier(const ast::base& node) const {
     if (node.is<ast::identifier>() &&
         _global_identifiers.find(node.as<ast::identifier>().name) ==
             _global_identifiers.end()) {
@@ -233,19 +525,34 @@ struct generator {
   auto get_block(vector_type vector) {
     jsast::utils::move_vector<jsast::ast::node> statements;
     for (auto& statement : vector) {
-      statements.emplace_back(get_node(*statement));
+      if (is_left_out(*statement)) {
+        static_cast<void>(get_node(*statement));
+      } else {
+        statements.emplace_back(get_node(*statement));
+      }
     }
     return jsast::ast::block_statement{std::move(statements)};
   }
 
+  // Ranges the nodes of the block were written to, as jsast reports them
+  std::vector<std::pair<source_range, ast::base*>> _ranges;
+
   jsast::ast::node get_node(ast::base& c) {
-    return c.apply<jsast::ast::node>([this](auto& node) {
-      return get_jsast(node, [&node](auto js_node) {
-        return jsast::ast::node{
-            std::move(js_node),
-            [&node](source_range range) { node._js_range = range; }};
-      });
-    });
+    const auto wrapper{[this, &c](auto js_node) {
+      return jsast::ast::node{
+          std::move(js_node),
+          [this, &c](source_range range) { _ranges.emplace_back(range, &c); }};
+    }};
+    if (const auto* constant{folded(c)}) {
+      if (constant->is(value::type::string)) {
+        return wrapper(jsast::ast::string_literal{constant->string()});
+      } else {
+        return wrapper(
+            jsast::ast::raw_literal{constant_folder::js_literal(*constant)});
+      }
+    }
+    return c.apply<jsast::ast::node>(
+        [this, &wrapper](auto& node) { return get_jsast(node, wrapper); });
   }
 
   template <typename wrapper_type>
@@ -276,14 +583,9 @@ struct generator {
 
   template <typename wrapper_type>
   auto get_jsast(ast::program& program, wrapper_type&& wrapper) {
-    jsast::utils::move_vector<jsast::ast::node> blocks;
-    for (auto& block : program.blocks()) {
-      blocks.emplace_back(get_node(*block));
-    }
-    blocks.emplace_back(
-        jsast::ast::expression_statement{jsast::ast::call_expression{
-            env_name("execute"), {jsast::ast::identifier{main_name}}}});
-    return wrapper(jsast::ast::program{std::move(blocks)});
+    // This should never be called, blocks are generated one by one
+    _errors.emplace_back("Unexpected program!", program);
+    return wrapper(jsast::ast::identifier{"__error__"});
   }
 
   template <typename wrapper_type>
@@ -291,7 +593,7 @@ struct generator {
     _global_identifiers.clear();
     auto block{get_block(start.statements())};
 
-    auto async{_async_blocks.find(&start) != _async_blocks.end()};
+    auto async{_graph->is_async(start)};
     return wrapper(jsast::ast::function_declaration{
         main_name, {}, jsast::ast::block_statement{std::move(block)}, async});
   }
@@ -325,7 +627,7 @@ struct generator {
 
       _global_identifiers.clear();
 
-      auto async{_async_blocks.find(&function) != _async_blocks.end()};
+      auto async{_graph->is_async(function)};
       return wrapper(jsast::ast::function_declaration{
           user_function_name(signature.name), std::move(params),
           jsast::ast::block_statement{std::move(block)}, async});
@@ -378,15 +680,16 @@ struct generator {
     for (auto& arg : call.arguments()) {
       args.emplace_back(get_node(*arg));
     }
-    auto [node_maker,
-          async]{array_modification_callee_map[raw_value(call.mod)]};
-    if (async) {
-      return wrapper(
-          jsast::ast::expression_statement{jsast::ast::await_expression{
-              jsast::ast::call_expression{node_maker(), std::move(args)}}});
+    const auto& entry{array_modification_callee_map[raw_value(call.mod)]};
+    auto callee{callee_node(
+        entry, is_unchecked(entry, call.arguments(), &*call.array()))};
+    if (entry.async) {
+      return wrapper(jsast::ast::expression_statement{
+          jsast::ast::await_expression{jsast::ast::call_expression{
+              std::move(callee), std::move(args)}}});
     } else {
       return wrapper(jsast::ast::expression_statement{
-          jsast::ast::call_expression{node_maker(), std::move(args)}});
+          jsast::ast::call_expression{std::move(callee), std::move(args)}});
     }
   }
 
@@ -396,25 +699,34 @@ struct generator {
     for (auto& arg : call.arguments()) {
       args.emplace_back(get_node(*arg));
     }
-    auto [node_maker, async]{system_procedure_callee_map[raw_value(call.proc)]};
-    if (async) {
-      return wrapper(
-          jsast::ast::expression_statement{jsast::ast::await_expression{
-              jsast::ast::call_expression{node_maker(), std::move(args)}}});
+    const auto& entry{system_procedure_callee_map[raw_value(call.proc)]};
+    auto callee{callee_node(entry, is_unchecked(entry, call.arguments()))};
+    if (entry.async) {
+      return wrapper(jsast::ast::expression_statement{
+          jsast::ast::await_expression{jsast::ast::call_expression{
+              std::move(callee), std::move(args)}}});
     } else {
       return wrapper(jsast::ast::expression_statement{
-          jsast::ast::call_expression{node_maker(), std::move(args)}});
+          jsast::ast::call_expression{std::move(callee), std::move(args)}});
     }
   }
 
   template <typename wrapper_type>
   auto get_jsast(ast::if_statement& statement, wrapper_type&& wrapper) {
+    if (_folder.condition(*statement.condition()) == true) {
+      return wrapper(get_block(statement.statements()));
+    }
     return wrapper(jsast::ast::if_statement{get_node(*statement.condition()),
                                             get_block(statement.statements())});
   }
 
   template <typename wrapper_type>
   auto get_jsast(ast::if_else_statement& statement, wrapper_type&& wrapper) {
+    if (const auto taken{taken_branch(statement)}) {
+      auto consequence{get_block(statement.consequence())};
+      auto alternate{get_block(statement.alternate())};
+      return wrapper(*taken ? std::move(consequence) : std::move(alternate));
+    }
     return wrapper(jsast::ast::if_statement{get_node(*statement.condition()),
                                             get_block(statement.consequence()),
                                             get_block(statement.alternate())});
@@ -491,7 +803,7 @@ struct generator {
   template <typename wrapper_type>
   auto get_jsast(ast::return_result_statement& statement,
                  wrapper_type&& wrapper) {
-    if (!check_in_loop(statement)) {
+    if (!check_in_user_function(statement)) {
       _errors.emplace_back(
           "Can only return a result in user-defined functions!", statement);
     }
@@ -539,6 +851,10 @@ struct generator {
   auto get_subscript(subscript_type& subscript, wrapper_type&& wrapper) {
     auto list{get_node(*subscript.list())};
     auto index{get_node(*subscript.index())};
+    if (is_array(*subscript.list())) {
+      return wrapper(
+          jsast::ast::member_expression{std::move(list), std::move(index)});
+    }
     return wrapper(jsast::ast::member_expression{
         jsast::ast::call_expression{env_name("asArray"), {std::move(list)}},
         std::move(index)});
@@ -565,18 +881,14 @@ struct generator {
 
   template <typename wrapper_type>
   auto get_jsast(ast::new_color& init, wrapper_type&& wrapper) {
-    static constexpr auto new_color_callee_map{make_array(
-        []() { return system_callee("ColorUtils", "rgb"); } /* rgb */,
-        []() { return system_callee("ColorUtils", "rgba"); } /* rgba */,
-        []() { return system_callee("ColorUtils", "hsl"); } /* hsl */,
-        []() { return system_callee("ColorUtils", "hsla"); } /* hsla */)};
-
     jsast::utils::move_vector<jsast::ast::node> args;
     for (auto& arg : init.arguments()) {
       args.emplace_back(get_node(*arg));
     }
-    auto node_maker{new_color_callee_map[raw_value(init.mode)]};
-    return wrapper(jsast::ast::call_expression{node_maker(), std::move(args)});
+    const auto& entry{new_color_callee_map[raw_value(init.mode)]};
+    return wrapper(jsast::ast::call_expression{
+        callee_node(entry, is_unchecked(entry, init.arguments())),
+        std::move(args)});
   }
 
   template <typename wrapper_type>
@@ -585,13 +897,14 @@ struct generator {
     for (auto& arg : call.arguments()) {
       args.emplace_back(get_node(*arg));
     }
-    auto [node_maker, async]{system_function_callee_map[raw_value(call.func)]};
-    if (async) {
+    const auto& entry{system_function_callee_map[raw_value(call.func)]};
+    auto callee{callee_node(entry, is_unchecked(entry, call.arguments()))};
+    if (entry.async) {
       return wrapper(jsast::ast::await_expression{
-          jsast::ast::call_expression{node_maker(), std::move(args)}});
+          jsast::ast::call_expression{std::move(callee), std::move(args)}});
     } else {
       return wrapper(
-          jsast::ast::call_expression{node_maker(), std::move(args)});
+          jsast::ast::call_expression{std::move(callee), std::move(args)});
     }
   }
 
@@ -605,9 +918,9 @@ struct generator {
           args.emplace_back(get_node(*arg));
         }
 
-        assert(_user_functions.find(call.name) != _user_functions.end());
-        if (_async_blocks.find(_user_functions[call.name]) ==
-            _async_blocks.end()) {
+        const auto* callee{_graph->function(call.name)};
+        assert(callee != nullptr);
+        if (!_graph->is_async(*callee)) {
           return wrapper(jsast::ast::call_expression{
               jsast::ast::identifier{user_function_name(call.name)},
               std::move(args)});
@@ -647,27 +960,28 @@ struct generator {
     return get_identifier(identifier.name, std::forward<wrapper_type>(wrapper));
   }
 
-  template <typename wrapper_type>
-  auto get_jsast(ast::number_literal& literal, wrapper_type&& wrapper) {
-    assert(literal.value.size() > 0);
-    auto it{literal.value.begin()};
+  // Drops the leading zeros of a number, but the one before the point
+  [[nodiscard]] static std::string number_text(const std::string& value) {
+    assert(value.size() > 0);
+    auto it{value.begin()};
     const bool is_negative{*it == '-'};
     if (is_negative) {
       it++;
     }
-    while (it != literal.value.end() && *it == '0') {
+    while (it != value.end() && *it == '0') {
       it++;
     }
-    if ((it == literal.value.end() || *it == '.') &&
-        it > literal.value.begin() && *(it - 1) == '0') {
+    if ((it == value.end() || *it == '.') && it > value.begin() &&
+        *(it - 1) == '0') {
       it--;
     }
-    std::string result{it, literal.value.end()};
-    if (is_negative) {
-      return wrapper(jsast::ast::raw_literal{"-" + std::move(result)});
-    } else {
-      return wrapper(jsast::ast::raw_literal{std::move(result)});
-    }
+    std::string result{it, value.end()};
+    return is_negative ? "-" + std::move(result) : result;
+  }
+
+  template <typename wrapper_type>
+  auto get_jsast(ast::number_literal& literal, wrapper_type&& wrapper) {
+    return wrapper(jsast::ast::raw_literal{number_text(literal.value)});
   }
 
   template <typename wrapper_type>
@@ -679,6 +993,449 @@ struct generator {
   auto get_jsast(ast::bool_literal& literal, wrapper_type&& wrapper) {
     return wrapper(jsast::ast::bool_literal{literal.value});
   }
+  // Streaming output, mirroring the trees built by get_jsast
+
+  js_writer _writer;
+  // Node being written, the one the text after its children belongs to
+  uint32_t _current{js_mapping::no_node};
+
+  static void write_env_name(js_writer& writer, std::string_view name) {
+    writer.write("window.env.");
+    writer.write(name);
+  }
+
+  // Statements after which nothing of the block runs, that sample before
+  // leaving it instead, see write(ast::return_result_statement&)
+  [[nodiscard]] static bool leaves_block(const ast::base& statement) {
+    return statement.is<ast::break_statement>() ||
+           statement.is<ast::continue_statement>() ||
+           statement.is<ast::return_statement>() ||
+           statement.is<ast::return_result_statement>();
+  }
+
+  void write_sample() {
+    write_env_name(_writer, "tick");
+    _writer.write("();");
+  }
+
+  void write_node(ast::base& c, bool sampled = false) {
+    const auto parent{std::exchange(_current, _block_mappings.add(c))};
+    _block_mappings.map(_writer.loc(), _current);
+    if (sampled && leaves_block(c) &&
+        !c.is<ast::return_result_statement>()) {
+      write_sample();
+      _writer.write(" ");
+    }
+    if (const auto* constant{folded(c)}) {
+      if (constant->is(value::type::string)) {
+        _writer.write_string(constant->string());
+      } else {
+        _writer.write(constant_folder::js_literal(*constant));
+      }
+    } else {
+      c.apply<void>([this](auto& node) { write(node); });
+    }
+    if (sampled && !leaves_block(c)) {
+      // Once the statement ran but still within it, so that a sample charges
+      // the time since the last one to the statement that took it
+      _writer.write(" ");
+      write_sample();
+    }
+    _current = parent;
+    _block_mappings.map(_writer.loc(), parent);
+  }
+
+  template <typename vector_type>
+  void write_block(vector_type vector) {
+    _writer.begin_block();
+    for (auto& statement : vector) {
+      if (is_left_out(*statement)) {
+        write_left_out([&]() { write_node(*statement); });
+        continue;
+      }
+      _writer.begin_statement();
+      write_node(*statement, _profile_interval > 0);
+      _writer.end_statement();
+    }
+    _writer.end_block();
+  }
+
+  // Checks what the callable writes, but leaves it out of the script
+  template <typename callable_type>
+  void write_left_out(callable_type&& write) {
+    auto output{std::exchange(_writer, js_writer{})};
+    auto mappings{std::exchange(_block_mappings, {})};
+    write();
+    _writer = std::move(output);
+    _block_mappings = std::move(mappings);
+  }
+
+  template <typename vector_type>
+  void write_arguments(vector_type vector, bool first = true) {
+    for (auto& arg : vector) {
+      if (!first) {
+        _writer.write(", ");
+      }
+      first = false;
+      write_node(*arg);
+    }
+  }
+
+  void write_callee(const callee& entry, bool unchecked) {
+    if (entry.module != nullptr) {
+      write_env_name(_writer, entry.module);
+      _writer.write(".");
+      _writer.write(entry.name);
+    } else {
+      write_env_name(_writer, entry.name);
+    }
+    if (unchecked) {
+      _writer.write(unchecked_suffix);
+    }
+  }
+
+  void write_error() { _writer.write("__error__"); }
+
+  void write(ast::variable_placeholder& node) {
+    _errors.emplace_back("Unexpected placeholder!", node);
+    write_error();
+  }
+
+  void write(ast::expression_placeholder& node) {
+    _errors.emplace_back("Unexpected placeholder!", node);
+    write_error();
+  }
+
+  void write(ast::function_placeholder& node) {
+    _errors.emplace_back("Unexpected function signature!", node);
+    write_error();
+  }
+
+  void write(ast::function_signature& node) {
+    _errors.emplace_back("Unexpected function signature!", node);
+    write_error();
+  }
+
+  void write(ast::program& program) {
+    _errors.emplace_back("Unexpected program!", program);
+    write_error();
+  }
+
+  void write(ast::on_start& start) {
+    _global_identifiers.clear();
+    if (_graph->is_async(start)) {
+      _writer.write("async ");
+    }
+    _writer.write("function ");
+    _writer.write(main_name);
+    _writer.write("() ");
+    write_block(start.statements());
+  }
+
+  void write(ast::parameter& param) {
+    _writer.write("__var_");
+    _writer.write(param.name);
+  }
+
+  void write(ast::function& function) {
+    if (!function.signature()->is<ast::function_signature>()) {
+      // The body is still checked, but left out
+      write_left_out([&]() { write_block(function.statements()); });
+      if (function.signature()->is<ast::function_placeholder>()) {
+        _errors.emplace_back("Unexpected placeholder!", *function.signature());
+      } else {
+        _errors.emplace_back("Unexpected node, expecting function signature!",
+                             *function.signature());
+      }
+      _writer.write(";");
+      return;
+    }
+
+    auto& signature{function.signature()->as<ast::function_signature>()};
+    if (_graph->is_async(function)) {
+      _writer.write("async ");
+    }
+    _writer.write("function __func_");
+    _writer.write(signature.name);
+    _writer.write("(");
+    const auto first_error{_errors.size()};
+    std::unordered_set<std::string_view> param_names;
+    for (auto& param : signature.parameters()) {
+      if (param->is<ast::parameter>()) {
+        std::string_view name{param->as<ast::parameter>().name};
+        if (param_names.find(name) == param_names.end()) {
+          if (!param_names.empty()) {
+            _writer.write(", ");
+          }
+          param_names.emplace(name);
+          write_node(*param);
+        } else {
+          _errors.emplace_back("Repeated function parameter!", *param);
+        }
+      } else {
+        _errors.emplace_back("Unexpected node, expecting function parameter!",
+                             *param);
+      }
+    }
+    _writer.write(") ");
+    const auto body_error{_errors.size()};
+    write_block(function.statements());
+    // Errors of the body come first, as it is built first in a tree
+    std::rotate(_errors.begin() + first_error, _errors.begin() + body_error,
+                _errors.end());
+
+    _global_identifiers.clear();
+  }
+
+  void write(ast::eval_statement& eval) {
+    write_node(*eval.expression());
+    _writer.write(";");
+  }
+
+  void write(ast::assignment& assignment) {
+    if (is_local_identifier(*assignment.variable())) {
+      _writer.write("var ");
+    }
+    write_node(*assignment.variable());
+    _writer.write(" = ");
+    write_node(*assignment.value());
+    _writer.write(";");
+  }
+
+  void write(ast::use_global& use_global) {
+    if (use_global.variable()->is<ast::variable_name>()) {
+      _global_identifiers.emplace(
+          use_global.variable()->as<ast::variable_name>().name);
+    } else {
+      _errors.emplace_back("Unexpected node, expecting variable name!",
+                           *use_global.variable());
+    }
+    _writer.write(";");
+  }
+
+  template <typename vector_type>
+  void write_call(const callee& entry, vector_type arguments,
+                  ast::base* first_argument = nullptr) {
+    if (entry.async) {
+      _writer.write("(await ");
+    }
+    write_callee(entry, is_unchecked(entry, arguments, first_argument));
+    _writer.write("(");
+    if (first_argument != nullptr) {
+      write_node(*first_argument);
+    }
+    write_arguments(arguments, first_argument == nullptr);
+    _writer.write(")");
+    if (entry.async) {
+      _writer.write(")");
+    }
+  }
+
+  void write(ast::modify_array& call) {
+    write_call(array_modification_callee_map[raw_value(call.mod)],
+               call.arguments(), &*call.array());
+    _writer.write(";");
+  }
+
+  void write(ast::system_procedure_call& call) {
+    write_call(system_procedure_callee_map[raw_value(call.proc)],
+               call.arguments());
+    _writer.write(";");
+  }
+
+  void write(ast::if_statement& statement) {
+    if (_folder.condition(*statement.condition()) == true) {
+      write_block(statement.statements());
+      return;
+    }
+    _writer.write("if (");
+    write_node(*statement.condition());
+    _writer.write(") ");
+    write_block(statement.statements());
+  }
+
+  void write(ast::if_else_statement& statement) {
+    // Errors of the consequence come first either way
+    if (const auto taken{taken_branch(statement)}) {
+      if (*taken) {
+        write_block(statement.consequence());
+        write_left_out([&]() { write_block(statement.alternate()); });
+      } else {
+        write_left_out([&]() { write_block(statement.consequence()); });
+        write_block(statement.alternate());
+      }
+      return;
+    }
+    _writer.write("if (");
+    write_node(*statement.condition());
+    _writer.write(") ");
+    write_block(statement.consequence());
+    _writer.write(" else ");
+    write_block(statement.alternate());
+  }
+
+  void write(ast::while_statement& statement) {
+    _writer.write("while (");
+    write_node(*statement.condition());
+    _writer.write(") ");
+    write_block(statement.statements());
+  }
+
+  void write(ast::for_statement& statement) {
+    _writer.write("for (");
+    if (is_local_identifier(*statement.variable())) {
+      _writer.write("var ");
+    }
+    write_node(*statement.variable());
+    _writer.write(" of ");
+    write_node(*statement.list());
+    _writer.write(") ");
+    write_block(statement.statements());
+  }
+
+  void write(ast::break_statement& statement) {
+    if (!check_in_loop(statement)) {
+      _errors.emplace_back("Break statement can only appear in a loop!",
+                           statement);
+    }
+    _writer.write("break;");
+  }
+
+  void write(ast::continue_statement& statement) {
+    if (!check_in_loop(statement)) {
+      _errors.emplace_back("Continue statement can only appear in a loop!",
+                           statement);
+    }
+    _writer.write("continue;");
+  }
+
+  void write(ast::return_statement&) { _writer.write("return;"); }
+
+  void write(ast::return_result_statement& statement) {
+    if (!check_in_user_function(statement)) {
+      _errors.emplace_back(
+          "Can only return a result in user-defined functions!", statement);
+    }
+    _writer.write("return ");
+    if (_profile_interval > 0) {
+      // Samples once the result is computed, tick passes it on
+      write_env_name(_writer, "tick");
+      _writer.write("(");
+      write_node(*statement.result());
+      _writer.write(");");
+    } else {
+      write_node(*statement.result());
+      _writer.write(";");
+    }
+  }
+
+  void write(ast::unary_expression& unary) {
+    static constexpr auto symbol_map{make_array<std::string_view>(
+        "(-" /* negative */, "(!" /* logical_not */)};
+    _writer.write(symbol_map[raw_value(unary.op)]);
+    write_node(*unary.argument());
+    _writer.write(")");
+  }
+
+  void write(ast::binary_expression& binary) {
+    static constexpr auto symbol_map{make_array<std::string_view>(
+        " + " /* add */, " - " /* subtract */, " * " /* multiply */,
+        " / " /* divide */, " === " /* equal */, " !== " /* not_equal */,
+        " < " /* less */, " <= " /* less_equal */, " > " /* greater */,
+        " >= " /* greater_equal */, " && " /* logical_and */,
+        " || " /* logical_or */)};
+    _writer.write("(");
+    write_node(*binary.left());
+    _writer.write(symbol_map[raw_value(binary.op)]);
+    write_node(*binary.right());
+    _writer.write(")");
+  }
+
+  template <typename subscript_type>
+  void write_subscript(subscript_type& subscript) {
+    if (is_array(*subscript.list())) {
+      write_node(*subscript.list());
+      _writer.write("[");
+    } else {
+      write_env_name(_writer, "asArray");
+      _writer.write("(");
+      write_node(*subscript.list());
+      _writer.write(")[");
+    }
+    write_node(*subscript.index());
+    _writer.write("]");
+  }
+
+  void write(ast::subscript_set& subscript) { write_subscript(subscript); }
+
+  void write(ast::subscript_get& subscript) { write_subscript(subscript); }
+
+  void write(ast::new_array& init) {
+    _writer.write("[");
+    write_arguments(init.elements());
+    _writer.write("]");
+  }
+
+  void write(ast::new_color& init) {
+    write_call(new_color_callee_map[raw_value(init.mode)], init.arguments());
+  }
+
+  void write(ast::system_function_call& call) {
+    write_call(system_function_callee_map[raw_value(call.func)],
+               call.arguments());
+  }
+
+  void write(ast::user_function_call& call) {
+    if (call.func() == nullptr) {
+      _errors.emplace_back("Call to unknown user function!", call);
+      write_error();
+    } else if (call.arguments().size() != call.func()->parameters.size()) {
+      _errors.emplace_back("Incorrect number of arguments!", call);
+      write_error();
+    } else {
+      const auto* callee{_graph->function(call.name)};
+      assert(callee != nullptr);
+      const auto async{_graph->is_async(*callee)};
+      if (async) {
+        _writer.write("(await ");
+      }
+      _writer.write("__func_");
+      _writer.write(call.name);
+      _writer.write("(");
+      write_arguments(call.arguments());
+      _writer.write(")");
+      if (async) {
+        _writer.write(")");
+      }
+    }
+  }
+
+  void write_identifier(const std::string& name) {
+    if (_global_identifiers.find(name) != _global_identifiers.end()) {
+      write_env_name(_writer, "globals");
+      _writer.write(".");
+      _writer.write(name);
+    } else {
+      _writer.write("__var_");
+      _writer.write(name);
+    }
+  }
+
+  void write(ast::variable_name& variable) { write_identifier(variable.name); }
+
+  void write(ast::identifier& identifier) { write_identifier(identifier.name); }
+
+  void write(ast::number_literal& literal) {
+    _writer.write(number_text(literal.value));
+  }
+
+  void write(ast::string_literal& literal) {
+    _writer.write_string(literal.value);
+  }
+
+  void write(ast::bool_literal& literal) {
+    _writer.write(literal.value ? "true" : "false");
+  }
 };
 
 }  // namespace marlin::exec
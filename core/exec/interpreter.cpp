@@ -0,0 +1,399 @@
+#include "interpreter.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+
+#include "resolver.hpp"
+
+namespace marlin::exec {
+
+namespace {
+
+// How a statement ends, break and continue never leave the loop they are in
+enum struct completion : uint8_t { normal, break_loop, continue_loop, ret };
+
+// Calls have at most this many arguments
+constexpr size_t max_argument_count{5};
+using arguments = std::array<value, max_argument_count>;
+
+struct execution {
+  execution(const interpreter::options& opts, const program_layout& layout)
+      : _options{opts},
+        _layout{layout},
+        _environment{opts.environment},
+        _globals(layout.globals.size()) {}
+
+  void run() {
+    if (!_layout.main_block) {
+      // Nothing to execute without an on_start block
+      return;
+    }
+    auto& main{_layout.blocks[*_layout.main_block]};
+    std::vector<value> locals(main.locals.size());
+    _block = &main;
+    _locals = &locals;
+    exec_all(main.block->as<ast::on_start>().statements());
+  }
+
+  environment& env() noexcept { return _environment; }
+
+ private:
+  const interpreter::options& _options;
+  const program_layout& _layout;
+  environment _environment;
+
+  std::vector<value> _globals;
+  const block_layout* _block{nullptr};
+  std::vector<value>* _locals{nullptr};
+
+  size_t _depth{0};
+  uint64_t _steps{0};
+  // Result of the function returning
+  value _result;
+
+  // The innermost node running when an error is thrown starts its stack
+  template <typename callable_type>
+  decltype(auto) at(ast::base& node, callable_type callable) {
+    try {
+      return callable();
+    } catch (runtime_error& e) {
+      if (e.stack().empty()) {
+        e.add_frame(node);
+      }
+      throw;
+    }
+  }
+
+  void step() {
+    if (_options.max_steps != 0 && ++_steps > _options.max_steps) {
+      throw runtime_error{"RangeError", "Maximum number of steps exceeded."};
+    }
+  }
+
+  [[nodiscard]] variable_ref ref(const ast::base& node) const {
+    const auto it{_layout.variables.find(&node)};
+    assert(it != _layout.variables.end());
+    return it->second;
+  }
+
+  [[nodiscard]] value& variable(const ast::base& node) {
+    const auto [is_global, slot]{ref(node)};
+    return is_global ? _globals[slot] : (*_locals)[slot];
+  }
+
+  [[nodiscard]] const value& read(const ast::base& node) {
+    const auto [is_global, slot]{ref(node)};
+    if (is_global) {
+      return _globals[slot];
+    }
+    if (!_block->declared[slot]) {
+      throw runtime_error{"ReferenceError",
+                          "Can't find variable: " + _block->locals[slot]};
+    }
+    return (*_locals)[slot];
+  }
+
+  [[nodiscard]] const value& constant(const ast::base& literal) const {
+    const auto it{_layout.constants.find(&literal)};
+    assert(it != _layout.constants.end());
+    return it->second;
+  }
+
+  // Subscripts check the array and evaluate the index before the value
+  template <typename callable_type>
+  void store(ast::base& target, callable_type compute) {
+    if (target.is<ast::subscript_set>()) {
+      auto& subscript{target.as<ast::subscript_set>()};
+      auto list{eval(*subscript.list())};
+      at(subscript, [&]() { static_cast<void>(as_array(list)); });
+      auto index{eval(*subscript.index())};
+      auto element{compute()};
+      at(subscript, [&]() { set_element(list, index, std::move(element)); });
+    } else {
+      variable(target) = compute();
+    }
+  }
+
+  template <typename vector_type>
+  [[nodiscard]] arguments eval_arguments(vector_type args) {
+    assert(args.size() <= max_argument_count);
+    arguments result;
+    for (size_t i{0}; i < args.size(); i++) {
+      result[i] = eval(*args[i]);
+    }
+    return result;
+  }
+
+  template <typename vector_type>
+  completion exec_all(vector_type statements) {
+    for (auto& statement : statements) {
+      const auto result{exec(*statement)};
+      if (result != completion::normal) {
+        return result;
+      }
+    }
+    return completion::normal;
+  }
+
+  completion exec(ast::base& node) {
+    return at(node, [&]() {
+      step();
+      return node.apply<completion>(
+          [this](auto& statement) { return execute(statement); });
+    });
+  }
+
+  value eval(ast::base& node) {
+    return at(node, [&]() {
+      return node.apply<value>(
+          [this](auto& expression) { return evaluate(expression); });
+    });
+  }
+
+  // Statements
+
+  template <typename node_type>
+  completion execute(node_type& node) {
+    static_cast<void>(eval(node));
+    return completion::normal;
+  }
+
+  completion execute(ast::eval_statement& statement) {
+    static_cast<void>(eval(*statement.expression()));
+    return completion::normal;
+  }
+
+  completion execute(ast::assignment& assignment) {
+    store(*assignment.variable(),
+          [&]() { return eval(*assignment.value()); });
+    return completion::normal;
+  }
+
+  completion execute(ast::use_global&) { return completion::normal; }
+
+  completion execute(ast::modify_array& call) {
+    const auto list{eval(*call.array())};
+    const auto args{eval_arguments(call.arguments())};
+    _environment.modify(call.mod, list, args.data());
+    return completion::normal;
+  }
+
+  completion execute(ast::system_procedure_call& call) {
+    const auto args{eval_arguments(call.arguments())};
+    _environment.call(call.proc, args.data());
+    return completion::normal;
+  }
+
+  completion execute(ast::if_statement& statement) {
+    if (to_boolean(eval(*statement.condition()))) {
+      return exec_all(statement.statements());
+    }
+    return completion::normal;
+  }
+
+  completion execute(ast::if_else_statement& statement) {
+    if (to_boolean(eval(*statement.condition()))) {
+      return exec_all(statement.consequence());
+    } else {
+      return exec_all(statement.alternate());
+    }
+  }
+
+  completion execute(ast::while_statement& statement) {
+    while (to_boolean(eval(*statement.condition()))) {
+      const auto result{exec_all(statement.statements())};
+      if (result == completion::break_loop) {
+        break;
+      } else if (result == completion::ret) {
+        return result;
+      }
+      step();
+    }
+    return completion::normal;
+  }
+
+  completion execute(ast::for_statement& statement) {
+    const auto list{eval(*statement.list())};
+    iteration elements{list};
+    value element;
+    while (elements.next(element)) {
+      store(*statement.variable(), [&]() { return element; });
+      const auto result{exec_all(statement.statements())};
+      if (result == completion::break_loop) {
+        break;
+      } else if (result == completion::ret) {
+        return result;
+      }
+      step();
+    }
+    return completion::normal;
+  }
+
+  completion execute(ast::break_statement&) { return completion::break_loop; }
+
+  completion execute(ast::continue_statement&) {
+    return completion::continue_loop;
+  }
+
+  completion execute(ast::return_statement&) {
+    _result = value{};
+    return completion::ret;
+  }
+
+  completion execute(ast::return_result_statement& statement) {
+    _result = eval(*statement.result());
+    return completion::ret;
+  }
+
+  // Expressions
+
+  template <typename node_type>
+  value evaluate(node_type&) {
+    // Placeholders and blocks are refused by the resolver
+    assert(false);
+    return {};
+  }
+
+  value evaluate(ast::unary_expression& unary) {
+    return exec::unary(unary.op, eval(*unary.argument()));
+  }
+
+  value evaluate(ast::binary_expression& binary) {
+    auto left{eval(*binary.left())};
+    if (binary.op == ast::binary_op::logical_and) {
+      return to_boolean(left) ? eval(*binary.right()) : left;
+    } else if (binary.op == ast::binary_op::logical_or) {
+      return to_boolean(left) ? left : eval(*binary.right());
+    }
+    return exec::binary(binary.op, left, eval(*binary.right()));
+  }
+
+  value evaluate(ast::subscript_get& subscript) {
+    const auto list{eval(*subscript.list())};
+    static_cast<void>(as_array(list));
+    return get_element(list, eval(*subscript.index()));
+  }
+
+  value evaluate(ast::new_array& init) {
+    auto elements{std::make_shared<array>()};
+    elements->reserve(init.elements().size());
+    for (auto& element : init.elements()) {
+      elements->push_back(eval(*element));
+    }
+    return elements;
+  }
+
+  value evaluate(ast::new_color& init) {
+    const auto args{eval_arguments(init.arguments())};
+    return _environment.make_color(init.mode, args.data());
+  }
+
+  value evaluate(ast::system_function_call& call) {
+    const auto args{eval_arguments(call.arguments())};
+    return _environment.call(call.func, args.data());
+  }
+
+  value evaluate(ast::user_function_call& call) {
+    const auto& callee{_layout.blocks[_layout.callees.at(&call)]};
+    std::vector<value> locals(callee.locals.size());
+    size_t index{0};
+    for (auto& arg : call.arguments()) {
+      auto argument{eval(*arg)};
+      if (index < callee.parameter_count) {
+        locals[index] = std::move(argument);
+      }
+      index++;
+    }
+
+    if (_depth >= _options.max_call_depth) {
+      throw runtime_error{"RangeError", "Maximum call stack size exceeded."};
+    }
+    const auto* caller_block{std::exchange(_block, &callee)};
+    auto* caller_locals{std::exchange(_locals, &locals)};
+    _depth++;
+    const auto restore{[&]() {
+      _depth--;
+      _block = caller_block;
+      _locals = caller_locals;
+    }};
+
+    completion result;
+    try {
+      result = exec_all(callee.block->as<ast::function>().statements());
+    } catch (runtime_error& e) {
+      restore();
+      e.add_frame(call);
+      throw;
+    }
+    restore();
+    return result == completion::ret ? std::exchange(_result, {}) : value{};
+  }
+
+  value evaluate(ast::variable_name& variable) { return read(variable); }
+
+  value evaluate(ast::identifier& identifier) { return read(identifier); }
+
+  value evaluate(ast::number_literal& literal) { return constant(literal); }
+
+  value evaluate(ast::string_literal& literal) { return constant(literal); }
+
+  value evaluate(ast::bool_literal& literal) { return constant(literal); }
+};
+
+}  // namespace
+
+run_result interpreter::run(ast::program& program) {
+  const auto layout{resolve(program)};
+  execution state{_options, layout};
+
+  run_result result;
+  try {
+    state.run();
+  } catch (runtime_error& e) {
+    result.error = std::move(e);
+  }
+  result.elapsed = state.env().elapsed();
+  result.printed = std::move(state.env()).printed();
+  result.commands = std::move(state.env()).commands();
+  return result;
+}
+
+std::vector<run_result> run_in_parallel(
+    const std::vector<ast::program*>& programs, interpreter::options opts,
+    size_t thread_count) {
+  std::vector<run_result> results(programs.size());
+  std::atomic<size_t> next{0};
+  const auto work{[&]() {
+    for (auto i{next++}; i < programs.size(); i = next++) {
+      try {
+        results[i] = interpreter{opts}.run(*programs[i]);
+      } catch (collected_generation_error& e) {
+        auto& first{e.errors().front()};
+        runtime_error error{"SyntaxError", first.what()};
+        error.add_frame(first.node());
+        results[i].error = std::move(error);
+      }
+    }
+  }};
+
+  if (thread_count == 0) {
+    thread_count = std::max(std::thread::hardware_concurrency(), 1u);
+  }
+  thread_count = std::min(thread_count, programs.size());
+  std::vector<std::thread> threads;
+  for (size_t i{1}; i < thread_count; i++) {
+    threads.emplace_back(work);
+  }
+  work();
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  return results;
+}
+
+}  // namespace marlin::exec
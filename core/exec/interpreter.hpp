@@ -0,0 +1,43 @@
+#ifndef marlin_exec_interpreter_hpp
+#define marlin_exec_interpreter_hpp
+
+#include <cstdint>
+#include <vector>
+
+#include "ast.hpp"
+#include "exec_errors.hpp"
+#include "runtime.hpp"
+
+namespace marlin::exec {
+
+// Runs programs directly from their tree, with the behavior of the code
+// exec::generator produces running in exec_env.js
+struct interpreter {
+  struct options {
+    exec::environment::options environment;
+    // Statements run and loop conditions checked before stopping with a
+    // RangeError, 0 for no limit
+    uint64_t max_steps{0};
+    size_t max_call_depth{1000};
+  };
+
+  explicit interpreter(options opts) : _options{opts} {}
+
+  // Throws collected_generation_error when exec::generator would refuse the
+  // program, errors of the run itself are part of the result
+  [[nodiscard]] run_result run(ast::program& program);
+
+ private:
+  options _options;
+};
+
+// Runs every program on its own, spread over several threads. Generation
+// errors become a SyntaxError at their first node. A thread_count of 0 uses
+// one thread per core.
+[[nodiscard]] std::vector<run_result> run_in_parallel(
+    const std::vector<ast::program*>& programs,
+    interpreter::options opts = {}, size_t thread_count = 0);
+
+}  // namespace marlin::exec
+
+#endif  // marlin_exec_interpreter_hpp
@@ -0,0 +1,84 @@
+#ifndef marlin_exec_js_writer_hpp
+#define marlin_exec_js_writer_hpp
+
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "utils.hpp"
+
+namespace marlin::exec {
+
+// Text buffer for JavaScript laid out like jsast::generator lays out its
+// trees, tracking the location reached so that nodes written straight from
+// the marlin AST can record their ranges as they go
+struct js_writer {
+  [[nodiscard]] source_loc loc() const noexcept { return _loc; }
+
+  [[nodiscard]] std::string str() && { return std::move(_source); }
+
+  // Text without line breaks
+  void write(std::string_view text) {
+    _source += text;
+    _loc.column += text.size();
+  }
+
+  void write_string(std::string_view value) {
+    write("\"");
+    for (const auto c : value) {
+      switch (c) {
+        case '"':
+          write("\\\"");
+          break;
+        case '\\':
+          write("\\\\");
+          break;
+        case '\n':
+          write("\\n");
+          break;
+        default:
+          _source += c;
+          _loc.column++;
+          break;
+      }
+    }
+    write("\"");
+  }
+
+  void begin_block() {
+    write("{");
+    line_break();
+    _depth++;
+  }
+
+  void end_block() {
+    _depth--;
+    begin_statement();
+    write("}");
+  }
+
+  void begin_statement() {
+    for (size_t i{0}; i < _depth; i++) {
+      write(indentation);
+    }
+  }
+
+  void end_statement() { line_break(); }
+
+  void line_break() {
+    _source += '\n';
+    _loc.line++;
+    _loc.column = 1;
+  }
+
+ private:
+  static constexpr std::string_view indentation{"  "};
+
+  std::string _source;
+  source_loc _loc{1, 1};
+  size_t _depth{0};
+};
+
+}  // namespace marlin::exec
+
+#endif  // marlin_exec_js_writer_hpp
@@ -0,0 +1,72 @@
+#include "profile.hpp"
+
+namespace marlin::exec {
+
+void profile::add_sample(std::string_view stacktrace,
+                         std::string_view source_url, const source_map& map,
+                         frame_cache* cache, frame_parser parser) {
+  std::vector<const ast::base*> frames;
+  for (const auto& loc : parse_stacktrace(stacktrace, source_url, parser)) {
+    if (const auto* node{cache != nullptr ? cache->locate(map, loc)
+                                          : map.locate(loc)}) {
+      frames.push_back(node);
+    }
+  }
+  add_sample(frames);
+}
+
+void profile::add_sample(const std::vector<const ast::base*>& frames) {
+  if (frames.empty()) {
+    return;
+  }
+  _samples++;
+
+  // The program itself is left out, it would count every sample
+  _seen_nodes.clear();
+  _seen_lines.clear();
+  for (const auto* frame : frames) {
+    for (auto* node{frame}; node->has_parent(); node = &node->parent()) {
+      if (!_seen_nodes.emplace(node).second) {
+        // So were the nodes around it
+        break;
+      }
+      _nodes[node].inclusive++;
+      const auto line{node->source_code_range.begin.line};
+      if (_seen_lines.emplace(line).second) {
+        _lines[line].inclusive++;
+      }
+    }
+  }
+
+  if (const auto* innermost{frames.front()}; innermost->has_parent()) {
+    _nodes[innermost].exclusive++;
+    _lines[innermost->source_code_range.begin.line].exclusive++;
+  }
+}
+
+profile::counts profile::of(const ast::base& node) const {
+  const auto it{_nodes.find(&node)};
+  return it != _nodes.end() ? it->second : counts{};
+}
+
+profile::counts profile::of_line(size_t line) const {
+  const auto it{_lines.find(line)};
+  return it != _lines.end() ? it->second : counts{};
+}
+
+std::vector<profile::line_counts> profile::lines() const {
+  std::vector<line_counts> result;
+  result.reserve(_lines.size());
+  for (const auto& [line, samples] : _lines) {
+    result.push_back({line, samples});
+  }
+  return result;
+}
+
+void profile::clear() noexcept {
+  _samples = 0;
+  _nodes.clear();
+  _lines.clear();
+}
+
+}  // namespace marlin::exec
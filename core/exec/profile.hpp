@@ -0,0 +1,62 @@
+#ifndef marlin_exec_profile_hpp
+#define marlin_exec_profile_hpp
+
+#include <map>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "ast.hpp"
+#include "source_map.hpp"
+#include "stacktrace.hpp"
+
+namespace marlin::exec {
+
+// Samples of a profiled run, the stack traces the script took as it ran
+// (see generator::set_profile_interval), counted against the nodes and
+// source lines they went through
+struct profile {
+  // Samples taken anywhere within, and those taken right on it
+  struct counts {
+    size_t inclusive{0};
+    size_t exclusive{0};
+  };
+
+  struct line_counts {
+    size_t line;
+    counts samples;
+  };
+
+  // Frames outside the script at source_url, or that the map has no node
+  // for, are left out
+  void add_sample(std::string_view stacktrace, std::string_view source_url,
+                  const source_map& map, frame_cache* cache = nullptr,
+                  frame_parser parser = parse_jsc_frame);
+
+  // Nodes of the frames of a sample, innermost first
+  void add_sample(const std::vector<const ast::base*>& frames);
+
+  [[nodiscard]] size_t sample_count() const noexcept { return _samples; }
+
+  [[nodiscard]] counts of(const ast::base& node) const;
+  [[nodiscard]] counts of_line(size_t line) const;
+
+  // Lines with samples in order, for a heat map of the source
+  [[nodiscard]] std::vector<line_counts> lines() const;
+
+  void clear() noexcept;
+
+ private:
+  size_t _samples{0};
+  std::unordered_map<const ast::base*, counts> _nodes;
+  std::map<size_t, counts> _lines;
+
+  // What the sample being added went through, counted once each
+  std::unordered_set<const ast::base*> _seen_nodes;
+  std::unordered_set<size_t> _seen_lines;
+};
+
+}  // namespace marlin::exec
+
+#endif  // marlin_exec_profile_hpp
@@ -0,0 +1,253 @@
+#include "resolver.hpp"
+
+#include <unordered_set>
+
+#include "exec_errors.hpp"
+
+namespace marlin::exec {
+
+namespace {
+
+struct resolver {
+  program_layout layout;
+
+  explicit resolver(ast::program& program) {
+    auto blocks{program.blocks()};
+    layout.blocks.reserve(blocks.size());
+    for (size_t i{0}; i < blocks.size(); i++) {
+      auto& block{*blocks[i]};
+      layout.blocks.emplace_back(block);
+      if (block.is<ast::on_start>()) {
+        layout.main_block = i;
+      } else if (block.is<ast::function>()) {
+        auto& signature{*block.as<ast::function>().signature()};
+        if (signature.is<ast::function_signature>()) {
+          _functions[signature.as<ast::function_signature>().name] = i;
+        }
+      }
+    }
+
+    for (size_t i{0}; i < blocks.size(); i++) {
+      _block = &layout.blocks[i];
+      _local_slots.clear();
+      resolve_block(*blocks[i]);
+    }
+
+    if (!_errors.empty()) {
+      throw collected_generation_error{std::move(_errors)};
+    }
+  }
+
+ private:
+  std::unordered_map<std::string_view, size_t> _functions;
+
+  std::unordered_set<std::string_view> _global_identifiers;
+  std::unordered_map<std::string_view, uint32_t> _global_slots;
+
+  block_layout* _block;
+  std::unordered_map<std::string_view, uint32_t> _local_slots;
+
+  std::vector<generation_error> _errors;
+
+  [[nodiscard]] uint32_t local_slot(std::string_view name) {
+    auto [it, inserted]{_local_slots.try_emplace(
+        name, static_cast<uint32_t>(_block->locals.size()))};
+    if (inserted) {
+      _block->locals.emplace_back(name);
+      _block->declared.push_back(false);
+    }
+    return it->second;
+  }
+
+  [[nodiscard]] uint32_t global_slot(std::string_view name) {
+    auto [it, inserted]{_global_slots.try_emplace(
+        name, static_cast<uint32_t>(layout.globals.size()))};
+    if (inserted) {
+      layout.globals.emplace_back(name);
+    }
+    return it->second;
+  }
+
+  [[nodiscard]] static const std::string* variable_name(ast::base& node) {
+    if (node.is<ast::identifier>()) {
+      return &node.as<ast::identifier>().name;
+    } else if (node.is<ast::variable_name>()) {
+      return &node.as<ast::variable_name>().name;
+    } else {
+      return nullptr;
+    }
+  }
+
+  [[nodiscard]] bool is_local_identifier(ast::base& node) {
+    const auto* name{variable_name(node)};
+    return name != nullptr &&
+           _global_identifiers.find(*name) == _global_identifiers.end();
+  }
+
+  void declare(ast::base& variable) {
+    if (is_local_identifier(variable)) {
+      _block->declared[local_slot(*variable_name(variable))] = true;
+    }
+  }
+
+  template <typename vector_type>
+  void resolve_all(vector_type vector) {
+    for (auto& node : vector) {
+      resolve(*node);
+    }
+  }
+
+  void resolve_block(ast::base& block) {
+    if (block.is<ast::on_start>()) {
+      _global_identifiers.clear();
+      resolve_all(block.as<ast::on_start>().statements());
+    } else if (block.is<ast::function>()) {
+      resolve_function(block.as<ast::function>());
+    } else {
+      resolve(block);
+    }
+  }
+
+  void resolve_function(ast::function& function) {
+    // Parameters come first in the slots but are checked after the body,
+    // like exec::generator does
+    auto& signature{*function.signature()};
+    if (signature.is<ast::function_signature>()) {
+      for (auto& param : signature.as<ast::function_signature>().parameters()) {
+        if (param->is<ast::parameter>()) {
+          const auto slot{local_slot(param->as<ast::parameter>().name)};
+          _block->declared[slot] = true;
+        }
+      }
+      _block->parameter_count = _block->locals.size();
+    }
+
+    resolve_all(function.statements());
+
+    if (signature.is<ast::function_signature>()) {
+      std::unordered_set<std::string_view> param_names;
+      for (auto& param : signature.as<ast::function_signature>().parameters()) {
+        if (param->is<ast::parameter>()) {
+          std::string_view name{param->as<ast::parameter>().name};
+          if (!param_names.emplace(name).second) {
+            _errors.emplace_back("Repeated function parameter!", *param);
+          }
+        } else {
+          _errors.emplace_back("Unexpected node, expecting function parameter!",
+                               *param);
+        }
+      }
+      _global_identifiers.clear();
+    } else if (signature.is<ast::function_placeholder>()) {
+      _errors.emplace_back("Unexpected placeholder!", signature);
+    } else {
+      _errors.emplace_back("Unexpected node, expecting function signature!",
+                           signature);
+    }
+  }
+
+  [[nodiscard]] static bool check_in_loop(ast::base& node) {
+    auto* current{&node};
+    while (current->has_parent()) {
+      current = &current->parent();
+      if (current->is<ast::while_statement>() ||
+          current->is<ast::for_statement>()) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  [[nodiscard]] static bool check_in_user_function(ast::base& node) {
+    auto* current{&node};
+    while (current->has_parent()) {
+      current = &current->parent();
+      if (current->is<ast::function>()) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void resolve(ast::base& node) {
+    if (node.is<ast::variable_placeholder>() ||
+        node.is<ast::expression_placeholder>()) {
+      _errors.emplace_back("Unexpected placeholder!", node);
+    } else if (node.is<ast::function_placeholder>() ||
+               node.is<ast::function_signature>()) {
+      _errors.emplace_back("Unexpected function signature!", node);
+    } else if (const auto* name{variable_name(node)}) {
+      if (_global_identifiers.find(*name) != _global_identifiers.end()) {
+        layout.variables[&node] = {true, global_slot(*name)};
+      } else {
+        layout.variables[&node] = {false, local_slot(*name)};
+      }
+    } else if (node.is<ast::number_literal>()) {
+      layout.constants[&node] =
+          string_to_number(node.as<ast::number_literal>().value);
+    } else if (node.is<ast::string_literal>()) {
+      layout.constants[&node] = node.as<ast::string_literal>().value;
+    } else if (node.is<ast::bool_literal>()) {
+      layout.constants[&node] = node.as<ast::bool_literal>().value;
+    } else if (node.is<ast::assignment>()) {
+      auto& assignment{node.as<ast::assignment>()};
+      declare(*assignment.variable());
+      resolve(*assignment.variable());
+      resolve(*assignment.value());
+    } else if (node.is<ast::for_statement>()) {
+      auto& statement{node.as<ast::for_statement>()};
+      declare(*statement.variable());
+      resolve(*statement.variable());
+      resolve(*statement.list());
+      resolve_all(statement.statements());
+    } else if (node.is<ast::use_global>()) {
+      auto& variable{*node.as<ast::use_global>().variable()};
+      if (variable.is<ast::variable_name>()) {
+        _global_identifiers.emplace(variable.as<ast::variable_name>().name);
+      } else {
+        _errors.emplace_back("Unexpected node, expecting variable name!",
+                             variable);
+      }
+    } else if (node.is<ast::break_statement>()) {
+      if (!check_in_loop(node)) {
+        _errors.emplace_back("Break statement can only appear in a loop!",
+                             node);
+      }
+    } else if (node.is<ast::continue_statement>()) {
+      if (!check_in_loop(node)) {
+        _errors.emplace_back("Continue statement can only appear in a loop!",
+                             node);
+      }
+    } else if (node.is<ast::return_result_statement>()) {
+      if (!check_in_user_function(node)) {
+        _errors.emplace_back(
+            "Can only return a result in user-defined functions!", node);
+      }
+      resolve_all(node.children());
+    } else if (node.is<ast::user_function_call>()) {
+      resolve_call(node.as<ast::user_function_call>());
+    } else {
+      resolve_all(node.children());
+    }
+  }
+
+  void resolve_call(ast::user_function_call& call) {
+    const auto it{_functions.find(call.name)};
+    if (call.func() == nullptr || it == _functions.end()) {
+      _errors.emplace_back("Call to unknown user function!", call);
+    } else if (call.arguments().size() != call.func()->parameters.size()) {
+      _errors.emplace_back("Incorrect number of arguments!", call);
+    } else {
+      layout.callees[&call] = it->second;
+      resolve_all(call.arguments());
+    }
+  }
+};
+
+}  // namespace
+
+program_layout resolve(ast::program& program) {
+  return std::move(resolver{program}.layout);
+}
+
+}  // namespace marlin::exec
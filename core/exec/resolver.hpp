@@ -0,0 +1,61 @@
+#ifndef marlin_exec_resolver_hpp
+#define marlin_exec_resolver_hpp
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "ast.hpp"
+#include "runtime.hpp"
+
+namespace marlin::exec {
+
+// Where every variable of a program lives when it runs natively, scoped the
+// way exec::generator scopes the JavaScript it produces: a block sees as
+// globals the names of every use_global met so far since the last on_start
+// or the end of the last function, and every other name is local to the
+// block.
+
+struct variable_ref {
+  bool is_global{false};
+  uint32_t slot{0};
+};
+
+struct block_layout {
+  explicit block_layout(ast::base& _block) : block{&_block} {}
+
+  ast::base* block;
+  // Parameters take the first slots
+  size_t parameter_count{0};
+  std::vector<std::string> locals;
+  // Whether the slot is ever assigned in the block, reading any other local
+  // is a ReferenceError
+  std::vector<bool> declared;
+};
+
+struct program_layout {
+  // In the order of the blocks of the program
+  std::vector<block_layout> blocks;
+  // The last on_start, like the last __main__ declaration
+  std::optional<size_t> main_block;
+  std::vector<std::string> globals;
+
+  std::unordered_map<const ast::base*, variable_ref> variables;
+  // Values of the number, string and bool literals
+  std::unordered_map<const ast::base*, value> constants;
+  // Block called by each user function call, the last function declared
+  // with the name
+  std::unordered_map<const ast::base*, size_t> callees;
+};
+
+// Throws collected_generation_error with the errors exec::generator would
+// report for the program, except that a result is returned in any user
+// function
+[[nodiscard]] program_layout resolve(ast::program& program);
+
+}  // namespace marlin::exec
+
+#endif  // marlin_exec_resolver_hpp
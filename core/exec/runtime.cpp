@@ -0,0 +1,810 @@
+#include "runtime.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <optional>
+#include <thread>
+
+#include "exec_errors.hpp"
+
+namespace marlin::exec {
+
+namespace {
+
+constexpr double pi{3.14159265358979323846};
+constexpr double rad_per_deg{pi / 180};
+
+// Arrays stop growing here instead of becoming sparse like in JavaScript
+constexpr size_t max_array_size{size_t{1} << 24};
+
+[[noreturn]] void throw_type_error(std::string message) {
+  throw runtime_error{"TypeError", std::move(message)};
+}
+
+// Objects all convert to strings before anything else
+[[nodiscard]] bool is_object(const value& v) noexcept {
+  return v.is(value::type::array) || v.is(value::type::color) ||
+         v.is(value::type::range);
+}
+
+[[nodiscard]] bool is_string_like(const value& v) noexcept {
+  return v.is(value::type::string) || is_object(v);
+}
+
+void join(const array& elements, std::string& result,
+          std::vector<const array*>& joining) {
+  // Arrays containing themselves join as empty, like Array.prototype.join
+  if (std::find(joining.begin(), joining.end(), &elements) != joining.end()) {
+    return;
+  }
+  joining.push_back(&elements);
+  for (size_t i{0}; i < elements.size(); i++) {
+    if (i > 0) {
+      result.push_back(',');
+    }
+    const auto& element{elements[i]};
+    if (element.is(value::type::array)) {
+      join(*element.array(), result, joining);
+    } else if (!element.is(value::type::undefined)) {
+      result.append(to_string(element));
+    }
+  }
+  joining.pop_back();
+}
+
+// Length of the JavaScript whitespace or line terminator at the front of
+// the UTF-8 text, 0 if there is none
+[[nodiscard]] size_t space_length(std::string_view text) noexcept {
+  if (text.empty()) {
+    return 0;
+  }
+  const auto c{static_cast<unsigned char>(text[0])};
+  if (c == ' ' || (c >= '\t' && c <= '\r')) {
+    return 1;
+  }
+  const auto starts_with{[&](std::string_view prefix) {
+    return text.substr(0, prefix.size()) == prefix;
+  }};
+  if (starts_with("\xC2\xA0") /* NBSP */) {
+    return 2;
+  }
+  if (starts_with("\xEF\xBB\xBF") /* BOM */ ||
+      starts_with("\xE1\x9A\x80") /* ogham space */ ||
+      starts_with("\xE2\x80\xAF") /* narrow NBSP */ ||
+      starts_with("\xE2\x81\x9F") /* math space */ ||
+      starts_with("\xE3\x80\x80") /* ideographic space */) {
+    return 3;
+  }
+  // En quad to hair space, then line and paragraph separators
+  if (text.size() >= 3 && c == 0xE2 &&
+      static_cast<unsigned char>(text[1]) == 0x80) {
+    const auto last{static_cast<unsigned char>(text[2])};
+    if (last <= 0x8A || last == 0xA8 || last == 0xA9) {
+      return 3;
+    }
+  }
+  return 0;
+}
+
+[[nodiscard]] std::string_view trim(std::string_view text) noexcept {
+  while (auto length = space_length(text)) {
+    text.remove_prefix(length);
+  }
+  // Spaces are found from the front, so trailing ones are found by trying
+  // every suffix
+  for (size_t end{text.size()}; end > 0;) {
+    size_t start{end - 1};
+    while (start > 0 &&
+           (static_cast<unsigned char>(text[start]) & 0xC0) == 0x80) {
+      start--;
+    }
+    if (space_length(text.substr(start, end - start)) != end - start) {
+      break;
+    }
+    text.remove_suffix(text.size() - start);
+    end = start;
+  }
+  return text;
+}
+
+[[nodiscard]] bool is_digit(char c) noexcept { return c >= '0' && c <= '9'; }
+
+[[nodiscard]] double radix_to_number(std::string_view digits, int radix) {
+  if (digits.empty()) {
+    return NAN;
+  }
+  double result{0};
+  for (const auto c : digits) {
+    int digit;
+    if (is_digit(c)) {
+      digit = c - '0';
+    } else if (c >= 'a' && c <= 'f') {
+      digit = c - 'a' + 10;
+    } else if (c >= 'A' && c <= 'F') {
+      digit = c - 'A' + 10;
+    } else {
+      return NAN;
+    }
+    if (digit >= radix) {
+      return NAN;
+    }
+    result = result * radix + digit;
+  }
+  return result;
+}
+
+// StrDecimalLiteral without the sign and Infinity
+[[nodiscard]] bool is_decimal(std::string_view text) noexcept {
+  size_t i{0};
+  size_t digits{0};
+  for (; i < text.size() && is_digit(text[i]); i++) {
+    digits++;
+  }
+  if (i < text.size() && text[i] == '.') {
+    for (i++; i < text.size() && is_digit(text[i]); i++) {
+      digits++;
+    }
+  }
+  if (digits == 0) {
+    return false;
+  }
+  if (i < text.size() && (text[i] == 'e' || text[i] == 'E')) {
+    i++;
+    if (i < text.size() && (text[i] == '+' || text[i] == '-')) {
+      i++;
+    }
+    const auto exponent_begin{i};
+    for (; i < text.size() && is_digit(text[i]); i++) {
+    }
+    if (i == exponent_begin) {
+      return false;
+    }
+  }
+  return i == text.size();
+}
+
+// CanonicalNumericIndexString restricted to array indices
+[[nodiscard]] std::optional<size_t> array_index(const value& key) {
+  constexpr double max_index{4294967295.0};
+  if (key.is(value::type::number)) {
+    const auto number{key.number()};
+    if (number >= 0 && number < max_index && std::floor(number) == number) {
+      return static_cast<size_t>(number);
+    }
+    return std::nullopt;
+  }
+  const auto text{to_string(key)};
+  if (text.empty() || text.size() > 10 || (text[0] == '0' && text.size() > 1) ||
+      !std::all_of(text.begin(), text.end(), is_digit)) {
+    return std::nullopt;
+  }
+  const auto index{std::strtoull(text.data(), nullptr, 10)};
+  if (index >= static_cast<unsigned long long>(max_index)) {
+    return std::nullopt;
+  }
+  return static_cast<size_t>(index);
+}
+
+// Start of Array.prototype.splice
+[[nodiscard]] size_t splice_start(double index, size_t size) noexcept {
+  const auto relative{std::trunc(index)};
+  const auto length{static_cast<double>(size)};
+  if (relative < 0) {
+    return static_cast<size_t>(std::max(length + relative, 0.0));
+  }
+  return static_cast<size_t>(std::min(relative, length));
+}
+
+[[nodiscard]] double restrict(double value, double min, double max) noexcept {
+  if (value < min) {
+    return min;
+  } else if (value > max) {
+    return max;
+  } else {
+    return value;
+  }
+}
+
+[[nodiscard]] double round(double number) noexcept {
+  auto result{std::floor(number)};
+  if (number - result >= 0.5) {
+    result += 1;
+  }
+  // Math.round keeps the sign of numbers rounded to zero
+  return result == 0 && std::signbit(number) ? -0.0 : result;
+}
+
+[[nodiscard]] double now() {
+  using namespace std::chrono;
+  const auto milliseconds{
+      duration_cast<std::chrono::milliseconds>(
+          system_clock::now().time_since_epoch())
+          .count()};
+  return static_cast<double>(milliseconds) / 1000;
+}
+
+}  // namespace
+
+bool value::same_object(const value& other) const noexcept {
+  if (_data.index() != other._data.index()) {
+    return false;
+  }
+  switch (get_type()) {
+    case type::array:
+      return array() == other.array();
+    case type::color:
+      return &color() == &other.color();
+    case type::range:
+      return range() == other.range();
+    default:
+      return false;
+  }
+}
+
+bool to_boolean(const value& v) noexcept {
+  switch (v.get_type()) {
+    case value::type::undefined:
+      return false;
+    case value::type::number:
+      return v.number() != 0 && !std::isnan(v.number());
+    case value::type::boolean:
+      return v.boolean();
+    case value::type::string:
+      return !v.string().empty();
+    default:
+      return true;
+  }
+}
+
+double to_number(const value& v) {
+  switch (v.get_type()) {
+    case value::type::undefined:
+      return NAN;
+    case value::type::number:
+      return v.number();
+    case value::type::boolean:
+      return v.boolean() ? 1 : 0;
+    case value::type::string:
+      return string_to_number(v.string());
+    default:
+      return string_to_number(to_string(v));
+  }
+}
+
+std::string to_string(const value& v) {
+  switch (v.get_type()) {
+    case value::type::undefined:
+      return "undefined";
+    case value::type::number:
+      return number_to_string(v.number());
+    case value::type::boolean:
+      return v.boolean() ? "true" : "false";
+    case value::type::string:
+      return v.string();
+    case value::type::array: {
+      std::string result;
+      std::vector<const array*> joining;
+      join(*v.array(), result, joining);
+      return result;
+    }
+    case value::type::color:
+      return v.color().text;
+    case value::type::range:
+      return "[object Generator]";
+  }
+  return {};
+}
+
+std::string number_to_string(double number) {
+  if (std::isnan(number)) {
+    return "NaN";
+  }
+  if (number == 0) {
+    return "0";
+  }
+  if (number < 0) {
+    return "-" + number_to_string(-number);
+  }
+  if (std::isinf(number)) {
+    return "Infinity";
+  }
+  if (number < 9007199254740992.0 && std::floor(number) == number) {
+    return std::to_string(static_cast<uint64_t>(number));
+  }
+
+  // Shortest digits that read back as the same number
+  char buffer[32];
+  for (int precision{1}; precision <= 17; precision++) {
+    std::snprintf(buffer, sizeof(buffer), "%.*e", precision - 1, number);
+    if (std::strtod(buffer, nullptr) == number) {
+      break;
+    }
+  }
+  std::string digits;
+  const char* p{buffer};
+  for (; *p != 'e'; p++) {
+    if (*p != '.') {
+      digits.push_back(*p);
+    }
+  }
+  while (digits.size() > 1 && digits.back() == '0') {
+    digits.pop_back();
+  }
+  const auto exponent{std::atoi(p + 1)};
+
+  // Number::toString, with n the position of the decimal point
+  const auto k{static_cast<int>(digits.size())};
+  const auto n{exponent + 1};
+  if (k <= n && n <= 21) {
+    return digits + std::string(n - k, '0');
+  }
+  if (0 < n && n <= 21) {
+    return digits.substr(0, n) + "." + digits.substr(n);
+  }
+  if (-6 < n && n <= 0) {
+    return "0." + std::string(-n, '0') + digits;
+  }
+  auto result{digits.substr(0, 1)};
+  if (k > 1) {
+    result += "." + digits.substr(1);
+  }
+  result += n - 1 < 0 ? "e-" : "e+";
+  return result + std::to_string(std::abs(n - 1));
+}
+
+double string_to_number(std::string_view string) {
+  const auto text{trim(string)};
+  if (text.empty()) {
+    return 0;
+  }
+  if (text.size() > 2 && text[0] == '0') {
+    switch (text[1]) {
+      case 'x':
+      case 'X':
+        return radix_to_number(text.substr(2), 16);
+      case 'o':
+      case 'O':
+        return radix_to_number(text.substr(2), 8);
+      case 'b':
+      case 'B':
+        return radix_to_number(text.substr(2), 2);
+      default:
+        break;
+    }
+  }
+
+  auto unsigned_text{text};
+  double sign{1};
+  if (text[0] == '+' || text[0] == '-') {
+    sign = text[0] == '-' ? -1 : 1;
+    unsigned_text.remove_prefix(1);
+  }
+  if (unsigned_text == "Infinity") {
+    return sign * INFINITY;
+  }
+  if (!is_decimal(unsigned_text)) {
+    return NAN;
+  }
+  const std::string copy{text};
+  return std::strtod(copy.data(), nullptr);
+}
+
+double as_number(const value& v) {
+  const auto result{to_number(v)};
+  if (std::isnan(result)) {
+    throw_type_error("Expecting a number");
+  }
+  return result;
+}
+
+const std::shared_ptr<array>& as_array(const value& v) {
+  if (!v.is(value::type::array)) {
+    throw_type_error("Expecting an array");
+  }
+  return v.array();
+}
+
+const color& as_color(const value& v) {
+  if (!v.is(value::type::color)) {
+    throw_type_error("Expecting a color");
+  }
+  return v.color();
+}
+
+value unary(ast::unary_op op, const value& argument) {
+  switch (op) {
+    case ast::unary_op::negative:
+      return -to_number(argument);
+    case ast::unary_op::logical_not:
+      return !to_boolean(argument);
+  }
+  return {};
+}
+
+value binary(ast::binary_op op, const value& left, const value& right) {
+  // Strings compare by UTF-8 bytes, which only differs from comparing UTF-16
+  // code units for characters out of the BMP
+  const auto compare{[&](auto string_compare, auto number_compare) -> value {
+    if (is_string_like(left) && is_string_like(right)) {
+      return string_compare(to_string(left), to_string(right));
+    }
+    return number_compare(to_number(left), to_number(right));
+  }};
+
+  switch (op) {
+    case ast::binary_op::add:
+      if (is_string_like(left) || is_string_like(right)) {
+        return to_string(left) + to_string(right);
+      }
+      return to_number(left) + to_number(right);
+    case ast::binary_op::subtract:
+      return to_number(left) - to_number(right);
+    case ast::binary_op::multiply:
+      return to_number(left) * to_number(right);
+    case ast::binary_op::divide:
+      return to_number(left) / to_number(right);
+    case ast::binary_op::equal:
+      return strict_equal(left, right);
+    case ast::binary_op::not_equal:
+      return !strict_equal(left, right);
+    case ast::binary_op::less:
+      return compare(std::less<>{}, std::less<>{});
+    case ast::binary_op::less_equal:
+      return compare(std::less_equal<>{}, std::less_equal<>{});
+    case ast::binary_op::greater:
+      return compare(std::greater<>{}, std::greater<>{});
+    case ast::binary_op::greater_equal:
+      return compare(std::greater_equal<>{}, std::greater_equal<>{});
+    case ast::binary_op::logical_and:
+    case ast::binary_op::logical_or:
+      // Evaluated by the interpreter
+      assert(false);
+      break;
+  }
+  return {};
+}
+
+bool strict_equal(const value& left, const value& right) {
+  if (left.get_type() != right.get_type()) {
+    return false;
+  }
+  switch (left.get_type()) {
+    case value::type::undefined:
+      return true;
+    case value::type::number:
+      return left.number() == right.number();
+    case value::type::boolean:
+      return left.boolean() == right.boolean();
+    case value::type::string:
+      return left.string() == right.string();
+    default:
+      return left.same_object(right);
+  }
+}
+
+value get_element(const value& list, const value& index) {
+  const auto& elements{*as_array(list)};
+  // Other keys would name properties, which arrays of programs never have
+  const auto i{array_index(index)};
+  if (i && *i < elements.size()) {
+    return elements[*i];
+  }
+  return {};
+}
+
+void set_element(const value& list, const value& index, value element) {
+  auto& elements{*as_array(list)};
+  // Properties other than indices are dropped
+  const auto i{array_index(index)};
+  if (!i) {
+    return;
+  }
+  if (*i >= elements.size()) {
+    if (*i >= max_array_size) {
+      throw runtime_error{"RangeError", "Invalid array length"};
+    }
+    elements.resize(*i + 1);
+  }
+  elements[*i] = std::move(element);
+}
+
+range_state make_range(ast::system_function func, const value* args) {
+  // Arguments are checked against undefined like range() does, so range(1, x)
+  // counts up to 1 when x is undefined
+  const auto count{func == ast::system_function::range1   ? 1
+                   : func == ast::system_function::range2 ? 2
+                                                          : 3};
+  range_state state{0, 0, 1};
+  if (count >= 2 && !args[1].is(value::type::undefined)) {
+    state.next = as_number(args[0]);
+    state.end = as_number(args[1]);
+    if (count == 3 && !args[2].is(value::type::undefined)) {
+      state.step = as_number(args[2]);
+    }
+  } else {
+    state.end = as_number(args[0]);
+  }
+  return state;
+}
+
+iteration::iteration(value iterable) : _iterable{std::move(iterable)} {
+  switch (_iterable.get_type()) {
+    case value::type::array:
+    case value::type::range:
+    case value::type::string:
+      break;
+    default:
+      throw_type_error(to_string(_iterable) + " is not iterable");
+  }
+}
+
+iteration::~iteration() {
+  // Leaving a loop early returns the generator, which then stays done
+  if (_iterable.is(value::type::range) && !_done) {
+    auto& state{*_iterable.range()};
+    state.next = state.end;
+  }
+}
+
+bool iteration::next(value& element) {
+  switch (_iterable.get_type()) {
+    case value::type::array: {
+      const auto& elements{*_iterable.array()};
+      if (_index < elements.size()) {
+        element = elements[_index++];
+        return true;
+      }
+      break;
+    }
+    case value::type::range: {
+      auto& state{*_iterable.range()};
+      if (state.step >= 0 ? state.next < state.end : state.next > state.end) {
+        element = state.next;
+        state.next += state.step;
+        return true;
+      }
+      break;
+    }
+    case value::type::string: {
+      const auto& text{_iterable.string()};
+      if (_index < text.size()) {
+        auto end{_index + 1};
+        while (end < text.size() &&
+               (static_cast<unsigned char>(text[end]) & 0xC0) == 0x80) {
+          end++;
+        }
+        element = text.substr(_index, end - _index);
+        _index = end;
+        return true;
+      }
+      break;
+    }
+    default:
+      break;
+  }
+  _done = true;
+  return false;
+}
+
+environment::logo_state::logo_state() : direction{pi} {}
+
+environment::environment(options opts)
+    : _options{opts},
+      _start_time{opts.start_time < 0 ? now() : opts.start_time},
+      _random{opts.random_seed} {}
+
+void environment::call(ast::system_procedure proc, const value* args) {
+  using kind = graphics_command::kind;
+  switch (proc) {
+    case ast::system_procedure::sleep:
+      sleep(as_number(args[0]));
+      break;
+    case ast::system_procedure::print:
+      _printed.push_back({_elapsed, to_string(args[0])});
+      break;
+    case ast::system_procedure::draw_line:
+      draw(kind::draw_line, args, 4);
+      break;
+    case ast::system_procedure::draw_arc:
+      draw(kind::draw_arc, args, 5);
+      break;
+    case ast::system_procedure::draw_rect:
+      draw(kind::draw_rect, args, 4);
+      break;
+    case ast::system_procedure::draw_ellipse:
+      draw(kind::draw_ellipse, args, 4);
+      break;
+    case ast::system_procedure::clear_canvas:
+      set_color(kind::clear_canvas, args[0]);
+      break;
+    case ast::system_procedure::set_line_width:
+      draw(kind::set_line_width, args, 1);
+      break;
+    case ast::system_procedure::set_line_color:
+      set_color(kind::set_line_color, args[0]);
+      break;
+    case ast::system_procedure::set_fill_color:
+      set_color(kind::set_fill_color, args[0]);
+      break;
+    case ast::system_procedure::logo_forward:
+      logo_forward(as_number(args[0]));
+      break;
+    case ast::system_procedure::logo_backward:
+      logo_forward(-as_number(args[0]));
+      break;
+    case ast::system_procedure::logo_turn_left:
+      _logo.direction =
+          std::fmod(_logo.direction - as_number(args[0]) * rad_per_deg, 2 * pi);
+      break;
+    case ast::system_procedure::logo_turn_right:
+      _logo.direction =
+          std::fmod(_logo.direction + as_number(args[0]) * rad_per_deg, 2 * pi);
+      break;
+    case ast::system_procedure::logo_pen_up:
+      _logo.is_pen_down = false;
+      break;
+    case ast::system_procedure::logo_pen_down:
+      _logo.is_pen_down = true;
+      break;
+    case ast::system_procedure::logo_go_home:
+      if (_logo.is_pen_down) {
+        _commands.push_back(
+            {kind::draw_line, _elapsed, {_logo.x, _logo.y, 0, 0}, {}});
+      }
+      _logo.x = 0;
+      _logo.y = 0;
+      _logo.direction = pi;
+      break;
+  }
+}
+
+value environment::call(ast::system_function func, const value* args) {
+  switch (func) {
+    case ast::system_function::range1:
+    case ast::system_function::range2:
+    case ast::system_function::range3:
+      return std::make_shared<range_state>(make_range(func, args));
+    case ast::system_function::random: {
+      const auto min{as_number(args[0])};
+      const auto max{as_number(args[1])};
+      return min + std::generate_canonical<double, 53>(_random) * (max - min);
+    }
+    case ast::system_function::list_length:
+      return static_cast<double>(as_array(args[0])->size());
+    case ast::system_function::time:
+      return _options.real_time ? now() : _start_time + _elapsed;
+    case ast::system_function::abs:
+      return std::abs(as_number(args[0]));
+    case ast::system_function::sqrt:
+      return std::sqrt(as_number(args[0]));
+    case ast::system_function::sin:
+      return std::sin(as_number(args[0]) * rad_per_deg);
+    case ast::system_function::cos:
+      return std::cos(as_number(args[0]) * rad_per_deg);
+    case ast::system_function::tan:
+      return std::tan(as_number(args[0]) * rad_per_deg);
+    case ast::system_function::asin:
+      return std::asin(as_number(args[0])) / rad_per_deg;
+    case ast::system_function::acos:
+      return std::acos(as_number(args[0])) / rad_per_deg;
+    case ast::system_function::atan:
+      return std::atan(as_number(args[0])) / rad_per_deg;
+    case ast::system_function::ln:
+      return std::log(as_number(args[0]));
+    case ast::system_function::log:
+      return std::log10(as_number(args[0]));
+    case ast::system_function::round:
+      return round(as_number(args[0]));
+    case ast::system_function::floor:
+      return std::floor(as_number(args[0]));
+    case ast::system_function::ceil:
+      return std::ceil(as_number(args[0]));
+  }
+  return {};
+}
+
+void environment::modify(ast::array_modification mod, const value& list,
+                         const value* args) {
+  auto& elements{*as_array(list)};
+  switch (mod) {
+    case ast::array_modification::append:
+      elements.push_back(args[0]);
+      break;
+    case ast::array_modification::insert: {
+      const auto start{splice_start(as_number(args[0]), elements.size())};
+      elements.insert(elements.begin() + start, args[1]);
+      break;
+    }
+    case ast::array_modification::remove: {
+      const auto start{splice_start(as_number(args[0]), elements.size())};
+      if (start < elements.size()) {
+        elements.erase(elements.begin() + start);
+      }
+      break;
+    }
+  }
+}
+
+value environment::make_color(ast::color_mode mode, const value* args) {
+  const auto channel{[&](size_t index, double max) {
+    return number_to_string(restrict(as_number(args[index]), 0, max));
+  }};
+  const auto percentage{[&](size_t index) {
+    return number_to_string(restrict(as_number(args[index]), 0, 1) * 100);
+  }};
+
+  std::string text;
+  switch (mode) {
+    case ast::color_mode::rgb: {
+      auto red{channel(0, 255)};
+      auto green{channel(1, 255)};
+      auto blue{channel(2, 255)};
+      text = "rgb(" + red + "," + green + "," + blue + ")";
+      break;
+    }
+    case ast::color_mode::rgba: {
+      auto red{channel(0, 255)};
+      auto green{channel(1, 255)};
+      auto blue{channel(2, 255)};
+      auto alpha{channel(3, 1)};
+      text = "rgba(" + red + "," + green + "," + blue + "," + alpha + ")";
+      break;
+    }
+    case ast::color_mode::hsl: {
+      auto hue{channel(0, 360)};
+      auto saturation{percentage(1)};
+      auto lightness{percentage(2)};
+      text = "hsl(" + hue + "," + saturation + "%," + lightness + "%)";
+      break;
+    }
+    case ast::color_mode::hsla: {
+      auto hue{channel(0, 360)};
+      auto saturation{percentage(1)};
+      auto lightness{percentage(2)};
+      auto alpha{channel(3, 1)};
+      text = "hsla(" + hue + "," + saturation + "%," + lightness + "%," +
+             alpha + ")";
+      break;
+    }
+  }
+  return std::make_shared<const color>(color{std::move(text)});
+}
+
+void environment::sleep(double seconds) {
+  seconds = std::max(seconds, 0.0);
+  _elapsed += seconds;
+  if (_options.real_time) {
+    std::this_thread::sleep_for(std::chrono::duration<double>{seconds});
+  }
+}
+
+void environment::draw(graphics_command::kind type, const value* args,
+                       size_t count) {
+  graphics_command command{type, _elapsed, {}, {}};
+  for (size_t i{0}; i < count; i++) {
+    command.arguments[i] = as_number(args[i]);
+  }
+  _commands.push_back(std::move(command));
+}
+
+void environment::set_color(graphics_command::kind type, const value& color) {
+  _commands.push_back({type, _elapsed, {}, as_color(color).text});
+}
+
+void environment::logo_forward(double length) {
+  const auto x{_logo.x};
+  const auto y{_logo.y};
+  _logo.x -= length * std::sin(_logo.direction);
+  _logo.y += length * std::cos(_logo.direction);
+  if (_logo.is_pen_down) {
+    _commands.push_back({graphics_command::kind::draw_line, _elapsed,
+                         {x, y, _logo.x, _logo.y}, {}});
+  }
+}
+
+}  // namespace marlin::exec
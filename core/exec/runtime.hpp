@@ -0,0 +1,254 @@
+#ifndef marlin_exec_runtime_hpp
+#define marlin_exec_runtime_hpp
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <random>
+#include <string>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+#include "exec_errors.hpp"
+#include "specs.hpp"
+
+namespace marlin::exec {
+
+// Values and system calls of programs run natively, following exec_env.js
+// and the JavaScript semantics of the code exec::generator produces
+
+struct value;
+
+using array = std::vector<value>;
+
+struct color {
+  // CSS text of the color, as built by ColorUtils
+  std::string text;
+};
+
+// State of the generator returned by range(), consumed as it is iterated
+struct range_state {
+  double next;
+  double end;
+  double step;
+};
+
+struct value {
+  // In the order of the alternatives of the variant
+  enum struct type : uint8_t {
+    undefined,
+    number,
+    boolean,
+    string,
+    array,
+    color,
+    range
+  };
+
+  value() noexcept = default;
+  value(double number) noexcept : _data{number} {}
+  value(bool boolean) noexcept : _data{boolean} {}
+  value(std::string string)
+      : _data{std::make_shared<const std::string>(std::move(string))} {}
+  value(const char* string) : value{std::string{string}} {}
+  value(std::shared_ptr<exec::array> array) noexcept
+      : _data{std::move(array)} {}
+  value(std::shared_ptr<const exec::color> color) noexcept
+      : _data{std::move(color)} {}
+  value(std::shared_ptr<range_state> range) noexcept
+      : _data{std::move(range)} {}
+
+  // Without going through a temporary value, for the registers of the VM
+  value& operator=(double number) noexcept {
+    _data = number;
+    return *this;
+  }
+  value& operator=(bool boolean) noexcept {
+    _data = boolean;
+    return *this;
+  }
+
+  [[nodiscard]] type get_type() const noexcept {
+    return static_cast<type>(_data.index());
+  }
+  [[nodiscard]] bool is(type t) const noexcept { return get_type() == t; }
+
+  [[nodiscard]] double number() const noexcept {
+    return *std::get_if<double>(&_data);
+  }
+  [[nodiscard]] bool boolean() const noexcept {
+    return *std::get_if<bool>(&_data);
+  }
+  [[nodiscard]] const std::string& string() const noexcept {
+    return **std::get_if<std::shared_ptr<const std::string>>(&_data);
+  }
+  [[nodiscard]] const std::shared_ptr<exec::array>& array() const noexcept {
+    return *std::get_if<std::shared_ptr<exec::array>>(&_data);
+  }
+  [[nodiscard]] const exec::color& color() const noexcept {
+    return **std::get_if<std::shared_ptr<const exec::color>>(&_data);
+  }
+  [[nodiscard]] const std::shared_ptr<range_state>& range() const noexcept {
+    return *std::get_if<std::shared_ptr<range_state>>(&_data);
+  }
+
+  // Arrays, colors and ranges are compared by identity
+  [[nodiscard]] bool same_object(const value& other) const noexcept;
+
+ private:
+  std::variant<std::monostate, double, bool, std::shared_ptr<const std::string>,
+               std::shared_ptr<exec::array>, std::shared_ptr<const exec::color>,
+               std::shared_ptr<range_state>>
+      _data;
+};
+
+// Conversions, named after the abstract operations of ECMAScript
+
+[[nodiscard]] bool to_boolean(const value& v) noexcept;
+[[nodiscard]] double to_number(const value& v);
+[[nodiscard]] std::string to_string(const value& v);
+
+[[nodiscard]] std::string number_to_string(double number);
+[[nodiscard]] double string_to_number(std::string_view string);
+
+// Checks of exec_env.js, throwing TypeError like asNumber, assertArray and
+// assertColor
+[[nodiscard]] double as_number(const value& v);
+[[nodiscard]] const std::shared_ptr<array>& as_array(const value& v);
+[[nodiscard]] const color& as_color(const value& v);
+
+// Operators, except the logical ones which evaluate their operands lazily
+[[nodiscard]] value unary(ast::unary_op op, const value& argument);
+[[nodiscard]] value binary(ast::binary_op op, const value& left,
+                           const value& right);
+[[nodiscard]] bool strict_equal(const value& left, const value& right);
+
+// Subscripts, the list going through asArray first
+[[nodiscard]] value get_element(const value& list, const value& index);
+void set_element(const value& list, const value& index, value element);
+
+// Arguments of range() as the numbers it counts with, checked like asNumber
+[[nodiscard]] range_state make_range(ast::system_function func,
+                                     const value* args);
+
+// Iteration of a for statement, over an array as it grows or shrinks, the
+// rest of a range, or the codepoints of a string
+struct iteration {
+  explicit iteration(value iterable);
+  ~iteration();
+
+  iteration(const iteration&) = delete;
+  iteration& operator=(const iteration&) = delete;
+
+  [[nodiscard]] bool next(value& element);
+
+ private:
+  value _iterable;
+  size_t _index{0};
+  bool _done{false};
+};
+
+struct graphics_command {
+  enum struct kind : uint8_t {
+    draw_line,
+    draw_arc,
+    draw_rect,
+    draw_ellipse,
+    clear_canvas,
+    set_line_width,
+    set_line_color,
+    set_fill_color
+  };
+
+  kind type;
+  // Time of the program when drawn, in seconds since it started
+  double time;
+  // Numbers as passed, coordinates relative to the center of the canvas
+  // and angles in degrees
+  std::array<double, 5> arguments{};
+  // CSS text of the color argument
+  std::string color;
+};
+
+struct printed_message {
+  double time;
+  std::string message;
+};
+
+// State of exec_env.js for one run: printed messages and graphics commands
+// are recorded, and sleep only moves the clock of the program forward unless
+// real time is asked for
+struct environment {
+  struct options {
+    // Value of time() when the program starts, in seconds since the epoch,
+    // the current time if negative
+    double start_time{-1};
+    uint64_t random_seed{0};
+    bool real_time{false};
+  };
+
+  struct logo_state {
+    double x{0};
+    double y{0};
+    double direction;
+    bool is_pen_down{true};
+
+    logo_state();
+  };
+
+  explicit environment(options opts);
+
+  [[nodiscard]] double elapsed() const noexcept { return _elapsed; }
+  [[nodiscard]] const std::vector<printed_message>& printed()
+      const& noexcept {
+    return _printed;
+  }
+  [[nodiscard]] std::vector<printed_message> printed() && noexcept {
+    return std::move(_printed);
+  }
+  [[nodiscard]] const std::vector<graphics_command>& commands()
+      const& noexcept {
+    return _commands;
+  }
+  [[nodiscard]] std::vector<graphics_command> commands() && noexcept {
+    return std::move(_commands);
+  }
+  [[nodiscard]] const logo_state& logo() const noexcept { return _logo; }
+
+  // Arguments are as many as the prototype of the call has
+  void call(ast::system_procedure proc, const value* args);
+  [[nodiscard]] value call(ast::system_function func, const value* args);
+  void modify(ast::array_modification mod, const value& list,
+              const value* args);
+  [[nodiscard]] value make_color(ast::color_mode mode, const value* args);
+
+ private:
+  options _options;
+  double _start_time;
+  double _elapsed{0};
+  std::mt19937_64 _random;
+  logo_state _logo;
+
+  std::vector<printed_message> _printed;
+  std::vector<graphics_command> _commands;
+
+  void sleep(double seconds);
+  void draw(graphics_command::kind type, const value* args, size_t count);
+  void set_color(graphics_command::kind type, const value& color);
+  void logo_forward(double length);
+};
+
+struct run_result {
+  // Time the program took, in seconds
+  double elapsed{0};
+  std::vector<printed_message> printed;
+  std::vector<graphics_command> commands;
+  // The error that stopped the program, if any
+  std::optional<runtime_error> error;
+};
+
+}  // namespace marlin::exec
+
+#endif  // marlin_exec_runtime_hpp
@@ -0,0 +1,160 @@
+#include "source_map.hpp"
+
+#include <algorithm>
+#include <cstdio>
+
+namespace marlin::exec {
+
+namespace {
+
+void append_vlq(std::string& output, int64_t value) {
+  static constexpr std::string_view digits{
+      "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/"};
+  // The sign goes to the lowest bit, continuations to the sixth
+  auto rest{value < 0 ? (static_cast<uint64_t>(-value) << 1) | 1
+                      : static_cast<uint64_t>(value) << 1};
+  do {
+    auto digit{rest & 0b11111};
+    rest >>= 5;
+    if (rest != 0) {
+      digit |= 0b100000;
+    }
+    output += digits[digit];
+  } while (rest != 0);
+}
+
+void append_json_string(std::string& output, std::string_view value) {
+  output += '"';
+  for (const auto c : value) {
+    switch (c) {
+      case '"':
+        output += "\\\"";
+        break;
+      case '\\':
+        output += "\\\\";
+        break;
+      case '\n':
+        output += "\\n";
+        break;
+      default:
+        if (static_cast<unsigned char>(c) < 0x20) {
+          char escaped[7];
+          std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+          output += escaped;
+        } else {
+          output += c;
+        }
+        break;
+    }
+  }
+  output += '"';
+}
+
+}  // namespace
+
+void js_mappings::append(const js_mappings& other, size_t line_offset) {
+  const auto id_offset{static_cast<uint32_t>(nodes.size())};
+  nodes.insert(nodes.end(), other.nodes.begin(), other.nodes.end());
+  for (auto mapping : other.mappings) {
+    mapping.loc.line += line_offset;
+    if (mapping.node != js_mapping::no_node) {
+      mapping.node += id_offset;
+    }
+    map(mapping.loc, mapping.node);
+  }
+}
+
+js_mappings js_mappings::of_ranges(
+    std::vector<std::pair<source_range, ast::base*>> ranges) {
+  // Outer nodes first, and among nodes written to the same range, those
+  // whose range was reported last
+  std::reverse(ranges.begin(), ranges.end());
+  std::stable_sort(ranges.begin(), ranges.end(),
+                   [](const auto& left, const auto& right) {
+                     return left.first.begin < right.first.begin ||
+                            (left.first.begin == right.first.begin &&
+                             right.first.end < left.first.end);
+                   });
+
+  js_mappings result;
+  result.nodes.reserve(ranges.size());
+  std::vector<std::pair<source_loc, uint32_t>> open;
+  const auto close{[&]() {
+    const auto end{open.back().first};
+    open.pop_back();
+    result.map(end, open.empty() ? js_mapping::no_node : open.back().second);
+  }};
+  for (const auto& [range, node] : ranges) {
+    while (!open.empty() && open.back().first <= range.begin) {
+      close();
+    }
+    const auto id{result.add(*node)};
+    open.emplace_back(range.end, id);
+    result.map(range.begin, id);
+  }
+  while (!open.empty()) {
+    close();
+  }
+  return result;
+}
+
+ast::base* source_map::locate(source_loc loc) const {
+  auto it{std::upper_bound(_segments.begin(), _segments.end(), loc,
+                           [](source_loc loc, const js_mapping& mapping) {
+                             return loc < mapping.loc;
+                           })};
+  if (it == _segments.begin() || (--it)->node == js_mapping::no_node) {
+    return nullptr;
+  }
+  return _nodes[it->node];
+}
+
+std::string source_map::vlq_mappings() const {
+  std::string result;
+  size_t line{1};
+  int64_t column{0};
+  bool first_in_line{true};
+  int64_t source_line{0};
+  int64_t source_column{0};
+  for (const auto& segment : _segments) {
+    for (; line < segment.loc.line; line++) {
+      result += ';';
+      column = 0;
+      first_in_line = true;
+    }
+    if (!first_in_line) {
+      result += ',';
+    }
+    first_in_line = false;
+
+    const auto generated_column{static_cast<int64_t>(segment.loc.column) - 1};
+    append_vlq(result, generated_column - column);
+    column = generated_column;
+    if (segment.node != js_mapping::no_node) {
+      const auto begin{_nodes[segment.node]->source_code_range.begin};
+      const auto node_line{static_cast<int64_t>(begin.line) - 1};
+      const auto node_column{static_cast<int64_t>(begin.column) - 1};
+      // Always the first and only source
+      append_vlq(result, 0);
+      append_vlq(result, node_line - source_line);
+      append_vlq(result, node_column - source_column);
+      source_line = node_line;
+      source_column = node_column;
+    }
+  }
+  return result;
+}
+
+std::string source_map::to_json(std::string_view file,
+                                std::string_view source) const {
+  std::string result{"{\"version\":3,\"file\":"};
+  append_json_string(result, file);
+  result += ",\"sources\":[";
+  append_json_string(result, source);
+  result += "],\"names\":[],\"mappings\":\"";
+  result += vlq_mappings();
+  result += "\"}";
+  return result;
+}
+
+}  // namespace marlin::exec
@@ -0,0 +1,92 @@
+#ifndef marlin_exec_source_map_hpp
+#define marlin_exec_source_map_hpp
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "ast.hpp"
+
+namespace marlin::exec {
+
+// The JavaScript from the location on, up to the next mapping, was written
+// for the node of the id, or outside any node
+struct js_mapping {
+  static constexpr uint32_t no_node{UINT32_MAX};
+
+  source_loc loc;
+  uint32_t node;
+};
+
+// Nodes written to a script, numbered in the order they were written, and
+// what the text at each location of the script belongs to
+struct js_mappings {
+  std::vector<ast::base*> nodes;
+  std::vector<js_mapping> mappings;
+
+  [[nodiscard]] uint32_t add(ast::base& node) {
+    nodes.push_back(&node);
+    return static_cast<uint32_t>(nodes.size() - 1);
+  }
+
+  // A later mapping at the same location takes over
+  void map(source_loc loc, uint32_t node) {
+    if (!mappings.empty() && mappings.back().loc == loc) {
+      mappings.back().node = node;
+    } else {
+      mappings.push_back({loc, node});
+    }
+  }
+
+  // Takes those of a script written after the lines of this one
+  void append(const js_mappings& other, size_t line_offset);
+
+  // From the ranges jsast reports each node was written to, children first
+  [[nodiscard]] static js_mappings of_ranges(
+      std::vector<std::pair<source_range, ast::base*>> ranges);
+
+  void clear() noexcept {
+    nodes.clear();
+    mappings.clear();
+  }
+};
+
+// Where the nodes of a program went in its generated JavaScript. Mappings
+// are sorted by location, so that the node written at a location is found by
+// binary search.
+struct source_map {
+  source_map() = default;
+  explicit source_map(js_mappings mappings) noexcept
+      : _nodes{std::move(mappings.nodes)},
+        _segments{std::move(mappings.mappings)} {}
+
+  // Innermost node written at the location, nullptr if none
+  [[nodiscard]] ast::base* locate(source_loc loc) const;
+
+  [[nodiscard]] size_t node_count() const noexcept { return _nodes.size(); }
+  [[nodiscard]] ast::base& node(uint32_t id) const { return *_nodes[id]; }
+
+  void clear() noexcept {
+    _nodes.clear();
+    _segments.clear();
+  }
+
+  // The mappings field of a Source Map v3, with Base64 VLQ segments from
+  // generated columns to the beginning of the nodes in the marlin source
+  [[nodiscard]] std::string vlq_mappings() const;
+
+  // Source Map v3 of the script named file, from the marlin source named
+  // source
+  [[nodiscard]] std::string to_json(std::string_view file,
+                                    std::string_view source) const;
+
+ private:
+  std::vector<ast::base*> _nodes;
+  std::vector<js_mapping> _segments;
+};
+
+}  // namespace marlin::exec
+
+#endif  // marlin_exec_source_map_hpp
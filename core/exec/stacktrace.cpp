@@ -1,35 +1,95 @@
 #include "stacktrace.hpp"
 
 #include <charconv>
-#include <regex>
 
 namespace marlin::exec {
 
+namespace {
+
+// Digits only, an empty number reads as 0
+[[nodiscard]] bool parse_number(std::string_view text, size_t& value) {
+  for (const auto c : text) {
+    if (c < '0' || c > '9') {
+      return false;
+    }
+  }
+  value = 0;
+  std::from_chars(text.data(), text.data() + text.size(), value);
+  return true;
+}
+
+// url:line:column, the url may contain colons itself
+[[nodiscard]] bool parse_location(std::string_view text, stack_frame& frame) {
+  const auto column_colon{text.rfind(':')};
+  if (column_colon == std::string_view::npos || column_colon == 0) {
+    return false;
+  }
+  const auto line_colon{text.rfind(':', column_colon - 1)};
+  if (line_colon == std::string_view::npos) {
+    return false;
+  }
+  frame.url = text.substr(0, line_colon);
+  return parse_number(text.substr(line_colon + 1,
+                                  column_colon - line_colon - 1),
+                      frame.loc.line) &&
+         parse_number(text.substr(column_colon + 1), frame.loc.column);
+}
+
+}  // namespace
+
+std::optional<stack_frame> parse_jsc_frame(std::string_view line) {
+  const auto at{line.find('@')};
+  if (at == std::string_view::npos) {
+    return std::nullopt;
+  }
+  stack_frame frame;
+  frame.function = line.substr(0, at);
+  if (!parse_location(line.substr(at + 1), frame)) {
+    return std::nullopt;
+  }
+  // JavaScriptCore reports the location after the error
+  // we have to -1 to correct
+  if (frame.loc.column > 1) {
+    frame.loc.column--;
+  }
+  return frame;
+}
+
+std::optional<stack_frame> parse_v8_frame(std::string_view line) {
+  const auto start{line.find_first_not_of(" \t")};
+  constexpr std::string_view prefix{"at "};
+  if (start == std::string_view::npos ||
+      line.substr(start, prefix.size()) != prefix) {
+    return std::nullopt;
+  }
+  line.remove_prefix(start + prefix.size());
+
+  stack_frame frame;
+  if (const auto paren{line.rfind(" (")};
+      paren != std::string_view::npos && line.back() == ')') {
+    frame.function = line.substr(0, paren);
+    line = line.substr(paren + 2, line.size() - paren - 3);
+  }
+  if (!parse_location(line, frame)) {
+    return std::nullopt;
+  }
+  return frame;
+}
+
 std::vector<source_loc> parse_stacktrace(std::string_view stacktrace,
-                                         std::string_view source_url) {
+                                         std::string_view source_url,
+                                         frame_parser parser) {
   std::vector<source_loc> locs;
-  std::regex regex{"^.*?@(.*):([0-9]*):([0-9]*)$"};
-  const char* prev{stacktrace.begin()};
-  for (const char* it{stacktrace.begin()}; it <= stacktrace.end(); it++) {
-    if (it == stacktrace.end() || *it == '\n') {
-      std::cmatch match;
-      if (std::regex_match(prev, it, match, regex) && match.size() > 3 &&
-          match[1].second - match[1].first >= 0) {
-        std::string_view matched_url{
-            match[1].first,
-            static_cast<size_t>(match[1].second - match[1].first)};
-        if (matched_url == source_url) {
-          size_t line{0}, column{0};
-          std::from_chars(match[2].first, match[2].second, line);
-          std::from_chars(match[3].first, match[3].second, column);
-          locs.emplace_back(line, column);
-        }
-      }
-
-      if (it < stacktrace.end()) {
-        prev = it + 1;
-      }
+  while (!stacktrace.empty()) {
+    const auto end{stacktrace.find('\n')};
+    if (const auto frame{parser(stacktrace.substr(0, end))};
+        frame.has_value() && frame->url == source_url) {
+      locs.push_back(frame->loc);
+    }
+    if (end == std::string_view::npos) {
+      break;
     }
+    stacktrace.remove_prefix(end + 1);
   }
   return locs;
 }
@@ -37,24 +97,22 @@ std::vector<source_loc> parse_stacktrace(std::string_view stacktrace,
 template <typename code_type, typename>
 std::vector<code_type*> parse_stacktrace(std::string_view stacktrace,
                                          std::string_view source_url,
-                                         code_type& code) {
+                                         const source_map& map,
+                                         code_type& code, frame_cache* cache,
+                                         frame_parser parser) {
   std::vector<code_type*> nodes;
-  for (const auto& loc : parse_stacktrace(stacktrace, source_url)) {
-    // JavaScriptCore reports the location after the error
-    // we have to -1 to correct
-    if (loc.column > 1) {
-      nodes.emplace_back(&code.locate_js({loc.line, loc.column - 1}));
-    } else {
-      nodes.emplace_back(&code.locate_js(loc));
-    }
+  for (const auto& loc : parse_stacktrace(stacktrace, source_url, parser)) {
+    auto* node{cache != nullptr ? cache->locate(map, loc) : map.locate(loc)};
+    nodes.emplace_back(node != nullptr ? node : &code);
   }
   return nodes;
 }
 
-template std::vector<ast::base*> parse_stacktrace<ast::base>(std::string_view,
-                                                             std::string_view,
-                                                             ast::base&);
+template std::vector<ast::base*> parse_stacktrace<ast::base>(
+    std::string_view, std::string_view, const source_map&, ast::base&,
+    frame_cache*, frame_parser);
 template std::vector<const ast::base*> parse_stacktrace<const ast::base>(
-    std::string_view, std::string_view, const ast::base&);
+    std::string_view, std::string_view, const source_map&, const ast::base&,
+    frame_cache*, frame_parser);
 
 }  // namespace marlin::exec
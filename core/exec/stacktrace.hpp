@@ -1,21 +1,82 @@
 #ifndef marlin_exec_stacktrace_hpp
 #define marlin_exec_stacktrace_hpp
 
+#include <cstdint>
+#include <optional>
 #include <string_view>
 #include <type_traits>
+#include <unordered_map>
 #include <vector>
 
 #include "base.hpp"
+#include "source_map.hpp"
 
 namespace marlin::exec {
 
+// Frame of a stack trace, with views into the line it was read from
+struct stack_frame {
+  std::string_view function;
+  std::string_view url;
+  // Where the error occurred, corrected for the engine
+  source_loc loc;
+};
+
+// Reads a line of a stack trace, std::nullopt if it is not a frame
+using frame_parser = std::optional<stack_frame> (*)(std::string_view line);
+
+// function@url:line:column, as JavaScriptCore writes frames
+[[nodiscard]] std::optional<stack_frame> parse_jsc_frame(
+    std::string_view line);
+
+// "at function (url:line:column)" or "at url:line:column", as V8 writes
+// frames
+[[nodiscard]] std::optional<stack_frame> parse_v8_frame(std::string_view line);
+
+// Locations of the frames in the script at source_url, innermost first
+[[nodiscard]] std::vector<source_loc> parse_stacktrace(
+    std::string_view stacktrace, std::string_view source_url,
+    frame_parser parser = parse_jsc_frame);
+
+// Remembers the node found at each location of a script, so that errors
+// thrown again and again from the same places resolve without searching the
+// source map. Must be cleared whenever the map changes.
+struct frame_cache {
+  [[nodiscard]] ast::base* locate(const source_map& map, source_loc loc) {
+    const auto key{(static_cast<uint64_t>(loc.line) << 32) | loc.column};
+    if (const auto it{_nodes.find(key)}; it != _nodes.end()) {
+      _hits++;
+      return it->second;
+    }
+    auto* node{map.locate(loc)};
+    _nodes.emplace(key, node);
+    return node;
+  }
+
+  void clear() noexcept {
+    _nodes.clear();
+    _hits = 0;
+  }
+
+  [[nodiscard]] size_t size() const noexcept { return _nodes.size(); }
+  [[nodiscard]] size_t hits() const noexcept { return _hits; }
+
+ private:
+  std::unordered_map<uint64_t, ast::base*> _nodes;
+  size_t _hits{0};
+};
+
+// Nodes of the frames in the script generated for code, located through its
+// source map. Frames the map has no node for are reported as code itself.
 template <typename code_type, typename = std::enable_if_t<
                                   std::is_same_v<code_type, ast::base> ||
                                   std::is_same_v<code_type, const ast::base>>>
 std::vector<code_type*> parse_stacktrace(std::string_view stacktrace,
                                          std::string_view source_url,
-                                         code_type& code);
+                                         const source_map& map,
+                                         code_type& code,
+                                         frame_cache* cache = nullptr,
+                                         frame_parser parser = parse_jsc_frame);
 
 }  // namespace marlin::exec
 
-#endif  // marlin_exec_stacktrace_hpp
\ No newline at end of file
+#endif  // marlin_exec_stacktrace_hpp
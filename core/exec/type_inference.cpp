@@ -0,0 +1,588 @@
+#include "type_inference.hpp"
+
+#include <cmath>
+#include <limits>
+
+namespace marlin::exec {
+
+namespace {
+
+constexpr auto infinity{js_type::infinity};
+constexpr auto largest{std::numeric_limits<double>::max()};
+
+constexpr js_type nan{js_type::nan};
+constexpr js_type numbers{js_type{js_type::number} | nan};
+// What + turns into a string, the others through toString
+constexpr js_type concatenated{js_type{js_type::string} | js_type::array |
+                               js_type::color | js_type::object};
+constexpr js_type primitive{js_type{js_type::undefined} | js_type::boolean |
+                            numbers};
+
+[[nodiscard]] bool may_be_zero(js_type type) {
+  return type.min <= 0 && type.max >= 0;
+}
+
+[[nodiscard]] bool may_be_infinite(js_type type) {
+  return type.min == -infinity || type.max == infinity;
+}
+
+[[nodiscard]] bool may_be_finite(js_type type) {
+  return type.min < infinity && type.max > -infinity &&
+         type.min <= type.max;
+}
+
+// Numbers the value converts to
+[[nodiscard]] js_type to_number(js_type type) {
+  auto result{type & numbers};
+  if (type.may_be(js_type::undefined)) {
+    result |= nan;
+  }
+  if (type.may_be(js_type::boolean)) {
+    result |= js_type::between(0, 1);
+  }
+  if (type.may_be(concatenated)) {
+    result |= numbers;
+  }
+  return result;
+}
+
+// Numbers asNumber lets through, it throws on NaN
+[[nodiscard]] js_type checked_number(js_type type) {
+  return to_number(type) & js_type::number;
+}
+
+// An operation monotonic in each operand reaches the bounds of its results
+// at the bounds of the operands, NaN where infinities meet, and gives NaN on
+// NaN operands
+template <typename operation_type>
+[[nodiscard]] js_type on_bounds(js_type left, js_type right,
+                                operation_type&& operation) {
+  js_type result;
+  if (left.may_be(nan) || right.may_be(nan)) {
+    result |= nan;
+  }
+  if (left.may_be(js_type::number) && right.may_be(js_type::number)) {
+    for (const auto l : {left.min, left.max}) {
+      for (const auto r : {right.min, right.max}) {
+        const auto value{operation(l, r)};
+        result |= std::isnan(value) ? nan : js_type::between(value, value);
+      }
+    }
+  }
+  return result;
+}
+
+[[nodiscard]] js_type negate(js_type type) {
+  auto result{type & nan};
+  if (type.may_be(js_type::number)) {
+    result |= js_type::between(-type.max, -type.min);
+  }
+  return result;
+}
+
+[[nodiscard]] js_type add(js_type left, js_type right) {
+  return on_bounds(left, right, [](double l, double r) { return l + r; });
+}
+
+[[nodiscard]] js_type subtract(js_type left, js_type right) {
+  return add(left, negate(right));
+}
+
+[[nodiscard]] js_type multiply(js_type left, js_type right) {
+  auto result{
+      on_bounds(left, right, [](double l, double r) { return l * r; })};
+  // Zero times infinity, the zero may not be a bound
+  if ((may_be_zero(left) && may_be_infinite(right)) ||
+      (may_be_infinite(left) && may_be_zero(right))) {
+    result |= nan;
+  }
+  return result;
+}
+
+[[nodiscard]] js_type divide(js_type left, js_type right) {
+  if (!may_be_zero(right)) {
+    return on_bounds(left, right, [](double l, double r) { return l / r; });
+  }
+  // Infinities of either sign, and NaN for zero divided by zero
+  auto result{(left | right) & nan};
+  if (left.may_be(js_type::number) && right.may_be(js_type::number)) {
+    result |= js_type::number;
+    if (may_be_zero(left) ||
+        (may_be_infinite(left) && may_be_infinite(right))) {
+      result |= nan;
+    }
+  }
+  return result;
+}
+
+// Results of a function of a checked number increasing with it
+template <typename function_type>
+[[nodiscard]] js_type increasing(js_type argument, function_type&& function) {
+  return js_type::between(function(argument.min), function(argument.max));
+}
+
+// Name of a variable read, also the list of a subscript assigned to
+[[nodiscard]] const std::string* name_of(const ast::base& expression) {
+  if (expression.is<ast::identifier>()) {
+    return &expression.as<ast::identifier>().name;
+  } else if (expression.is<ast::variable_name>()) {
+    return &expression.as<ast::variable_name>().name;
+  } else {
+    return nullptr;
+  }
+}
+
+[[nodiscard]] js_type type_of(const value& constant) {
+  switch (constant.get_type()) {
+    case value::type::boolean:
+      return js_type::boolean;
+    case value::type::string:
+      return js_type::string;
+    case value::type::number:
+      return std::isnan(constant.number())
+                 ? nan
+                 : js_type::between(constant.number(), constant.number());
+    default:
+      return js_type::any();
+  }
+}
+
+}  // namespace
+
+void type_inference::infer(const ast::base& block,
+                           const std::vector<std::string>& globals,
+                           const constant_folder& constants) {
+  _types.clear();
+  _constants = &constants;
+  _globals.clear();
+  _globals.insert(globals.begin(), globals.end());
+  // Anywhere in the block, as a local named the same before the declaration
+  // is left untyped too
+  collect_globals(block);
+
+  state current;
+  if (block.is<ast::function>()) {
+    const auto& function{block.as<ast::function>()};
+    if (function.signature()->is<ast::function_signature>()) {
+      const auto& signature{
+          function.signature()->as<ast::function_signature>()};
+      for (const auto& param : signature.parameters()) {
+        if (param->is<ast::parameter>()) {
+          current.locals[param->as<ast::parameter>().name] = js_type::any();
+        }
+      }
+    }
+    visit_block(function.statements(), current);
+  } else if (block.is<ast::on_start>()) {
+    visit_block(block.as<ast::on_start>().statements(), current);
+  }
+
+  _constants = nullptr;
+  _globals.clear();
+  _loops.clear();
+}
+
+js_type type_inference::type(const ast::base& node) const {
+  const auto it{_types.find(&node)};
+  return it != _types.end() ? it->second : js_type::any();
+}
+
+js_type type_inference::state::local(std::string_view name) const {
+  const auto it{locals.find(name)};
+  return it != locals.end() ? it->second : js_type{js_type::undefined};
+}
+
+void type_inference::state::join(const state& other) {
+  if (!other.reachable) {
+    return;
+  } else if (!reachable) {
+    *this = other;
+    return;
+  }
+  for (auto& [name, type] : locals) {
+    type |= other.local(name);
+  }
+  for (const auto& [name, type] : other.locals) {
+    locals.try_emplace(name, type | js_type::undefined);
+  }
+}
+
+void type_inference::state::widen(const state& before) {
+  for (auto& [name, type] : locals) {
+    const auto previous{before.local(name)};
+    if (!previous.may_be(js_type::number)) {
+      continue;
+    }
+    if (type.min < previous.min) {
+      type.min = type.min >= -largest ? -largest : -infinity;
+    }
+    if (type.max > previous.max) {
+      type.max = type.max <= largest ? largest : infinity;
+    }
+  }
+}
+
+void type_inference::collect_globals(const ast::base& node) {
+  if (node.is<ast::use_global>()) {
+    if (const auto& variable{*node.as<ast::use_global>().variable()};
+        variable.is<ast::variable_name>()) {
+      _globals.emplace(variable.as<ast::variable_name>().name);
+    }
+  } else {
+    for (const auto& child : node.children()) {
+      collect_globals(*child);
+    }
+  }
+}
+
+template <typename vector_type>
+void type_inference::visit_block(vector_type statements, state& current) {
+  for (const auto& statement : statements) {
+    visit_statement(*statement, current);
+  }
+}
+
+void type_inference::visit_statement(const ast::base& statement,
+                                     state& current) {
+  if (statement.is<ast::eval_statement>()) {
+    static_cast<void>(visit_expression(
+        *statement.as<ast::eval_statement>().expression(), current));
+  } else if (statement.is<ast::assignment>()) {
+    const auto& assignment{statement.as<ast::assignment>()};
+    const auto& variable{*assignment.variable()};
+    if (variable.is<ast::subscript_set>()) {
+      // The list is checked before the index and the value are evaluated
+      static_cast<void>(visit_expression(variable, current));
+      static_cast<void>(visit_expression(*assignment.value(), current));
+    } else {
+      const auto type{visit_expression(*assignment.value(), current)};
+      if (variable.is<ast::variable_name>()) {
+        const auto& name{variable.as<ast::variable_name>().name};
+        if (is_local(name)) {
+          current.locals[name] = type;
+        }
+      }
+    }
+  } else if (statement.is<ast::modify_array>()) {
+    const auto& call{statement.as<ast::modify_array>()};
+    static_cast<void>(visit_expression(*call.array(), current));
+    for (const auto& arg : call.arguments()) {
+      static_cast<void>(visit_expression(*arg, current));
+    }
+    narrow(*call.array(), js_type::array, current);
+  } else if (statement.is<ast::system_procedure_call>()) {
+    for (const auto& arg :
+         statement.as<ast::system_procedure_call>().arguments()) {
+      static_cast<void>(visit_expression(*arg, current));
+    }
+  } else if (statement.is<ast::if_statement>()) {
+    const auto& if_statement{statement.as<ast::if_statement>()};
+    static_cast<void>(visit_expression(*if_statement.condition(), current));
+    auto taken{current};
+    visit_block(if_statement.statements(), taken);
+    current.join(taken);
+  } else if (statement.is<ast::if_else_statement>()) {
+    const auto& if_else{statement.as<ast::if_else_statement>()};
+    static_cast<void>(visit_expression(*if_else.condition(), current));
+    auto alternate{current};
+    visit_block(if_else.consequence(), current);
+    visit_block(if_else.alternate(), alternate);
+    current.join(alternate);
+  } else if (statement.is<ast::while_statement>()) {
+    visit_while(statement.as<ast::while_statement>(), current);
+  } else if (statement.is<ast::for_statement>()) {
+    visit_for(statement.as<ast::for_statement>(), current);
+  } else if (statement.is<ast::break_statement>()) {
+    if (!_loops.empty()) {
+      _loops.back().breaks.join(current);
+    }
+    current.reachable = false;
+  } else if (statement.is<ast::continue_statement>()) {
+    if (!_loops.empty()) {
+      _loops.back().continues.join(current);
+    }
+    current.reachable = false;
+  } else if (statement.is<ast::return_statement>()) {
+    current.reachable = false;
+  } else if (statement.is<ast::return_result_statement>()) {
+    static_cast<void>(visit_expression(
+        *statement.as<ast::return_result_statement>().result(), current));
+    current.reachable = false;
+  }
+}
+
+// The state at the head of a loop grows with each pass through the body
+// until it no longer changes, which it must as types only gain kinds and
+// bounds widen to the infinities
+void type_inference::visit_while(const ast::while_statement& statement,
+                                 state& current) {
+  auto head{current};
+  while (true) {
+    auto body{head};
+    static_cast<void>(visit_expression(*statement.condition(), body));
+    auto exit{body};
+
+    _loops.emplace_back();
+    visit_block(statement.statements(), body);
+    body.join(_loops.back().continues);
+    exit.join(_loops.back().breaks);
+    _loops.pop_back();
+
+    auto next{head};
+    next.join(body);
+    next.widen(head);
+    if (next == head) {
+      current = std::move(exit);
+      return;
+    }
+    head = std::move(next);
+  }
+}
+
+void type_inference::visit_for(const ast::for_statement& statement,
+                               state& current) {
+  static_cast<void>(visit_expression(*statement.list(), current));
+  const auto element{element_type(*statement.list())};
+  const auto* name{statement.variable()->is<ast::variable_name>()
+                       ? &statement.variable()->as<ast::variable_name>().name
+                       : nullptr};
+
+  auto head{current};
+  while (true) {
+    auto body{head};
+    if (name != nullptr && is_local(*name)) {
+      body.locals[*name] = element;
+    }
+
+    _loops.emplace_back();
+    visit_block(statement.statements(), body);
+    body.join(_loops.back().continues);
+    auto breaks{std::move(_loops.back().breaks)};
+    _loops.pop_back();
+
+    auto next{head};
+    next.join(body);
+    next.widen(head);
+    if (next == head) {
+      current = std::move(head);
+      current.join(breaks);
+      return;
+    }
+    head = std::move(next);
+  }
+}
+
+js_type type_inference::visit_expression(const ast::base& expression,
+                                         state& current) {
+  js_type result{js_type::any()};
+  if (const auto* constant{_constants->constant(expression)}) {
+    result = type_of(*constant);
+  } else if (const auto* name{name_of(expression)}) {
+    if (is_local(*name)) {
+      result = current.local(*name);
+    }
+  } else if (expression.is<ast::unary_expression>()) {
+    const auto& unary{expression.as<ast::unary_expression>()};
+    const auto argument{visit_expression(*unary.argument(), current)};
+    result = unary.op == ast::unary_op::negative ? negate(to_number(argument))
+                                                 : js_type::boolean;
+  } else if (expression.is<ast::binary_expression>()) {
+    const auto& binary{expression.as<ast::binary_expression>()};
+    const auto left{visit_expression(*binary.left(), current)};
+    js_type right;
+    if (binary.op == ast::binary_op::logical_and ||
+        binary.op == ast::binary_op::logical_or) {
+      // The right operand may not run
+      auto evaluated{current};
+      right = visit_expression(*binary.right(), evaluated);
+      current.join(evaluated);
+    } else {
+      right = visit_expression(*binary.right(), current);
+    }
+    switch (binary.op) {
+      case ast::binary_op::add:
+        result = add(to_number(left & primitive), to_number(right & primitive));
+        if (left.may_be(concatenated) || right.may_be(concatenated)) {
+          result |= js_type::string;
+        }
+        break;
+      case ast::binary_op::subtract:
+        result = subtract(to_number(left), to_number(right));
+        break;
+      case ast::binary_op::multiply:
+        result = multiply(to_number(left), to_number(right));
+        break;
+      case ast::binary_op::divide:
+        result = divide(to_number(left), to_number(right));
+        break;
+      case ast::binary_op::logical_and:
+      case ast::binary_op::logical_or:
+        // Either operand as it is
+        result = left | right;
+        break;
+      default:
+        result = js_type::boolean;
+        break;
+    }
+  } else if (expression.is<ast::subscript_get>()) {
+    visit_subscript(expression.as<ast::subscript_get>(), current);
+  } else if (expression.is<ast::subscript_set>()) {
+    visit_subscript(expression.as<ast::subscript_set>(), current);
+  } else if (expression.is<ast::new_array>()) {
+    for (const auto& element : expression.as<ast::new_array>().elements()) {
+      static_cast<void>(visit_expression(*element, current));
+    }
+    result = js_type::array;
+  } else if (expression.is<ast::new_color>()) {
+    for (const auto& arg : expression.as<ast::new_color>().arguments()) {
+      static_cast<void>(visit_expression(*arg, current));
+    }
+    result = js_type::color;
+  } else if (expression.is<ast::system_function_call>()) {
+    result = visit_system_function(
+        expression.as<ast::system_function_call>(), current);
+  } else if (expression.is<ast::user_function_call>()) {
+    for (const auto& arg :
+         expression.as<ast::user_function_call>().arguments()) {
+      static_cast<void>(visit_expression(*arg, current));
+    }
+  }
+  _types[&expression] |= result;
+  return result;
+}
+
+template <typename subscript_type>
+void type_inference::visit_subscript(const subscript_type& subscript,
+                                     state& current) {
+  static_cast<void>(visit_expression(*subscript.list(), current));
+  narrow(*subscript.list(), js_type::array, current);
+  static_cast<void>(visit_expression(*subscript.index(), current));
+}
+
+js_type type_inference::visit_system_function(
+    const ast::system_function_call& call, state& current) {
+  std::vector<js_type> arguments;
+  for (const auto& arg : call.arguments()) {
+    arguments.push_back(checked_number(visit_expression(*arg, current)));
+  }
+  const auto argument{[&arguments](size_t index) {
+    return index < arguments.size() ? arguments[index] : js_type{};
+  }};
+  const auto first{argument(0)};
+
+  switch (call.func) {
+    case ast::system_function::range1:
+    case ast::system_function::range2:
+    case ast::system_function::range3:
+      return js_type::object;
+    case ast::system_function::random:
+      // min + Math.random() * (max - min)
+      return add(argument(0), multiply(js_type::between(0, 1),
+                                       subtract(argument(1), argument(0))));
+    case ast::system_function::list_length:
+      return js_type::between(0, 4294967295.0);
+    case ast::system_function::time:
+      return js_type::between(0, largest);
+    case ast::system_function::abs:
+      if (!first.may_be(js_type::number)) {
+        return {};
+      } else if (first.min >= 0) {
+        return first;
+      } else if (first.max <= 0) {
+        return negate(first);
+      } else {
+        return js_type::between(0, std::max(-first.min, first.max));
+      }
+    case ast::system_function::round:
+      return increasing(first, [](double x) { return std::floor(x + 0.5); });
+    case ast::system_function::floor:
+      return increasing(first, [](double x) { return std::floor(x); });
+    case ast::system_function::ceil:
+      return increasing(first, [](double x) { return std::ceil(x); });
+    case ast::system_function::sqrt:
+      return (first.min < 0 ? nan : js_type{}) |
+             increasing(first & js_type::between(0, infinity),
+                        [](double x) { return std::sqrt(x); });
+    case ast::system_function::ln:
+      return (first.min < 0 ? nan : js_type{}) |
+             increasing(first & js_type::between(0, infinity),
+                        [](double x) { return std::log(x); });
+    case ast::system_function::log:
+      return (first.min < 0 ? nan : js_type{}) |
+             increasing(first & js_type::between(0, infinity),
+                        [](double x) { return std::log10(x); });
+    default:
+      break;
+  }
+
+  // Functions of angles, NaN for infinite ones
+  auto result{may_be_infinite(first) ? nan : js_type{}};
+  switch (call.func) {
+    case ast::system_function::sin:
+    case ast::system_function::cos:
+      return may_be_finite(first) ? result | js_type::between(-1, 1)
+                                    : result;
+    case ast::system_function::tan:
+      return may_be_finite(first)
+                 ? result | js_type::between(-largest, largest)
+                 : result;
+    case ast::system_function::asin:
+    case ast::system_function::acos:
+      result = first.min < -1 || first.max > 1 ? nan : js_type{};
+      if (!(first & js_type::between(-1, 1)).may_be(js_type::number)) {
+        return result;
+      }
+      return result | (call.func == ast::system_function::asin
+                           ? js_type::between(-90, 90)
+                           : js_type::between(0, 180));
+    case ast::system_function::atan:
+      return first.may_be(js_type::number) ? js_type::between(-90, 90)
+                                             : js_type{};
+    default:
+      return js_type::any();
+  }
+}
+
+js_type type_inference::element_type(const ast::base& list) const {
+  if (!list.is<ast::system_function_call>()) {
+    return js_type::any();
+  }
+  const auto& call{list.as<ast::system_function_call>()};
+  const auto arguments{call.arguments()};
+  const auto argument{[this, &arguments](size_t index) {
+    return checked_number(type(*arguments[index]));
+  }};
+  // From the beginning on by the step while before the end, so that only a
+  // beginning may be infinite. Before an infinite end, the elements run up
+  // to the largest number, or down to the smallest for negative steps
+  const auto before_end{[](js_type end) {
+    auto result{end & js_type::between(-largest, largest)};
+    if (end.max == infinity) {
+      result |= js_type::between(largest, largest);
+    }
+    if (end.min == -infinity) {
+      result |= js_type::between(-largest, -largest);
+    }
+    return result;
+  }};
+  switch (call.func) {
+    case ast::system_function::range1:
+      return js_type::between(0, 0) | before_end(argument(0));
+    case ast::system_function::range2:
+      return argument(0) | before_end(argument(1));
+    case ast::system_function::range3:
+      return argument(0) | before_end(argument(1));
+    default:
+      return js_type::any();
+  }
+}
+
+void type_inference::narrow(const ast::base& expression, js_type type,
+                            state& current) {
+  if (const auto* name{name_of(expression)}; name != nullptr &&
+                                             is_local(*name)) {
+    current.locals[*name] = current.local(*name) & type;
+  }
+}
+
+}  // namespace marlin::exec
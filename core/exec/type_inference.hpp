@@ -0,0 +1,171 @@
+#ifndef marlin_exec_type_inference_hpp
+#define marlin_exec_type_inference_hpp
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "ast.hpp"
+#include "constant_folder.hpp"
+
+namespace marlin::exec {
+
+// Kinds of values an expression of the script may evaluate to, numbers
+// within bounds, so that the NaN that the checks of exec_env.js reject can
+// be ruled out where no infinities meet
+struct js_type {
+  enum kind : uint16_t {
+    undefined = 1 << 0,
+    boolean = 1 << 1,
+    number = 1 << 2,  // Other than NaN, infinities included
+    nan = 1 << 3,
+    string = 1 << 4,
+    array = 1 << 5,
+    color = 1 << 6,
+    object = 1 << 7  // Anything else, like the ranges of for loops
+  };
+
+  static constexpr double infinity{std::numeric_limits<double>::infinity()};
+
+  uint16_t kinds{0};
+  // Bounds of the numbers, empty when it may not be one
+  double min{infinity};
+  double max{-infinity};
+
+  constexpr js_type() noexcept = default;
+  constexpr js_type(kind k) noexcept
+      : kinds{k},
+        min{k == number ? -infinity : infinity},
+        max{k == number ? infinity : -infinity} {}
+
+  [[nodiscard]] static constexpr js_type between(double min,
+                                                 double max) noexcept {
+    js_type type;
+    if (min <= max) {
+      type.kinds = number;
+      type.min = min;
+      type.max = max;
+    }
+    return type;
+  }
+
+  [[nodiscard]] static constexpr js_type any() noexcept {
+    auto type{js_type{number}};
+    type.kinds = (object << 1) - 1;
+    return type;
+  }
+
+  [[nodiscard]] constexpr bool is_within(js_type type) const noexcept {
+    return (kinds & ~type.kinds) == 0 && min >= type.min && max <= type.max;
+  }
+  [[nodiscard]] constexpr bool may_be(js_type type) const noexcept {
+    return (kinds & type.kinds) != 0;
+  }
+
+  [[nodiscard]] constexpr js_type operator|(js_type type) const noexcept {
+    type.kinds |= kinds;
+    type.min = std::min(type.min, min);
+    type.max = std::max(type.max, max);
+    return type;
+  }
+  [[nodiscard]] constexpr js_type operator&(js_type type) const noexcept {
+    type.kinds &= kinds;
+    type.min = std::max(type.min, min);
+    type.max = std::min(type.max, max);
+    if (type.min > type.max || (type.kinds & number) == 0) {
+      type.kinds &= ~number;
+      type.min = infinity;
+      type.max = -infinity;
+    }
+    return type;
+  }
+  constexpr js_type& operator|=(js_type type) noexcept {
+    return *this = *this | type;
+  }
+
+  [[nodiscard]] constexpr bool operator==(js_type type) const noexcept {
+    return kinds == type.kinds && min == type.min && max == type.max;
+  }
+  [[nodiscard]] constexpr bool operator!=(js_type type) const noexcept {
+    return !(*this == type);
+  }
+};
+
+// Types of the expressions of a block, following its locals through
+// assignments, branches and loops, and narrowing them past the checks that
+// let only arrays through. Globals may change anywhere, they are left
+// untyped, and so are parameters until assigned, as a block is generated
+// apart from its callers.
+struct type_inference {
+  // Replaces the types found for the previous block. Globals are those
+  // declared before it, the constants those folded in it.
+  void infer(const ast::base& block, const std::vector<std::string>& globals,
+             const constant_folder& constants);
+
+  // Any type for nodes not inferred
+  [[nodiscard]] js_type type(const ast::base& node) const;
+
+  void clear() noexcept { _types.clear(); }
+
+ private:
+  // Types of the locals at a point of the block, unassigned ones missing
+  struct state {
+    // Nothing flows out of a break, continue or return
+    bool reachable{true};
+    std::unordered_map<std::string_view, js_type> locals;
+
+    [[nodiscard]] js_type local(std::string_view name) const;
+    void join(const state& other);
+    // Pushes the bounds that grew since the state before to the largest
+    // finite numbers, then to the infinities, so that loops settle
+    void widen(const state& before);
+
+    [[nodiscard]] bool operator==(const state& other) const {
+      return reachable == other.reachable && locals == other.locals;
+    }
+  };
+
+  // States the breaks and continues of a loop jump from
+  struct loop_exits {
+    state breaks{false, {}};
+    state continues{false, {}};
+  };
+
+  std::unordered_map<const ast::base*, js_type> _types;
+  const constant_folder* _constants{nullptr};
+  std::unordered_set<std::string_view> _globals;
+  std::vector<loop_exits> _loops;
+
+  [[nodiscard]] bool is_local(std::string_view name) const {
+    return _globals.find(name) == _globals.end();
+  }
+
+  void collect_globals(const ast::base& node);
+
+  template <typename vector_type>
+  void visit_block(vector_type statements, state& current);
+  void visit_statement(const ast::base& statement, state& current);
+  void visit_while(const ast::while_statement& statement, state& current);
+  void visit_for(const ast::for_statement& statement, state& current);
+
+  js_type visit_expression(const ast::base& expression, state& current);
+  // The list is checked before the index is evaluated
+  template <typename subscript_type>
+  void visit_subscript(const subscript_type& subscript, state& current);
+  js_type visit_system_function(const ast::system_function_call& call,
+                                state& current);
+  // Type of what a for loop goes through the list
+  [[nodiscard]] js_type element_type(const ast::base& list) const;
+
+  // Past a check letting only the type through
+  void narrow(const ast::base& expression, js_type type, state& current);
+};
+
+}  // namespace marlin::exec
+
+#endif  // marlin_exec_type_inference_hpp
@@ -0,0 +1,452 @@
+#include "vm.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#if defined(__GNUC__)
+#define MARLIN_THREADED_DISPATCH 1
+#else
+#define MARLIN_THREADED_DISPATCH 0
+#endif
+
+namespace marlin::exec {
+
+namespace {
+
+using bytecode::instruction;
+using bytecode::opcode;
+
+// Code of a function with the handler of each instruction filled in
+struct threaded_function {
+  const bytecode::function_code* source;
+  std::vector<instruction> code;
+};
+
+struct frame {
+  const threaded_function* function;
+  // Call instruction of the function while it waits for a callee
+  const instruction* call{nullptr};
+  size_t base;
+  // Register of the caller receiving the result
+  uint32_t result;
+  size_t iterator_base;
+};
+
+struct machine {
+  machine(const vm::options& opts, const bytecode::module& module)
+      : _options{opts},
+        _module{module},
+        _environment{opts.environment},
+        _threaded(module.functions.size()),
+        _call_caches(module.call_sites.size(), nullptr),
+        _globals(module.global_count) {}
+
+  void run() {
+    if (_module.main_function) {
+      execute();
+    }
+  }
+
+  environment& env() noexcept { return _environment; }
+
+ private:
+  const vm::options& _options;
+  const bytecode::module& _module;
+  environment _environment;
+
+  const void* const* _handlers{nullptr};
+  // Threaded when first called
+  std::vector<std::unique_ptr<threaded_function>> _threaded;
+  std::vector<const threaded_function*> _call_caches;
+
+  std::vector<value> _registers;
+  std::vector<value> _globals;
+  // Grown ahead of the running frame, so that calls only fill in the next one
+  std::vector<frame> _frames;
+  frame* _frame{nullptr};
+  std::vector<std::unique_ptr<iteration>> _iterators;
+  uint64_t _steps{0};
+
+  const threaded_function& thread(uint32_t index) {
+    auto& threaded{_threaded[index]};
+    if (!threaded) {
+      const auto& source{_module.functions[index]};
+      threaded = std::make_unique<threaded_function>(
+          threaded_function{&source, source.code});
+      if (_handlers != nullptr) {
+        for (auto& inst : threaded->code) {
+          inst.handler = _handlers[static_cast<size_t>(inst.op)];
+        }
+      }
+    }
+    return *threaded;
+  }
+
+  // Registers of the frame starting at base, with the locals past the
+  // parameters cleared
+  value* enter(const threaded_function& function, size_t base) {
+    const auto end{base + function.source->register_count};
+    if (_registers.size() < end) {
+      _registers.resize(std::max(end, _registers.size() * 2));
+    }
+    auto* registers{_registers.data() + base};
+    for (auto i{function.source->parameter_count};
+         i < function.source->local_count; i++) {
+      registers[i] = value{};
+    }
+    return registers;
+  }
+
+  frame& push_frame() {
+    if (_frame == &_frames.back()) {
+      const auto depth{_frames.size()};
+      _frames.resize(depth * 2);
+      _frame = _frames.data() + depth - 1;
+    }
+    return *++_frame;
+  }
+
+  // Same stack as the interpreter: the failing node, then the calls
+  void add_stack(runtime_error& e, const instruction* ip) {
+    const auto node_of{[](const frame& f, const instruction* inst) {
+      return f.function->source->nodes[inst - f.function->code.data()];
+    }};
+    if (e.stack().empty()) {
+      e.add_frame(*node_of(*_frame, ip));
+    }
+    for (auto* caller{_frame}; caller != _frames.data();) {
+      --caller;
+      e.add_frame(*node_of(*caller, caller->call));
+    }
+  }
+
+  void execute();
+};
+
+void machine::execute() {
+#if MARLIN_THREADED_DISPATCH
+#define _HANDLER_ADDRESS_TEMPLATE(NAME) &&handle_##NAME,
+  static const void* const handlers[]{OPCODES(_HANDLER_ADDRESS_TEMPLATE)};
+#undef _HANDLER_ADDRESS_TEMPLATE
+  _handlers = handlers;
+#define HANDLER(NAME) handle_##NAME:
+#define DISPATCH() goto* ip->handler
+#else
+#define HANDLER(NAME) case opcode::NAME:
+#define DISPATCH() goto dispatch
+#endif
+#define NEXT()  \
+  do {          \
+    ++ip;       \
+    DISPATCH(); \
+  } while (false)
+#define JUMP(TARGET)      \
+  do {                    \
+    ip = code + (TARGET); \
+    DISPATCH();           \
+  } while (false)
+
+  const auto& main{thread(*_module.main_function)};
+  _registers.resize(std::max<size_t>(main.source->register_count, 256));
+  _frames.resize(64);
+  _frame = _frames.data();
+  *_frame = {&main, nullptr, 0, 0, 0};
+  const instruction* code{main.code.data()};
+  const instruction* ip{code};
+  value* r{enter(main, 0)};
+  const value* k{_module.constants.data()};
+  value result;
+
+  try {
+    DISPATCH();
+#if !MARLIN_THREADED_DISPATCH
+  dispatch:
+    switch (ip->op) {
+#endif
+
+    HANDLER(load_constant) {
+      r[ip->a] = k[ip->b];
+      NEXT();
+    }
+    HANDLER(move) {
+      r[ip->a] = r[ip->b];
+      NEXT();
+    }
+    HANDLER(get_global) {
+      r[ip->a] = _globals[ip->b];
+      NEXT();
+    }
+    HANDLER(set_global) {
+      _globals[ip->a] = r[ip->b];
+      NEXT();
+    }
+    HANDLER(throw_reference) {
+      throw runtime_error{"ReferenceError", k[ip->a].string()};
+    }
+
+    HANDLER(negate) {
+      const auto& argument{r[ip->b]};
+      if (argument.is(value::type::number)) {
+        r[ip->a] = -argument.number();
+      } else {
+        r[ip->a] = unary(ast::unary_op::negative, argument);
+      }
+      NEXT();
+    }
+    HANDLER(logical_not) {
+      r[ip->a] = !to_boolean(r[ip->b]);
+      NEXT();
+    }
+
+#define ARITHMETIC_HANDLER(NAME, OPERATOR)                                   \
+  HANDLER(NAME) {                                                            \
+    const auto& left{r[ip->b]};                                              \
+    const auto& right{r[ip->c]};                                             \
+    if (left.is(value::type::number) && right.is(value::type::number)) {     \
+      r[ip->a] = left.number() OPERATOR right.number();                      \
+    } else {                                                                 \
+      r[ip->a] = binary(ast::binary_op::NAME, left, right);                  \
+    }                                                                        \
+    NEXT();                                                                  \
+  }
+
+    ARITHMETIC_HANDLER(add, +)
+    ARITHMETIC_HANDLER(subtract, -)
+    ARITHMETIC_HANDLER(multiply, *)
+    ARITHMETIC_HANDLER(divide, /)
+    ARITHMETIC_HANDLER(less, <)
+    ARITHMETIC_HANDLER(less_equal, <=)
+    ARITHMETIC_HANDLER(greater, >)
+    ARITHMETIC_HANDLER(greater_equal, >=)
+#undef ARITHMETIC_HANDLER
+
+    HANDLER(equal) {
+      r[ip->a] = strict_equal(r[ip->b], r[ip->c]);
+      NEXT();
+    }
+    HANDLER(not_equal) {
+      r[ip->a] = !strict_equal(r[ip->b], r[ip->c]);
+      NEXT();
+    }
+
+    HANDLER(jump) { JUMP(ip->a); }
+    HANDLER(jump_if_false) {
+      if (!to_boolean(r[ip->a])) {
+        JUMP(ip->b);
+      }
+      NEXT();
+    }
+    HANDLER(jump_if_true) {
+      if (to_boolean(r[ip->a])) {
+        JUMP(ip->b);
+      }
+      NEXT();
+    }
+
+#define COMPARISON_JUMP_HANDLER(NAME, OPERATOR)                              \
+  HANDLER(jump_unless_##NAME) {                                              \
+    const auto& left{r[ip->a]};                                              \
+    const auto& right{r[ip->b]};                                             \
+    if (left.is(value::type::number) && right.is(value::type::number)        \
+            ? left.number() OPERATOR right.number()                          \
+            : to_boolean(binary(ast::binary_op::NAME, left, right))) {       \
+      NEXT();                                                                \
+    }                                                                        \
+    JUMP(ip->c);                                                             \
+  }
+
+    COMPARISON_JUMP_HANDLER(less, <)
+    COMPARISON_JUMP_HANDLER(less_equal, <=)
+    COMPARISON_JUMP_HANDLER(greater, >)
+    COMPARISON_JUMP_HANDLER(greater_equal, >=)
+#undef COMPARISON_JUMP_HANDLER
+
+    HANDLER(jump_unless_equal) {
+      if (strict_equal(r[ip->a], r[ip->b])) {
+        NEXT();
+      }
+      JUMP(ip->c);
+    }
+    HANDLER(jump_unless_not_equal) {
+      if (!strict_equal(r[ip->a], r[ip->b])) {
+        NEXT();
+      }
+      JUMP(ip->c);
+    }
+    HANDLER(loop) {
+      if (_options.max_steps != 0 && ++_steps > _options.max_steps) {
+        throw runtime_error{"RangeError", "Maximum number of steps exceeded."};
+      }
+      JUMP(ip->a);
+    }
+
+    HANDLER(check_array) {
+      static_cast<void>(as_array(r[ip->a]));
+      NEXT();
+    }
+    HANDLER(get_element) {
+      const auto& list{r[ip->b]};
+      const auto& index{r[ip->c]};
+      if (list.is(value::type::array) && index.is(value::type::number)) {
+        const auto& elements{*list.array()};
+        const auto i{index.number()};
+        if (i >= 0 && i < elements.size() && i == std::floor(i)) {
+          // The list may be in the destination register
+          value element{elements[static_cast<size_t>(i)]};
+          r[ip->a] = std::move(element);
+          NEXT();
+        }
+      }
+      r[ip->a] = get_element(list, index);
+      NEXT();
+    }
+    HANDLER(set_element) {
+      set_element(r[ip->a], r[ip->b], r[ip->c]);
+      NEXT();
+    }
+    HANDLER(new_array) {
+      const auto* first{r + ip->b};
+      r[ip->a] = std::make_shared<array>(first, first + ip->c);
+      NEXT();
+    }
+    HANDLER(new_color) {
+      r[ip->a] = _environment.make_color(static_cast<ast::color_mode>(ip->c),
+                                         r + ip->b);
+      NEXT();
+    }
+
+    HANDLER(call_procedure) {
+      _environment.call(static_cast<ast::system_procedure>(ip->b), r + ip->a);
+      NEXT();
+    }
+    HANDLER(call_function) {
+      r[ip->a] = _environment.call(static_cast<ast::system_function>(ip->c),
+                                   r + ip->b);
+      NEXT();
+    }
+    HANDLER(modify_array) {
+      _environment.modify(static_cast<ast::array_modification>(ip->b),
+                          r[ip->a], r + ip->a + 1);
+      NEXT();
+    }
+
+    HANDLER(range_init) {
+      const auto range{
+          make_range(static_cast<ast::system_function>(ip->c), r + ip->b)};
+      r[ip->a] = range.next;
+      r[ip->a + 1] = range.end;
+      r[ip->a + 2] = range.step;
+      NEXT();
+    }
+    HANDLER(range_next) {
+      const auto next{r[ip->a].number()};
+      const auto end{r[ip->a + 1].number()};
+      const auto step{r[ip->a + 2].number()};
+      if (step >= 0 ? next < end : next > end) {
+        r[ip->b] = next;
+        r[ip->a] = next + step;
+        NEXT();
+      }
+      JUMP(ip->c);
+    }
+    HANDLER(iter_begin) {
+      _iterators.push_back(std::make_unique<iteration>(r[ip->a]));
+      NEXT();
+    }
+    HANDLER(iter_next) {
+      if (_iterators.back()->next(r[ip->a])) {
+        NEXT();
+      }
+      JUMP(ip->b);
+    }
+    HANDLER(iter_end) {
+      _iterators.pop_back();
+      NEXT();
+    }
+
+    HANDLER(call) {
+      auto& cache{_call_caches[ip->c]};
+      if (cache == nullptr) {
+        cache = &thread(_module.call_sites[ip->c].function);
+      }
+      if (static_cast<size_t>(_frame - _frames.data()) >=
+          _options.max_call_depth) {
+        throw runtime_error{"RangeError", "Maximum call stack size exceeded."};
+      }
+      _frame->call = ip;
+      const auto base{_frame->base + ip->b};
+      auto& callee{push_frame()};
+      callee.function = cache;
+      callee.base = base;
+      callee.result = ip->a;
+      callee.iterator_base = _iterators.size();
+      r = enter(*cache, base);
+      code = cache->code.data();
+      ip = code;
+      DISPATCH();
+    }
+    HANDLER(ret) {
+      result = std::move(r[ip->a]);
+      goto return_result;
+    }
+    HANDLER(ret_undefined) {
+      result = value{};
+      goto return_result;
+    }
+
+#if !MARLIN_THREADED_DISPATCH
+    }
+#endif
+
+  return_result : {
+    // Loops left by returning leave their iterations behind
+    if (_iterators.size() != _frame->iterator_base) {
+      _iterators.resize(_frame->iterator_base);
+    }
+    if (_frame == _frames.data()) {
+      return;
+    }
+    const auto result_register{_frame->result};
+    --_frame;
+    code = _frame->function->code.data();
+    ip = _frame->call;
+    r = _registers.data() + _frame->base;
+    r[result_register] = std::move(result);
+    NEXT();
+  }
+  } catch (runtime_error& e) {
+    add_stack(e, ip);
+    throw;
+  }
+
+#undef HANDLER
+#undef DISPATCH
+#undef NEXT
+#undef JUMP
+}
+
+}  // namespace
+
+run_result vm::run(const bytecode::module& module) {
+  machine state{_options, module};
+
+  run_result result;
+  try {
+    state.run();
+  } catch (runtime_error& e) {
+    result.error = std::move(e);
+  }
+  result.elapsed = state.env().elapsed();
+  result.printed = std::move(state.env()).printed();
+  result.commands = std::move(state.env()).commands();
+  return result;
+}
+
+run_result vm::run(ast::program& program) {
+  return run(bytecode::compile(program));
+}
+
+}  // namespace marlin::exec
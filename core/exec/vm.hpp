@@ -0,0 +1,37 @@
+#ifndef marlin_exec_vm_hpp
+#define marlin_exec_vm_hpp
+
+#include <cstdint>
+
+#include "ast.hpp"
+#include "bytecode.hpp"
+#include "runtime.hpp"
+
+namespace marlin::exec {
+
+// Runs programs compiled to bytecode, with the same results as
+// exec::interpreter. Instructions are dispatched through the address of
+// their handler where the compiler supports it, and each call site caches
+// the code of the function it calls once it first runs.
+struct vm {
+  struct options {
+    exec::environment::options environment;
+    // Loop iterations before stopping with a RangeError, 0 for no limit
+    uint64_t max_steps{0};
+    size_t max_call_depth{1000};
+  };
+
+  explicit vm(options opts) : _options{opts} {}
+
+  [[nodiscard]] run_result run(const bytecode::module& module);
+
+  // Throws collected_generation_error like bytecode::compile
+  [[nodiscard]] run_result run(ast::program& program);
+
+ private:
+  options _options;
+};
+
+}  // namespace marlin::exec
+
+#endif  // marlin_exec_vm_hpp
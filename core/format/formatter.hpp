@@ -1,17 +1,26 @@
 #ifndef marlin_format_formatter_hpp
 #define marlin_format_formatter_hpp
 
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <ostream>
 #include <string>
+#include <string_view>
 #include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include "ast.hpp"
 #include "node.hpp"
 #include "specs.hpp"
+#include "utf8.hpp"
 
 namespace marlin::format {
 
-enum struct highlight_token_type {
+enum struct highlight_token_type : uint8_t {
   keyword,
   op,
   boolean,
@@ -20,22 +29,231 @@ enum struct highlight_token_type {
   placeholder
 };
 
+// Offsets and lengths count bytes of the source of the display, unlike the
+// columns of source locations, see utf8.hpp. They are kept in 32 bits, which
+// bounds a display to 4 GiB.
 struct highlight_token {
   highlight_token_type type;
-  size_t offset;
-  size_t length;
+  uint32_t offset;
+  uint32_t length;
 
   highlight_token(highlight_token_type _type, size_t _offset, size_t _length)
-      : type(_type), offset(_offset), length(_length) {}
+      : type(_type),
+        offset(static_cast<uint32_t>(_offset)),
+        length(static_cast<uint32_t>(_length)) {
+    assert(_offset <= UINT32_MAX && _length <= UINT32_MAX);
+  }
 };
 
+// Tokens of a display, usually those of one of its lines
+struct highlight_span {
+  highlight_span() = default;
+  highlight_span(const highlight_token* first, const highlight_token* last)
+      : _first{first}, _last{last} {}
+  highlight_span(const std::vector<highlight_token>& highlights)
+      : _first{highlights.data()},
+        _last{highlights.data() + highlights.size()} {}
+
+  [[nodiscard]] const highlight_token* begin() const noexcept {
+    return _first;
+  }
+  [[nodiscard]] const highlight_token* end() const noexcept { return _last; }
+  [[nodiscard]] size_t size() const noexcept {
+    return static_cast<size_t>(_last - _first);
+  }
+  [[nodiscard]] bool empty() const noexcept { return _first == _last; }
+
+ private:
+  const highlight_token* _first{nullptr};
+  const highlight_token* _last{nullptr};
+};
+
+// The line index is built when the display is constructed, so a display
+// should be constructed from its final source and highlights rather than
+// appended to
 struct display {
   std::string source;
   std::vector<highlight_token> highlights;
 
   display() {}
   display(std::string _source, std::vector<highlight_token> _highlights)
-      : source{std::move(_source)}, highlights{std::move(_highlights)} {}
+      : source{std::move(_source)}, highlights{std::move(_highlights)} {
+    index_lines();
+  }
+
+  // A final line break does not start another line, so that the display of
+  // a block has as many lines as the block
+  [[nodiscard]] size_t line_count() const noexcept {
+    return _lines.empty() ? 0 : _lines.size() - 1;
+  }
+  // Lines are counted from 0, and their source excludes the line break
+  [[nodiscard]] size_t line_offset(size_t line) const noexcept {
+    assert(line < line_count());
+    return _lines[line].offset;
+  }
+  [[nodiscard]] std::string_view line_source(size_t line) const noexcept {
+    assert(line < line_count());
+    return std::string_view{source}.substr(
+        _lines[line].offset, _lines[line + 1].offset - _lines[line].offset - 1);
+  }
+  // Offsets of the tokens stay relative to the start of the display
+  [[nodiscard]] highlight_span line_highlights(size_t line) const noexcept {
+    assert(line < line_count());
+    return {highlights.data() + _lines[line].first_highlight,
+            highlights.data() + _lines[line + 1].first_highlight};
+  }
+
+ private:
+  struct line_start {
+    uint32_t offset;
+    uint32_t first_highlight;
+  };
+
+  // One entry per line, followed by one for the end of the source
+  std::vector<line_start> _lines;
+
+  void index_lines() {
+    if (source.empty()) {
+      return;
+    }
+    assert(source.size() < UINT32_MAX && highlights.size() < UINT32_MAX);
+    uint32_t highlight{0};
+    const auto add_line{[&](size_t offset) {
+      while (highlight < highlights.size() &&
+             highlights[highlight].offset < offset) {
+        highlight++;
+      }
+      _lines.push_back({static_cast<uint32_t>(offset), highlight});
+    }};
+    add_line(0);
+    for (auto pos{source.find('\n')}; pos != std::string::npos;
+         pos = source.find('\n', pos + 1)) {
+      add_line(pos + 1);
+    }
+    if (source.back() != '\n') {
+      // As if the last line ended with a line break
+      add_line(source.size() + 1);
+    }
+    _lines.back().first_highlight = static_cast<uint32_t>(highlights.size());
+  }
+};
+
+// Rendered text of a block or statement, without the indent of its first
+// line and its final line break
+struct fragment {
+  uint64_t revision;
+  size_t indent;
+  std::string source;
+  // Offsets are relative to the start of the fragment
+  std::vector<highlight_token> highlights;
+  // Line breaks in the fragment, and the columns of its last line
+  size_t lines;
+  size_t last_columns;
+};
+
+// Keeps the fragments of the lines formatted before, so that a formatter
+// only renders the blocks and statements modified since, together with their
+// ancestors, and copies the rest. Entries are checked against the revision of
+// the node, so fragments of removed nodes are never used again, and are
+// dropped by retain.
+struct fragment_cache {
+  [[nodiscard]] const fragment* find(const ast::base& node,
+                                     size_t indent) const {
+    if (auto it{_fragments.find(&node)};
+        it != _fragments.end() && it->second.revision == node.revision() &&
+        it->second.indent == indent) {
+      return &it->second;
+    }
+    return nullptr;
+  }
+
+  void store(const ast::base& node, fragment value) {
+    _fragments.insert_or_assign(&node, std::move(value));
+  }
+
+  // Drops the entries of the lines no longer under the root
+  void retain(const ast::base& root) {
+    std::unordered_set<const ast::base*> lines;
+    collect_lines(root, lines);
+    for (auto it{_fragments.begin()}; it != _fragments.end();) {
+      it = lines.find(it->first) == lines.end() ? _fragments.erase(it)
+                                                : std::next(it);
+    }
+    _retained = _fragments.size();
+  }
+
+  // Whether enough entries were added since the last retain to be worth
+  // walking the program for
+  [[nodiscard]] bool needs_retain() const noexcept {
+    return _fragments.size() > 2 * _retained + 64;
+  }
+
+  void clear() noexcept {
+    _fragments.clear();
+    _hits = 0;
+    _retained = 0;
+  }
+
+  [[nodiscard]] size_t size() const noexcept { return _fragments.size(); }
+  [[nodiscard]] size_t hits() const noexcept { return _hits; }
+  void record_hit() noexcept { _hits++; }
+
+ private:
+  std::unordered_map<const ast::base*, fragment> _fragments;
+  size_t _hits{0};
+  // Entries left by the last retain
+  size_t _retained{0};
+
+  static void collect_lines(const ast::base& node,
+                            std::unordered_set<const ast::base*>& lines) {
+    if (node.inherits<ast::block>() || node.inherits<ast::statement>()) {
+      lines.emplace(&node);
+    }
+    for (const auto& child : node.children()) {
+      collect_lines(*child, lines);
+    }
+  }
+};
+
+// Moves the source ranges of a formatted node and its descendants
+inline void shift_lines(ast::base& node, ptrdiff_t offset) {
+  node.source_code_range.begin.line += offset;
+  node.source_code_range.end.line += offset;
+  if (node.is<ast::if_else_statement>()) {
+    node.as<ast::if_else_statement>().else_loc.line += offset;
+  }
+  for (auto& child : node.children()) {
+    shift_lines(*child, offset);
+  }
+}
+
+// Receives the output of a formatter in chunks of whole lines, in order.
+// Highlight offsets are relative to the text of the same call.
+struct sink {
+  explicit sink(size_t buffer_size = 16 * 1024) : _buffer_size{buffer_size} {}
+  virtual ~sink() = default;
+
+  // Text held by the formatter before it is passed on
+  [[nodiscard]] size_t buffer_size() const noexcept { return _buffer_size; }
+
+  virtual void write(std::string_view source,
+                     const std::vector<highlight_token>& highlights) = 0;
+
+ private:
+  size_t _buffer_size;
+};
+
+// Writes the plain text, for exporting
+struct stream_sink final : sink {
+  explicit stream_sink(std::ostream& stream) : _stream{&stream} {}
+
+  void write(std::string_view source,
+             const std::vector<highlight_token>&) override {
+    _stream->write(source.data(), static_cast<std::streamsize>(source.size()));
+  }
+
+ private:
+  std::ostream* _stream;
 };
 
 template <bool is_const>
@@ -43,6 +261,9 @@ struct formatter {
   template <typename base_type>
   using node_type = std::conditional_t<is_const, const base_type, base_type>;
 
+  formatter() = default;
+  explicit formatter(fragment_cache& cache) : _cache{&cache} {}
+
   template <typename input_type>
   display format(input_type&& nodes, const ast::base& target) {
     size_t paren_precedence{0};
@@ -77,17 +298,47 @@ struct formatter {
     return format(std::forward<input_type>(nodes), {start_line, 1}, indent, 0);
   }
 
+  // Same as format, passing the output to the sink as it is produced instead
+  // of holding all of it
+  template <typename input_type>
+  void format_to(sink& output, input_type&& nodes, size_t start_line = 1) {
+    _sink = &output;
+    try {
+      emit(std::forward<input_type>(nodes), {start_line, 1}, 0, 0);
+      flush();
+    } catch (...) {
+      _sink = nullptr;
+      throw;
+    }
+    _sink = nullptr;
+  }
+
  private:
   std::string _source_buffer;
   std::vector<highlight_token> _highlights;
   source_loc _current_loc;
   size_t _indent;
+  fragment_cache* _cache{nullptr};
+
+  sink* _sink{nullptr};
+  // Output already passed to the sink
+  size_t _flushed_size{0};
+  size_t _flushed_highlights{0};
 
   template <typename input_type>
   display format(input_type&& nodes, source_loc start, size_t indent,
                  size_t paren_precedence) {
+    emit(std::forward<input_type>(nodes), start, indent, paren_precedence);
+    return {std::exchange(_source_buffer, {}), std::exchange(_highlights, {})};
+  }
+
+  template <typename input_type>
+  void emit(input_type&& nodes, source_loc start, size_t indent,
+            size_t paren_precedence) {
     _source_buffer.clear();
     _highlights.clear();
+    _flushed_size = 0;
+    _flushed_highlights = 0;
     _current_loc = start;
     _indent = indent;
     if constexpr (std::is_base_of_v<ast::base, std::decay_t<input_type>>) {
@@ -103,17 +354,36 @@ struct formatter {
       assert(nodes.size() != 0);
       emit_vector(nodes, paren_precedence);
     }
+  }
 
-    return {std::exchange(_source_buffer, {}), std::exchange(_highlights, {})};
+  void flush() {
+    _sink->write(_source_buffer, _highlights);
+    _flushed_size += _source_buffer.size();
+    _flushed_highlights += _highlights.size();
+    _source_buffer.clear();
+    _highlights.clear();
   }
 
   void emit_string(std::string_view string) {
     _source_buffer.append(string);
 
     // For now, assume that "\n" will be handled only in emit_new_line
+    _current_loc.column += codepoint_count(string);
+  }
+
+  // Keywords, operators and literals other than strings are ASCII, so they
+  // take a column per byte without being counted
+  void emit_ascii(std::string_view string) {
+    assert(codepoint_count(string) == string.size());
+    _source_buffer.append(string);
     _current_loc.column += string.size();
   }
 
+  template <size_t size>
+  void emit_string(const char (&string)[size]) {
+    emit_ascii({string, size - 1});
+  }
+
   void emit_indent() {
     for (size_t i{0}; i < _indent; i++) {
       emit_string("  ");
@@ -123,6 +393,9 @@ struct formatter {
   void emit_new_line() {
     emit_string("\n");
     _current_loc = {_current_loc.line + 1, 1};
+    if (_sink != nullptr && _source_buffer.size() >= _sink->buffer_size()) {
+      flush();
+    }
   }
 
   void emit_placeholder(std::string_view name) {
@@ -134,7 +407,11 @@ struct formatter {
 
   void emit_highlight(std::string_view string, highlight_token_type type) {
     _highlights.emplace_back(type, _source_buffer.size(), string.size());
-    emit_string(std::move(string));
+    if (type == highlight_token_type::string) {
+      emit_string(std::move(string));
+    } else {
+      emit_ascii(std::move(string));
+    }
   }
 
   template <typename vector_type>
@@ -147,7 +424,7 @@ struct formatter {
   template <typename vector_type>
   void emit_arguments(vector_type&& args, std::string_view left_delim = "(",
                       std::string_view right_delim = ")") {
-    emit_string(left_delim);
+    emit_ascii(left_delim);
     bool first{true};
     for (auto& arg : args) {
       if (first) {
@@ -157,7 +434,7 @@ struct formatter {
       }
       emit_node(*arg);
     }
-    emit_string(right_delim);
+    emit_ascii(right_delim);
   }
 
   void emit_node(node_type<ast::base>& node, size_t paren_precedence = 0) {
@@ -165,7 +442,14 @@ struct formatter {
                        node.template inherits<ast::statement>()};
     if (is_line) {
       emit_indent();
+      if (_cache != nullptr && emit_cached(node)) {
+        emit_new_line();
+        return;
+      }
     }
+    const auto start{_current_loc};
+    const auto source_begin{_flushed_size + _source_buffer.size()};
+    const auto highlight_begin{_flushed_highlights + _highlights.size()};
     if constexpr (!is_const) {
       node.source_code_range.begin = _current_loc;
     }
@@ -176,10 +460,75 @@ struct formatter {
       node.source_code_range.end = _current_loc;
     }
     if (is_line) {
+      if (_cache != nullptr) {
+        store_fragment(node, start, source_begin, highlight_begin);
+      }
       emit_new_line();
     }
   }
 
+  bool emit_cached(node_type<ast::base>& node) {
+    const auto* cached{_cache->find(node, _indent)};
+    if (cached == nullptr) {
+      return false;
+    }
+
+    source_loc end{_current_loc.line + cached->lines, cached->last_columns};
+    if (cached->lines == 0) {
+      end.column += _current_loc.column;
+    } else {
+      end.column++;
+    }
+    if constexpr (!is_const) {
+      // The ranges inside are reused, they stay valid apart from line shifts
+      // made by the document when lines are inserted or removed before them
+      const auto& range{node.source_code_range};
+      if (range.begin.column != _current_loc.column ||
+          range.end.column != end.column ||
+          range.end.line - range.begin.line != cached->lines) {
+        return false;
+      }
+      if (range.begin.line != _current_loc.line) {
+        shift_lines(node, static_cast<ptrdiff_t>(_current_loc.line) -
+                              static_cast<ptrdiff_t>(range.begin.line));
+      }
+    }
+
+    const auto offset{_source_buffer.size()};
+    _source_buffer.append(cached->source);
+    for (const auto& token : cached->highlights) {
+      _highlights.emplace_back(token.type, token.offset + offset,
+                               token.length);
+    }
+    _current_loc = end;
+    _cache->record_hit();
+    return true;
+  }
+
+  void store_fragment(const ast::base& node, source_loc start,
+                      size_t source_begin, size_t highlight_begin) {
+    if (source_begin < _flushed_size) {
+      // Part of the fragment has already been passed to the sink
+      return;
+    }
+    source_begin -= _flushed_size;
+    highlight_begin -= _flushed_highlights;
+
+    std::vector<highlight_token> highlights;
+    highlights.reserve(_highlights.size() - highlight_begin);
+    for (auto i{highlight_begin}; i < _highlights.size(); i++) {
+      highlights.emplace_back(_highlights[i].type,
+                              _highlights[i].offset - source_begin,
+                              _highlights[i].length);
+    }
+    const auto lines{_current_loc.line - start.line};
+    const auto last_columns{lines == 0 ? _current_loc.column - start.column
+                                       : _current_loc.column - 1};
+    _cache->store(node, {node.revision(), _indent,
+                         _source_buffer.substr(source_begin),
+                         std::move(highlights), lines, last_columns});
+  }
+
   void emit_ast(node_type<ast::program>& program, size_t) {
     emit_vector(program.blocks());
   }
@@ -244,7 +593,7 @@ struct formatter {
   }
 
   void emit_ast(node_type<ast::modify_array>& call, size_t) {
-    emit_string(display_for(call.mod));
+    emit_ascii(display_for(call.mod));
     emit_string("(");
     emit_node(*call.array());
     for (auto& arg : call.arguments()) {
@@ -255,7 +604,7 @@ struct formatter {
   }
 
   void emit_ast(node_type<ast::system_procedure_call>& call, size_t) {
-    emit_string(display_for(call.proc));
+    emit_ascii(display_for(call.proc));
     emit_arguments(call.arguments());
     emit_string(";");
   }
@@ -419,12 +768,12 @@ struct formatter {
   }
 
   void emit_ast(node_type<ast::new_color>& init, size_t) {
-    emit_string(display_for(init.mode));
+    emit_ascii(display_for(init.mode));
     emit_arguments(init.arguments());
   }
 
   void emit_ast(node_type<ast::system_function_call>& call, size_t) {
-    emit_string(display_for(call.func));
+    emit_ascii(display_for(call.func));
     emit_arguments(call.arguments());
   }
 
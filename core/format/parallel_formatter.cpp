@@ -0,0 +1,84 @@
+#include "parallel_formatter.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace marlin::format {
+
+namespace {
+
+// Calls work with every index up to count, spread over the threads
+template <typename callable_type>
+void for_each_index(size_t count, size_t thread_count, callable_type work) {
+  std::atomic<size_t> next{0};
+  const auto run{[&]() {
+    for (auto i{next++}; i < count; i = next++) {
+      work(i);
+    }
+  }};
+
+  std::vector<std::thread> threads;
+  threads.reserve(thread_count - 1);
+  for (size_t i{1}; i < thread_count; i++) {
+    threads.emplace_back(run);
+  }
+  run();
+  for (auto& thread : threads) {
+    thread.join();
+  }
+}
+
+}  // namespace
+
+display format_in_parallel(ast::program& program, size_t thread_count) {
+  auto blocks{program.blocks()};
+  if (thread_count == 0) {
+    thread_count = std::max(std::thread::hardware_concurrency(), 1u);
+  }
+  thread_count = std::min(thread_count, blocks.size());
+  if (thread_count <= 1) {
+    return in_place_formatter{}.format(program);
+  }
+
+  std::vector<display> displays(blocks.size());
+  for_each_index(blocks.size(), thread_count, [&](size_t i) {
+    displays[i] = in_place_formatter{}.format(*blocks[i]);
+  });
+
+  // Every block ends with a line break, so a block starts on the line after
+  // the end of the previous one
+  std::vector<size_t> line_offsets(blocks.size());
+  size_t lines{0};
+  size_t source_size{0};
+  size_t highlight_count{0};
+  for (size_t i{0}; i < blocks.size(); i++) {
+    line_offsets[i] = lines;
+    lines += blocks[i]->source_code_range.end.line;
+    source_size += displays[i].source.size();
+    highlight_count += displays[i].highlights.size();
+  }
+  for_each_index(blocks.size(), thread_count, [&](size_t i) {
+    if (line_offsets[i] > 0) {
+      shift_lines(*blocks[i], static_cast<ptrdiff_t>(line_offsets[i]));
+    }
+  });
+  program.source_code_range = {{1, 1}, {lines + 1, 1}};
+
+  std::string source;
+  std::vector<highlight_token> highlights;
+  source.reserve(source_size);
+  highlights.reserve(highlight_count);
+  for (auto& block_display : displays) {
+    const auto offset{source.size()};
+    source.append(block_display.source);
+    for (const auto& token : block_display.highlights) {
+      highlights.emplace_back(token.type, token.offset + offset, token.length);
+    }
+    block_display = {};
+  }
+  return {std::move(source), std::move(highlights)};
+}
+
+}  // namespace marlin::format
@@ -0,0 +1,18 @@
+#ifndef marlin_format_parallel_formatter_hpp
+#define marlin_format_parallel_formatter_hpp
+
+#include "ast.hpp"
+#include "formatter.hpp"
+
+namespace marlin::format {
+
+// Formats the blocks of a program on several threads, each from line 1, then
+// moves them to their actual lines. The result and the source ranges are the
+// same as formatting the program with an in_place_formatter. A thread_count
+// of 0 uses one thread per core.
+[[nodiscard]] display format_in_parallel(ast::program& program,
+                                         size_t thread_count = 0);
+
+}  // namespace marlin::format
+
+#endif  // marlin_format_parallel_formatter_hpp
@@ -0,0 +1,207 @@
+#include "text_diff.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <optional>
+#include <string_view>
+
+#include "utf8.hpp"
+
+namespace marlin::format {
+
+namespace {
+
+// A run of changed codepoints, [original_begin, original_end) in the
+// original text becoming [updated_begin, updated_end) in the updated one
+struct hunk {
+  size_t original_begin;
+  size_t original_end;
+  size_t updated_begin;
+  size_t updated_end;
+};
+
+// The codepoints of a display with their highlight type, 0 for plain text
+struct sequence {
+  std::string_view text;
+  // Offset of each codepoint, then the size of the text
+  std::vector<size_t> starts;
+  std::vector<uint8_t> styles;
+
+  explicit sequence(const display& d) : text{d.source} {
+    std::vector<uint8_t> byte_styles(text.size(), 0);
+    for (const auto& token : d.highlights) {
+      const auto style{
+          static_cast<uint8_t>(static_cast<uint8_t>(token.type) + 1)};
+      std::fill_n(byte_styles.begin() + token.offset, token.length, style);
+    }
+    starts.reserve(text.size() + 1);
+    styles.reserve(text.size());
+    for (size_t i{0}; i < text.size(); i++) {
+      if (!is_continuation_byte(text[i])) {
+        starts.push_back(i);
+        styles.push_back(byte_styles[i]);
+      }
+    }
+    starts.push_back(text.size());
+  }
+
+  [[nodiscard]] size_t size() const noexcept { return styles.size(); }
+  [[nodiscard]] std::string_view operator[](size_t i) const noexcept {
+    return text.substr(starts[i], starts[i + 1] - starts[i]);
+  }
+};
+
+[[nodiscard]] bool same(const sequence& a, size_t i, const sequence& b,
+                        size_t j) noexcept {
+  return a.styles[i] == b.styles[j] && a[i] == b[j];
+}
+
+// Myers' shortest edit script between a[begin, a_end) and b[begin, b_end),
+// or nothing if it takes more than max_edits insertions and deletions
+[[nodiscard]] std::optional<std::vector<hunk>> shortest_edit(
+    const sequence& a, size_t a_end, const sequence& b, size_t b_end,
+    size_t begin, size_t max_edits) {
+  const auto n{static_cast<ptrdiff_t>(a_end - begin)};
+  const auto m{static_cast<ptrdiff_t>(b_end - begin)};
+  const auto max{std::min(static_cast<ptrdiff_t>(max_edits), n + m)};
+  const auto index{[max](ptrdiff_t k) { return k + max + 1; }};
+  const auto equal{[&](ptrdiff_t x, ptrdiff_t y) {
+    return same(a, begin + x, b, begin + y);
+  }};
+
+  // Furthest x reached on each diagonal k = x - y, kept for every number of
+  // edits to walk back the path
+  std::vector<ptrdiff_t> v(2 * max + 3, 0);
+  std::vector<std::vector<ptrdiff_t>> trace;
+  const auto goes_down{[](const std::vector<ptrdiff_t>& v, ptrdiff_t d,
+                          ptrdiff_t k, auto index) {
+    return k == -d || (k != d && v[index(k - 1)] < v[index(k + 1)]);
+  }};
+
+  std::optional<ptrdiff_t> edits;
+  for (ptrdiff_t d{0}; d <= max && !edits; d++) {
+    trace.push_back(v);
+    for (auto k{-d}; k <= d; k += 2) {
+      auto x{goes_down(v, d, k, index) ? v[index(k + 1)]
+                                       : v[index(k - 1)] + 1};
+      auto y{x - k};
+      while (x < n && y < m && equal(x, y)) {
+        x++;
+        y++;
+      }
+      v[index(k)] = x;
+      if (x >= n && y >= m) {
+        edits = d;
+        break;
+      }
+    }
+  }
+  if (!edits) {
+    return std::nullopt;
+  }
+
+  // Walk back from the end, one insertion or deletion per step
+  std::vector<hunk> hunks;
+  auto x{n};
+  auto y{m};
+  for (auto d{*edits}; d > 0; d--) {
+    const auto& previous{trace[d]};
+    const auto k{x - y};
+    const auto down{goes_down(previous, d, k, index)};
+    const auto previous_k{down ? k + 1 : k - 1};
+    const auto previous_x{previous[index(previous_k)]};
+    const auto previous_y{previous_x - previous_k};
+
+    const auto original{begin + static_cast<size_t>(previous_x)};
+    const auto updated{begin + static_cast<size_t>(previous_y)};
+    const hunk edit{original, down ? original : original + 1, updated,
+                    down ? updated + 1 : updated};
+    if (!hunks.empty() && hunks.back().original_begin == edit.original_end &&
+        hunks.back().updated_begin == edit.updated_end) {
+      hunks.back().original_begin = edit.original_begin;
+      hunks.back().updated_begin = edit.updated_begin;
+    } else {
+      hunks.push_back(edit);
+    }
+    x = previous_x;
+    y = previous_y;
+  }
+  std::reverse(hunks.begin(), hunks.end());
+  return hunks;
+}
+
+[[nodiscard]] display slice(const display& d, size_t begin, size_t end) {
+  std::vector<highlight_token> highlights;
+  for (const auto& token : d.highlights) {
+    const size_t token_end{token.offset + token.length};
+    if (token_end > begin && token.offset < end) {
+      const auto first{std::max<size_t>(token.offset, begin)};
+      highlights.emplace_back(token.type, first - begin,
+                              std::min(token_end, end) - first);
+    }
+  }
+  return {d.source.substr(begin, end - begin), std::move(highlights)};
+}
+
+}  // namespace
+
+std::vector<text_edit> diff(const display& original, const display& updated,
+                            size_t max_edits) {
+  const sequence a{original};
+  const sequence b{updated};
+
+  size_t prefix{0};
+  while (prefix < a.size() && prefix < b.size() && same(a, prefix, b, prefix)) {
+    prefix++;
+  }
+  if (prefix == a.size() && prefix == b.size()) {
+    return {};
+  }
+  size_t suffix{0};
+  while (suffix < a.size() - prefix && suffix < b.size() - prefix &&
+         same(a, a.size() - suffix - 1, b, b.size() - suffix - 1)) {
+    suffix++;
+  }
+  const auto a_end{a.size() - suffix};
+  const auto b_end{b.size() - suffix};
+
+  auto hunks{shortest_edit(a, a_end, b, b_end, prefix, max_edits)};
+  if (!hunks) {
+    hunks = std::vector<hunk>{{prefix, a_end, prefix, b_end}};
+  }
+
+  // Extend insertions over an unchanged neighbour, merging hunks that meet
+  std::vector<hunk> merged;
+  for (auto current : *hunks) {
+    if (current.original_begin == current.original_end && a.size() > 0) {
+      if (current.original_begin > 0) {
+        current.original_begin--;
+        current.updated_begin--;
+      } else {
+        current.original_end++;
+        current.updated_end++;
+      }
+    }
+    if (!merged.empty() &&
+        merged.back().original_end >= current.original_begin) {
+      merged.back().original_end =
+          std::max(merged.back().original_end, current.original_end);
+      merged.back().updated_end =
+          std::max(merged.back().updated_end, current.updated_end);
+    } else {
+      merged.push_back(current);
+    }
+  }
+
+  std::vector<text_edit> edits;
+  edits.reserve(merged.size());
+  for (const auto& h : merged) {
+    const auto offset{a.starts[h.original_begin]};
+    edits.push_back(
+        {offset, a.starts[h.original_end] - offset,
+         slice(updated, b.starts[h.updated_begin], b.starts[h.updated_end])});
+  }
+  return edits;
+}
+
+}  // namespace marlin::format
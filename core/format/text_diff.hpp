@@ -0,0 +1,33 @@
+#ifndef marlin_format_text_diff_hpp
+#define marlin_format_text_diff_hpp
+
+#include <cstddef>
+#include <vector>
+
+#include "formatter.hpp"
+
+namespace marlin::format {
+
+// Replaces length bytes at offset in the original text with the replacement,
+// whose highlights are relative to the start of the edit. Edits never split
+// a codepoint.
+struct text_edit {
+  size_t offset;
+  size_t length;
+  display replacement;
+};
+
+// Smallest set of edits turning the original display into the updated one,
+// compared by codepoint, where a codepoint only counts as unchanged if its
+// highlight is unchanged too. Edits are in the order of their offsets and
+// never overlap. Each replaces at least one codepoint of a non-empty
+// original, so an insertion takes the codepoint before it along, or the one
+// after it at the start of the text. When the displays differ in more than
+// max_edits codepoints, one edit spans all the changes.
+[[nodiscard]] std::vector<text_edit> diff(const display& original,
+                                          const display& updated,
+                                          size_t max_edits = 64);
+
+}  // namespace marlin::format
+
+#endif  // marlin_format_text_diff_hpp
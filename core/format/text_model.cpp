@@ -0,0 +1,243 @@
+#include "text_model.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+#include "utf8.hpp"
+
+namespace marlin::format {
+
+namespace {
+
+// Longer text is inserted as several pieces to keep lookups inside a piece
+// short
+constexpr size_t max_piece_size{1024};
+
+}  // namespace
+
+struct text_model::piece {
+  std::string text;
+  size_t text_lines;
+  uint64_t priority;
+
+  piece_ptr left;
+  piece_ptr right;
+  size_t size;
+  size_t lines;
+
+  piece(std::string _text, uint64_t _priority)
+      : text{std::move(_text)},
+        text_lines{static_cast<size_t>(
+            std::count(text.begin(), text.end(), '\n'))},
+        priority{_priority},
+        size{text.size()},
+        lines{text_lines} {}
+
+  void update() noexcept {
+    size = size_of(left.get()) + text.size() + size_of(right.get());
+    lines = lines_of(left.get()) + text_lines + lines_of(right.get());
+  }
+};
+
+void text_model::piece_deleter::operator()(piece* p) const noexcept {
+  delete p;
+}
+
+size_t text_model::size_of(const piece* p) noexcept {
+  return p == nullptr ? 0 : p->size;
+}
+
+size_t text_model::lines_of(const piece* p) noexcept {
+  return p == nullptr ? 0 : p->lines;
+}
+
+text_model::piece_ptr text_model::make_piece(std::string text) {
+  // xorshift64, priorities only need to be spread out
+  _seed ^= _seed << 13;
+  _seed ^= _seed >> 7;
+  _seed ^= _seed << 17;
+  return piece_ptr{new piece{std::move(text), _seed}};
+}
+
+text_model::piece_ptr text_model::merge(piece_ptr left, piece_ptr right) {
+  if (left == nullptr) {
+    return right;
+  }
+  if (right == nullptr) {
+    return left;
+  }
+  if (left->priority > right->priority) {
+    left->right = merge(std::move(left->right), std::move(right));
+    left->update();
+    return left;
+  } else {
+    right->left = merge(std::move(left), std::move(right->left));
+    right->update();
+    return right;
+  }
+}
+
+std::pair<text_model::piece_ptr, text_model::piece_ptr> text_model::split(
+    piece_ptr node, size_t offset) {
+  if (node == nullptr) {
+    return {nullptr, nullptr};
+  }
+  const auto left_size{size_of(node->left.get())};
+  if (offset <= left_size) {
+    auto [left, right]{split(std::move(node->left), offset)};
+    node->left = std::move(right);
+    node->update();
+    return {std::move(left), std::move(node)};
+  }
+  const auto text_end{left_size + node->text.size()};
+  if (offset >= text_end) {
+    auto [left, right]{split(std::move(node->right), offset - text_end)};
+    node->right = std::move(left);
+    node->update();
+    return {std::move(node), std::move(right)};
+  }
+
+  // The offset falls inside the text of the piece
+  const auto local{offset - left_size};
+  auto tail{make_piece(node->text.substr(local))};
+  node->text.resize(local);
+  node->text_lines = static_cast<size_t>(
+      std::count(node->text.begin(), node->text.end(), '\n'));
+  auto right{std::move(node->right)};
+  node->update();
+  return {std::move(node), merge(std::move(tail), std::move(right))};
+}
+
+size_t text_model::offset_after_lines(size_t lines) const {
+  assert(lines <= lines_of(_root.get()));
+  size_t offset{0};
+  const auto* node{_root.get()};
+  while (lines > 0) {
+    const auto left_lines{lines_of(node->left.get())};
+    if (lines <= left_lines) {
+      node = node->left.get();
+      continue;
+    }
+    lines -= left_lines;
+    offset += size_of(node->left.get());
+    if (lines <= node->text_lines) {
+      size_t index{0};
+      for (; lines > 0; index++) {
+        if (node->text[index] == '\n') {
+          lines--;
+        }
+      }
+      return offset + index;
+    }
+    lines -= node->text_lines;
+    offset += node->text.size();
+    node = node->right.get();
+  }
+  return offset;
+}
+
+size_t text_model::offset_of(source_loc loc) const {
+  assert(loc.line >= 1 && loc.line <= line_count());
+  assert(loc.column >= 1);
+  const auto begin{offset_after_lines(loc.line - 1)};
+  if (loc.column == 1) {
+    return begin;
+  }
+  // A codepoint takes at most 4 bytes
+  const auto length{std::min(size() - begin, (loc.column - 1) * 4)};
+  const auto text{substr(begin, length)};
+  return begin + codepoint_offset(text, loc.column - 1);
+}
+
+source_loc text_model::loc_of(size_t offset) const {
+  assert(offset <= size());
+  size_t lines{0};
+  size_t base{0};
+  const auto* node{_root.get()};
+  while (node != nullptr) {
+    const auto left_size{size_of(node->left.get())};
+    if (offset < base + left_size) {
+      node = node->left.get();
+      continue;
+    }
+    lines += lines_of(node->left.get());
+    base += left_size;
+    const auto local{offset - base};
+    if (local <= node->text.size()) {
+      lines += static_cast<size_t>(std::count(
+          node->text.begin(), node->text.begin() + local, '\n'));
+      break;
+    }
+    lines += node->text_lines;
+    base += node->text.size();
+    node = node->right.get();
+  }
+  const auto begin{offset_after_lines(lines)};
+  return {lines + 1, codepoint_count(substr(begin, offset - begin)) + 1};
+}
+
+std::string text_model::substr(size_t offset, size_t length) const {
+  std::string result;
+  result.reserve(length);
+
+  // In-order walk limited to the pieces overlapping the range
+  const auto end{offset + length};
+  const auto append{[&](const auto& self, const piece* node,
+                        size_t base) -> void {
+    if (node == nullptr || base >= end || base + node->size <= offset) {
+      return;
+    }
+    const auto left_size{size_of(node->left.get())};
+    self(self, node->left.get(), base);
+    const auto text_base{base + left_size};
+    const auto begin{std::max(offset, text_base)};
+    const auto stop{std::min(end, text_base + node->text.size())};
+    if (begin < stop) {
+      result.append(node->text, begin - text_base, stop - begin);
+    }
+    self(self, node->right.get(), text_base + node->text.size());
+  }};
+  append(append, _root.get(), 0);
+  return result;
+}
+
+std::string text_model::line(size_t line) const {
+  assert(line >= 1 && line <= line_count());
+  const auto begin{offset_after_lines(line - 1)};
+  const auto end{line < line_count() ? offset_after_lines(line) - 1 : size()};
+  return substr(begin, end - begin);
+}
+
+void text_model::replace(source_range range, std::string_view text) {
+  const auto begin{offset_of(range.begin)};
+  const auto end{offset_of(range.end)};
+  assert(begin <= end);
+  replace(begin, end - begin, text);
+}
+
+void text_model::replace(size_t offset, size_t length, std::string_view text) {
+  assert(offset + length <= size());
+  auto [left, rest]{split(std::move(_root), offset)};
+  auto [removed, right]{split(std::move(rest), length)};
+  removed.reset();
+
+  for (size_t i{0}; i < text.size(); i += max_piece_size) {
+    left = merge(std::move(left),
+                 make_piece(std::string{text.substr(i, max_piece_size)}));
+  }
+  _root = merge(std::move(left), std::move(right));
+}
+
+void text_model::apply(source_range range, const display& display) {
+  if (range.begin == range.end) {
+    const source_loc loc{std::min(range.begin.line, line_count()), 1};
+    replace({loc, loc}, display.source);
+  } else if (range.begin.line == range.end.line) {
+    replace(range, display.source);
+  } else {
+    assert(display.source.empty());
+    replace({{range.begin.line, 1}, {range.end.line, 1}}, display.source);
+  }
+}
+
+}  // namespace marlin::format
@@ -0,0 +1,80 @@
+#ifndef marlin_format_text_model_hpp
+#define marlin_format_text_model_hpp
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "formatter.hpp"
+#include "utils.hpp"
+
+namespace marlin::format {
+
+// The rendered text of a document, kept as a rope of pieces in a balanced
+// tree that also counts the line breaks, so that locating a line or column
+// and replacing a range take logarithmic time in the size of the document.
+// Columns count codepoints like the source ranges of the nodes, while
+// offsets count bytes of the UTF-8 text.
+struct text_model {
+  text_model() = default;
+  explicit text_model(std::string_view text) { insert(0, text); }
+
+  text_model(text_model&&) noexcept = default;
+  text_model& operator=(text_model&&) noexcept = default;
+
+  [[nodiscard]] size_t size() const noexcept { return size_of(_root.get()); }
+  // Text after the last line break counts as a line, even when empty
+  [[nodiscard]] size_t line_count() const noexcept {
+    return lines_of(_root.get()) + 1;
+  }
+
+  [[nodiscard]] size_t offset_of(source_loc loc) const;
+  [[nodiscard]] source_loc loc_of(size_t offset) const;
+
+  // Content of the line without its line break
+  [[nodiscard]] std::string line(size_t line) const;
+  [[nodiscard]] std::string substr(size_t offset, size_t length) const;
+  [[nodiscard]] std::string str() const { return substr(0, size()); }
+
+  void replace(source_range range, std::string_view text);
+  void replace(size_t offset, size_t length, std::string_view text);
+  void insert(size_t offset, std::string_view text) {
+    replace(offset, 0, text);
+  }
+  void erase(size_t offset, size_t length) { replace(offset, length, {}); }
+
+  // Applies the range and display of a control::source_update the way the
+  // views do: an empty range inserts whole lines before its line, a range
+  // on one line replaces an expression, and other ranges remove the lines
+  // from the first line up to the last one
+  void apply(source_range range, const display& display);
+
+ private:
+  struct piece;
+
+  struct piece_deleter {
+    void operator()(piece* p) const noexcept;
+  };
+
+  using piece_ptr = std::unique_ptr<piece, piece_deleter>;
+
+  piece_ptr _root;
+  uint64_t _seed{0x2545f4914f6cdd1d};
+
+  [[nodiscard]] static size_t size_of(const piece* p) noexcept;
+  [[nodiscard]] static size_t lines_of(const piece* p) noexcept;
+
+  [[nodiscard]] piece_ptr make_piece(std::string text);
+  [[nodiscard]] static piece_ptr merge(piece_ptr left, piece_ptr right);
+  [[nodiscard]] std::pair<piece_ptr, piece_ptr> split(piece_ptr node,
+                                                      size_t offset);
+
+  // Offset just after the given number of line breaks
+  [[nodiscard]] size_t offset_after_lines(size_t lines) const;
+};
+
+}  // namespace marlin::format
+
+#endif  // marlin_format_text_model_hpp
@@ -0,0 +1,81 @@
+#ifndef marlin_format_utf8_hpp
+#define marlin_format_utf8_hpp
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+namespace marlin::format {
+
+// Columns of source locations count codepoints, so that a name or string in
+// any script takes one column per character in the views, while offsets
+// into a display, including those of its highlights, count bytes of its
+// UTF-8 source. These functions map between the two along a line.
+
+[[nodiscard]] inline bool is_continuation_byte(char c) noexcept {
+  return (static_cast<unsigned char>(c) & 0xc0) == 0x80;
+}
+
+// Continuation bytes among eight packed in a word
+[[nodiscard]] inline size_t continuation_count(uint64_t word) noexcept {
+  constexpr uint64_t high_bits{0x8080808080808080};
+  constexpr uint64_t low_bits{0x0101010101010101};
+
+  if ((word & high_bits) == 0) {
+    return 0;
+  }
+  // Continuation bytes are 10xxxxxx: the high bit set and the next clear
+  const auto marks{(word & ~(word << 1) & high_bits) >> 7};
+  // Sums the marks of the eight bytes into the top byte
+  return static_cast<size_t>((marks * low_bits) >> 56);
+}
+
+// Counts the bytes that start a codepoint, eight at a time, the last ones
+// padded with zeros. Text made only of ASCII, like most names, takes a
+// single test per eight bytes.
+[[nodiscard]] inline size_t codepoint_count(std::string_view text) noexcept {
+  size_t continuations{0};
+  size_t i{0};
+  for (; i + sizeof(uint64_t) <= text.size(); i += sizeof(uint64_t)) {
+    uint64_t word;
+    std::memcpy(&word, text.data() + i, sizeof(word));
+    continuations += continuation_count(word);
+  }
+  if (i < text.size()) {
+    uint64_t word{0};
+    std::memcpy(&word, text.data() + i, text.size() - i);
+    continuations += continuation_count(word);
+  }
+  return text.size() - continuations;
+}
+
+// Offset of the byte after the first count codepoints of the text, or its
+// size if it has fewer
+[[nodiscard]] inline size_t codepoint_offset(std::string_view text,
+                                             size_t count) noexcept {
+  size_t offset{0};
+  for (; offset < text.size(); offset++) {
+    if (!is_continuation_byte(text[offset])) {
+      if (count == 0) {
+        break;
+      }
+      count--;
+    }
+  }
+  return offset;
+}
+
+// UTF-16 code units of the text, which index the strings of the views:
+// codepoints past the basic plane, led by 11110xxx, take two
+[[nodiscard]] inline size_t utf16_length(std::string_view text) noexcept {
+  size_t supplementary{0};
+  for (const auto c : text) {
+    supplementary += static_cast<unsigned char>(c) >= 0xf0 ? 1 : 0;
+  }
+  return codepoint_count(text) + supplementary;
+}
+
+}  // namespace marlin::format
+
+#endif  // marlin_format_utf8_hpp
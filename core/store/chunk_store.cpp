@@ -0,0 +1,342 @@
+#include "chunk_store.hpp"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <limits>
+#include <vector>
+
+#include "store.hpp"
+#include "store_errors.hpp"
+
+namespace marlin::store {
+
+namespace {
+
+constexpr std::string_view manifest_header{"marlin-chunks 2"};
+
+// SHA-256, so that distinct chunks never share an id and a chunk already in
+// the directory can be taken as the one being saved
+struct sha256 {
+  static constexpr std::array<uint32_t, 64> rounds{
+      0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1,
+      0x923f82a4, 0xab1c5ed5, 0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+      0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174, 0xe49b69c1, 0xefbe4786,
+      0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+      0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147,
+      0x06ca6351, 0x14292967, 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+      0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85, 0xa2bfe8a1, 0xa81a664b,
+      0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+      0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a,
+      0x5b9cca4f, 0x682e6ff3, 0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+      0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+
+  std::array<uint32_t, 8> state{0x6a09e667, 0xbb67ae85, 0x3c6ef372,
+                                0xa54ff53a, 0x510e527f, 0x9b05688c,
+                                0x1f83d9ab, 0x5be0cd19};
+
+  [[nodiscard]] static constexpr uint32_t rotate(uint32_t value,
+                                                 int count) noexcept {
+    return (value >> count) | (value << (32 - count));
+  }
+
+  void add_block(const uint8_t* block) noexcept {
+    std::array<uint32_t, 64> words;
+    for (size_t i{0}; i < 16; i++) {
+      words[i] = static_cast<uint32_t>(block[i * 4]) << 24 |
+                 static_cast<uint32_t>(block[i * 4 + 1]) << 16 |
+                 static_cast<uint32_t>(block[i * 4 + 2]) << 8 |
+                 static_cast<uint32_t>(block[i * 4 + 3]);
+    }
+    for (size_t i{16}; i < 64; i++) {
+      const auto s0{rotate(words[i - 15], 7) ^ rotate(words[i - 15], 18) ^
+                    (words[i - 15] >> 3)};
+      const auto s1{rotate(words[i - 2], 17) ^ rotate(words[i - 2], 19) ^
+                    (words[i - 2] >> 10)};
+      words[i] = words[i - 16] + s0 + words[i - 7] + s1;
+    }
+
+    auto [a, b, c, d, e, f, g, h]{state};
+    for (size_t i{0}; i < 64; i++) {
+      const auto t1{h + (rotate(e, 6) ^ rotate(e, 11) ^ rotate(e, 25)) +
+                    ((e & f) ^ (~e & g)) + rounds[i] + words[i]};
+      const auto t2{(rotate(a, 2) ^ rotate(a, 13) ^ rotate(a, 22)) +
+                    ((a & b) ^ (a & c) ^ (b & c))};
+      h = g;
+      g = f;
+      f = e;
+      e = d + t1;
+      d = c;
+      c = b;
+      b = a;
+      a = t1 + t2;
+    }
+    const std::array<uint32_t, 8> added{a, b, c, d, e, f, g, h};
+    for (size_t i{0}; i < 8; i++) {
+      state[i] += added[i];
+    }
+  }
+
+  [[nodiscard]] static std::array<uint32_t, 8> of(data_view data) noexcept {
+    sha256 result;
+    const auto* bytes{reinterpret_cast<const uint8_t*>(data.begin())};
+    const auto size{data.size()};
+    size_t offset{0};
+    for (; offset + 64 <= size; offset += 64) {
+      result.add_block(bytes + offset);
+    }
+
+    // The rest, a one bit, zeros and the length in bits
+    std::array<uint8_t, 128> tail{};
+    const auto rest{size - offset};
+    std::copy(bytes + offset, bytes + size, tail.begin());
+    tail[rest] = 0x80;
+    const size_t tail_size{rest + 9 <= 64 ? 64u : 128u};
+    const auto bits{static_cast<uint64_t>(size) * 8};
+    for (size_t i{0}; i < 8; i++) {
+      tail[tail_size - 1 - i] = static_cast<uint8_t>(bits >> (i * 8));
+    }
+    for (size_t i{0}; i < tail_size; i += 64) {
+      result.add_block(tail.data() + i);
+    }
+    return result.state;
+  }
+};
+
+constexpr size_t hash_digits{64};
+
+// Lengths and counts are stored as 32 bit integers, so save refuses larger
+// chunks and a manifest naming one is not trusted
+constexpr size_t max_chunk_size{std::numeric_limits<uint32_t>::max()};
+
+[[nodiscard]] std::string chunk_id(data_view data) {
+  std::string id;
+  char buffer[16];
+  for (const auto word : sha256::of(data)) {
+    std::snprintf(buffer, sizeof(buffer), "%08x", word);
+    id += buffer;
+  }
+  std::snprintf(buffer, sizeof(buffer), "-%zu", data.size());
+  return id + buffer;
+}
+
+[[nodiscard]] size_t chunk_size(const std::string& id) {
+  const auto separator{id.find('-')};
+  if (separator != hash_digits || separator + 1 == id.size()) {
+    throw read_error{"Invalid chunk id!"};
+  }
+  // Only lowercase hex digits, as the id also names the chunk's path
+  if (!std::all_of(id.begin(), id.begin() + separator, [](char c) {
+        return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f');
+      })) {
+    throw read_error{"Invalid chunk id!"};
+  }
+  size_t size{0};
+  for (auto i{separator + 1}; i < id.size(); i++) {
+    if (id[i] < '0' || id[i] > '9') {
+      throw read_error{"Invalid chunk id!"};
+    }
+    const auto digit{static_cast<size_t>(id[i] - '0')};
+    if (size > (max_chunk_size - digit) / 10) {
+      throw read_error{"Invalid chunk id!"};
+    }
+    size = size * 10 + digit;
+  }
+  return size;
+}
+
+void make_directory(const std::string& path) {
+  if (::mkdir(path.c_str(), 0755) != 0 && errno != EEXIST) {
+    throw write_error{"Cannot create directory!"};
+  }
+}
+
+[[nodiscard]] bool is_valid_name(const std::string& name) noexcept {
+  return !name.empty() && name != "." && name != ".." &&
+         name.find('/') == std::string::npos;
+}
+
+[[nodiscard]] bool file_exists(const std::string& path) {
+  struct stat status;
+  return ::stat(path.c_str(), &status) == 0;
+}
+
+[[nodiscard]] bool has_file_size(const std::string& path, size_t size) {
+  struct stat status;
+  return ::stat(path.c_str(), &status) == 0 && S_ISREG(status.st_mode) &&
+         static_cast<uintmax_t>(status.st_size) == size;
+}
+
+// Writes to a temporary file first so that readers never see partial data
+void write_file(const std::string& path, data_view data) {
+  std::string temp_path{path + ".XXXXXX"};
+  const int fd{::mkstemp(temp_path.data())};
+  if (fd < 0) {
+    throw write_error{"Cannot create file!"};
+  }
+
+  auto* begin{reinterpret_cast<const char*>(data.begin())};
+  auto remaining{data.size()};
+  while (remaining > 0) {
+    const auto written{::write(fd, begin, remaining)};
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      ::close(fd);
+      ::unlink(temp_path.c_str());
+      throw write_error{"Cannot write file!"};
+    }
+    begin += written;
+    remaining -= static_cast<size_t>(written);
+  }
+  ::fchmod(fd, 0644);
+  ::close(fd);
+
+  if (::rename(temp_path.c_str(), path.c_str()) != 0) {
+    ::unlink(temp_path.c_str());
+    throw write_error{"Cannot write file!"};
+  }
+}
+
+}  // namespace
+
+chunk_store::chunk_store(std::string directory, chunk_granularity granularity)
+    : _directory{std::move(directory)}, _granularity{granularity} {
+  make_directory(_directory);
+  make_directory(_directory + "/chunks");
+  make_directory(_directory + "/manifests");
+}
+
+void chunk_store::save(const std::string& name, const ast::base& program) {
+  if (!is_valid_name(name)) {
+    throw write_error{"Invalid document name!"};
+  }
+
+  const size_t depth{_granularity == chunk_granularity::block ? 1u : 2u};
+  const auto chunks{write_chunks({&program}, depth)};
+  const auto& data{chunks.data};
+
+  std::string manifest{manifest_header};
+  manifest += '\n';
+
+  size_t begin{0};
+  const auto add_chunk{[&](size_t end) {
+    if (end <= begin) {
+      return;
+    }
+    const data_view chunk{data.data() + begin, end - begin};
+    if (chunk.size() > max_chunk_size) {
+      throw write_error{"Chunk too large!"};
+    }
+    auto id{chunk_id(chunk)};
+    if (_seen_chunks.find(id) == _seen_chunks.end()) {
+      _stats.unique_bytes += chunk.size();
+      write_chunk(id, chunk);
+      _seen_chunks.emplace(id);
+    }
+    manifest += id;
+    manifest += '\n';
+    begin = end;
+  }};
+  for (const auto boundary : chunks.boundaries) {
+    add_chunk(boundary);
+  }
+  add_chunk(data.size());
+
+  write_file(manifest_path(name),
+             {reinterpret_cast<data_view::pointer>(manifest.data()),
+              manifest.size()});
+
+  _stats.documents_saved++;
+  _stats.logical_bytes += data.size();
+}
+
+data_vector chunk_store::load(const std::string& name) {
+  if (!is_valid_name(name)) {
+    throw read_error{"Invalid document name!"};
+  }
+
+  std::ifstream manifest{manifest_path(name)};
+  if (!manifest) {
+    throw read_error{"Cannot open manifest!"};
+  }
+
+  std::string line;
+  if (!std::getline(manifest, line) || line != manifest_header) {
+    throw read_error{"Unrecognized manifest!"};
+  }
+
+  // Sizes are checked against the chunks on disk before anything is allocated
+  std::vector<std::string> ids;
+  size_t total_size{0};
+  while (std::getline(manifest, line)) {
+    if (!line.empty()) {
+      const auto size{chunk_size(line)};
+      if (!has_file_size(chunk_path(line), size)) {
+        throw read_error{"Missing or truncated chunk!"};
+      }
+      if (size > std::numeric_limits<size_t>::max() - total_size) {
+        throw read_error{"Document too large!"};
+      }
+      total_size += size;
+      ids.emplace_back(std::move(line));
+    }
+  }
+
+  data_vector data(total_size);
+  size_t offset{0};
+  for (const auto& id : ids) {
+    const auto size{chunk_size(id)};
+    std::ifstream chunk{chunk_path(id), std::ios::binary};
+    if (!chunk.read(reinterpret_cast<char*>(data.data() + offset), size) ||
+        chunk.peek() != std::ifstream::traits_type::eof()) {
+      throw read_error{"Missing or truncated chunk!"};
+    }
+    if (chunk_id({data.data() + offset, size}) != id) {
+      throw read_error{"Corrupted chunk!"};
+    }
+    offset += size;
+  }
+  return data;
+}
+
+reconstruction_result chunk_store::read(const std::string& name,
+                                        user_function_table_interface& table) {
+  const auto start{std::chrono::steady_clock::now()};
+  const auto data{load(name)};
+  auto result{store::read(data, table, type_expectation::program)};
+
+  _stats.documents_read++;
+  _stats.read_bytes += data.size();
+  _stats.read_time += std::chrono::steady_clock::now() - start;
+  return result;
+}
+
+std::string chunk_store::manifest_path(const std::string& name) const {
+  return _directory + "/manifests/" + name;
+}
+
+std::string chunk_store::chunk_path(const std::string& id) const {
+  // Fan out by the leading hash digits to keep directories small
+  return _directory + "/chunks/" + id.substr(0, 2) + "/" + id;
+}
+
+void chunk_store::write_chunk(const std::string& id, data_view data) {
+  const auto path{chunk_path(id)};
+  if (file_exists(path)) {
+    return;
+  }
+  make_directory(_directory + "/chunks/" + id.substr(0, 2));
+  write_file(path, data);
+  _stats.written_bytes += data.size();
+}
+
+}  // namespace marlin::store
@@ -0,0 +1,74 @@
+#ifndef marlin_store_chunk_store_hpp
+#define marlin_store_chunk_store_hpp
+
+#include <chrono>
+#include <string>
+#include <unordered_set>
+
+#include "store_definition.hpp"
+
+namespace marlin::store {
+
+enum struct chunk_granularity { block, statement };
+
+struct chunk_stats {
+  size_t documents_saved{0};
+  // Size of the saved documents as they would be stored on their own
+  size_t logical_bytes{0};
+  // Size of the distinct chunks the saved documents are made of
+  size_t unique_bytes{0};
+  // Size of the chunks that were not in the directory yet
+  size_t written_bytes{0};
+
+  size_t documents_read{0};
+  size_t read_bytes{0};
+  std::chrono::steady_clock::duration read_time{0};
+
+  [[nodiscard]] double dedup_ratio() const noexcept {
+    return unique_bytes == 0 ? 1 : static_cast<double>(logical_bytes) /
+                                       static_cast<double>(unique_bytes);
+  }
+
+  // Bytes per second, including decoding and formatting
+  [[nodiscard]] double read_throughput() const noexcept {
+    const std::chrono::duration<double> seconds{read_time};
+    return seconds.count() == 0 ? 0 : read_bytes / seconds.count();
+  }
+};
+
+// Saves documents as manifests of chunks addressed by their content hash, so
+// that blocks shared between documents, like starter code and common helper
+// functions, are stored only once in the directory. The directory can be
+// shared between processes, while an instance is not meant to be used from
+// several threads at once.
+struct chunk_store {
+  explicit chunk_store(
+      std::string directory,
+      chunk_granularity granularity = chunk_granularity::block);
+
+  void save(const std::string& name, const ast::base& program);
+
+  // Rebuilds the saved data of the document from its chunks
+  [[nodiscard]] data_vector load(const std::string& name);
+
+  [[nodiscard]] reconstruction_result read(
+      const std::string& name, user_function_table_interface& table);
+
+  [[nodiscard]] const chunk_stats& stats() const noexcept { return _stats; }
+
+ private:
+  std::string _directory;
+  chunk_granularity _granularity;
+
+  chunk_stats _stats;
+  std::unordered_set<std::string> _seen_chunks;
+
+  [[nodiscard]] std::string manifest_path(const std::string& name) const;
+  [[nodiscard]] std::string chunk_path(const std::string& id) const;
+
+  void write_chunk(const std::string& id, data_view data);
+};
+
+}  // namespace marlin::store
+
+#endif  // marlin_store_chunk_store_hpp
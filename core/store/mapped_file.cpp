@@ -0,0 +1,48 @@
+#include "mapped_file.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "store_errors.hpp"
+
+namespace marlin::store {
+
+mapped_file::mapped_file(const std::string& path) {
+  const int fd{::open(path.c_str(), O_RDONLY)};
+  if (fd < 0) {
+    throw read_error{"Cannot open file!"};
+  }
+
+  struct stat status;
+  if (::fstat(fd, &status) != 0) {
+    ::close(fd);
+    throw read_error{"Cannot read file status!"};
+  }
+
+  // Mapping an empty file is not allowed, leave the view empty instead
+  if (status.st_size > 0) {
+    _size = static_cast<size_t>(status.st_size);
+    _data = ::mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (_data == MAP_FAILED) {
+      _data = nullptr;
+      _size = 0;
+      ::close(fd);
+      throw read_error{"Cannot map file into memory!"};
+    }
+    // The document is decoded from front to back exactly once
+    ::madvise(_data, _size, MADV_SEQUENTIAL);
+  }
+
+  // The mapping stays valid after the descriptor is closed
+  ::close(fd);
+}
+
+mapped_file::~mapped_file() noexcept {
+  if (_data != nullptr) {
+    ::munmap(_data, _size);
+  }
+}
+
+}  // namespace marlin::store
@@ -0,0 +1,42 @@
+#ifndef marlin_store_mapped_file_hpp
+#define marlin_store_mapped_file_hpp
+
+#include <string>
+#include <utility>
+
+#include "byte_span.hpp"
+
+namespace marlin::store {
+
+// Read-only memory mapping of a saved document, so that the store can
+// decode directly from the file without an intermediate buffer
+struct mapped_file {
+  explicit mapped_file(const std::string& path);
+  ~mapped_file() noexcept;
+
+  mapped_file(mapped_file&& other) noexcept
+      : _data{std::exchange(other._data, nullptr)},
+        _size{std::exchange(other._size, 0)} {}
+  mapped_file& operator=(mapped_file&& other) noexcept {
+    std::swap(_data, other._data);
+    std::swap(_size, other._size);
+    return *this;
+  }
+
+  mapped_file(const mapped_file&) = delete;
+  mapped_file& operator=(const mapped_file&) = delete;
+
+  [[nodiscard]] data_view view() const noexcept {
+    return {static_cast<data_view::pointer>(_data), _size};
+  }
+
+  [[nodiscard]] size_t size() const noexcept { return _size; }
+
+ private:
+  void* _data{nullptr};
+  size_t _size{0};
+};
+
+}  // namespace marlin::store
+
+#endif  // marlin_store_mapped_file_hpp
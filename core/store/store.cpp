@@ -1,12 +1,48 @@
 #include "store.hpp"
 
+#include <unordered_map>
+
+#include "mapped_file.hpp"
+#include "parallel_formatter.hpp"
 #include "store_errors.hpp"
 
 // Stores
 #include "v1_store.hpp"
+#include "v2_store.hpp"
 
 namespace marlin::store {
 
+namespace {
+
+// Below this, starting threads costs more than formatting the blocks
+constexpr size_t parallel_format_size{256 * 1024};
+
+// Functions of a program_reader, kept apart from any document
+struct reader_function_table final : user_function_table_interface {
+  [[nodiscard]] bool has_function(const std::string& name) const override {
+    return _functions.find(name) != _functions.end();
+  }
+
+  [[nodiscard]] const function_definition& get_function(
+      const std::string& name) const override {
+    return _functions.at(name);
+  }
+
+  void add_function(function_definition signature) override {
+    auto name{signature.name};
+    _functions.emplace(std::move(name), std::move(signature));
+  }
+
+  void remove_function(const std::string& name) override {
+    _functions.erase(name);
+  }
+
+ private:
+  std::unordered_map<std::string, function_definition> _functions;
+};
+
+}  // namespace
+
 [[nodiscard]] reconstruction_result read(data_view data, size_t start_line,
                                          const ast::base& parent,
                                          user_function_table_interface& table) {
@@ -53,17 +89,97 @@ namespace marlin::store {
                                          user_function_table_interface& table,
                                          type_expectation type) {
   auto* s{base_store::corresponding_store(data)};
+  const auto size{data.size()};
 
   auto nodes{s->read(std::move(data), type, table)};
+  if (size >= parallel_format_size && nodes.size() == 1 &&
+      nodes[0]->is<ast::program>()) {
+    auto display{format::format_in_parallel(nodes[0]->as<ast::program>())};
+    return {std::move(nodes), std::move(display)};
+  }
   format::in_place_formatter formatter;
   auto display{formatter.format(nodes)};
   return {std::move(nodes), std::move(display)};
 }
 
+[[nodiscard]] std::vector<ast::node> read_nodes(
+    data_view data, user_function_table_interface& table,
+    type_expectation type) {
+  auto* s{base_store::corresponding_store(data)};
+  return s->read(std::move(data), type, table);
+}
+
+[[nodiscard]] reconstruction_result read_file(
+    const std::string& path, user_function_table_interface& table,
+    type_expectation type) {
+  // Nodes keep their own copies of every string they need, so the mapping
+  // only has to outlive decoding
+  mapped_file file{path};
+  return read(file.view(), table, type);
+}
+
 [[nodiscard]] data_vector write(
     std::vector<const ast::base*> nodes,
     std::optional<std::string_view> erase_function_names) {
   return latest_store::_singleton.write(nodes, erase_function_names);
 }
 
+[[nodiscard]] chunked_data write_chunks(std::vector<const ast::base*> nodes,
+                                        size_t depth) {
+  return latest_store::_singleton.write_chunks(nodes, depth);
+}
+
+struct program_reader::impl {
+  data_vector data;
+  reader_function_table table;
+  v1::reader reader;
+  size_t block_count;
+  size_t blocks_read{0};
+
+  explicit impl(data_vector _data)
+      : data{std::move(_data)},
+        reader{read_directory(data, table)},
+        block_count{reader.begin_program()} {}
+
+  static v1::reader read_directory(data_view data,
+                                   user_function_table_interface& table) {
+    const auto* store{
+        dynamic_cast<const v2::store*>(base_store::corresponding_store(data))};
+    if (store == nullptr) {
+      throw read_error{"Data has no function directory!"};
+    }
+    return store->reader(data, table);
+  }
+};
+
+program_reader::program_reader(data_vector data)
+    : _impl{std::make_unique<impl>(std::move(data))} {}
+
+program_reader::~program_reader() noexcept = default;
+
+program_reader::program_reader(program_reader&&) noexcept = default;
+program_reader& program_reader::operator=(program_reader&&) noexcept =
+    default;
+
+const std::vector<function_definition>& program_reader::functions() const {
+  return _impl->reader.directory();
+}
+
+size_t program_reader::block_count() const noexcept {
+  return _impl->block_count;
+}
+
+bool program_reader::done() const noexcept {
+  return _impl->blocks_read == _impl->block_count;
+}
+
+ast::node program_reader::read_block() {
+  assert(!done());
+  auto block{_impl->reader.read_block()};
+  if (++_impl->blocks_read == _impl->block_count) {
+    _impl->reader.end_program();
+  }
+  return block;
+}
+
 }  // namespace marlin::store
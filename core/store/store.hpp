@@ -1,6 +1,9 @@
 #ifndef marlin_store_store_hpp
 #define marlin_store_store_hpp
 
+#include <memory>
+#include <string>
+
 #include "store_definition.hpp"
 
 namespace marlin::store {
@@ -17,10 +20,50 @@ namespace marlin::store {
     data_view data, user_function_table_interface& table,
     type_expectation type = type_expectation::any);
 
+// Only decodes the nodes, without formatting them into a display
+[[nodiscard]] std::vector<ast::node> read_nodes(
+    data_view data, user_function_table_interface& table,
+    type_expectation type = type_expectation::any);
+
+// Decodes a saved document straight from a read-only mapping of the file
+[[nodiscard]] reconstruction_result read_file(
+    const std::string& path, user_function_table_interface& table,
+    type_expectation type = type_expectation::any);
+
 [[nodiscard]] data_vector write(
     std::vector<const ast::base*> nodes,
     std::optional<std::string_view> erase_function_names = std::nullopt);
 
+// Same as write, also giving the offsets around the nodes kept in vectors down
+// to depth levels below the written nodes, e.g. 1 for the blocks of a program
+[[nodiscard]] chunked_data write_chunks(std::vector<const ast::base*> nodes,
+                                        size_t depth);
+
+// Decodes a program one block at a time, so that a large document can be
+// shown before it is fully read. Only data with a function directory can be
+// read this way. Calls are bound to the functions of the reader, and must be
+// bound again once the blocks are moved to a document.
+struct program_reader {
+  // Throws read_error when the data has no directory or is not a program
+  explicit program_reader(data_vector data);
+  ~program_reader() noexcept;
+
+  program_reader(program_reader&&) noexcept;
+  program_reader& operator=(program_reader&&) noexcept;
+
+  [[nodiscard]] const std::vector<function_definition>& functions() const;
+
+  [[nodiscard]] size_t block_count() const noexcept;
+  [[nodiscard]] bool done() const noexcept;
+
+  // Also checks that every function has been read after the last block
+  [[nodiscard]] ast::node read_block();
+
+ private:
+  struct impl;
+  std::unique_ptr<impl> _impl;
+};
+
 }  // namespace marlin::store
 
 #endif  // marlin_store_store_hpp
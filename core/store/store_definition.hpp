@@ -15,12 +15,12 @@
 namespace marlin::store {
 
 struct user_function_table_interface {
-  [[nodiscard]] virtual const bool has_function(
-      const std::string& name) const = 0;
+  [[nodiscard]] virtual bool has_function(const std::string& name) const = 0;
   [[nodiscard]] virtual const function_definition& get_function(
       const std::string& name) const = 0;
 
   virtual void add_function(function_definition signature) = 0;
+  virtual void remove_function(const std::string& name) = 0;
 };
 
 enum struct type_expectation {
@@ -42,11 +42,19 @@ struct reconstruction_result {
       : nodes{std::move(_nodes)}, display{std::move(_display)} {}
 };
 
+struct chunked_data {
+  data_vector data;
+  // Offsets in data where it can be split, in increasing order
+  std::vector<size_t> boundaries;
+};
+
+// Stores hold no state, each read or write works on its own reader or writer
+// context, so different documents can be processed on different threads
 struct base_store {
   template <typename store_type>
   struct impl;
 
-  static base_store* corresponding_store(data_view data) {
+  static const base_store* corresponding_store(data_view data) {
     for (auto* s : get_stores()) {
       if (s->recognize(data)) {
         return s;
@@ -57,17 +65,19 @@ struct base_store {
 
   virtual ~base_store() noexcept = default;
 
-  virtual bool recognize(data_view data) = 0;
-  virtual std::vector<ast::node> read(data_view data, type_expectation type,
-                                      user_function_table_interface& table) = 0;
+  virtual bool recognize(data_view data) const = 0;
+  virtual std::vector<ast::node> read(
+      data_view data, type_expectation type,
+      user_function_table_interface& table) const = 0;
 
   // The latest version also needs to implement
   // data_vector write(std::vector<const ast::base*> node,
   //     std::optional<std::string_view> erase_function_names);
 
  private:
-  [[nodiscard]] static std::vector<base_store*>& get_stores() {
-    static std::vector<base_store*> _stores;
+  // Only modified during static initialization
+  [[nodiscard]] static std::vector<const base_store*>& get_stores() {
+    static std::vector<const base_store*> _stores;
     return _stores;
   }
 };
@@ -77,6 +87,8 @@ struct base_store::impl : base_store {
   friend data_vector write(
       std::vector<const ast::base*> nodes,
       std::optional<std::string_view> erase_function_names);
+  friend chunked_data write_chunks(std::vector<const ast::base*> nodes,
+                                   size_t depth);
 
  protected:
   impl() { get_stores().emplace_back(&_singleton); }
@@ -17,6 +17,17 @@ struct read_error : std::exception {
   std::string _message;
 };
 
+struct write_error : std::exception {
+  inline write_error(std::string message) : _message{std::move(message)} {}
+
+  [[nodiscard]] const char* what() const noexcept override {
+    return _message.data();
+  }
+
+ private:
+  std::string _message;
+};
+
 }  // namespace marlin::store
 
 #endif  // marlin_store_store_hpp
\ No newline at end of file
@@ -0,0 +1,237 @@
+#ifndef marlin_store_store_schema_hpp
+#define marlin_store_store_schema_hpp
+
+#include <array>
+#include <optional>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "base.hpp"
+#include "specs.hpp"
+#include "store_definition.hpp"
+
+// Building blocks for describing how a node is laid out in storage. A schema
+// names the key of the node, what it can be read as, the fields stored ahead
+// of its subnodes and the expectation for each subnode; readers, writers and
+// dispatch tables are then generated from the schemas at compile time.
+
+namespace marlin::store::schema {
+
+template <type_expectation... types>
+struct expect {
+  static constexpr size_t size{sizeof...(types)};
+  static constexpr std::array<type_expectation, size> values{types...};
+
+  [[nodiscard]] static constexpr bool contains(type_expectation type) noexcept {
+    return ((type == types) || ...);
+  }
+};
+
+// Fields, stored in order before the subnodes
+
+// Constant distinguishing nodes sharing the same key, must come first
+template <bool value>
+struct flag {};
+
+template <auto member>
+struct string {};
+
+template <auto member>
+struct boolean {};
+
+template <auto member>
+struct symbol {};
+
+template <typename... field_types>
+struct fields {};
+
+// Symbols are stored by name, looked up in the existing spec tables
+
+template <typename enum_type>
+struct symbols {};
+
+template <>
+struct symbols<ast::array_modification> {
+  static constexpr const auto& names{ast::array_modification_name_map};
+};
+
+template <>
+struct symbols<ast::system_procedure> {
+  static constexpr const auto& names{ast::system_procedure_name_map};
+};
+
+template <>
+struct symbols<ast::unary_op> {
+  static constexpr const auto& names{ast::unary_op_symbol_map};
+};
+
+template <>
+struct symbols<ast::binary_op> {
+  static constexpr const auto& names{ast::binary_op_symbol_map};
+};
+
+template <>
+struct symbols<ast::system_function> {
+  static constexpr const auto& names{ast::system_function_name_map};
+};
+
+template <>
+struct symbols<ast::color_mode> {
+  static constexpr const auto& names{ast::color_mode_name_map};
+};
+
+template <typename enum_type>
+[[nodiscard]] constexpr std::string_view name_of(enum_type value) noexcept {
+  return symbols<enum_type>::names[raw_value(value)];
+}
+
+template <typename enum_type>
+[[nodiscard]] constexpr std::optional<enum_type> find_symbol(
+    std::string_view name) noexcept {
+  const auto& names{symbols<enum_type>::names};
+  for (size_t i{0}; i < names.size(); i++) {
+    if (names[i] == name) {
+      return static_cast<enum_type>(i);
+    }
+  }
+  return std::nullopt;
+}
+
+template <typename member_type>
+struct member_traits {};
+
+template <typename class_type, typename value_type>
+struct member_traits<value_type class_type::*> {
+  using type = value_type;
+};
+
+template <auto member>
+using member_t = typename member_traits<decltype(member)>::type;
+
+template <typename impl_type>
+struct subnode_layout {};
+
+template <typename node_type, typename... subnode_types>
+struct subnode_layout<ast::base::impl<node_type, subnode_types...>> {
+  static constexpr size_t size{sizeof...(subnode_types)};
+
+  template <size_t index>
+  static constexpr bool is_vector{
+      std::is_same_v<std::tuple_element_t<index, std::tuple<subnode_types...>>,
+                     ast::subnode::vector>};
+};
+
+template <typename node_type>
+using subnodes_of = subnode_layout<typename node_type::base_type>;
+
+template <typename field_type>
+struct flag_value {
+  static constexpr std::optional<bool> value{std::nullopt};
+};
+
+template <bool value_>
+struct flag_value<fields<flag<value_>>> {
+  static constexpr std::optional<bool> value{value_};
+};
+
+template <bool value_, typename f0, typename... field_types>
+struct flag_value<fields<flag<value_>, f0, field_types...>> {
+  static constexpr std::optional<bool> value{value_};
+};
+
+// Common base of all node schemas
+template <typename node_type, const std::string_view& node_key,
+          typename accept_types, typename subnode_types,
+          typename field_types = fields<>>
+struct node_schema {
+  static_assert(subnode_types::size == subnodes_of<node_type>::size,
+                "Every subnode needs an expectation!");
+
+  static constexpr std::string_view key{node_key};
+  static constexpr std::optional<bool> flag{flag_value<field_types>::value};
+
+  using accepts = accept_types;
+  using subnodes = subnode_types;
+  using fields = field_types;
+
+  // Builds the node from the fields followed by the subnodes, overridden by
+  // nodes whose constructors take them in a different order
+  template <typename... arg_types>
+  [[nodiscard]] static ast::node make(arg_types&&... args) {
+    return ast::make<node_type>(std::forward<arg_types>(args)...);
+  }
+};
+
+// Sorted at compile time so that a key is found by binary search, nodes
+// sharing a key stay in declaration order
+struct key_entry {
+  std::string_view key;
+  size_t type;
+};
+
+template <size_t size>
+struct key_table {
+  // Keys are given in the order of the node types
+  constexpr explicit key_table(
+      const std::array<std::string_view, size>& keys) noexcept {
+    for (size_t i{0}; i < size; i++) {
+      _entries[i] = {keys[i], i};
+      for (size_t j{i}; j > 0 && _entries[j].key < _entries[j - 1].key; j--) {
+        const auto entry{_entries[j]};
+        _entries[j] = _entries[j - 1];
+        _entries[j - 1] = entry;
+      }
+    }
+  }
+
+  [[nodiscard]] constexpr const key_entry& operator[](
+      size_t index) const noexcept {
+    return _entries[index];
+  }
+
+  [[nodiscard]] constexpr std::pair<size_t, size_t> equal_range(
+      std::string_view key) const noexcept {
+    size_t begin{0};
+    size_t end{size};
+    while (begin < end) {
+      const auto mid{begin + (end - begin) / 2};
+      if (_entries[mid].key < key) {
+        begin = mid + 1;
+      } else {
+        end = mid;
+      }
+    }
+    end = begin;
+    while (end < size && _entries[end].key == key) {
+      end++;
+    }
+    return {begin, end};
+  }
+
+ private:
+  std::array<key_entry, size> _entries{};
+};
+
+[[nodiscard]] constexpr std::string_view unexpected_message(
+    type_expectation type) noexcept {
+  switch (type) {
+    case type_expectation::program:
+      return "Unexpected program!";
+    case type_expectation::block:
+      return "Unexpected block!";
+    case type_expectation::function_signature:
+      return "Unexpected function!";
+    case type_expectation::statement:
+      return "Unexpected statement!";
+    case type_expectation::parameter:
+      return "Unexpected parameter!";
+    default:
+      return "Unexpected expression!";
+  }
+}
+
+}  // namespace marlin::store::schema
+
+#endif  // marlin_store_store_schema_hpp
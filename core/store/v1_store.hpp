@@ -2,14 +2,18 @@
 #define marlin_store_v1_store_hpp
 
 #include <algorithm>
+#include <array>
+#include <tuple>
 #include <type_traits>
 #include <unordered_map>
 #include <unordered_set>
+#include <utility>
 
 #include "base.hpp"
 #include "specs.hpp"
 #include "store_definition.hpp"
 #include "store_errors.hpp"
+#include "store_schema.hpp"
 
 // For now we are supporting print statement for back capability
 // Will remove later
@@ -20,68 +24,387 @@ namespace v1 {
 
 namespace key {
 
-inline const std::string_view program{"program"};
-inline const std::string_view on_start{"on_start"};
-inline const std::string_view function{"function"};
-inline const std::string_view function_signature{"signature"};
+inline constexpr std::string_view program{"program"};
+inline constexpr std::string_view on_start{"on_start"};
+inline constexpr std::string_view function{"function"};
+inline constexpr std::string_view function_signature{"signature"};
 
-inline const std::string_view eval_statement{"eval"};
-inline const std::string_view assignment{"assign"};
-inline const std::string_view use_global{"global"};
+inline constexpr std::string_view eval_statement{"eval"};
+inline constexpr std::string_view assignment{"assign"};
+inline constexpr std::string_view use_global{"global"};
 
-inline const std::string_view modify_array{"mod_array"};
-inline const std::string_view system_procedure{"sys_proc"};
+inline constexpr std::string_view modify_array{"mod_array"};
+inline constexpr std::string_view system_procedure{"sys_proc"};
 
-inline const std::string_view if_else{"if"};
-inline const std::string_view while_loop{"while"};
-inline const std::string_view for_loop{"for"};
+inline constexpr std::string_view if_else{"if"};
+inline constexpr std::string_view while_loop{"while"};
+inline constexpr std::string_view for_loop{"for"};
 
-inline const std::string_view break_statement{"break"};
-inline const std::string_view continue_statement{"continue"};
-inline const std::string_view return_statement{"return"};
+inline constexpr std::string_view break_statement{"break"};
+inline constexpr std::string_view continue_statement{"continue"};
+inline constexpr std::string_view return_statement{"return"};
 
-inline const std::string_view placeholder{"placeholder"};
-inline const std::string_view identifier{"id"};
+inline constexpr std::string_view placeholder{"placeholder"};
+inline constexpr std::string_view identifier{"id"};
 
-inline const std::string_view unary{"unary"};
-inline const std::string_view binary{"binary"};
+inline constexpr std::string_view unary{"unary"};
+inline constexpr std::string_view binary{"binary"};
 
-inline const std::string_view subscript{"sub"};
+inline constexpr std::string_view subscript{"sub"};
 
-inline const std::string_view new_array{"new_array"};
-inline const std::string_view new_color{"new_color"};
+inline constexpr std::string_view new_array{"new_array"};
+inline constexpr std::string_view new_color{"new_color"};
 
-inline const std::string_view system_function{"sys_func"};
-inline const std::string_view user_function{"user_func"};
+inline constexpr std::string_view system_function{"sys_func"};
+inline constexpr std::string_view user_function{"user_func"};
 
-inline const std::string_view number{"number"};
-inline const std::string_view string{"string"};
-inline const std::string_view boolean{"boolean"};
+inline constexpr std::string_view number{"number"};
+inline constexpr std::string_view string{"string"};
+inline constexpr std::string_view boolean{"boolean"};
 
 }  // namespace key
 
-struct store : base_store::impl<store> {
-  bool recognize(data_view data) override {
-    return data.size() >= data_prefix().size() &&
-           std::equal(data.begin(), data.begin() + data_prefix().size(),
-                      data_prefix().begin(), data_prefix().end());
-  }
 
-  std::vector<ast::node> read(data_view data, type_expectation type,
-                              user_function_table_interface& table) override {
-    assert(recognize(data));
+// Describes how each node is stored, every node in ASTS needs one
+
+template <typename node_type>
+struct schema_for;
+
+template <>
+struct schema_for<ast::program>
+    : schema::node_schema<ast::program, key::program,
+                          schema::expect<type_expectation::program>,
+                          schema::expect<type_expectation::block>> {};
+
+template <>
+struct schema_for<ast::on_start>
+    : schema::node_schema<ast::on_start, key::on_start,
+                          schema::expect<type_expectation::block>,
+                          schema::expect<type_expectation::statement>> {};
+
+template <>
+struct schema_for<ast::function_placeholder>
+    : schema::node_schema<ast::function_placeholder, key::placeholder,
+                          schema::expect<type_expectation::function_signature>,
+                          schema::expect<type_expectation::parameter>,
+                          schema::fields<schema::string<
+                              &ast::function_placeholder::name>>> {};
+
+template <>
+struct schema_for<ast::function_signature>
+    : schema::node_schema<
+          ast::function_signature, key::function_signature,
+          schema::expect<type_expectation::function_signature>,
+          schema::expect<type_expectation::parameter>,
+          schema::fields<schema::string<&ast::function_signature::name>>> {
+  // Repeated parameters are dropped
+  [[nodiscard]] static ast::node make(std::string name,
+                                      std::vector<ast::node> params) {
+    std::unordered_set<std::string_view> names;
+    params.erase(std::remove_if(params.begin(), params.end(),
+                                [&names](const auto& param) {
+                                  return !names
+                                              .emplace(param->template as<
+                                                       ast::parameter>()
+                                                           .name)
+                                              .second;
+                                }),
+                 params.end());
+    return ast::make<ast::function_signature>(std::move(name),
+                                              std::move(params));
+  }
+};
+
+template <>
+struct schema_for<ast::parameter>
+    : schema::node_schema<
+          ast::parameter, key::identifier,
+          schema::expect<type_expectation::parameter>, schema::expect<>,
+          schema::fields<schema::string<&ast::parameter::name>>> {};
+
+template <>
+struct schema_for<ast::function>
+    : schema::node_schema<ast::function, key::function,
+                          schema::expect<type_expectation::block>,
+                          schema::expect<type_expectation::function_signature,
+                                         type_expectation::statement>> {};
+
+template <>
+struct schema_for<ast::eval_statement>
+    : schema::node_schema<ast::eval_statement, key::eval_statement,
+                          schema::expect<type_expectation::statement>,
+                          schema::expect<type_expectation::rvalue>> {};
+
+template <>
+struct schema_for<ast::assignment>
+    : schema::node_schema<
+          ast::assignment, key::assignment,
+          schema::expect<type_expectation::statement>,
+          schema::expect<type_expectation::lvalue, type_expectation::rvalue>> {
+};
+
+template <>
+struct schema_for<ast::use_global>
+    : schema::node_schema<ast::use_global, key::use_global,
+                          schema::expect<type_expectation::statement>,
+                          schema::expect<type_expectation::lvalue>> {};
+
+template <>
+struct schema_for<ast::modify_array>
+    : schema::node_schema<
+          ast::modify_array, key::modify_array,
+          schema::expect<type_expectation::statement>,
+          schema::expect<type_expectation::lvalue, type_expectation::rvalue>,
+          schema::fields<schema::symbol<&ast::modify_array::mod>>> {};
+
+template <>
+struct schema_for<ast::system_procedure_call>
+    : schema::node_schema<
+          ast::system_procedure_call, key::system_procedure,
+          schema::expect<type_expectation::statement>,
+          schema::expect<type_expectation::rvalue>,
+          schema::fields<schema::symbol<&ast::system_procedure_call::proc>>> {
+};
+
+template <>
+struct schema_for<ast::if_statement>
+    : schema::node_schema<ast::if_statement, key::if_else,
+                          schema::expect<type_expectation::statement>,
+                          schema::expect<type_expectation::rvalue,
+                                         type_expectation::statement>,
+                          schema::fields<schema::flag<false>>> {};
+
+template <>
+struct schema_for<ast::if_else_statement>
+    : schema::node_schema<
+          ast::if_else_statement, key::if_else,
+          schema::expect<type_expectation::statement>,
+          schema::expect<type_expectation::rvalue, type_expectation::statement,
+                         type_expectation::statement>,
+          schema::fields<schema::flag<true>>> {};
+
+template <>
+struct schema_for<ast::while_statement>
+    : schema::node_schema<ast::while_statement, key::while_loop,
+                          schema::expect<type_expectation::statement>,
+                          schema::expect<type_expectation::rvalue,
+                                         type_expectation::statement>> {};
+
+template <>
+struct schema_for<ast::for_statement>
+    : schema::node_schema<
+          ast::for_statement, key::for_loop,
+          schema::expect<type_expectation::statement>,
+          schema::expect<type_expectation::lvalue, type_expectation::rvalue,
+                         type_expectation::statement>> {};
+
+template <>
+struct schema_for<ast::break_statement>
+    : schema::node_schema<ast::break_statement, key::break_statement,
+                          schema::expect<type_expectation::statement>,
+                          schema::expect<>> {};
+
+template <>
+struct schema_for<ast::continue_statement>
+    : schema::node_schema<ast::continue_statement, key::continue_statement,
+                          schema::expect<type_expectation::statement>,
+                          schema::expect<>> {};
+
+template <>
+struct schema_for<ast::return_statement>
+    : schema::node_schema<ast::return_statement, key::return_statement,
+                          schema::expect<type_expectation::statement>,
+                          schema::expect<>,
+                          schema::fields<schema::flag<false>>> {};
+
+template <>
+struct schema_for<ast::return_result_statement>
+    : schema::node_schema<ast::return_result_statement, key::return_statement,
+                          schema::expect<type_expectation::statement>,
+                          schema::expect<type_expectation::rvalue>,
+                          schema::fields<schema::flag<true>>> {};
+
+template <>
+struct schema_for<ast::variable_placeholder>
+    : schema::node_schema<
+          ast::variable_placeholder, key::placeholder,
+          schema::expect<type_expectation::lvalue>, schema::expect<>,
+          schema::fields<schema::string<&ast::variable_placeholder::name>>> {
+};
+
+template <>
+struct schema_for<ast::variable_name>
+    : schema::node_schema<
+          ast::variable_name, key::identifier,
+          schema::expect<type_expectation::lvalue>, schema::expect<>,
+          schema::fields<schema::string<&ast::variable_name::name>>> {};
+
+template <>
+struct schema_for<ast::subscript_set>
+    : schema::node_schema<
+          ast::subscript_set, key::subscript,
+          schema::expect<type_expectation::lvalue>,
+          schema::expect<type_expectation::lvalue, type_expectation::rvalue>> {
+};
+
+template <>
+struct schema_for<ast::expression_placeholder>
+    : schema::node_schema<
+          ast::expression_placeholder, key::placeholder,
+          schema::expect<type_expectation::rvalue>, schema::expect<>,
+          schema::fields<schema::string<&ast::expression_placeholder::name>>> {
+};
+
+template <>
+struct schema_for<ast::unary_expression>
+    : schema::node_schema<
+          ast::unary_expression, key::unary,
+          schema::expect<type_expectation::rvalue>,
+          schema::expect<type_expectation::rvalue>,
+          schema::fields<schema::symbol<&ast::unary_expression::op>>> {};
+
+template <>
+struct schema_for<ast::binary_expression>
+    : schema::node_schema<
+          ast::binary_expression, key::binary,
+          schema::expect<type_expectation::rvalue>,
+          schema::expect<type_expectation::rvalue, type_expectation::rvalue>,
+          schema::fields<schema::symbol<&ast::binary_expression::op>>> {
+  [[nodiscard]] static ast::node make(ast::binary_op op, ast::node left,
+                                      ast::node right) {
+    return ast::make<ast::binary_expression>(std::move(left), op,
+                                             std::move(right));
+  }
+};
+
+template <>
+struct schema_for<ast::subscript_get>
+    : schema::node_schema<
+          ast::subscript_get, key::subscript,
+          schema::expect<type_expectation::rvalue>,
+          schema::expect<type_expectation::rvalue, type_expectation::rvalue>> {
+};
+
+template <>
+struct schema_for<ast::new_array>
+    : schema::node_schema<ast::new_array, key::new_array,
+                          schema::expect<type_expectation::rvalue>,
+                          schema::expect<type_expectation::rvalue>> {};
+
+template <>
+struct schema_for<ast::new_color>
+    : schema::node_schema<
+          ast::new_color, key::new_color,
+          schema::expect<type_expectation::rvalue>,
+          schema::expect<type_expectation::rvalue>,
+          schema::fields<schema::symbol<&ast::new_color::mode>>> {};
+
+template <>
+struct schema_for<ast::system_function_call>
+    : schema::node_schema<
+          ast::system_function_call, key::system_function,
+          schema::expect<type_expectation::rvalue>,
+          schema::expect<type_expectation::rvalue>,
+          schema::fields<schema::symbol<&ast::system_function_call::func>>> {
+};
+
+template <>
+struct schema_for<ast::user_function_call>
+    : schema::node_schema<
+          ast::user_function_call, key::user_function,
+          schema::expect<type_expectation::rvalue>,
+          schema::expect<type_expectation::rvalue>,
+          schema::fields<schema::string<&ast::user_function_call::name>>> {};
+
+template <>
+struct schema_for<ast::identifier>
+    : schema::node_schema<
+          ast::identifier, key::identifier,
+          schema::expect<type_expectation::rvalue>, schema::expect<>,
+          schema::fields<schema::string<&ast::identifier::name>>> {};
+
+template <>
+struct schema_for<ast::number_literal>
+    : schema::node_schema<
+          ast::number_literal, key::number,
+          schema::expect<type_expectation::rvalue>, schema::expect<>,
+          schema::fields<schema::string<&ast::number_literal::value>>> {};
+
+template <>
+struct schema_for<ast::string_literal>
+    : schema::node_schema<
+          ast::string_literal, key::string,
+          schema::expect<type_expectation::rvalue>, schema::expect<>,
+          schema::fields<schema::string<&ast::string_literal::value>>> {};
+
+template <>
+struct schema_for<ast::bool_literal>
+    : schema::node_schema<
+          ast::bool_literal, key::boolean,
+          schema::expect<type_expectation::rvalue>, schema::expect<>,
+          schema::fields<schema::boolean<&ast::bool_literal::value>>> {};
+
+#define _STORE_KEY_TEMPLATE(NAME) schema_for<ast::NAME>::key,
+
+#define _STORE_NODE_ENTRY_TEMPLATE(NAME)                        \
+  node_entry{&reader::read_schema<ast::NAME>,                   \
+             &schema_for<ast::NAME>::accepts::contains,         \
+             schema_for<ast::NAME>::flag,                       \
+             schema::unexpected_message(                        \
+                 schema_for<ast::NAME>::accepts::values.front())},
+
+struct reader {
+  reader(data_view::pointer begin, data_view::pointer end,
+         user_function_table_interface& table)
+      : _iter{begin}, _end{end}, _functions{&table} {}
+
+  // Later versions list every function signature ahead of the nodes, the
+  // functions are then added before decoding so that calls bind right away
+  void read_directory() {
+    const auto count{read_int()};
+    _directory.reserve(count);
+    for (size_t i{0}; i < count; i++) {
+      function_definition definition{std::string{read_string()}};
+      const auto param_count{read_int()};
+      definition.parameters.reserve(param_count);
+      for (size_t j{0}; j < param_count; j++) {
+        definition.parameters.emplace_back(read_string());
+      }
+      _directory.emplace_back(std::move(definition));
+    }
 
-    _iter = data.begin() + data_prefix().size();
-    _end = data.end();
-    _functions = &table;
-    _new_functions.clear();
-    _unknown_calls.clear();
+    std::unordered_set<std::string_view> names;
+    names.reserve(_directory.size());
+    for (const auto& definition : _directory) {
+      if (_functions->has_function(definition.name) ||
+          !names.emplace(definition.name).second) {
+        throw read_error{"Repeated function name encountered!"};
+      }
+    }
+    _has_directory = true;
+  }
 
-    auto nodes{read_vector(type)};
-    if (nodes.size() == 0) {
-      throw read_error{"No data is read!"};
+  std::vector<ast::node> read(type_expectation type) {
+    if (_has_directory) {
+      for (const auto& definition : _directory) {
+        _functions->add_function(definition);
+      }
+      try {
+        auto nodes{read_nodes(type)};
+        if (_next_signature < _directory.size()) {
+          throw read_error{"Function directory does not match!"};
+        }
+        return nodes;
+      } catch (const read_error&) {
+        for (const auto& definition : _directory) {
+          _functions->remove_function(definition.name);
+        }
+        throw;
+      }
     }
 
+    auto nodes{read_nodes(type)};
+
     // Only update function table when there are no errors
     for (auto& it : _new_functions) {
       _functions->add_function(std::move(it.second));
@@ -98,26 +421,39 @@ struct store : base_store::impl<store> {
     return nodes;
   }
 
-  data_vector write(std::vector<const ast::base*> nodes,
-                    std::optional<std::string_view> erase_function_names) {
-    _data_buffer.clear();
-    _erase_function_names = erase_function_names;
-    write_bytes(data_prefix());
-    write_vector(nodes);
-    return std::exchange(_data_buffer, {});
+  // A program can also be read one block at a time after the directory, the
+  // functions of the directory are added first and returns the block count
+  size_t begin_program() {
+    assert(_has_directory);
+    for (const auto& definition : _directory) {
+      _functions->add_function(definition);
+    }
+    if (read_int() != 1 ||
+        read_zero_terminated() != schema_for<ast::program>::key) {
+      throw read_error{"Expecting a program!"};
+    }
+    return read_int();
   }
 
- private:
-  using read_node_entry = ast::node (store::*)(type_expectation);
+  ast::node read_block() { return read_node(type_expectation::block); }
 
-  static data_view data_prefix() {
-    static const data_vector _data{std::byte{'M'}, std::byte{'K'},
-                                   std::byte{'B'}, std::byte{1}};
-    return _data;
+  void end_program() {
+    if (_next_signature < _directory.size()) {
+      throw read_error{"Function directory does not match!"};
+    }
   }
 
-  data_vector _data_buffer;
-  std::optional<std::string_view> _erase_function_names;
+  [[nodiscard]] const std::vector<function_definition>& directory() const {
+    return _directory;
+  }
+
+ private:
+  struct node_entry {
+    ast::node (reader::*read)();
+    bool (*accepts)(type_expectation);
+    std::optional<bool> flag;
+    std::string_view unexpected;
+  };
 
   data_view::pointer _iter;
   data_view::pointer _end;
@@ -127,11 +463,16 @@ struct store : base_store::impl<store> {
 
   std::vector<ast::user_function_call*> _unknown_calls;
 
-  template <type_expectation... expect_types>
-  void assert_type(type_expectation type, std::string message) {
-    if (type != type_expectation::any && ((type != expect_types) && ...)) {
-      throw read_error{std::move(message)};
+  bool _has_directory{false};
+  std::vector<function_definition> _directory;
+  size_t _next_signature{0};
+
+  std::vector<ast::node> read_nodes(type_expectation type) {
+    auto nodes{read_vector(type)};
+    if (nodes.size() == 0) {
+      throw read_error{"No data is read!"};
     }
+    return nodes;
   }
 
   std::string_view read_zero_terminated() {
@@ -190,408 +531,213 @@ struct store : base_store::impl<store> {
   }
 
   ast::node read_node(type_expectation type) {
-    static const std::unordered_map<std::string_view, read_node_entry>
-        read_node_map{
-            {key::program, &store::read_program},
-            {key::on_start, &store::read_on_start},
-            {key::function, &store::read_function},
-            {key::function_signature, &store::read_function_signature},
-            {key::eval_statement, &store::read_eval},
-            {key::assignment, &store::read_assignment},
-            {key::use_global, &store::read_use_global},
-            {key::modify_array, &store::read_array_modification},
-            {key::system_procedure, &store::read_system_procedure},
-            {key::if_else, &store::read_if_else},
-            {key::while_loop, &store::read_while},
-            {key::for_loop, &store::read_for},
-            {key::break_statement, &store::read_break},
-            {key::continue_statement, &store::read_continue},
-            {key::return_statement, &store::read_return},
-            {key::placeholder, &store::read_placeholder},
-            {key::identifier, &store::read_identifier},
-            {key::unary, &store::read_unary_expression},
-            {key::binary, &store::read_binary_expression},
-            {key::subscript, &store::read_subscript},
-            {key::new_array, &store::read_new_array},
-            {key::new_color, &store::read_new_color},
-            {key::system_function, &store::read_system_function},
-            {key::user_function, &store::read_user_function},
-            {key::number, &store::read_number_literal},
-            {key::string, &store::read_string_literal},
-            {key::boolean, &store::read_bool_literal}};
-
-    const auto it{read_node_map.find(read_zero_terminated())};
-    if (it == read_node_map.end()) {
+    static constexpr std::array node_entries{
+        ASTS(_STORE_NODE_ENTRY_TEMPLATE)};
+    static constexpr schema::key_table<node_entries.size()> keys{
+        {ASTS(_STORE_KEY_TEMPLATE)}};
+
+    const auto [begin, end]{keys.equal_range(read_zero_terminated())};
+    if (begin == end) {
       throw read_error{"Unknown node key encountered!"};
-    } else {
-      auto node{(this->*(it->second))(type)};
-      return node;
     }
-  }
-
-  ast::node read_program(type_expectation type) {
-    assert_type<type_expectation::program>(type, "Unexpected program!");
 
-    auto blocks{read_vector(type_expectation::block)};
-    return ast::make<ast::program>(std::move(blocks));
-  }
-
-  ast::node read_on_start(type_expectation type) {
-    assert_type<type_expectation::block>(type, "Unexpected block!");
-    auto statements{read_vector(type_expectation::statement)};
-    return ast::make<ast::on_start>(std::move(statements));
-  }
-
-  ast::node read_function_signature(type_expectation type) {
-    assert_type<type_expectation::function_signature>(type,
-                                                      "Unexpected function!");
-
-    std::string name{read_string()};
-    auto params{read_vector(type_expectation::parameter)};
-
-    if (_functions->has_function(name) ||
-        _new_functions.find(name) != _new_functions.end()) {
-      throw read_error{"Repeated function name encountered!"};
-    } else {
-      std::vector<std::string> param_names;
-      size_t index{0};
-      std::unordered_set<std::string_view> name_collection;
-      while (index < params.size()) {
-        if (params[index]->is<ast::parameter>()) {
-          std::string_view param_name{params[index]->as<ast::parameter>().name};
-          if (name_collection.find(param_name) == name_collection.end()) {
-            name_collection.emplace(param_name);
-            param_names.emplace_back(std::string{param_name});
-            index++;
-          } else {
-            params.erase(params.begin() + index);
-          }
-        } else {
-          throw read_error{"Unexpected node, expecting function parameter!"};
-        }
+    // Nodes sharing a key are told apart either by a stored flag or by what
+    // the node is read as, falling back to the last one when anything goes
+    auto index{begin};
+    if (node_entries[keys[begin].type].flag.has_value()) {
+      const bool flag{read_bool()};
+      while (index < end && *node_entries[keys[index].type].flag != flag) {
+        index++;
       }
-      _new_functions[name] = {name, std::move(param_names)};
-      return ast::make<ast::function_signature>(std::string{std::move(name)},
-                                                std::move(params));
-    }
-  }
-
-  ast::node read_function(type_expectation type) {
-    assert_type<type_expectation::block>(type, "Unexpected function!");
-
-    auto signature{read_node(type_expectation::function_signature)};
-    auto statements{read_vector(type_expectation::statement)};
-    return ast::make<ast::function>(std::move(signature),
-                                    std::move(statements));
-  }
-
-  ast::node read_eval(type_expectation type) {
-    assert_type<type_expectation::statement>(type, "Unexpected statement!");
-
-    auto expression{read_node(type_expectation::rvalue)};
-    return ast::make<ast::eval_statement>(std::move(expression));
-  }
-
-  ast::node read_assignment(type_expectation type) {
-    assert_type<type_expectation::statement>(type, "Unexpected statement!");
-
-    auto variable{read_node(type_expectation::lvalue)};
-    auto value{read_node(type_expectation::rvalue)};
-    return ast::make<ast::assignment>(std::move(variable), std::move(value));
-  }
-
-  ast::node read_use_global(type_expectation type) {
-    assert_type<type_expectation::statement>(type, "Unexpected statement!");
-
-    auto variable{read_node(type_expectation::lvalue)};
-    return ast::make<ast::use_global>(std::move(variable));
-  }
-
-  ast::node read_array_modification(type_expectation type) {
-    assert_type<type_expectation::statement>(type, "Unexpected statement!");
-
-    static const auto array_modification_inverse_name_map{[]() {
-      std::unordered_map<std::string_view, ast::array_modification> map;
-      for (std::underlying_type_t<ast::array_modification> i{0};
-           i < ast::array_modification_name_map.size(); i++) {
-        map[ast::array_modification_name_map[i]] = {i};
+      if (index == end) {
+        throw read_error{"Unknown node variant encountered!"};
       }
-      return map;
-    }()};
-
-    auto name{read_zero_terminated()};
-    auto it{array_modification_inverse_name_map.find(name)};
-    if (it == array_modification_inverse_name_map.end()) {
-      throw read_error{"Unknown system function encountered!"};
+    } else if (type == type_expectation::any) {
+      index = end - 1;
     } else {
-      const auto mod{it->second};
-      auto array{read_node(type_expectation::lvalue)};
-      auto args{read_vector(type_expectation::rvalue)};
-      return ast::make<ast::modify_array>(mod, std::move(array),
-                                          std::move(args));
-    }
-  }
-
-  ast::node read_system_procedure(type_expectation type) {
-    assert_type<type_expectation::statement>(type, "Unexpected statement!");
-
-    static const auto system_procedure_inverse_name_map{[]() {
-      std::unordered_map<std::string_view, ast::system_procedure> map;
-      for (std::underlying_type_t<ast::system_procedure> i{0};
-           i < ast::system_procedure_name_map.size(); i++) {
-        map[ast::system_procedure_name_map[i]] = {i};
+      while (index < end && !node_entries[keys[index].type].accepts(type)) {
+        index++;
+      }
+      if (index == end) {
+        throw read_error{
+            std::string{node_entries[keys[begin].type].unexpected}};
       }
-      return map;
-    }()};
-
-    auto name{read_zero_terminated()};
-    auto it{system_procedure_inverse_name_map.find(name)};
-    if (it == system_procedure_inverse_name_map.end()) {
-      throw read_error{"Unknown system function encountered!"};
-    } else {
-      const auto proc{it->second};
-      auto args{read_vector(type_expectation::rvalue)};
-      return ast::make<ast::system_procedure_call>(proc, std::move(args));
     }
-  }
-
-  ast::node read_if_else(type_expectation type) {
-    assert_type<type_expectation::statement>(type, "Unexpected statement!");
 
-    const bool has_else{read_bool()};
-    auto condition{read_node(type_expectation::rvalue)};
-    auto consequence{read_vector(type_expectation::statement)};
-    if (has_else) {
-      auto alternate{read_vector(type_expectation::statement)};
-      return ast::make<ast::if_else_statement>(
-          std::move(condition), std::move(consequence), std::move(alternate));
-    } else {
-      return ast::make<ast::if_statement>(std::move(condition),
-                                          std::move(consequence));
+    const auto& entry{node_entries[keys[index].type]};
+    if (type != type_expectation::any && !entry.accepts(type)) {
+      throw read_error{std::string{entry.unexpected}};
     }
+    return (this->*entry.read)();
   }
 
-  ast::node read_while(type_expectation type) {
-    assert_type<type_expectation::statement>(type, "Unexpected statement!");
+  template <typename node_type>
+  ast::node read_schema() {
+    using node_schema = schema_for<node_type>;
 
-    auto condition{read_node(type_expectation::rvalue)};
-    auto statements{read_vector(type_expectation::statement)};
-    return ast::make<ast::while_statement>(std::move(condition),
-                                           std::move(statements));
+    auto fields{read_fields(typename node_schema::fields{})};
+    auto subnodes{read_subnodes<node_type>(
+        std::make_index_sequence<node_schema::subnodes::size>{})};
+    auto node{std::apply(
+        [](auto&&... args) {
+          return node_schema::make(std::forward<decltype(args)>(args)...);
+        },
+        std::tuple_cat(std::move(fields), std::move(subnodes)))};
+    did_read(node->template as<node_type>());
+    return node;
   }
 
-  ast::node read_for(type_expectation type) {
-    assert_type<type_expectation::statement>(type, "Unexpected statement!");
-
-    auto variable{read_node(type_expectation::lvalue)};
-    auto list{read_node(type_expectation::rvalue)};
-    auto statements{read_vector(type_expectation::statement)};
-    return ast::make<ast::for_statement>(std::move(variable), std::move(list),
-                                         std::move(statements));
+  // The flag has been consumed while looking up the node
+  template <bool value, typename... field_types>
+  auto read_fields(schema::fields<schema::flag<value>, field_types...>) {
+    return read_fields(schema::fields<field_types...>{});
   }
 
-  ast::node read_break(type_expectation type) {
-    assert_type<type_expectation::statement>(type, "Unexpected statement!");
-    return ast::make<ast::break_statement>();
+  template <typename... field_types>
+  auto read_fields(schema::fields<field_types...>) {
+    return std::tuple<decltype(read_field(field_types{}))...>{
+        read_field(field_types{})...};
   }
 
-  ast::node read_continue(type_expectation type) {
-    assert_type<type_expectation::statement>(type, "Unexpected statement!");
-    return ast::make<ast::continue_statement>();
+  template <auto member>
+  std::string read_field(schema::string<member>) {
+    return std::string{read_string()};
   }
 
-  ast::node read_return(type_expectation type) {
-    assert_type<type_expectation::statement>(type, "Unexpected statement!");
-
-    const bool has_result{read_bool()};
-    if (has_result) {
-      auto result{read_node(type_expectation::rvalue)};
-      return ast::make<ast::return_result_statement>(std::move(result));
-    } else {
-      return ast::make<ast::return_statement>();
-    }
+  template <auto member>
+  bool read_field(schema::boolean<member>) {
+    return read_bool();
   }
 
-  ast::node read_placeholder(type_expectation type) {
-    assert_type<type_expectation::lvalue, type_expectation::function_signature,
-                type_expectation::rvalue>(type, "Unexpected placeholder!");
-
-    auto string{read_string()};
-    if (type == type_expectation::lvalue) {
-      return ast::make<ast::variable_placeholder>(
-          std::string{std::move(string)});
-    } else if (type == type_expectation::function_signature) {
-      auto params{read_vector(type_expectation::parameter)};
-      return ast::make<ast::function_placeholder>(
-          std::string{std::move(string)}, std::move(params));
+  template <auto member>
+  schema::member_t<member> read_field(schema::symbol<member>) {
+    const auto symbol{read_zero_terminated()};
+    if (const auto value{schema::find_symbol<schema::member_t<member>>(symbol)};
+        value.has_value()) {
+      return *value;
     } else {
-      return ast::make<ast::expression_placeholder>(
-          std::string{std::move(string)});
+      throw read_error{"Unknown symbol encountered!"};
     }
   }
 
-  ast::node read_identifier(type_expectation type) {
-    assert_type<type_expectation::lvalue, type_expectation::rvalue,
-                type_expectation::parameter>(type, "Unexpected identifier!");
-
-    auto string{read_string()};
-    if (type == type_expectation::lvalue) {
-      return ast::make<ast::variable_name>(std::string{std::move(string)});
-    } else if (type == type_expectation::rvalue) {
-      return ast::make<ast::identifier>(std::string{std::move(string)});
-    } else {
-      return ast::make<ast::parameter>(std::string{std::move(string)});
-    }
+  template <typename node_type, size_t... indices>
+  auto read_subnodes(std::index_sequence<indices...>) {
+    return std::tuple<decltype(read_subnode<node_type, indices>())...>{
+        read_subnode<node_type, indices>()...};
   }
 
-  ast::node read_subscript(type_expectation type) {
-    assert_type<type_expectation::lvalue, type_expectation::rvalue>(
-        type, "Unexpected identifier!");
-
-    auto list{read_node(type)};
-    auto index{read_node(type_expectation::rvalue)};
-    if (type == type_expectation::lvalue) {
-      return ast::make<ast::subscript_set>(std::move(list), std::move(index));
+  template <typename node_type, size_t index>
+  auto read_subnode() {
+    constexpr auto type{schema_for<node_type>::subnodes::values[index]};
+    if constexpr (schema::subnodes_of<node_type>::template is_vector<index>) {
+      return read_vector(type);
     } else {
-      return ast::make<ast::subscript_get>(std::move(list), std::move(index));
+      return read_node(type);
     }
   }
 
-  ast::node read_unary_expression(type_expectation type) {
-    assert_type<type_expectation::rvalue>(type, "Unexpected expression!");
+  template <typename node_type>
+  void did_read(node_type&) {}
 
-    static const auto unary_inverse_op_symbol_map{[]() {
-      std::unordered_map<std::string_view, ast::unary_op> map;
-      for (std::underlying_type_t<ast::unary_op> i{0};
-           i < ast::unary_op_symbol_map.size(); i++) {
-        map[ast::unary_op_symbol_map[i]] = {i};
+  void did_read(ast::function_signature& signature) {
+    if (_has_directory) {
+      // Signatures come in the same order as the directory
+      if (_next_signature == _directory.size() ||
+          !matches(_directory[_next_signature++], signature)) {
+        throw read_error{"Function directory does not match!"};
       }
-      return map;
-    }()};
-
-    auto op_symbol{read_zero_terminated()};
-    auto it{unary_inverse_op_symbol_map.find(op_symbol)};
-    if (it == unary_inverse_op_symbol_map.end()) {
-      throw read_error{"Unknown unary operator encountered!"};
-    } else {
-      const auto op{it->second};
-      auto argument{read_node(type_expectation::rvalue)};
-      return ast::make<ast::unary_expression>(op, std::move(argument));
+      return;
     }
-  }
 
-  ast::node read_binary_expression(type_expectation type) {
-    assert_type<type_expectation::rvalue>(type, "Unexpected expression!");
-
-    static const auto binary_inverse_op_symbol_map{[]() {
-      std::unordered_map<std::string_view, ast::binary_op> map;
-      for (std::underlying_type_t<ast::binary_op> i{0};
-           i < ast::binary_op_symbol_map.size(); i++) {
-        map[ast::binary_op_symbol_map[i]] = {i};
-      }
-      return map;
-    }()};
+    if (_functions->has_function(signature.name) ||
+        _new_functions.find(signature.name) != _new_functions.end()) {
+      throw read_error{"Repeated function name encountered!"};
+    }
 
-    auto op_symbol{read_zero_terminated()};
-    auto it{binary_inverse_op_symbol_map.find(op_symbol)};
-    if (it == binary_inverse_op_symbol_map.end()) {
-      throw read_error{"Unknown binary operator encountered!"};
-    } else {
-      const auto op{it->second};
-      auto left{read_node(type_expectation::rvalue)};
-      auto right{read_node(type_expectation::rvalue)};
-      return ast::make<ast::binary_expression>(std::move(left), op,
-                                               std::move(right));
+    std::vector<std::string> param_names;
+    for (const auto& param : signature.parameters()) {
+      param_names.emplace_back(param->as<ast::parameter>().name);
     }
+    _new_functions[signature.name] = {signature.name, std::move(param_names)};
   }
 
-  ast::node read_new_array(type_expectation type) {
-    assert_type<type_expectation::rvalue>(type, "Unexpected expression!");
+  void did_read(ast::user_function_call& call) {
+    if (_functions->has_function(call.name)) {
+      call.assign_definition(&_functions->get_function(call.name));
+    } else if (!_has_directory) {
+      _unknown_calls.emplace_back(&call);
+    }
+  }
 
-    auto args{read_vector(type_expectation::rvalue)};
-    return ast::make<ast::new_array>(std::move(args));
+  static bool matches(const function_definition& definition,
+                      const ast::function_signature& signature) {
+    const auto params{signature.parameters()};
+    return definition.name == signature.name &&
+           std::equal(definition.parameters.begin(),
+                      definition.parameters.end(), params.begin(),
+                      params.end(), [](const auto& name, const auto& param) {
+                        return name == param->template as<ast::parameter>()
+                                           .name;
+                      });
   }
+};
 
-  ast::node read_system_function(type_expectation type) {
-    assert_type<type_expectation::rvalue>(type, "Unexpected expression!");
+struct writer {
+  // With a chunk depth, boundaries are recorded around the nodes kept in
+  // vectors down to that depth below the written nodes
+  explicit writer(std::optional<std::string_view> erase_function_names,
+                  size_t chunk_depth = 0)
+      : _erase_function_names{erase_function_names},
+        _chunk_depth{chunk_depth} {}
 
-    static const auto system_function_inverse_name_map{[]() {
-      std::unordered_map<std::string_view, ast::system_function> map;
-      for (std::underlying_type_t<ast::system_function> i{0};
-           i < ast::system_function_name_map.size(); i++) {
-        map[ast::system_function_name_map[i]] = {i};
-      }
-      return map;
-    }()};
+  void write_bytes(data_view data) { write_bytes(data.begin(), data.end()); }
 
-    auto name{read_zero_terminated()};
-    auto it{system_function_inverse_name_map.find(name)};
-    if (it == system_function_inverse_name_map.end()) {
-      throw read_error{"Unknown system function encountered!"};
-    } else {
-      const auto func{it->second};
-      auto args{read_vector(type_expectation::rvalue)};
-      return ast::make<ast::system_function_call>(func, std::move(args));
+  template <typename vector_type>
+  void write_vector(const vector_type& vector) {
+    write_int(static_cast<uint32_t>(vector.size()));
+    const bool is_chunk{_level > 0 && _level <= _chunk_depth};
+    for (const auto& child : vector) {
+      if (is_chunk) {
+        _boundaries.emplace_back(_data_buffer.size());
+      }
+      write_base(*child);
+    }
+    if (is_chunk && vector.size() > 0) {
+      _boundaries.emplace_back(_data_buffer.size());
     }
   }
 
-  ast::node read_new_color(type_expectation type) {
-    assert_type<type_expectation::rvalue>(type, "Unexpected expression!");
-
-    static const auto color_mode_inverse_name_map{[]() {
-      std::unordered_map<std::string_view, ast::color_mode> map;
-      for (std::underlying_type_t<ast::color_mode> i{0};
-           i < ast::color_mode_name_map.size(); i++) {
-        map[ast::color_mode_name_map[i]] = {i};
+  // Directory of function signatures read back by read_directory
+  void write_directory(
+      const std::vector<const ast::function_signature*>& signatures) {
+    write_int(static_cast<uint32_t>(signatures.size()));
+    for (const auto* signature : signatures) {
+      write_string(signature->name);
+      write_int(static_cast<uint32_t>(signature->parameters().size()));
+      for (const auto& param : signature->parameters()) {
+        write_string(param->as<ast::parameter>().name);
       }
-      return map;
-    }()};
-
-    auto name{read_zero_terminated()};
-    auto it{color_mode_inverse_name_map.find(name)};
-    if (it == color_mode_inverse_name_map.end()) {
-      throw read_error{"Unknown system function encountered!"};
-    } else {
-      const auto mode{it->second};
-      auto args{read_vector(type_expectation::rvalue)};
-      return ast::make<ast::new_color>(mode, std::move(args));
     }
   }
 
-  ast::node read_user_function(type_expectation type) {
-    assert_type<type_expectation::rvalue>(type, "Unexpected expression!");
-
-    std::string name{read_string()};
-    auto args{read_vector(type_expectation::rvalue)};
-    auto node{
-        ast::make<ast::user_function_call>(std::move(name), std::move(args))};
-    auto& call{node->as<ast::user_function_call>()};
-    if (_functions->has_function(name)) {
-      call.assign_definition(&_functions->get_function(name));
-      return node;
-    } else {
-      _unknown_calls.emplace_back(&call);
-      return node;
-    }
-  }
+  // Signatures written so far, in order
+  [[nodiscard]] const auto& signatures() const noexcept { return _signatures; }
 
-  ast::node read_number_literal(type_expectation type) {
-    assert_type<type_expectation::rvalue>(type, "Unexpected literal!");
+  [[nodiscard]] const auto& boundaries() const noexcept { return _boundaries; }
 
-    return ast::make<ast::number_literal>(std::string{read_string()});
-  }
+  [[nodiscard]] size_t size() const noexcept { return _data_buffer.size(); }
 
-  ast::node read_string_literal(type_expectation type) {
-    assert_type<type_expectation::rvalue>(type, "Unexpected literal!");
+  data_vector release() { return std::exchange(_data_buffer, {}); }
 
-    return ast::make<ast::string_literal>(std::string{read_string()});
-  }
+ private:
+  data_vector _data_buffer;
+  std::optional<std::string_view> _erase_function_names;
 
-  ast::node read_bool_literal(type_expectation type) {
-    assert_type<type_expectation::rvalue>(type, "Unexpected literal!");
+  std::vector<const ast::function_signature*> _signatures;
 
-    return ast::make<ast::bool_literal>(read_bool());
-  }
+  size_t _chunk_depth;
+  size_t _level{0};
+  std::vector<size_t> _boundaries;
 
   void write_byte(uint8_t byte) { _data_buffer.emplace_back(std::byte{byte}); }
 
@@ -605,8 +751,6 @@ struct store : base_store::impl<store> {
                         reinterpret_cast<const std::byte*>(end));
   }
 
-  void write_bytes(data_view data) { write_bytes(data.begin(), data.end()); }
-
   void write_bytes(std::string_view string) {
     write_bytes(string.begin(), string.end());
   }
@@ -637,32 +781,20 @@ struct store : base_store::impl<store> {
     write_bytes(value.begin(), value.end());
   }
 
-  template <typename vector_type>
-  void write_vector(const vector_type& vector) {
-    write_int(static_cast<uint32_t>(vector.size()));
-    for (const auto& child : vector) {
-      write_base(*child);
-    }
-  }
-
   void write_base(const ast::base& node) {
+    _level++;
     node.apply<void>([this](const auto& n) { write_node(n); });
+    _level--;
   }
 
-  void write_node(const ast::program& program) {
-    write_key(key::program);
-    write_vector(program.blocks());
-  }
+  template <typename node_type>
+  void write_node(const node_type& node) {
+    using node_schema = schema_for<node_type>;
 
-  void write_node(const ast::on_start& block) {
-    write_key(key::on_start);
-    write_vector(block.statements());
-  }
-
-  void write_node(const ast::function_placeholder& placeholder) {
-    write_key(key::placeholder);
-    write_string(placeholder.name);
-    write_vector(placeholder.parameters());
+    write_key(node_schema::key);
+    write_fields(node, typename node_schema::fields{});
+    write_subnodes(node,
+                   std::make_index_sequence<node_schema::subnodes::size>{});
   }
 
   void write_node(const ast::function_signature& signature) {
@@ -672,185 +804,85 @@ struct store : base_store::impl<store> {
     } else {
       write_key(key::function_signature);
       write_string(signature.name);
+      _signatures.emplace_back(&signature);
     }
     write_vector(signature.parameters());
   }
 
-  void write_node(const ast::parameter& param) {
-    write_key(key::identifier);
-    write_string(param.name);
+  template <typename node_type, typename... field_types>
+  void write_fields(const node_type& node, schema::fields<field_types...>) {
+    (write_field(node, field_types{}), ...);
   }
 
-  void write_node(const ast::function& function) {
-    write_key(key::function);
-    write_base(*function.signature());
-    write_vector(function.statements());
+  template <typename node_type, bool value>
+  void write_field(const node_type&, schema::flag<value>) {
+    write_bool(value);
   }
 
-  void write_node(const ast::eval_statement& eval) {
-    write_key(key::eval_statement);
-    write_base(*eval.expression());
+  template <typename node_type, auto member>
+  void write_field(const node_type& node, schema::string<member>) {
+    write_string(node.*member);
   }
 
-  void write_node(const ast::assignment& assignment) {
-    write_key(key::assignment);
-    write_base(*assignment.variable());
-    write_base(*assignment.value());
+  template <typename node_type, auto member>
+  void write_field(const node_type& node, schema::boolean<member>) {
+    write_bool(node.*member);
   }
 
-  void write_node(const ast::use_global& use_global) {
-    write_key(key::use_global);
-    write_base(*use_global.variable());
+  template <typename node_type, auto member>
+  void write_field(const node_type& node, schema::symbol<member>) {
+    write_symbol(schema::name_of(node.*member));
   }
 
-  void write_node(const ast::modify_array& call) {
-    write_key(key::modify_array);
-    write_symbol(ast::name_for(call.mod));
-    write_base(*call.array());
-    write_vector(call.arguments());
+  template <typename node_type, size_t... indices>
+  void write_subnodes(const node_type& node, std::index_sequence<indices...>) {
+    (write_subnode(node.template get_subnode<indices>()), ...);
   }
 
-  void write_node(const ast::system_procedure_call& call) {
-    write_key(key::system_procedure);
-    write_symbol(ast::name_for(call.proc));
-    write_vector(call.arguments());
+  void write_subnode(ast::subnode::const_concrete_view<ast::base> subnode) {
+    write_base(*subnode);
   }
 
-  void write_node(const ast::if_statement& statement) {
-    write_key(key::if_else);
-    write_bool(false);
-    write_base(*statement.condition());
-    write_vector(statement.statements());
+  void write_subnode(ast::subnode::const_vector_view<ast::base> subnode) {
+    write_vector(subnode);
   }
+};
 
-  void write_node(const ast::if_else_statement& statement) {
-    write_key(key::if_else);
-    write_bool(true);
-    write_base(*statement.condition());
-    write_vector(statement.consequence());
-    write_vector(statement.alternate());
-  }
-
-  void write_node(const ast::while_statement& statement) {
-    write_key(key::while_loop);
-    write_base(*statement.condition());
-    write_vector(statement.statements());
-  }
-
-  void write_node(const ast::for_statement& statement) {
-    write_key(key::for_loop);
-    write_base(*statement.variable());
-    write_base(*statement.list());
-    write_vector(statement.statements());
-  }
-
-  void write_node(const ast::break_statement& statement) {
-    write_key(key::break_statement);
-  }
-
-  void write_node(const ast::continue_statement& statement) {
-    write_key(key::continue_statement);
-  }
-
-  void write_node(const ast::return_statement&) {
-    write_key(key::return_statement);
-    write_bool(false);
-  }
-
-  void write_node(const ast::return_result_statement& statement) {
-    write_key(key::return_statement);
-    write_bool(true);
-    write_base(*statement.result());
-  }
-
-  void write_node(const ast::variable_placeholder& placeholder) {
-    write_key(key::placeholder);
-    write_string(placeholder.name);
-  }
-
-  void write_node(const ast::variable_name& variable) {
-    write_key(key::identifier);
-    write_string(variable.name);
-  }
-
-  void write_node(const ast::subscript_set& subscript) {
-    write_key(key::subscript);
-    write_base(*subscript.list());
-    write_base(*subscript.index());
-  }
-
-  void write_node(const ast::expression_placeholder& placeholder) {
-    write_key(key::placeholder);
-    write_string(placeholder.name);
-  }
-
-  void write_node(const ast::unary_expression& unary) {
-    write_key(key::unary);
-    write_symbol(ast::symbol_for(unary.op));
-    write_base(*unary.argument());
-  }
-
-  void write_node(const ast::binary_expression& binary) {
-    write_key(key::binary);
-    write_symbol(ast::symbol_for(binary.op));
-    write_base(*binary.left());
-    write_base(*binary.right());
-  }
-
-  void write_node(const ast::subscript_get& subscript) {
-    write_key(key::subscript);
-    write_base(*subscript.list());
-    write_base(*subscript.index());
-  }
-
-  void write_node(const ast::new_array& init) {
-    write_key(key::new_array);
-    write_vector(init.elements());
-  }
-
-  void write_node(const ast::new_color& init) {
-    write_key(key::new_color);
-    write_symbol(ast::name_for(init.mode));
-    write_vector(init.arguments());
-  }
-
-  void write_node(const ast::system_function_call& call) {
-    write_key(key::system_function);
-    write_symbol(ast::name_for(call.func));
-    write_vector(call.arguments());
-  }
-
-  void write_node(const ast::user_function_call& call) {
-    write_key(key::user_function);
-    write_string(call.name);
-    write_vector(call.arguments());
+struct store : base_store::impl<store> {
+  bool recognize(data_view data) const override {
+    return data.size() >= data_prefix().size() &&
+           std::equal(data.begin(), data.begin() + data_prefix().size(),
+                      data_prefix().begin(), data_prefix().end());
   }
 
-  void write_node(const ast::identifier& identifier) {
-    write_key(key::identifier);
-    write_string(identifier.name);
-  }
+  std::vector<ast::node> read(
+      data_view data, type_expectation type,
+      user_function_table_interface& table) const override {
+    assert(recognize(data));
 
-  void write_node(const ast::number_literal& literal) {
-    write_key(key::number);
-    write_string(literal.value);
+    reader r{data.begin() + data_prefix().size(), data.end(), table};
+    return r.read(type);
   }
 
-  void write_node(const ast::string_literal& literal) {
-    write_key(key::string);
-    write_string(literal.value);
+  data_vector write(
+      std::vector<const ast::base*> nodes,
+      std::optional<std::string_view> erase_function_names) const {
+    writer w{erase_function_names};
+    w.write_bytes(data_prefix());
+    w.write_vector(nodes);
+    return w.release();
   }
 
-  void write_node(const ast::bool_literal& literal) {
-    write_key(key::boolean);
-    write_bool(literal.value);
+ private:
+  static data_view data_prefix() {
+    static const data_vector _data{std::byte{'M'}, std::byte{'K'},
+                                   std::byte{'B'}, std::byte{1}};
+    return _data;
   }
-};  // namespace v1
+};
 
 }  // namespace v1
 
-using latest_store = v1::store;
-
 }  // namespace marlin::store
 
 #endif  // marlin_store_v1_store_hpp
@@ -0,0 +1,84 @@
+#ifndef marlin_store_v2_store_hpp
+#define marlin_store_v2_store_hpp
+
+#include <algorithm>
+
+#include "store_definition.hpp"
+#include "v1_store.hpp"
+
+namespace marlin::store {
+
+namespace v2 {
+
+// Nodes are stored as in version 1, preceded by a directory of every function
+// signature so that user calls are bound while they are decoded
+struct store : base_store::impl<store> {
+  bool recognize(data_view data) const override {
+    return data.size() >= data_prefix().size() &&
+           std::equal(data.begin(), data.begin() + data_prefix().size(),
+                      data_prefix().begin(), data_prefix().end());
+  }
+
+  std::vector<ast::node> read(
+      data_view data, type_expectation type,
+      user_function_table_interface& table) const override {
+    return reader(data, table).read(type);
+  }
+
+  data_vector write(
+      std::vector<const ast::base*> nodes,
+      std::optional<std::string_view> erase_function_names) const {
+    return write(std::move(nodes), erase_function_names, 0).data;
+  }
+
+  chunked_data write_chunks(std::vector<const ast::base*> nodes,
+                            size_t depth) const {
+    return write(std::move(nodes), std::nullopt, depth);
+  }
+
+  // Reader positioned after the directory
+  v1::reader reader(data_view data,
+                    user_function_table_interface& table) const {
+    assert(recognize(data));
+
+    v1::reader r{data.begin() + data_prefix().size(), data.end(), table};
+    r.read_directory();
+    return r;
+  }
+
+ private:
+  chunked_data write(std::vector<const ast::base*> nodes,
+                     std::optional<std::string_view> erase_function_names,
+                     size_t chunk_depth) const {
+    v1::writer body{erase_function_names, chunk_depth};
+    body.write_vector(nodes);
+
+    v1::writer w{erase_function_names};
+    w.write_bytes(data_prefix());
+    w.write_directory(body.signatures());
+
+    const auto offset{w.size()};
+    std::vector<size_t> boundaries;
+    boundaries.reserve(body.boundaries().size());
+    for (const auto boundary : body.boundaries()) {
+      boundaries.emplace_back(offset + boundary);
+    }
+
+    w.write_bytes(body.release());
+    return {w.release(), std::move(boundaries)};
+  }
+
+  static data_view data_prefix() {
+    static const data_vector _data{std::byte{'M'}, std::byte{'K'},
+                                   std::byte{'B'}, std::byte{2}};
+    return _data;
+  }
+};
+
+}  // namespace v2
+
+using latest_store = v2::store;
+
+}  // namespace marlin::store
+
+#endif  // marlin_store_v2_store_hpp
@@ -0,0 +1,39 @@
+#ifndef marlin_test_batch_program_hpp
+#define marlin_test_batch_program_hpp
+
+#include <vector>
+
+#include "program_builders.hpp"
+
+namespace marlin::program_builders {
+
+// Built into an executable by cpp_generator for the tests, which compare
+// what it prints with the interpreter. Elements of arrays are loop
+// variables in sibling loops, over ranges and over arrays.
+inline std::vector<node> batch_program() {
+  using namespace ast;
+  const auto element{[](std::string list, std::string index) {
+    return make<subscript_set>(id(std::move(list)), number(std::move(index)));
+  }};
+  return nodes(
+      make<on_start>(nodes(
+          assign("a", make<new_array>(nodes(number("0"), number("0")))),
+          make<for_statement>(element("a", "1"),
+                              call(system_function::range1, number("3")),
+                              nodes(print(id("a")))),
+          assign("b", make<new_array>(nodes(text("-")))),
+          make<for_statement>(element("b", "0"),
+                              make<new_array>(nodes(text("x"), text("y"))),
+                              nodes(print(id("b")))),
+          make<for_statement>(element("b", "0"), id("a"),
+                              nodes(assign("total", call("add", id("b"))))),
+          print(id("total")))),
+      function_block("add", nodes(make<parameter>("list")),
+                     nodes(make<return_result_statement>(binary(
+                         make<subscript_get>(id("list"), number("0")),
+                         binary_op::add, number("10"))))));
+}
+
+}  // namespace marlin::program_builders
+
+#endif  // marlin_test_batch_program_hpp
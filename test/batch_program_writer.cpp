@@ -0,0 +1,16 @@
+#include <fstream>
+
+#include "batch_program.hpp"
+#include "cpp_generator.hpp"
+
+// Writes the C++ source of the batch program to the file given
+int main(int argc, char* argv[]) {
+  if (argc != 2) {
+    return 1;
+  }
+  marlin::program_builders::stored_program program{
+      marlin::program_builders::batch_program()};
+  std::ofstream{argv[1]} << marlin::exec::cpp_generator{}.generate(
+      program.get());
+  return 0;
+}
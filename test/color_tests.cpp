@@ -4,6 +4,7 @@
 #include "line_inserter.hpp"
 #include "source_selection.hpp"
 #include "store.hpp"
+#include "text_model.hpp"
 
 static auto make_test_document() {
   std::vector<marlin::ast::node> new_color_arguments;
@@ -54,3 +55,28 @@ TEST_CASE("control::Change color literal", "[control]") {
   REQUIRE(update[0].range.end.line == 2);
   REQUIRE(update[0].range.end.column == 40);
 }
+
+TEST_CASE("control::Change color literal by deltas", "[control]") {
+  auto result = make_test_document();
+  REQUIRE(result.has_value());
+  auto [document, init_data] = *std::move(result);
+  marlin::control::source_selection selection{document, {2, 17}};
+
+  marlin::control::color_literal new_literal{marlin::ast::color_mode::rgba};
+  new_literal.set(0.0, 128.0, 255.0, 0.8);
+  auto update{selection.set_color_literal(new_literal)};
+  REQUIRE(update.size() == 1);
+  REQUIRE(update[0].deltas.size() == 1);
+  // Only the placeholder is replaced
+  REQUIRE(update[0].deltas[0].range.begin.column == 23);
+  REQUIRE(update[0].deltas[0].range.end.column == 29);
+  REQUIRE(update[0].deltas[0].display.source == "128");
+
+  marlin::format::text_model full{init_data.display.source};
+  full.apply(update[0].range, update[0].display);
+  marlin::format::text_model by_deltas{init_data.display.source};
+  for (const auto& delta : update[0].deltas) {
+    by_deltas.apply(delta.range, delta.display);
+  }
+  REQUIRE(by_deltas.str() == full.str());
+}
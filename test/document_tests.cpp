@@ -0,0 +1,149 @@
+#include <catch2/catch.hpp>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "ast.hpp"
+#include "progressive_document.hpp"
+#include "source_selection.hpp"
+#include "store.hpp"
+#include "text_model.hpp"
+
+namespace {
+
+marlin::store::data_vector make_data(size_t function_count) {
+  std::vector<marlin::ast::node> blocks;
+  for (size_t i{0}; i < function_count; i++) {
+    std::vector<marlin::ast::node> params;
+    params.emplace_back(marlin::ast::make<marlin::ast::parameter>("x"));
+    std::vector<marlin::ast::node> statements;
+    std::vector<marlin::ast::node> args;
+    args.emplace_back(marlin::ast::make<marlin::ast::identifier>("x"));
+    // Calls the next function, defined further down
+    statements.emplace_back(marlin::ast::make<marlin::ast::eval_statement>(
+        marlin::ast::make<marlin::ast::user_function_call>(
+            "f" + std::to_string((i + 1) % function_count), std::move(args))));
+    blocks.emplace_back(marlin::ast::make<marlin::ast::function>(
+        marlin::ast::make<marlin::ast::function_signature>(
+            "f" + std::to_string(i), std::move(params)),
+        std::move(statements)));
+  }
+  blocks.emplace_back(marlin::ast::make<marlin::ast::on_start>(
+      std::vector<marlin::ast::node>{}));
+  auto program{marlin::ast::make<marlin::ast::program>(std::move(blocks))};
+  return marlin::store::write({program.get()});
+}
+
+}  // namespace
+
+TEST_CASE("control::Open documents progressively", "[control]") {
+  const auto data{make_data(40)};
+
+  auto expected{marlin::control::document::make_document(data)};
+  REQUIRE(expected.has_value());
+  const auto& expected_source{expected->second.display.source};
+
+  auto result{marlin::control::progressive_document::open(data, 5, 12)};
+  REQUIRE(result.has_value());
+  auto& [doc, first_update] = *result;
+
+  // Only the first blocks are shown at first
+  marlin::format::text_model text;
+  text.apply(first_update.range, first_update.display);
+  REQUIRE(text.line_count() > 5);
+  REQUIRE(text.line_count() < 20);
+  REQUIRE(doc.content().write().size() < data.size());
+
+  SECTION("Finish") {
+    for (const auto& update : doc.finish()) {
+      text.apply(update.range, update.display);
+    }
+    REQUIRE(doc.is_complete());
+    REQUIRE_FALSE(doc.has_failed());
+    REQUIRE(text.str() == expected_source);
+    REQUIRE(doc.content().write() == data);
+
+    // Positions match those of a document opened at once
+    const auto loc{marlin::source_loc{119, 8}};
+    const auto& node{doc.content().locate(loc)};
+    const auto& expected_node{expected->first.locate(loc)};
+    REQUIRE(node.is<marlin::ast::user_function_call>());
+    REQUIRE(expected_node.is<marlin::ast::user_function_call>());
+    REQUIRE(node.as<marlin::ast::user_function_call>().name ==
+            expected_node.as<marlin::ast::user_function_call>().name);
+    REQUIRE(node.as<marlin::ast::user_function_call>().func() != nullptr);
+  }
+
+  SECTION("Poll") {
+    while (!doc.is_complete()) {
+      for (const auto& update : doc.poll()) {
+        text.apply(update.range, update.display);
+      }
+    }
+    REQUIRE(text.str() == expected_source);
+  }
+}
+
+TEST_CASE("control::Rename parameters by deltas", "[control]") {
+  auto result{marlin::control::document::make_document(make_data(1))};
+  REQUIRE(result.has_value());
+  auto& [document, init_data]{*result};
+  const auto column{init_data.display.source.find("f0(")};
+  marlin::control::source_selection selection{
+      document, {1, column}, marlin::control::dropping_rule};
+  REQUIRE(selection.is_function_signature());
+
+  auto update{std::move(selection).replace_function_signature({"f0", {"y"}})};
+  REQUIRE(update.source_updates.size() == 1);
+  const auto& renamed{update.source_updates[0]};
+  REQUIRE(renamed.display.source == "f0(y)");
+  // Only the parameter is replaced
+  REQUIRE(renamed.deltas.size() == 1);
+  REQUIRE(renamed.deltas[0].display.source == "y");
+
+  marlin::format::text_model full{init_data.display.source};
+  full.apply(renamed.range, renamed.display);
+  marlin::format::text_model by_deltas{init_data.display.source};
+  for (const auto& delta : renamed.deltas) {
+    by_deltas.apply(delta.range, delta.display);
+  }
+  REQUIRE(by_deltas.str() == full.str());
+}
+
+TEST_CASE("control::Map generated code to the source", "[control]") {
+  auto result{marlin::control::document::make_document(make_data(1))};
+  REQUIRE(result.has_value());
+  auto& document{result->first};
+  const auto code{document.generate_executable_code()};
+  const auto& map{document.executable_source_map()};
+
+  // The function starts both the script and the source
+  const auto json{map.to_json("main.js", "main.marlin")};
+  REQUIRE(json.rfind("{\"version\":3,\"file\":\"main.js\",\"sources\":"
+                     "[\"main.marlin\"],\"names\":[],\"mappings\":\"AAAA",
+                     0) == 0);
+  REQUIRE(map.node_count() > 0);
+
+  // Frames are located after the error, those out of any node fall back to
+  // the program
+  const auto last_line{
+      static_cast<size_t>(std::count(code.begin(), code.end(), '\n'))};
+  const auto stacktrace{
+      "__func_f0@marlin:2:5\nf@other:2:5\n__main__@marlin:" +
+      std::to_string(last_line) + ":2"};
+  const auto frames{document.locate_stacktrace(stacktrace, "marlin")};
+  REQUIRE(frames.size() == 2);
+  REQUIRE(frames[0]->is<marlin::ast::user_function_call>());
+  REQUIRE(frames[1]->is<marlin::ast::program>());
+
+  // Editing frees nodes of the map, which is dropped until code is generated
+  // again
+  marlin::control::source_selection call{
+      document, frames[0]->source_code_range.begin};
+  static_cast<void>(std::move(call).remove_from_document());
+  REQUIRE(map.node_count() == 0);
+  const auto edited_frames{document.locate_stacktrace(stacktrace, "marlin")};
+  REQUIRE(edited_frames.size() == 2);
+  REQUIRE(edited_frames[0]->is<marlin::ast::program>());
+}
@@ -0,0 +1,1106 @@
+#include <catch2/catch.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "ast.hpp"
+#include "batch_program.hpp"
+#include "cpp_generator.hpp"
+#include "call_graph.hpp"
+#include "constant_folder.hpp"
+#include "generator.hpp"
+#include "interpreter.hpp"
+#include "profile.hpp"
+#include "program_builders.hpp"
+#include "stacktrace.hpp"
+#include "vm.hpp"
+
+namespace {
+
+using namespace marlin::ast;
+using namespace marlin::program_builders;
+
+struct test_program : stored_program {
+  using stored_program::stored_program;
+
+  marlin::exec::run_result run(marlin::exec::interpreter::options opts = {}) {
+    return marlin::exec::interpreter{opts}.run(get());
+  }
+
+  marlin::exec::run_result run_bytecode(marlin::exec::vm::options opts = {}) {
+    return marlin::exec::vm{opts}.run(get());
+  }
+};
+
+std::vector<std::string> printed_of(const marlin::exec::run_result& result) {
+  std::vector<std::string> messages;
+  for (const auto& printed : result.printed) {
+    messages.push_back(printed.message);
+  }
+  return messages;
+}
+
+// The bytecode VM must match the interpreter, down to the stack of errors
+void require_same_run(test_program& program, size_t max_call_depth = 1000) {
+  marlin::exec::interpreter::options interpreter_opts;
+  interpreter_opts.max_call_depth = max_call_depth;
+  marlin::exec::vm::options vm_opts;
+  vm_opts.max_call_depth = max_call_depth;
+  const auto expected{program.run(interpreter_opts)};
+  const auto result{program.run_bytecode(vm_opts)};
+
+  REQUIRE(printed_of(result) == printed_of(expected));
+  REQUIRE(result.elapsed == expected.elapsed);
+  REQUIRE(result.commands.size() == expected.commands.size());
+  for (size_t i{0}; i < result.commands.size(); i++) {
+    REQUIRE(result.commands[i].type == expected.commands[i].type);
+    REQUIRE(result.commands[i].arguments == expected.commands[i].arguments);
+    REQUIRE(result.commands[i].color == expected.commands[i].color);
+  }
+  REQUIRE(result.error.has_value() == expected.error.has_value());
+  if (expected.error) {
+    REQUIRE(result.error->name() == expected.error->name());
+    REQUIRE(std::string{result.error->what()} == expected.error->what());
+    REQUIRE(result.error->stack() == expected.error->stack());
+  }
+}
+
+// Nodes found at each location of the generated JavaScript
+std::vector<const base*> js_locations(const std::string& source,
+                                      const marlin::exec::source_map& map) {
+  std::vector<const base*> result;
+  size_t line{1};
+  size_t column{1};
+  for (auto c : source) {
+    result.push_back(map.locate({line, column}));
+    if (c == '\n') {
+      line++;
+      column = 1;
+    } else {
+      column++;
+    }
+  }
+  return result;
+}
+
+}  // namespace
+
+TEST_CASE("exec::Convert numbers like JavaScript", "[exec]") {
+  using marlin::exec::number_to_string;
+  using marlin::exec::string_to_number;
+
+  REQUIRE(number_to_string(42) == "42");
+  REQUIRE(number_to_string(-0.0) == "0");
+  REQUIRE(number_to_string(0.1 + 0.2) == "0.30000000000000004");
+  REQUIRE(number_to_string(1.0 / 3) == "0.3333333333333333");
+  REQUIRE(number_to_string(1e21) == "1e+21");
+  REQUIRE(number_to_string(123e-20) == "1.23e-18");
+  REQUIRE(number_to_string(0.000001) == "0.000001");
+  REQUIRE(number_to_string(1e-7) == "1e-7");
+  REQUIRE(number_to_string(std::pow(2, 60)) == "1152921504606847000");
+  REQUIRE(number_to_string(NAN) == "NaN");
+  REQUIRE(number_to_string(-INFINITY) == "-Infinity");
+
+  REQUIRE(string_to_number(" 12.5\n") == 12.5);
+  REQUIRE(string_to_number("") == 0);
+  REQUIRE(string_to_number("0x1F") == 31);
+  REQUIRE(string_to_number("-Infinity") == -INFINITY);
+  REQUIRE(std::isnan(string_to_number("12px")));
+  REQUIRE(std::isnan(string_to_number("1e")));
+  REQUIRE(std::isnan(string_to_number("-0x1")));
+}
+
+TEST_CASE("exec::Run programs natively", "[exec]") {
+  SECTION("Operators follow JavaScript") {
+    test_program program{nodes(make<on_start>(nodes(
+        print(binary(number("1"), binary_op::add, number("2"))),
+        print(binary(text("a"), binary_op::add, number("1.50"))),
+        print(binary(number("2"), binary_op::less, text("10"))),
+        print(binary(text("2"), binary_op::less, text("10"))),
+        print(binary(number("1"), binary_op::equal, text("1"))),
+        print(binary(number("0"), binary_op::logical_or, text("b"))),
+        print(make<unary_expression>(unary_op::logical_not, text(""))))))};
+    const auto result{program.run()};
+    REQUIRE_FALSE(result.error);
+    REQUIRE(printed_of(result) == std::vector<std::string>{
+                                      "3", "a1.5", "true", "false", "false",
+                                      "b", "true"});
+  }
+
+  SECTION("Loops consume ranges") {
+    test_program program{nodes(make<on_start>(nodes(
+        assign("sum", number("0")),
+        make<for_statement>(
+            var("i"),
+            call(system_function::range2, number("1"), number("5")),
+            nodes(assign("sum", binary(id("sum"), binary_op::add, id("i"))))),
+        assign("r", call(system_function::range3, number("10"), number("0"),
+                         number("-3"))),
+        make<for_statement>(var("j"), id("r"),
+                            nodes(print(id("j")), make<break_statement>())),
+        make<for_statement>(var("j"), id("r"), nodes(print(id("j")))),
+        print(id("sum")))))};
+    const auto result{program.run()};
+    REQUIRE_FALSE(result.error);
+    // Leaving the loop early closes the range
+    REQUIRE(printed_of(result) == std::vector<std::string>{"10", "10"});
+  }
+
+  SECTION("Arrays grow and shrink") {
+    test_program program{nodes(make<on_start>(nodes(
+        assign("a", make<new_array>(nodes(number("1"), number("2")))),
+        make<modify_array>(array_modification::append, id("a"),
+                           nodes(number("3"))),
+        make<assignment>(make<subscript_set>(id("a"), number("5")),
+                         number("6")),
+        print(id("a")),
+        make<modify_array>(array_modification::insert, id("a"),
+                           nodes(number("-1"), text("x"))),
+        make<modify_array>(array_modification::remove, id("a"),
+                           nodes(number("0"))),
+        print(id("a")),
+        print(call(system_function::list_length, id("a"))),
+        print(make<subscript_get>(id("a"), text("1"))))))};
+    const auto result{program.run()};
+    REQUIRE_FALSE(result.error);
+    REQUIRE(printed_of(result) ==
+            std::vector<std::string>{"1,2,3,,,6", "2,3,,,x,6", "6", "3"});
+  }
+
+  SECTION("Functions and globals") {
+    auto recursion{call("triple_fact",
+                        binary(id("n"), binary_op::subtract, number("1")))};
+    test_program program{nodes(
+        make<on_start>(nodes(make<use_global>(var("scale")),
+                             assign("scale", number("3")),
+                             print(call("triple_fact", number("5"))))),
+        function_block(
+            "triple_fact", nodes(make<parameter>("n")),
+            nodes(make<if_statement>(
+                      binary(id("n"), binary_op::less_equal, number("1")),
+                      nodes(make<return_result_statement>(id("scale")))),
+                  make<return_result_statement>(binary(
+                      id("n"), binary_op::multiply, std::move(recursion))))))};
+    const auto result{program.run()};
+    REQUIRE_FALSE(result.error);
+    REQUIRE(printed_of(result) == std::vector<std::string>{"360"});
+  }
+
+  SECTION("Graphics calls are recorded") {
+    using marlin::exec::graphics_command;
+
+    test_program program{nodes(make<on_start>(nodes(
+        call(system_procedure::clear_canvas,
+             make<new_color>(color_mode::rgb,
+                             nodes(number("300"), number("0"),
+                                   number("0.5")))),
+        call(system_procedure::set_fill_color,
+             make<new_color>(color_mode::hsl,
+                             nodes(number("120"), number("0.5"),
+                                   number("2")))),
+        call(system_procedure::logo_forward, number("10")),
+        call(system_procedure::logo_turn_right, number("90")),
+        call(system_procedure::logo_pen_up),
+        call(system_procedure::logo_forward, number("10")),
+        call(system_procedure::logo_go_home))))};
+    const auto result{program.run()};
+    REQUIRE_FALSE(result.error);
+    REQUIRE(result.commands.size() == 3);
+    REQUIRE(result.commands[0].type == graphics_command::kind::clear_canvas);
+    REQUIRE(result.commands[0].color == "rgb(255,0,0.5)");
+    REQUIRE(result.commands[1].color == "hsl(120,50%,100%)");
+
+    // The turtle starts facing up the screen, where y decreases
+    const auto& line{result.commands[2]};
+    REQUIRE(line.type == graphics_command::kind::draw_line);
+    REQUIRE(line.arguments[2] == Approx(0).margin(1e-9));
+    REQUIRE(line.arguments[3] == Approx(-10));
+  }
+
+  SECTION("Sleeping moves the clock without waiting") {
+    marlin::exec::interpreter::options opts;
+    opts.environment.start_time = 100;
+
+    test_program program{nodes(make<on_start>(
+        nodes(call(system_procedure::sleep, number("3600")),
+              print(call(system_function::time)),
+              call(system_procedure::sleep, number("-1")),
+              call(system_procedure::draw_rect, number("0"), number("0"),
+                   number("1"), number("1")))))};
+    const auto result{program.run(opts)};
+    REQUIRE_FALSE(result.error);
+    REQUIRE(result.elapsed == 3600);
+    REQUIRE(printed_of(result) == std::vector<std::string>{"3700"});
+    REQUIRE(result.printed[0].time == 3600);
+    REQUIRE(result.commands[0].time == 3600);
+  }
+}
+
+TEST_CASE("exec::Report errors of programs", "[exec]") {
+  SECTION("Runtime errors keep their stack") {
+    test_program program{nodes(
+        make<on_start>(nodes(print(text("before")),
+                             print(call("root", text("four"))),
+                             print(text("after")))),
+        function_block("root", nodes(make<parameter>("x")),
+                       nodes(make<return_result_statement>(
+                           call(system_function::sqrt, id("x"))))))};
+    const auto result{program.run()};
+    REQUIRE(printed_of(result) == std::vector<std::string>{"before"});
+    REQUIRE(result.error);
+    REQUIRE(result.error->name() == "TypeError");
+    REQUIRE(std::string{result.error->what()} == "Expecting a number");
+
+    const auto& stack{result.error->stack()};
+    REQUIRE(stack.size() == 2);
+    REQUIRE(stack[0]->is<system_function_call>());
+    REQUIRE(stack[1]->is<user_function_call>());
+    const auto& main{program.get().blocks()[0]->as<on_start>()};
+    REQUIRE(&stack[1]->parent() == main.statements()[1].get());
+  }
+
+  SECTION("Locals must be assigned in their block") {
+    test_program program{nodes(make<on_start>(nodes(print(id("missing")))))};
+    const auto result{program.run()};
+    REQUIRE(result.error);
+    REQUIRE(result.error->name() == "ReferenceError");
+    REQUIRE(result.error->stack()[0]->is<identifier>());
+  }
+
+  SECTION("Limits stop runaway programs") {
+    test_program recursion{nodes(
+        make<on_start>(nodes(make<eval_statement>(call("loop")))),
+        function_block("loop", {},
+                       nodes(make<eval_statement>(call("loop")))))};
+    marlin::exec::interpreter::options opts;
+    opts.max_call_depth = 50;
+    const auto overflow{recursion.run(opts)};
+    REQUIRE(overflow.error);
+    REQUIRE(overflow.error->name() == "RangeError");
+    REQUIRE(overflow.error->stack().size() == 51);
+
+    test_program spin{nodes(make<on_start>(nodes(make<while_statement>(
+        make<bool_literal>(true), nodes(assign("x", number("1")))))))};
+    opts.max_steps = 1000;
+    const auto steps{spin.run(opts)};
+    REQUIRE(steps.error);
+    REQUIRE(steps.error->name() == "RangeError");
+  }
+
+  SECTION("Generation errors are reported before running") {
+    test_program program{nodes(make<on_start>(
+        nodes(print(text("never")),
+              print(make<expression_placeholder>("value")))))};
+    REQUIRE_THROWS_AS(program.run(),
+                      marlin::exec::collected_generation_error);
+
+    const auto results{marlin::exec::run_in_parallel({&program.get()})};
+    REQUIRE(results.size() == 1);
+    REQUIRE(results[0].printed.empty());
+    REQUIRE(results[0].error->name() == "SyntaxError");
+    REQUIRE(results[0].error->stack()[0]->is<expression_placeholder>());
+  }
+}
+
+TEST_CASE("exec::Run bytecode like the interpreter", "[exec]") {
+  SECTION("Expressions and conditions") {
+    test_program program{nodes(make<on_start>(nodes(
+        assign("a", number("3")), assign("b", text("4")),
+        print(binary(id("a"), binary_op::add, id("b"))),
+        print(binary(id("a"), binary_op::divide, number("0"))),
+        print(make<unary_expression>(unary_op::negative, id("b"))),
+        assign("c", binary(id("a"), binary_op::logical_and, id("b"))),
+        assign("a", binary(id("a"), binary_op::logical_or, id("c"))),
+        print(id("c")), print(id("a")),
+        make<if_else_statement>(
+            binary(id("a"), binary_op::greater_equal, id("b")),
+            nodes(print(text("no"))), nodes(print(text("yes")))),
+        make<if_statement>(
+            make<unary_expression>(
+                unary_op::logical_not,
+                binary(id("b"), binary_op::not_equal, text("4"))),
+            nodes(print(text("equal")))))))};
+    require_same_run(program);
+  }
+
+  SECTION("Loops") {
+    test_program program{nodes(make<on_start>(nodes(
+        assign("n", number("0")), assign("sum", number("0")),
+        make<while_statement>(
+            binary(id("n"), binary_op::less, number("10")),
+            nodes(assign("n", binary(id("n"), binary_op::add, number("1"))),
+                  make<if_statement>(
+                      binary(id("n"), binary_op::equal, number("3")),
+                      nodes(make<continue_statement>())),
+                  make<if_statement>(
+                      binary(id("n"), binary_op::greater, number("7")),
+                      nodes(make<break_statement>())),
+                  assign("sum", binary(id("sum"), binary_op::add, id("n"))))),
+        print(id("sum")),
+        make<for_statement>(
+            var("i"),
+            call(system_function::range3, number("0"), number("1"),
+                 number("0.25")),
+            nodes(print(id("i")))),
+        assign("r", call(system_function::range1, number("4"))),
+        make<for_statement>(var("i"), id("r"),
+                            nodes(make<break_statement>())),
+        make<for_statement>(var("i"), id("r"), nodes(print(id("i")))),
+        make<for_statement>(var("ch"), text("añb"), nodes(print(id("ch")))),
+        assign("list", make<new_array>(nodes(number("1"), number("2")))),
+        make<for_statement>(
+            var("x"), id("list"),
+            nodes(make<modify_array>(array_modification::append, id("list"),
+                                     nodes(id("x"))),
+                  make<if_statement>(
+                      binary(call(system_function::list_length, id("list")),
+                             binary_op::greater, number("5")),
+                      nodes(make<break_statement>())))),
+        print(id("list")))))};
+    require_same_run(program);
+  }
+
+  SECTION("Calls and subscripts") {
+    auto fib_left{call("fib", binary(id("n"), binary_op::subtract,
+                                     number("1")))};
+    auto fib_right{call("fib", binary(id("n"), binary_op::subtract,
+                                      number("2")))};
+    test_program program{nodes(
+        make<on_start>(nodes(
+            make<use_global>(var("calls")), assign("calls", number("0")),
+            assign("a", make<new_array>(nodes(number("0"), number("0")))),
+            make<for_statement>(
+                var("i"), call(system_function::range1, number("2")),
+                nodes(make<assignment>(
+                    make<subscript_set>(id("a"), id("i")),
+                    call("fib", binary(id("i"), binary_op::add,
+                                       number("10")))))),
+            print(id("a")),
+            print(make<subscript_get>(id("a"), number("1"))),
+            print(make<subscript_get>(id("a"), number("9"))),
+            print(id("calls")),
+            make<eval_statement>(call("draw", number("3"))))),
+        function_block(
+            "fib", nodes(make<parameter>("n")),
+            nodes(make<use_global>(var("calls")),
+                  assign("calls",
+                         binary(id("calls"), binary_op::add, number("1"))),
+                  make<if_statement>(
+                      binary(id("n"), binary_op::less, number("2")),
+                      nodes(make<return_result_statement>(id("n")))),
+                  make<return_result_statement>(binary(
+                      std::move(fib_left), binary_op::add,
+                      std::move(fib_right))))),
+        function_block(
+            "draw", nodes(make<parameter>("sides")),
+            nodes(make<for_statement>(
+                      var("i"), call(system_function::range1, id("sides")),
+                      nodes(call(system_procedure::logo_forward, number("10")),
+                            call(system_procedure::logo_turn_left,
+                                 number("120")),
+                            make<return_statement>())),
+                  print(text("unreachable")))))};
+    require_same_run(program);
+  }
+
+  SECTION("Errors") {
+    test_program type_error{nodes(
+        make<on_start>(nodes(print(call("root", text("four"))))),
+        function_block("root", nodes(make<parameter>("x")),
+                       nodes(make<return_result_statement>(
+                           call(system_function::sqrt, id("x"))))))};
+    require_same_run(type_error);
+
+    test_program subscript_error{nodes(make<on_start>(nodes(
+        assign("a", number("1")),
+        make<assignment>(make<subscript_set>(id("a"), number("0")),
+                         id("missing")))))};
+    require_same_run(subscript_error);
+
+    test_program reference_error{nodes(make<on_start>(nodes(
+        make<if_statement>(make<bool_literal>(false),
+                           nodes(assign("x", number("1")))),
+        print(id("x")))))};
+    require_same_run(reference_error);
+
+    test_program recursion{nodes(
+        make<on_start>(nodes(make<eval_statement>(call("loop")))),
+        function_block("loop", {},
+                       nodes(make<eval_statement>(call("loop")))))};
+    require_same_run(recursion, 50);
+    require_same_run(recursion);
+  }
+
+  SECTION("Locals start undefined in every call") {
+    test_program program{nodes(
+        make<on_start>(nodes(
+            make<eval_statement>(call("f", make<bool_literal>(true))),
+            make<eval_statement>(call("f", make<bool_literal>(false))))),
+        function_block("f", nodes(make<parameter>("set")),
+                       nodes(make<if_statement>(
+                                 id("set"), nodes(assign("x", number("1")))),
+                             print(id("x")))))};
+    REQUIRE(printed_of(program.run_bytecode()) ==
+            std::vector<std::string>{"1", "undefined"});
+    require_same_run(program);
+  }
+}
+
+TEST_CASE("exec::Generate C++ for batch runs", "[exec]") {
+  auto recursion{call("count", binary(id("n"), binary_op::subtract,
+                                      number("1")))};
+  test_program program{nodes(
+      make<on_start>(nodes(
+          assign("total", number("0.1")),
+          make<for_statement>(
+              var("i"), call(system_function::range1, number("3")),
+              nodes(assign("total", binary(id("total"), binary_op::add,
+                                           call("count", id("i")))))),
+          print(binary(text("total \"x\"\n"), binary_op::add,
+                       id("total"))))),
+      function_block(
+          "count", nodes(make<parameter>("n")),
+          nodes(make<if_statement>(
+                    binary(id("n"), binary_op::less_equal, number("0")),
+                    nodes(make<return_result_statement>(number("0")))),
+                make<return_result_statement>(binary(
+                    call("count", id("n")), binary_op::add,
+                    std::move(recursion))))))};
+  const auto source{marlin::exec::cpp_generator{}.generate(program.get())};
+
+  const auto contains{[&](const std::string& text) {
+    return source.find(text) != std::string::npos;
+  }};
+  REQUIRE(contains("#include \"cpp_runtime.hpp\""));
+  REQUIRE(contains("marlin::exec::cpp::main<program>(argc, argv)"));
+  // Numbers keep every bit, strings are escaped
+  REQUIRE(contains("value{0x1.999999999999ap-4}"));
+  REQUIRE(contains("{\"total \\\"x\\\"\\012\"}"));
+  // Ranges count in locals, user functions guard the depth of calls
+  REQUIRE(contains("make_range(system_function{0}"));
+  REQUIRE(contains("const call_guard guard{*this};"));
+  // Operands with effects on both sides are evaluated in order
+  REQUIRE(contains("ordered<add>({block_1("));
+  REQUIRE(contains("less_equal(local_0, value{0x0p+0})"));
+
+  test_program invalid{nodes(make<on_start>(
+      nodes(print(make<expression_placeholder>("value")))))};
+  REQUIRE_THROWS_AS(marlin::exec::cpp_generator{}.generate(invalid.get()),
+                    marlin::exec::collected_generation_error);
+}
+
+TEST_CASE("exec::Run generated C++ like the interpreter", "[exec]") {
+  // Built from batch_program() by the build, see test/CMakeLists.txt
+  auto* pipe{popen(MARLIN_BATCH_PROGRAM, "r")};
+  REQUIRE(pipe != nullptr);
+  std::string output;
+  char buffer[256];
+  while (const auto count{std::fread(buffer, 1, sizeof(buffer), pipe)}) {
+    output.append(buffer, count);
+  }
+  REQUIRE(pclose(pipe) == 0);
+
+  test_program program{batch_program()};
+  const auto result{program.run()};
+  REQUIRE(!result.error.has_value());
+  std::string expected;
+  for (const auto& message : printed_of(result)) {
+    expected += message + '\n';
+  }
+  REQUIRE(output == expected);
+}
+
+TEST_CASE("exec::Reuse JavaScript of unchanged blocks", "[exec]") {
+  test_program program{
+      nodes(make<on_start>(nodes(assign("x", number("1")),
+                                 make<eval_statement>(call("wait")))),
+            function_block("wait", {}, nodes(print(text("waiting")))),
+            function_block("other", nodes(make<parameter>("n")),
+                           nodes(print(id("n")))))};
+  marlin::exec::js_cache cache;
+  marlin::exec::call_graph calls;
+  marlin::exec::source_map map;
+  const auto generate{[&]() {
+    return marlin::exec::generator{cache, calls}.generate(program.get(), map);
+  }};
+
+  const auto first{generate()};
+  REQUIRE(cache.size() == 3);
+  REQUIRE(cache.hits() == 0);
+  REQUIRE(generate() == first);
+  REQUIRE(cache.hits() == 3);
+
+  // Sleeping makes the function async, so its caller is generated again
+  auto& wait{*program.get().blocks()[1]};
+  wait.as<function>().statements().emplace_back(
+      call(system_procedure::sleep, number("1")));
+  const auto cached{generate()};
+  REQUIRE(cache.hits() == 4);
+  const auto cached_locations{js_locations(cached, map)};
+
+  marlin::exec::source_map expected_map;
+  const auto expected{
+      marlin::exec::generator{}.generate(program.get(), expected_map)};
+  REQUIRE(cached == expected);
+  REQUIRE(cached != first);
+  REQUIRE(cached_locations == js_locations(expected, expected_map));
+  REQUIRE(map.vlq_mappings() == expected_map.vlq_mappings());
+
+  program.get().blocks().pop(2);
+  static_cast<void>(generate());
+  REQUIRE(cache.size() == 2);
+}
+
+TEST_CASE("exec::Stream JavaScript like the jsast tree", "[exec]") {
+  using output = marlin::exec::generator::output;
+
+  test_program program{nodes(
+      make<on_start>(nodes(
+          make<use_global>(var("g")), assign("g", number("007.50")),
+          assign("list", make<new_array>(nodes(number("-00"), text("\"a\\\n"),
+                                               make<bool_literal>(true)))),
+          make<modify_array>(array_modification::append, id("list"),
+                             nodes(make<new_color>(
+                                 color_mode::rgb,
+                                 nodes(number("1"), number("2"),
+                                       number("3"))))),
+          make<for_statement>(
+              var("i"), call(system_function::range1, number("3")),
+              nodes(make<if_else_statement>(
+                  binary(id("i"), binary_op::logical_or,
+                         make<unary_expression>(unary_op::logical_not,
+                                                id("g"))),
+                  nodes(make<break_statement>()),
+                  nodes(make<continue_statement>())))),
+          make<for_statement>(var("g"), id("list"), nodes()),
+          make<while_statement>(
+              binary(make<subscript_get>(id("list"), number("0")),
+                     binary_op::not_equal,
+                     make<unary_expression>(unary_op::negative, id("i"))),
+              nodes(make<assignment>(make<subscript_set>(id("list"),
+                                                         number("0")),
+                                     call("wait", id("g"))))))),
+      function_block("wait", nodes(make<parameter>("n")),
+                     nodes(call(system_procedure::sleep, id("n")),
+                           make<return_statement>(),
+                           make<while_statement>(
+                               make<bool_literal>(false),
+                               nodes(make<return_result_statement>(
+                                   id("n")))))))};
+
+  marlin::exec::source_map tree_map;
+  const auto tree{marlin::exec::generator{output::tree}.generate(
+      program.get(), tree_map)};
+  marlin::exec::source_map stream_map;
+  const auto stream{marlin::exec::generator{output::stream}.generate(
+      program.get(), stream_map)};
+  REQUIRE(stream == tree);
+  REQUIRE(js_locations(stream, stream_map) == js_locations(tree, tree_map));
+  REQUIRE(stream_map.node_count() == tree_map.node_count());
+
+  // Errors are reported in the same order, bodies left out are not mapped
+  auto invalid{make<marlin::ast::program>(nodes(
+      make<on_start>(nodes(print(make<expression_placeholder>("value")))),
+      function_block("f", nodes(make<parameter>("a"), make<parameter>("a")),
+                     nodes(make<break_statement>())),
+      make<function>(make<function_placeholder>("g", nodes()),
+                     nodes(print(text("left out"))))))};
+  const auto errors_of{[&](output mode) {
+    std::vector<std::string> messages;
+    marlin::exec::source_map map;
+    try {
+      static_cast<void>(
+          marlin::exec::generator{mode}.generate(*invalid, map));
+    } catch (marlin::exec::collected_generation_error& e) {
+      for (const auto& error : e.errors()) {
+        messages.emplace_back(error.what());
+      }
+    }
+    messages.push_back(map.vlq_mappings());
+    return messages;
+  }};
+  REQUIRE(errors_of(output::stream).size() == 5);
+  REQUIRE(errors_of(output::stream) == errors_of(output::tree));
+}
+
+TEST_CASE("exec::Propagate async status through changed calls", "[exec]") {
+  test_program program{
+      nodes(make<on_start>(nodes(make<eval_statement>(call("ping")))),
+            function_block("ping", {},
+                           nodes(make<eval_statement>(call("pong")))),
+            function_block("pong", {},
+                           nodes(make<eval_statement>(call("ping")))),
+            function_block("idle", {}, nodes(print(text("idle")))))};
+  auto blocks{program.get().blocks()};
+  marlin::exec::call_graph calls;
+
+  calls.update(program.get());
+  REQUIRE(calls.scans() == 4);
+  REQUIRE(calls.function("pong") == blocks[2].get());
+  REQUIRE(calls.calls(*blocks[1]).size() == 1);
+  for (auto& block : blocks) {
+    REQUIRE_FALSE(calls.is_async(*block));
+  }
+
+  // Only the edited block is scanned again, the whole cycle becomes async
+  blocks[2]->as<function>().statements().emplace_back(
+      call(system_procedure::sleep, number("1")));
+  calls.update(program.get());
+  REQUIRE(calls.scans() == 5);
+  REQUIRE(calls.is_async(*blocks[0]));
+  REQUIRE(calls.is_async(*blocks[1]));
+  REQUIRE(calls.is_async(*blocks[2]));
+  REQUIRE_FALSE(calls.is_async(*blocks[3]));
+
+  // Callers of a removed function no longer wait for it
+  blocks[1]->as<function>().statements().pop(0);
+  blocks.pop(2);
+  calls.update(program.get());
+  REQUIRE(calls.scans() == 6);
+  REQUIRE(calls.function("pong") == nullptr);
+  REQUIRE_FALSE(calls.is_async(*blocks[0]));
+  REQUIRE_FALSE(calls.is_async(*blocks[1]));
+
+  // Call chains are followed without recursion
+  constexpr size_t chain_length{100000};
+  std::vector<node> chain;
+  for (size_t i{0}; i + 1 < chain_length; i++) {
+    chain.emplace_back(function_block(
+        "f" + std::to_string(i), {},
+        nodes(make<eval_statement>(call("f" + std::to_string(i + 1))))));
+  }
+  chain.emplace_back(
+      function_block("f" + std::to_string(chain_length - 1), {},
+                     nodes(call(system_procedure::sleep, number("1")))));
+  test_program long_chain{std::move(chain)};
+  marlin::exec::call_graph chain_calls;
+  chain_calls.update(long_chain.get());
+  REQUIRE(chain_calls.is_async(*long_chain.get().blocks()[0]));
+}
+
+TEST_CASE("exec::Parse stack traces of each engine", "[exec]") {
+  using marlin::exec::parse_jsc_frame;
+  using marlin::exec::parse_v8_frame;
+
+  // JavaScriptCore reports the column after the error
+  const auto jsc{parse_jsc_frame("f@file:///a:b.js:3:10")};
+  REQUIRE(jsc.has_value());
+  REQUIRE(jsc->function == "f");
+  REQUIRE(jsc->url == "file:///a:b.js");
+  REQUIRE(jsc->loc == marlin::source_loc{3, 9});
+  REQUIRE(parse_jsc_frame("@marlin:1:1")->loc == marlin::source_loc{1, 1});
+  REQUIRE_FALSE(parse_jsc_frame("global code").has_value());
+  REQUIRE_FALSE(parse_jsc_frame("f@marlin:x:1").has_value());
+  REQUIRE_FALSE(parse_jsc_frame("f@marlin:1").has_value());
+
+  const auto v8{parse_v8_frame("    at f (marlin:3:10)")};
+  REQUIRE(v8.has_value());
+  REQUIRE(v8->function == "f");
+  REQUIRE(v8->url == "marlin");
+  REQUIRE(v8->loc == marlin::source_loc{3, 10});
+  REQUIRE(parse_v8_frame("    at marlin:2:4")->function.empty());
+  REQUIRE_FALSE(parse_v8_frame("TypeError: x is not a function").has_value());
+
+  const auto locs{marlin::exec::parse_stacktrace(
+      "TypeError: oops\n    at f (marlin:2:5)\n    at other:1:1\n"
+      "    at marlin:4:1",
+      "marlin", parse_v8_frame)};
+  REQUIRE(locs == std::vector<marlin::source_loc>{{2, 5}, {4, 1}});
+
+  // Frames repeated by recursion are located once
+  test_program program{
+      nodes(make<on_start>(nodes(print(text("a")), print(text("b")))))};
+  marlin::exec::source_map map;
+  static_cast<void>(marlin::exec::generator{}.generate(program.get(), map));
+  marlin::exec::frame_cache cache;
+  base& code{program.get()};
+  const auto frames{marlin::exec::parse_stacktrace(
+      "f@marlin:2:5\nf@marlin:2:5\nf@marlin:3:5\nf@marlin:2:5", "marlin",
+      map, code, &cache)};
+  REQUIRE(frames.size() == 4);
+  REQUIRE(cache.size() == 2);
+  REQUIRE(cache.hits() == 2);
+  REQUIRE(frames[0] == map.locate({2, 4}));
+  REQUIRE(frames[0]->is<marlin::ast::system_procedure_call>());
+  REQUIRE(frames[2]->is<marlin::ast::system_procedure_call>());
+  REQUIRE(frames[0] != frames[2]);
+  REQUIRE(frames[3] == frames[0]);
+}
+
+TEST_CASE("exec::Count profile samples by node and line", "[exec]") {
+  test_program program{
+      nodes(make<on_start>(nodes(
+                assign("x", number("1")),
+                make<while_statement>(
+                    make<bool_literal>(true),
+                    nodes(make<eval_statement>(call("f", id("x"))))))),
+            function_block("f", nodes(make<parameter>("n")),
+                           nodes(print(id("n")))))};
+  auto& start{program.get().blocks()[0]->as<on_start>()};
+  auto& assignment{*start.statements()[0]};
+  auto& loop{*start.statements()[1]};
+  auto& call_site{*loop.as<while_statement>().statements()[0]};
+  auto& f{*program.get().blocks()[1]};
+  auto& printing{*f.as<function>().statements()[0]};
+
+  marlin::exec::generator generator;
+  generator.set_profile_interval(0.01);
+  marlin::exec::source_map map;
+  const auto script{generator.generate(program.get(), map)};
+  REQUIRE(script.find("window.env.profile(__main__, 0.010000);") !=
+          std::string::npos);
+
+  // Every statement samples itself once it ran, so that a sample taken
+  // after a call is charged to the call rather than to the next statement
+  REQUIRE(script.find("__func_f(__var_x); window.env.tick();") !=
+          std::string::npos);
+  std::vector<marlin::source_loc> ticks;
+  size_t line{1};
+  size_t column{1};
+  for (size_t i{0}; i < script.size(); i++) {
+    if (script.compare(i, 16, "window.env.tick(") == 0) {
+      ticks.emplace_back(line, column);
+    }
+    if (script[i] == '\n') {
+      line++;
+      column = 1;
+    } else {
+      column++;
+    }
+  }
+  REQUIRE(ticks.size() == 4);
+  REQUIRE(map.locate(ticks[0]) == &assignment);
+  REQUIRE(map.locate(ticks[1]) == &call_site);
+  REQUIRE(map.locate(ticks[2]) == &loop);
+  REQUIRE(map.locate(ticks[3]) == &printing);
+
+  // JavaScriptCore reports the column after the call
+  const auto frame{[](const char* function, marlin::source_loc loc) {
+    return std::string{function} + "@marlin:" + std::to_string(loc.line) +
+           ":" + std::to_string(loc.column + 1) + "\n";
+  }};
+  const std::string tick{"tick@exec_env.js:10:3\n"};
+  marlin::exec::profile profile;
+  marlin::exec::frame_cache cache;
+  for (size_t i{0}; i < 3; i++) {
+    profile.add_sample(tick + frame("__func_f", ticks[3]) +
+                           frame("__main__", ticks[1]),
+                       "marlin", map, &cache);
+  }
+  profile.add_sample(tick + frame("__main__", ticks[0]), "marlin", map,
+                     &cache);
+  REQUIRE(cache.hits() == 4);
+  // Recursion counts once
+  profile.add_sample({&printing, &call_site, &printing, &call_site});
+  profile.add_sample(tick, "marlin", map);
+  REQUIRE(profile.sample_count() == 5);
+
+  using counts = marlin::exec::profile::counts;
+  const auto equal{[](counts left, counts right) {
+    return left.inclusive == right.inclusive &&
+           left.exclusive == right.exclusive;
+  }};
+  REQUIRE(equal(profile.of(printing), {4, 4}));
+  REQUIRE(equal(profile.of(f), {4, 0}));
+  REQUIRE(equal(profile.of(call_site), {4, 0}));
+  REQUIRE(equal(profile.of(loop), {4, 0}));
+  REQUIRE(equal(profile.of(assignment), {1, 1}));
+  REQUIRE(equal(profile.of(*program.get().blocks()[0]), {5, 0}));
+
+  const auto printing_line{printing.source_code_range.begin.line};
+  const auto start_line{start.source_code_range.begin.line};
+  REQUIRE(equal(profile.of_line(printing_line), {4, 4}));
+  REQUIRE(equal(profile.of_line(start_line), {5, 0}));
+  const auto lines{profile.lines()};
+  REQUIRE(lines.size() == 6);
+  REQUIRE(lines.front().line == start_line);
+  REQUIRE(lines.back().line == printing_line);
+
+  // Statements leaving their block sample before they do, or once their
+  // result is computed
+  test_program leaving{nodes(
+      make<on_start>(nodes(make<while_statement>(
+          make<bool_literal>(true),
+          nodes(make<eval_statement>(call("g", number("1"))),
+                make<break_statement>())))),
+      function_block(
+          "g", nodes(make<parameter>("n")),
+          nodes(make<return_result_statement>(
+              binary(id("n"), binary_op::multiply, number("2"))))))};
+  const auto leaving_script{generator.generate(leaving.get())};
+  REQUIRE(leaving_script.find("window.env.tick(); break;") !=
+          std::string::npos);
+  REQUIRE(leaving_script.find("break; window.env.tick();") ==
+          std::string::npos);
+  REQUIRE(leaving_script.find("return window.env.tick((__var_n * 2));") !=
+          std::string::npos);
+}
+
+TEST_CASE("exec::Fold constants like JavaScript", "[exec]") {
+  marlin::exec::constant_folder folder;
+  const auto fold{[&folder](node expression) -> std::optional<std::string> {
+    folder.fold(*expression);
+    const auto* constant{folder.constant(*expression)};
+    if (constant == nullptr) {
+      return std::nullopt;
+    } else if (constant->is(marlin::exec::value::type::string)) {
+      return "'" + constant->string() + "'";
+    } else {
+      return marlin::exec::constant_folder::js_literal(*constant);
+    }
+  }};
+  const auto negative{[](node argument) {
+    return make<unary_expression>(unary_op::negative, std::move(argument));
+  }};
+  const auto yes{[]() { return make<bool_literal>(true); }};
+
+  REQUIRE(fold(binary(number("1"), binary_op::add, number("2"))) == "3");
+  REQUIRE(fold(binary(number("0.1"), binary_op::add, number("0.2"))) ==
+          "0.30000000000000004");
+  REQUIRE(fold(binary(binary(number("2"), binary_op::multiply, number("3")),
+                      binary_op::subtract, negative(number("1")))) == "7");
+  REQUIRE(fold(binary(number("1000000"), binary_op::multiply,
+                      number("1000000000000000"))) == "1e+21");
+  REQUIRE(fold(binary(number("1"), binary_op::divide, number("0"))) ==
+          "Infinity");
+  REQUIRE(fold(binary(number("-1"), binary_op::divide, number("0"))) ==
+          "(-Infinity)");
+  REQUIRE(fold(binary(number("0"), binary_op::divide, number("0"))) == "NaN");
+  REQUIRE(fold(negative(number("0"))) == "(-0)");
+  REQUIRE(fold(negative(number("-00"))) == "0");
+
+  // Strings and booleans convert like JavaScript
+  REQUIRE(fold(binary(text("a"), binary_op::add, number("1.50"))) == "'a1.5'");
+  REQUIRE(fold(binary(yes(), binary_op::add, number("1"))) == "2");
+  REQUIRE(fold(binary(text("10"), binary_op::less, text("9"))) == "true");
+  REQUIRE(fold(binary(number("10"), binary_op::less, text("9"))) == "false");
+  REQUIRE(fold(binary(text(" 0x1F "), binary_op::equal, number("31"))) ==
+          "false");
+  REQUIRE(fold(negative(text(" 0x1F "))) == "(-31)");
+  REQUIRE(fold(binary(number("1"), binary_op::equal, yes())) == "false");
+  REQUIRE(fold(binary(text(""), binary_op::logical_or, text("x"))) == "'x'");
+  REQUIRE(fold(binary(number("0"), binary_op::logical_and, text("x"))) ==
+          "0");
+  REQUIRE(fold(make<unary_expression>(unary_op::logical_not, text(""))) ==
+          "true");
+
+  // Strings compare by UTF-16 code units in JavaScript
+  REQUIRE_FALSE(fold(binary(text("\xF0\x9F\x98\x80"), binary_op::less,
+                            text("\xEF\xBF\xBD")))
+                    .has_value());
+  REQUIRE_FALSE(fold(binary(id("x"), binary_op::add, number("1"))).has_value());
+}
+
+TEST_CASE("exec::Leave out unreachable branches", "[exec]") {
+  using output = marlin::exec::generator::output;
+
+  test_program program{nodes(make<on_start>(nodes(
+      make<use_global>(var("g")),
+      assign("g", binary(number("2"), binary_op::multiply, number("3"))),
+      make<if_statement>(binary(number("1"), binary_op::greater, number("2")),
+                         nodes(print(text("never")))),
+      make<if_statement>(make<bool_literal>(true),
+                         nodes(print(text("always")))),
+      make<if_else_statement>(
+          make<unary_expression>(unary_op::logical_not,
+                                 make<bool_literal>(true)),
+          nodes(print(text("consequence"))), nodes(print(text("alternate")))),
+      make<while_statement>(make<bool_literal>(false),
+                            nodes(print(text("never")))),
+      make<while_statement>(binary(id("g"), binary_op::less, number("9")),
+                            nodes(assign("g", binary(id("g"), binary_op::add,
+                                                     text("1"))))))))};
+
+  marlin::exec::source_map map;
+  const auto script{marlin::exec::generator{}.generate(program.get(), map)};
+  marlin::exec::source_map tree_map;
+  REQUIRE(marlin::exec::generator{output::tree}.generate(program.get(),
+                                                         tree_map) == script);
+  REQUIRE(js_locations(script, map) == js_locations(script, tree_map));
+
+  REQUIRE(script.find("window.env.globals.g = 6;") != std::string::npos);
+  REQUIRE(script.find("\"always\"") != std::string::npos);
+  REQUIRE(script.find("\"alternate\"") != std::string::npos);
+  REQUIRE(script.find("never") == std::string::npos);
+  REQUIRE(script.find("consequence") == std::string::npos);
+  REQUIRE(script.find("if") == std::string::npos);
+  REQUIRE(script.find(";\n") != std::string::npos);
+  REQUIRE(script.find("  ;\n") == std::string::npos);
+  REQUIRE(script.find("while ((window.env.globals.g < 9))") !=
+          std::string::npos);
+
+  // The literal maps to the expression it replaces
+  const auto folded{script.find("= 6;") + 2};
+  const auto line{1 + static_cast<size_t>(std::count(
+                          script.begin(), script.begin() + folded, '\n'))};
+  const auto column{folded - script.rfind('\n', folded)};
+  auto& start{program.get().blocks()[0]->as<on_start>()};
+  REQUIRE(map.locate({line, column}) ==
+          start.statements()[1]->as<assignment>().value().get());
+
+  marlin::exec::generator verbatim;
+  verbatim.set_optimize(false);
+  const auto unoptimized{verbatim.generate(program.get())};
+  REQUIRE(unoptimized.find("(2 * 3)") != std::string::npos);
+  REQUIRE(unoptimized.find("never") != std::string::npos);
+
+  // Branches left out are still checked
+  auto invalid{make<marlin::ast::program>(nodes(make<on_start>(nodes(
+      make<if_else_statement>(
+          make<bool_literal>(false),
+          nodes(print(make<expression_placeholder>("value"))),
+          nodes(make<break_statement>())),
+      make<while_statement>(make<bool_literal>(false),
+                            nodes(make<use_global>(number("1"))))))))};
+  for (const auto mode : {output::tree, output::stream}) {
+    std::vector<std::string> messages;
+    try {
+      static_cast<void>(marlin::exec::generator{mode}.generate(*invalid));
+    } catch (marlin::exec::collected_generation_error& e) {
+      for (const auto& error : e.errors()) {
+        messages.emplace_back(error.what());
+      }
+    }
+    REQUIRE(messages ==
+            std::vector<std::string>{
+                "Unexpected placeholder!",
+                "Break statement can only appear in a loop!",
+                "Unexpected node, expecting variable name!"});
+  }
+}
+
+TEST_CASE("exec::Keep unreachable branches declaring locals", "[exec]") {
+  using output = marlin::exec::generator::output;
+
+  // JavaScript hoists the declarations, so x and y read as undefined
+  test_program program{nodes(make<on_start>(nodes(
+      make<if_statement>(make<bool_literal>(false),
+                         nodes(assign("x", number("1")))),
+      make<if_else_statement>(
+          make<bool_literal>(true), nodes(print(text("taken"))),
+          nodes(make<for_statement>(
+              var("y"), call(system_function::range2, number("1"), number("2")),
+              nodes()))),
+      make<while_statement>(make<bool_literal>(false),
+                            nodes(print(text("never")))),
+      print(id("x")), print(id("y")))))};
+  const auto result{program.run()};
+  REQUIRE_FALSE(result.error);
+  REQUIRE(printed_of(result) ==
+          std::vector<std::string>{"taken", "undefined", "undefined"});
+
+  const auto script{marlin::exec::generator{}.generate(program.get())};
+  REQUIRE(script.find("var __var_x = 1;") != std::string::npos);
+  REQUIRE(script.find("var __var_y") != std::string::npos);
+  REQUIRE(script.find("never") == std::string::npos);
+  REQUIRE(marlin::exec::generator{output::tree}.generate(program.get()) ==
+          script);
+}
+
+TEST_CASE("exec::Prove types only on paths that run", "[exec]") {
+  using output = marlin::exec::generator::output;
+
+  // p[0] does not run when q is false, and p stays a number
+  test_program program{nodes(make<on_start>(nodes(
+      assign("p", number("0")),
+      assign("q", binary(number("1"), binary_op::less, id("p"))),
+      make<if_statement>(binary(id("q"), binary_op::logical_and,
+                                make<subscript_get>(id("p"), number("0"))),
+                         nodes()),
+      print(make<subscript_get>(id("p"), number("1"))))))};
+
+  const auto script{marlin::exec::generator{}.generate(program.get())};
+  REQUIRE(script.find("window.env.print(window.env.asArray(__var_p)[1])") !=
+          std::string::npos);
+  REQUIRE(marlin::exec::generator{output::tree}.generate(program.get()) ==
+          script);
+}
+
+TEST_CASE("exec::Leave out checks of proven types", "[exec]") {
+  using output = marlin::exec::generator::output;
+
+  test_program program{nodes(
+      make<on_start>(nodes(
+          make<use_global>(var("g")), assign("g", make<new_array>(nodes())),
+          assign("list", make<new_array>(nodes(number("1")))),
+          make<for_statement>(
+              var("i"), call(system_function::range2, number("0"), number("9")),
+              nodes(call(system_procedure::logo_forward,
+                         call(system_function::sin,
+                              binary(id("i"), binary_op::multiply,
+                                     number("3")))),
+                    call(system_procedure::logo_turn_left,
+                         call(system_function::sqrt,
+                              binary(id("i"), binary_op::subtract,
+                                     number("1")))),
+                    make<assignment>(
+                        make<subscript_set>(id("list"), id("i")),
+                        make<subscript_get>(id("g"), number("0"))))),
+          assign("x", number("1")),
+          make<while_statement>(
+              binary(id("x"), binary_op::less, number("9")),
+              nodes(assign("x", binary(id("x"), binary_op::multiply,
+                                       number("2"))))),
+          call(system_procedure::logo_turn_right,
+               binary(id("x"), binary_op::subtract, id("x"))))),
+      function_block("f", nodes(make<parameter>("n")),
+                     nodes(call(system_procedure::sleep, id("n")),
+                           assign("n", number("2")),
+                           call(system_procedure::sleep, id("n")))))};
+
+  const auto script{marlin::exec::generator{}.generate(program.get())};
+  REQUIRE(marlin::exec::generator{output::tree}.generate(program.get()) ==
+          script);
+
+  REQUIRE(script.find("Logo.forwardUnchecked(window.env.MathUtils."
+                      "sinUnchecked((__var_i * 3)))") != std::string::npos);
+  // The square root of -1 is NaN
+  REQUIRE(script.find("Logo.turnLeft(window.env.MathUtils.sqrtUnchecked("
+                      "(__var_i - 1)))") != std::string::npos);
+  REQUIRE(script.find("__var_list[__var_i] = "
+                      "window.env.asArray(window.env.globals.g)[0];") !=
+          std::string::npos);
+  // Doubling grows to infinity, and infinity minus infinity is NaN
+  REQUIRE(script.find("Logo.turnRight((__var_x - __var_x))") !=
+          std::string::npos);
+  // Parameters are untyped until assigned
+  REQUIRE(script.find("window.env.sleep(__var_n)") != std::string::npos);
+  REQUIRE(script.find("window.env.sleepUnchecked(__var_n)") !=
+          std::string::npos);
+
+  marlin::exec::generator checked;
+  checked.set_optimize(false);
+  const auto unoptimized{checked.generate(program.get())};
+  REQUIRE(unoptimized.find("Unchecked") == std::string::npos);
+  REQUIRE(unoptimized.find("window.env.asArray(__var_list)") !=
+          std::string::npos);
+}
+
+TEST_CASE("exec::Type elements of endless ranges", "[exec]") {
+  // Elements grow without bound before an infinite end, so the square roots
+  // may be NaN and are checked before moving
+  test_program program{nodes(make<on_start>(nodes(
+      make<for_statement>(
+          var("i"), call(system_function::range1, number("1e999")),
+          nodes(call(system_procedure::logo_forward,
+                     call(system_function::sqrt,
+                          make<unary_expression>(unary_op::negative,
+                                                 id("i")))))),
+      make<for_statement>(
+          var("j"),
+          call(system_function::range3, number("0"), number("-1e999"),
+               number("-1")),
+          nodes(call(system_procedure::logo_forward,
+                     call(system_function::sqrt, id("j"))))))))};
+
+  const auto script{marlin::exec::generator{}.generate(program.get())};
+  REQUIRE(script.find("forwardUnchecked") == std::string::npos);
+  REQUIRE(script.find("Logo.forward(window.env.MathUtils.sqrtUnchecked((-"
+                      "__var_i)))") != std::string::npos);
+  REQUIRE(script.find("Logo.forward(window.env.MathUtils.sqrtUnchecked("
+                      "__var_j))") != std::string::npos);
+}
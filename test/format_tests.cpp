@@ -0,0 +1,414 @@
+#include <catch2/catch.hpp>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "ast.hpp"
+#include "formatter.hpp"
+#include "parallel_formatter.hpp"
+#include "text_diff.hpp"
+#include "text_model.hpp"
+#include "utf8.hpp"
+
+namespace {
+
+marlin::ast::node make_assignment(std::string variable, std::string value) {
+  return marlin::ast::make<marlin::ast::assignment>(
+      marlin::ast::make<marlin::ast::variable_name>(std::move(variable)),
+      marlin::ast::make<marlin::ast::number_literal>(std::move(value)));
+}
+
+marlin::ast::node make_program() {
+  std::vector<marlin::ast::node> body;
+  body.emplace_back(make_assignment("a", "1"));
+  std::vector<marlin::ast::node> branch;
+  branch.emplace_back(make_assignment("b", "2"));
+  std::vector<marlin::ast::node> alternate;
+  alternate.emplace_back(make_assignment("c", "3"));
+  body.emplace_back(marlin::ast::make<marlin::ast::if_else_statement>(
+      marlin::ast::make<marlin::ast::bool_literal>(true), std::move(branch),
+      std::move(alternate)));
+
+  std::vector<marlin::ast::node> start;
+  start.emplace_back(make_assignment("d", "4"));
+
+  std::vector<marlin::ast::node> blocks;
+  blocks.emplace_back(marlin::ast::make<marlin::ast::function>(
+      marlin::ast::make<marlin::ast::function_signature>(
+          "f", std::vector<marlin::ast::node>{}),
+      std::move(body)));
+  blocks.emplace_back(
+      marlin::ast::make<marlin::ast::on_start>(std::move(start)));
+  return marlin::ast::make<marlin::ast::program>(std::move(blocks));
+}
+
+void collect_ranges(const marlin::ast::base& node,
+                    std::vector<marlin::source_range>& ranges) {
+  ranges.emplace_back(node.source_code_range);
+  for (const auto& child : node.children()) {
+    collect_ranges(*child, ranges);
+  }
+}
+
+bool same_ranges(const marlin::ast::base& lhs, const marlin::ast::base& rhs) {
+  std::vector<marlin::source_range> lhs_ranges;
+  std::vector<marlin::source_range> rhs_ranges;
+  collect_ranges(lhs, lhs_ranges);
+  collect_ranges(rhs, rhs_ranges);
+  if (lhs_ranges.size() != rhs_ranges.size()) {
+    return false;
+  }
+  for (size_t i{0}; i < lhs_ranges.size(); i++) {
+    if (lhs_ranges[i].begin.line != rhs_ranges[i].begin.line ||
+        lhs_ranges[i].begin.column != rhs_ranges[i].begin.column ||
+        lhs_ranges[i].end.line != rhs_ranges[i].end.line ||
+        lhs_ranges[i].end.column != rhs_ranges[i].end.column) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool same_display(const marlin::format::display& lhs,
+                  const marlin::format::display& rhs) {
+  if (lhs.source != rhs.source ||
+      lhs.highlights.size() != rhs.highlights.size()) {
+    return false;
+  }
+  for (size_t i{0}; i < lhs.highlights.size(); i++) {
+    if (lhs.highlights[i].type != rhs.highlights[i].type ||
+        lhs.highlights[i].offset != rhs.highlights[i].offset ||
+        lhs.highlights[i].length != rhs.highlights[i].length) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+TEST_CASE("format::Reuse cached fragments", "[format]") {
+  marlin::format::fragment_cache cache;
+  auto program{make_program()};
+  auto expected{make_program()};
+
+  const auto first{marlin::format::in_place_formatter{cache}.format(program)};
+  REQUIRE(first.source ==
+          "func f() {\n"
+          "  a = 1;\n"
+          "  if (true) {\n"
+          "    b = 2;\n"
+          "  } else {\n"
+          "    c = 3;\n"
+          "  }\n"
+          "}\n"
+          "on start {\n"
+          "  d = 4;\n"
+          "}\n");
+  REQUIRE(cache.hits() == 0);
+
+  SECTION("Unchanged blocks") {
+    const auto second{
+        marlin::format::in_place_formatter{cache}.format(program)};
+    REQUIRE(same_display(first, second));
+    REQUIRE(cache.hits() == 2);
+  }
+
+  SECTION("Modified statement") {
+    auto& function{program->children()[0]->as<marlin::ast::function>()};
+    auto& if_else{
+        function.statements()[1]->as<marlin::ast::if_else_statement>()};
+    if_else.alternate()[0]->as<marlin::ast::assignment>().value().replace(
+        marlin::ast::make<marlin::ast::number_literal>("30"));
+    auto& expected_function{
+        expected->children()[0]->as<marlin::ast::function>()};
+    expected_function.statements()[1]
+        ->as<marlin::ast::if_else_statement>()
+        .alternate()[0]
+        ->as<marlin::ast::assignment>()
+        .value()
+        .replace(marlin::ast::make<marlin::ast::number_literal>("30"));
+
+    const auto second{
+        marlin::format::in_place_formatter{cache}.format(program)};
+    const auto fresh{marlin::format::in_place_formatter{}.format(expected)};
+    REQUIRE(same_display(second, fresh));
+    REQUIRE(same_ranges(*program, *expected));
+    // a = 1, b = 2 and on start
+    REQUIRE(cache.hits() == 3);
+  }
+
+  SECTION("Shifted lines") {
+    auto& function{program->children()[0]->as<marlin::ast::function>()};
+    function.statements().emplace(0, make_assignment("e", "5"));
+    auto& expected_function{
+        expected->children()[0]->as<marlin::ast::function>()};
+    expected_function.statements().emplace(0, make_assignment("e", "5"));
+
+    const auto second{
+        marlin::format::in_place_formatter{cache}.format(program)};
+    const auto fresh{marlin::format::in_place_formatter{}.format(expected)};
+    REQUIRE(same_display(second, fresh));
+    REQUIRE(same_ranges(*program, *expected));
+    REQUIRE(program->children()[0]
+                ->as<marlin::ast::function>()
+                .statements()[2]
+                ->as<marlin::ast::if_else_statement>()
+                .else_loc.line == 6);
+    // a = 1, if else and on start
+    REQUIRE(cache.hits() == 3);
+  }
+
+  SECTION("Removed statement") {
+    // Two blocks and five statements
+    REQUIRE(cache.size() == 7);
+    auto& function{program->children()[0]->as<marlin::ast::function>()};
+    static_cast<void>(function.statements().pop(1));
+
+    static_cast<void>(
+        marlin::format::in_place_formatter{cache}.format(program));
+    REQUIRE(cache.size() == 7);
+    // The if else and its two statements are dropped
+    cache.retain(*program);
+    REQUIRE(cache.size() == 4);
+    REQUIRE_FALSE(cache.needs_retain());
+  }
+}
+
+namespace {
+
+struct collecting_sink final : marlin::format::sink {
+  using sink::sink;
+
+  marlin::format::display output;
+  size_t chunks{0};
+  size_t largest_chunk{0};
+
+  void write(std::string_view source,
+             const std::vector<marlin::format::highlight_token>& highlights)
+      override {
+    for (const auto& token : highlights) {
+      output.highlights.emplace_back(
+          token.type, output.source.size() + token.offset, token.length);
+    }
+    output.source.append(source);
+    chunks++;
+    largest_chunk = std::max(largest_chunk, source.size());
+  }
+};
+
+}  // namespace
+
+TEST_CASE("format::Stream formatted source to sink", "[format]") {
+  std::vector<marlin::ast::node> statements;
+  for (size_t i{0}; i < 200; i++) {
+    statements.emplace_back(make_assignment("a", std::to_string(i)));
+  }
+  std::vector<marlin::ast::node> blocks;
+  blocks.emplace_back(
+      marlin::ast::make<marlin::ast::on_start>(std::move(statements)));
+  blocks.emplace_back(marlin::ast::make<marlin::ast::on_start>(
+      std::vector<marlin::ast::node>{}));
+  const auto program{
+      marlin::ast::make<marlin::ast::program>(std::move(blocks))};
+
+  const auto expected{marlin::format::const_formatter{}.format(program)};
+
+  collecting_sink output{64};
+  marlin::format::const_formatter{}.format_to(output, program);
+  REQUIRE(same_display(output.output, expected));
+  REQUIRE(output.chunks > 10);
+  // Output is passed on at the first line break past the buffer size
+  REQUIRE(output.largest_chunk < 64 + 16);
+}
+
+TEST_CASE("format::Format blocks in parallel", "[format]") {
+  const auto make_blocks{[]() {
+    std::vector<marlin::ast::node> blocks;
+    for (size_t i{0}; i < 24; i++) {
+      // Alternate functions and on start blocks
+      auto program{make_program()};
+      blocks.emplace_back(
+          program->as<marlin::ast::program>().blocks().pop(i % 2));
+    }
+    return marlin::ast::make<marlin::ast::program>(std::move(blocks));
+  }};
+  auto program{make_blocks()};
+  auto expected{make_blocks()};
+
+  const auto display{marlin::format::format_in_parallel(
+      program->as<marlin::ast::program>(), 4)};
+  const auto fresh{marlin::format::in_place_formatter{}.format(expected)};
+  REQUIRE(same_display(display, fresh));
+  REQUIRE(same_ranges(*program, *expected));
+
+  const auto& last_function{
+      program->children()[22]->as<marlin::ast::function>()};
+  const auto& expected_function{
+      expected->children()[22]->as<marlin::ast::function>()};
+  REQUIRE(last_function.statements()[1]
+              ->as<marlin::ast::if_else_statement>()
+              .else_loc.line == expected_function.statements()[1]
+                                    ->as<marlin::ast::if_else_statement>()
+                                    .else_loc.line);
+}
+
+TEST_CASE("format::Index highlights by line", "[format]") {
+  static_assert(sizeof(marlin::format::highlight_token) <= 12);
+
+  const auto display{
+      marlin::format::const_formatter{}.format(make_program())};
+  REQUIRE(display.line_count() == 11);
+
+  size_t highlights{0};
+  for (size_t line{0}; line < display.line_count(); line++) {
+    const auto offset{display.line_offset(line)};
+    const auto source{display.line_source(line)};
+    REQUIRE(source.find('\n') == std::string_view::npos);
+    REQUIRE(display.source.compare(offset, source.size(), source) == 0);
+    for (const auto& token : display.line_highlights(line)) {
+      REQUIRE(token.offset >= offset);
+      REQUIRE(token.offset + token.length <= offset + source.size());
+      highlights++;
+    }
+  }
+  REQUIRE(highlights == display.highlights.size());
+  REQUIRE(display.line_source(2) == "  if (true) {");
+  REQUIRE(display.line_highlights(2).size() == 2);
+
+  const marlin::format::display partial{"a\nb", {}};
+  REQUIRE(partial.line_count() == 2);
+  REQUIRE(partial.line_source(1) == "b");
+  REQUIRE(marlin::format::display{"", {}}.line_count() == 0);
+}
+
+namespace {
+
+// Highlight type of every byte as a character, ' ' for plain text
+std::string styles_of(const marlin::format::display& display) {
+  std::string styles(display.source.size(), ' ');
+  for (const auto& token : display.highlights) {
+    std::fill_n(styles.begin() + token.offset, token.length,
+                static_cast<char>('0' + static_cast<int>(token.type)));
+  }
+  return styles;
+}
+
+// Applies the edits from the last one, to both the text and its styles
+void check_diff(const marlin::format::display& original,
+                const marlin::format::display& updated,
+                size_t max_edits = 64) {
+  const auto edits{marlin::format::diff(original, updated, max_edits)};
+  marlin::format::text_model text{original.source};
+  marlin::format::text_model styles{styles_of(original)};
+  for (auto edit{edits.rbegin()}; edit != edits.rend(); ++edit) {
+    REQUIRE(edit->length > 0);
+    text.replace(edit->offset, edit->length, edit->replacement.source);
+    styles.replace(edit->offset, edit->length, styles_of(edit->replacement));
+  }
+  REQUIRE(text.str() == updated.source);
+  REQUIRE(styles.str() == styles_of(updated));
+}
+
+marlin::format::display display_of(const marlin::ast::node& node) {
+  return marlin::format::const_formatter{}.format(node);
+}
+
+}  // namespace
+
+TEST_CASE("format::Diff displays", "[format]") {
+  using marlin::ast::make;
+  namespace ast = marlin::ast;
+
+  const auto call{[](std::vector<std::string> arguments) {
+    std::vector<ast::node> nodes;
+    for (auto& argument : arguments) {
+      if (argument[0] == '@') {
+        nodes.emplace_back(
+            make<ast::expression_placeholder>(argument.substr(1)));
+      } else {
+        nodes.emplace_back(make<ast::number_literal>(argument));
+      }
+    }
+    return display_of(
+        make<ast::user_function_call>("draw_circle", std::move(nodes)));
+  }};
+
+  SECTION("Renamed placeholder") {
+    const auto original{call({"@x", "@y", "@radius"})};
+    const auto updated{call({"@x", "@y", "@size"})};
+    const auto edits{marlin::format::diff(original, updated)};
+    REQUIRE(edits.size() == 1);
+    REQUIRE(edits[0].length < 8);
+    check_diff(original, updated);
+  }
+
+  SECTION("Changed style") {
+    // The text stays, but it is no longer highlighted
+    const auto original{display_of(make<ast::number_literal>("12"))};
+    const auto updated{display_of(make<ast::identifier>("12"))};
+    REQUIRE(original.source == updated.source);
+    REQUIRE(marlin::format::diff(original, updated).size() == 1);
+    check_diff(original, updated);
+  }
+
+  SECTION("Inserted and removed arguments") {
+    check_diff(call({"1"}), call({"12"}));
+    check_diff(call({"12"}), call({"1"}));
+    check_diff(call({"1", "2"}), call({"0", "1", "2", "3"}));
+    check_diff(call({"1", "@b", "3", "@d"}), call({"@a", "2", "@c", "4"}));
+    check_diff(call({}), call({"@a", "@b", "@c"}));
+  }
+
+  SECTION("Too many changes") {
+    const auto original{call({"@first", "@second"})};
+    const auto updated{call({"123", "456"})};
+    REQUIRE(marlin::format::diff(original, updated, 4).size() == 1);
+    check_diff(original, updated, 4);
+  }
+
+  SECTION("Non-ASCII text") {
+    check_diff(call({"@caf\u00e9"}), call({"@caf\u00e8"}));
+    check_diff(call({"@\u65e5"}), call({"@\u65e5\u672c", "@x"}));
+  }
+
+  SECTION("Same display") {
+    REQUIRE(marlin::format::diff(call({"1"}), call({"1"})).empty());
+  }
+}
+
+TEST_CASE("format::Count columns in codepoints", "[format]") {
+  // Long enough to go through whole words as well as the remaining bytes
+  const std::string text{
+      "a\u00e9\u65e5\U0001f600 plain ascii text \u00e9\u00e9"};
+  const auto count_bytewise{[](std::string_view rest) {
+    size_t count{0};
+    for (const auto c : rest) {
+      if ((static_cast<unsigned char>(c) & 0xc0) != 0x80) {
+        count++;
+      }
+    }
+    return count;
+  }};
+  const auto expected{count_bytewise(text)};
+  for (size_t begin{0}; begin <= text.size(); begin++) {
+    const std::string_view rest{text.data() + begin, text.size() - begin};
+    const auto count{marlin::format::codepoint_count(rest)};
+    REQUIRE(count == count_bytewise(rest));
+    REQUIRE(marlin::format::codepoint_offset(rest, count) == rest.size());
+  }
+  REQUIRE(marlin::format::codepoint_offset(text, 3) == 1 + 2 + 3);
+  // The emoji takes a surrogate pair
+  REQUIRE(marlin::format::utf16_length(text.substr(0, 1 + 2 + 3 + 4)) == 5);
+  REQUIRE(marlin::format::utf16_length(text) == expected + 1);
+
+  auto assignment{make_assignment("\u00e9t\u00e9", "1")};
+  const auto display{marlin::format::in_place_formatter{}.format(assignment)};
+  REQUIRE(display.source == "\u00e9t\u00e9 = 1;\n");
+  const auto& value{assignment->as<marlin::ast::assignment>().value()};
+  REQUIRE(value->source_code_range.begin.column == 7);
+  REQUIRE(value->source_code_range.end.column == 8);
+  // Highlight offsets still count bytes
+  REQUIRE(display.highlights.back().offset == 8);
+}
@@ -0,0 +1,95 @@
+#ifndef marlin_test_program_builders_hpp
+#define marlin_test_program_builders_hpp
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "ast.hpp"
+#include "store.hpp"
+#include "user_function.hpp"
+
+// Short hands building programs in tests and benchmarks
+
+namespace marlin::program_builders {
+
+using ast::node;
+
+template <typename... node_types>
+std::vector<node> nodes(node_types... args) {
+  std::vector<node> result;
+  (result.emplace_back(std::move(args)), ...);
+  return result;
+}
+
+inline node number(std::string value) {
+  return ast::make<ast::number_literal>(std::move(value));
+}
+
+inline node text(std::string value) {
+  return ast::make<ast::string_literal>(std::move(value));
+}
+
+inline node id(std::string name) {
+  return ast::make<ast::identifier>(std::move(name));
+}
+
+inline node var(std::string name) {
+  return ast::make<ast::variable_name>(std::move(name));
+}
+
+inline node binary(node left, ast::binary_op op, node right) {
+  return ast::make<ast::binary_expression>(std::move(left), op,
+                                           std::move(right));
+}
+
+inline node assign(std::string name, node value) {
+  return ast::make<ast::assignment>(var(std::move(name)), std::move(value));
+}
+
+template <typename... node_types>
+node call(ast::system_procedure proc, node_types... args) {
+  return ast::make<ast::system_procedure_call>(proc,
+                                               nodes(std::move(args)...));
+}
+
+template <typename... node_types>
+node call(ast::system_function func, node_types... args) {
+  return ast::make<ast::system_function_call>(func, nodes(std::move(args)...));
+}
+
+template <typename... node_types>
+node call(std::string name, node_types... args) {
+  return ast::make<ast::user_function_call>(std::move(name),
+                                            nodes(std::move(args)...));
+}
+
+inline node print(node value) {
+  return call(ast::system_procedure::print, std::move(value));
+}
+
+inline node function_block(std::string name, std::vector<node> params,
+                           std::vector<node> statements) {
+  return ast::make<ast::function>(
+      ast::make<ast::function_signature>(std::move(name), std::move(params)),
+      std::move(statements));
+}
+
+// Goes through the store so that calls are bound to their functions
+struct stored_program {
+  control::temporary_user_function_table_holder table;
+  std::vector<node> nodes;
+
+  explicit stored_program(std::vector<node> blocks) {
+    auto program{ast::make<ast::program>(std::move(blocks))};
+    const auto data{store::write({program.get()})};
+    nodes =
+        store::read(data, table, store::type_expectation::program).nodes;
+  }
+
+  ast::program& get() { return nodes[0]->as<ast::program>(); }
+};
+
+}  // namespace marlin::program_builders
+
+#endif  // marlin_test_program_builders_hpp
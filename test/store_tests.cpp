@@ -1,6 +1,15 @@
 #include <catch2/catch.hpp>
 
+#include <atomic>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <thread>
+
 #include "ast.hpp"
+#include "chunk_store.hpp"
 #include "store.hpp"
 #include "user_function.hpp"
 
@@ -37,6 +46,112 @@ TEST_CASE("store::Write and read expressions", "[store]") {
   REQUIRE(inner_result.display.source == "(@left + @right)");
 }
 
+TEST_CASE("store::Keep stored layout", "[store]") {
+  marlin::control::temporary_user_function_table_holder table;
+
+  auto node{marlin::ast::make<marlin::ast::return_result_statement>(
+      marlin::ast::make<marlin::ast::binary_expression>(
+          marlin::ast::make<marlin::ast::number_literal>("1"),
+          marlin::ast::binary_op::add,
+          marlin::ast::make<marlin::ast::identifier>("a")))};
+  auto data{marlin::store::write({node.get()})};
+
+  const auto to_data{[](std::string_view bytes) {
+    marlin::store::data_vector result;
+    for (const auto byte : bytes) {
+      result.emplace_back(static_cast<std::byte>(byte));
+    }
+    return result;
+  }};
+
+  using namespace std::literals;
+  const auto body{
+      "\0\0\0\x01"
+      "return\0\x01"
+      "binary\0+\0"
+      "number\0\0\0\0\x01"
+      "1"
+      "id\0\0\0\0\x01"
+      "a"sv};
+  REQUIRE(data == to_data("MKB\x02\0\0\0\0"s + std::string{body}));
+
+  auto result{marlin::store::read(
+      data, table, marlin::store::type_expectation::statement)};
+  REQUIRE(result.nodes.size() == 1);
+  REQUIRE(result.display.source == "return 1 + a;\n");
+
+  // Documents saved before the function directory stay readable
+  auto v1_result{
+      marlin::store::read(to_data("MKB\x01"s + std::string{body}), table,
+                          marlin::store::type_expectation::statement)};
+  REQUIRE(v1_result.nodes.size() == 1);
+  REQUIRE(v1_result.display.source == "return 1 + a;\n");
+}
+
+TEST_CASE("store::Bind calls through function directory", "[store]") {
+  using namespace marlin::ast;
+
+  const auto make_function{[](std::string name, std::string param,
+                              std::string callee) {
+    std::vector<node> params;
+    params.emplace_back(make<parameter>(std::move(param)));
+    std::vector<node> args;
+    args.emplace_back(make<number_literal>("1"));
+    std::vector<node> statements;
+    statements.emplace_back(make<eval_statement>(
+        make<user_function_call>(std::move(callee), std::move(args))));
+    return make<function>(
+        make<function_signature>(std::move(name), std::move(params)),
+        std::move(statements));
+  }};
+
+  std::vector<node> blocks;
+  // f calls g before g is defined
+  blocks.emplace_back(make_function("f", "x", "g"));
+  blocks.emplace_back(make_function("g", "y", "f"));
+  auto program{make<marlin::ast::program>(std::move(blocks))};
+  auto data{marlin::store::write({program.get()})};
+
+  SECTION("Calls are bound") {
+    marlin::control::temporary_user_function_table_holder table;
+    auto result{marlin::store::read(
+        data, table, marlin::store::type_expectation::program)};
+    REQUIRE(table.has_function("f"));
+    REQUIRE(table.has_function("g"));
+    REQUIRE(table.get_function("f").parameters ==
+            std::vector<std::string>{"x"});
+
+    const auto& read_program{result.nodes[0]->as<marlin::ast::program>()};
+    for (const auto& block : read_program.blocks()) {
+      const auto& statement{*block->as<function>().statements()[0]};
+      const auto& call{*statement.as<eval_statement>().expression()};
+      const auto* definition{call.as<user_function_call>().func()};
+      REQUIRE(definition != nullptr);
+      REQUIRE(definition->name == call.as<user_function_call>().name);
+    }
+  }
+
+  SECTION("Functions are taken out again on errors") {
+    marlin::control::temporary_user_function_table_holder table;
+    REQUIRE_THROWS_AS(
+        marlin::store::read(data, table,
+                            marlin::store::type_expectation::statement),
+        marlin::store::read_error);
+    REQUIRE_FALSE(table.has_function("f"));
+    REQUIRE_FALSE(table.has_function("g"));
+  }
+
+  SECTION("Repeated functions are rejected") {
+    marlin::control::temporary_user_function_table_holder table;
+    table.add_function({"g"});
+    REQUIRE_THROWS_AS(
+        marlin::store::read(data, table,
+                            marlin::store::type_expectation::program),
+        marlin::store::read_error);
+    REQUIRE_FALSE(table.has_function("f"));
+  }
+}
+
 TEST_CASE("store::Write and read statements", "[store]") {
   marlin::control::temporary_user_function_table_holder table;
 
@@ -100,3 +215,234 @@ TEST_CASE("store::Report type error", "[store]") {
 
   REQUIRE_THROWS(marlin::store::read(inner_data, left, table));
 }
+
+TEST_CASE("store::Read and write documents in parallel", "[store]") {
+  using namespace marlin::ast;
+
+  constexpr size_t thread_count{8};
+  constexpr size_t documents_per_thread{64};
+
+  const auto make_document{[](size_t index) {
+    std::vector<node> params;
+    params.emplace_back(make<parameter>("x"));
+    std::vector<node> args;
+    args.emplace_back(make<identifier>("x"));
+    std::vector<node> function_statements;
+    function_statements.emplace_back(make<return_result_statement>(
+        make<binary_expression>(make<identifier>("x"), binary_op::multiply,
+                                make<number_literal>(std::to_string(index)))));
+    std::vector<node> call_args;
+    call_args.emplace_back(make<number_literal>("2"));
+    std::vector<node> print_args;
+    print_args.emplace_back(make<user_function_call>(
+        "scale" + std::to_string(index), std::move(call_args)));
+    std::vector<node> on_start_statements;
+    on_start_statements.emplace_back(make<system_procedure_call>(
+        system_procedure::print, std::move(print_args)));
+
+    std::vector<node> blocks;
+    blocks.emplace_back(make<function>(
+        make<function_signature>("scale" + std::to_string(index),
+                                 std::move(params)),
+        std::move(function_statements)));
+    blocks.emplace_back(make<on_start>(std::move(on_start_statements)));
+    return make<program>(std::move(blocks));
+  }};
+
+  std::vector<std::string> expected;
+  std::vector<marlin::store::data_vector> documents;
+  for (size_t i{0}; i < thread_count * documents_per_thread; i++) {
+    const auto index{std::to_string(i)};
+    expected.emplace_back("func scale" + index + "(x) {\n" +
+                          "  return x * " + index + ";\n" + "}\n" +
+                          "on start {\n" + "  print(scale" + index +
+                          "(2));\n" + "}\n");
+    documents.emplace_back(marlin::store::write({make_document(i).get()}));
+  }
+
+  std::vector<std::string> sources(documents.size());
+  std::vector<marlin::store::data_vector> rewritten(documents.size());
+  std::atomic<size_t> failures{0};
+  std::vector<std::thread> threads;
+  for (size_t t{0}; t < thread_count; t++) {
+    threads.emplace_back([&, t]() {
+      for (size_t i{t}; i < documents.size(); i += thread_count) {
+        try {
+          marlin::control::temporary_user_function_table_holder table;
+          auto result{marlin::store::read(
+              documents[i], table, marlin::store::type_expectation::program)};
+          sources[i] = std::move(result.display.source);
+          rewritten[i] = marlin::store::write({result.nodes[0].get()});
+        } catch (const marlin::store::read_error&) {
+          failures++;
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  REQUIRE(failures == 0);
+  REQUIRE(sources == expected);
+  REQUIRE(rewritten == documents);
+}
+
+TEST_CASE("store::Deduplicate documents in chunk store", "[store]") {
+  using namespace marlin::ast;
+
+  const auto make_document{[](std::string greeting) {
+    std::vector<node> helper_args;
+    helper_args.emplace_back(make<identifier>("x"));
+    std::vector<node> helper_statements;
+    helper_statements.emplace_back(make<system_procedure_call>(
+        system_procedure::print, std::move(helper_args)));
+    std::vector<node> params;
+    params.emplace_back(make<parameter>("x"));
+
+    std::vector<node> print_args;
+    print_args.emplace_back(make<string_literal>(std::move(greeting)));
+    std::vector<node> on_start_statements;
+    on_start_statements.emplace_back(make<system_procedure_call>(
+        system_procedure::print, std::move(print_args)));
+    on_start_statements.emplace_back(make<break_statement>());
+
+    std::vector<node> blocks;
+    blocks.emplace_back(
+        make<function>(make<function_signature>("helper", std::move(params)),
+                       std::move(helper_statements)));
+    blocks.emplace_back(make<on_start>(std::move(on_start_statements)));
+    return make<program>(std::move(blocks));
+  }};
+
+  const auto directory{std::filesystem::temp_directory_path() /
+                       "marlin_store_tests_chunks"};
+  std::filesystem::remove_all(directory);
+
+  const auto granularity{
+      GENERATE(marlin::store::chunk_granularity::block,
+               marlin::store::chunk_granularity::statement)};
+  marlin::store::chunk_store chunks{directory.string(), granularity};
+
+  std::vector<marlin::store::data_vector> documents;
+  for (size_t i{0}; i < 16; i++) {
+    auto program{make_document(i % 2 == 0 ? "hello" : "hi")};
+    documents.emplace_back(marlin::store::write({program.get()}));
+    chunks.save("document" + std::to_string(i), *program);
+  }
+
+  // Only two distinct on start blocks, sharing the helper function
+  const auto& stats{chunks.stats()};
+  REQUIRE(stats.documents_saved == 16);
+  REQUIRE(stats.written_bytes == stats.unique_bytes);
+  REQUIRE(stats.dedup_ratio() > 6);
+
+  for (size_t i{0}; i < 16; i++) {
+    REQUIRE(chunks.load("document" + std::to_string(i)) == documents[i]);
+  }
+
+  marlin::control::temporary_user_function_table_holder table;
+  auto result{chunks.read("document1", table)};
+  REQUIRE(result.display.source ==
+          "func helper(x) {\n"
+          "  print(x);\n"
+          "}\n"
+          "on start {\n"
+          "  print(\"hi\");\n"
+          "  break;\n"
+          "}\n");
+  REQUIRE(chunks.stats().documents_read == 1);
+  REQUIRE(chunks.stats().read_bytes == documents[1].size());
+
+  // Chunks already in the directory are not written again
+  marlin::store::chunk_store reopened{directory.string(), granularity};
+  reopened.save("copy", *make_document("hello"));
+  REQUIRE(reopened.stats().written_bytes == 0);
+  REQUIRE(reopened.load("copy") == documents[0]);
+
+  REQUIRE_THROWS_AS(chunks.load("missing"), marlin::store::read_error);
+
+  // Chunks are named by their SHA-256 digest and size, and checked on load
+  std::filesystem::path chunk;
+  for (const auto& entry :
+       std::filesystem::recursive_directory_iterator{directory / "chunks"}) {
+    if (entry.is_regular_file()) {
+      chunk = entry.path();
+    }
+  }
+  const auto name{chunk.filename().string()};
+  REQUIRE(name.find('-') == 64);
+  REQUIRE(std::stoul(name.substr(65)) == std::filesystem::file_size(chunk));
+  {
+    std::fstream file{chunk, std::ios::in | std::ios::out | std::ios::binary};
+    const auto first{static_cast<char>(file.get())};
+    file.seekp(0);
+    file.put(static_cast<char>(first ^ 1));
+  }
+  size_t corrupted{0};
+  for (size_t i{0}; i < 16; i++) {
+    try {
+      static_cast<void>(chunks.load("document" + std::to_string(i)));
+    } catch (const marlin::store::read_error&) {
+      corrupted++;
+    }
+  }
+  REQUIRE(corrupted > 0);
+
+  // Sizes in a manifest are checked before anything is allocated
+  const auto hash{name.substr(0, 64)};
+  for (const auto& id :
+       {hash + "-99999999999999", hash + "-99999999999999999999999999",
+        hash + "-" + std::to_string(std::filesystem::file_size(chunk) + 1),
+        std::string(64, '.') + "-1"}) {
+    {
+      std::ofstream manifest{directory / "manifests" / "hostile"};
+      manifest << "marlin-chunks 2\n" << id << '\n';
+    }
+    REQUIRE_THROWS_AS(chunks.load("hostile"), marlin::store::read_error);
+  }
+
+  std::filesystem::remove_all(directory);
+}
+
+TEST_CASE("store::Read document from mapped file", "[store]") {
+  marlin::control::temporary_user_function_table_holder table;
+
+  std::vector<marlin::ast::node> print_arguments;
+  print_arguments.emplace_back(
+      marlin::ast::make<marlin::ast::string_literal>("mapped"));
+  std::vector<marlin::ast::node> on_start_statements;
+  on_start_statements.emplace_back(
+      marlin::ast::make<marlin::ast::system_procedure_call>(
+          marlin::ast::system_procedure::print, std::move(print_arguments)));
+  std::vector<marlin::ast::node> program_blocks;
+  program_blocks.emplace_back(
+      marlin::ast::make<marlin::ast::on_start>(std::move(on_start_statements)));
+  auto program{
+      marlin::ast::make<marlin::ast::program>(std::move(program_blocks))};
+  auto data{marlin::store::write({program.get()})};
+
+  const std::string path{"store_tests_mapped.mkb"};
+  {
+    std::ofstream file{path, std::ios::binary};
+    file.write(reinterpret_cast<const char*>(data.data()), data.size());
+  }
+
+  auto result{marlin::store::read_file(
+      path, table, marlin::store::type_expectation::program)};
+  std::remove(path.c_str());
+
+  REQUIRE(result.nodes.size() == 1);
+  REQUIRE(result.display.source ==
+          "on start {\n"
+          "  print(\"mapped\");\n"
+          "}\n");
+}
+
+TEST_CASE("store::Read missing file", "[store]") {
+  marlin::control::temporary_user_function_table_holder table;
+
+  REQUIRE_THROWS_AS(
+      marlin::store::read_file("store_tests_missing.mkb", table),
+      marlin::store::read_error);
+}
@@ -0,0 +1,78 @@
+#include <catch2/catch.hpp>
+
+#include <cstdint>
+#include <string>
+
+#include "text_model.hpp"
+
+TEST_CASE("format::Look up lines in text model", "[format]") {
+  marlin::format::text_model model{"on start {\n  a = 1;\n}\n"};
+  REQUIRE(model.line_count() == 4);
+  REQUIRE(model.line(1) == "on start {");
+  REQUIRE(model.line(2) == "  a = 1;");
+  REQUIRE(model.line(4) == "");
+  REQUIRE(model.offset_of({2, 3}) == 13);
+  REQUIRE(model.loc_of(13).line == 2);
+  REQUIRE(model.loc_of(13).column == 3);
+  REQUIRE(model.loc_of(model.size()).line == 4);
+
+  // Columns count codepoints
+  marlin::format::text_model text{"on start {\n  été = \"日本\";\n}\n"};
+  REQUIRE(text.offset_of({2, 5}) == 11 + 5);
+  REQUIRE(text.loc_of(11 + 5).column == 5);
+  REQUIRE(text.offset_of({2, 13}) == 11 + 18);
+  REQUIRE(text.loc_of(11 + 18).column == 13);
+}
+
+TEST_CASE("format::Apply source updates to text model", "[format]") {
+  marlin::format::text_model model{"on start {\n  a = 1;\n}\n"};
+
+  // Insert a statement
+  model.apply({{3, 1}, {3, 1}}, {"  print(@value);\n", {}});
+  REQUIRE(model.str() == "on start {\n  a = 1;\n  print(@value);\n}\n");
+
+  // Replace an expression
+  model.apply({{3, 9}, {3, 15}}, {"\"text\"", {}});
+  REQUIRE(model.line(3) == "  print(\"text\");");
+
+  // Remove a statement
+  model.apply({{2, 3}, {3, 1}}, {"", {}});
+  REQUIRE(model.str() == "on start {\n  print(\"text\");\n}\n");
+}
+
+TEST_CASE("format::Match string edits in text model", "[format]") {
+  marlin::format::text_model model;
+  std::string expected;
+
+  uint64_t state{1};
+  const auto next{[&state](size_t bound) {
+    state = state * 6364136223846793005 + 1442695040888963407;
+    return static_cast<size_t>((state >> 33) % bound);
+  }};
+
+  for (size_t i{0}; i < 2000; i++) {
+    const auto offset{next(expected.size() + 1)};
+    const auto length{next(std::min<size_t>(expected.size() - offset, 8) + 1)};
+    std::string text;
+    for (auto count{next(200)}; count > 0; count--) {
+      text += next(8) == 0 ? '\n' : static_cast<char>('a' + next(26));
+    }
+    model.replace(offset, length, text);
+    expected.replace(offset, length, text);
+
+    if (i % 100 == 0) {
+      REQUIRE(model.str() == expected);
+      const auto line{1 + next(model.line_count())};
+      size_t begin{0};
+      for (size_t j{1}; j < line; j++) {
+        begin = expected.find('\n', begin) + 1;
+      }
+      const auto end{std::min(expected.find('\n', begin), expected.size())};
+      REQUIRE(model.line(line) == expected.substr(begin, end - begin));
+      REQUIRE(model.offset_of({line, 1}) == begin);
+      REQUIRE(model.loc_of(end).line == line);
+      REQUIRE(model.loc_of(end).column == end - begin + 1);
+    }
+  }
+  REQUIRE(model.size() == expected.size());
+}